@@ -0,0 +1,67 @@
+#version 440 core
+
+#include_part
+
+// Struct Particle must be declared before including this file
+
+#include "particleSystemState.glsl"
+
+layout(local_size_x = PARTICLES_WORK_GROUP_SIZE) in;
+
+// Particles from the last update and particles that survive this one
+layout(std430, binding = 0) readonly buffer InputParticlesBlock
+{
+    Particle inputParticles[];
+};
+
+layout(std430, binding = 1) writeonly buffer OutputParticlesBlock
+{
+    Particle outputParticles[];
+};
+
+// Number of particles written to the output buffer so far (it's numWrittenParticles of the state)
+layout(binding = 0, offset = 4) uniform atomic_uint numOutputParticles;
+
+// How many particles should be generated during this update
+uniform int numParticlesToGenerate;
+
+// Maximal number of particles in the buffers
+uniform int numMaxParticles;
+
+/**
+ * Checks, if this invocation updates a particle from the input buffer.
+ */
+bool isUpdatingParticle()
+{
+    return gl_GlobalInvocationID.x < particleSystemState.numAliveParticles;
+}
+
+/**
+ * Checks, if this invocation generates a new particle.
+ */
+bool isGeneratingParticle()
+{
+    return !isUpdatingParticle() && gl_GlobalInvocationID.x - particleSystemState.numAliveParticles < uint(numParticlesToGenerate);
+}
+
+/**
+ * Gets particle updated by this invocation.
+ */
+Particle getInputParticle()
+{
+    return inputParticles[gl_GlobalInvocationID.x];
+}
+
+/**
+ * Appends particle to the output buffer. Particles, that are not emitted, die.
+ * If the buffer is full already, particle is dropped.
+ */
+void emitParticle(Particle particle)
+{
+    uint particleIndex = atomicCounterIncrement(numOutputParticles);
+    if (particleIndex < uint(numMaxParticles)) {
+        outputParticles[particleIndex] = particle;
+    }
+}
+
+#definition_part
@@ -0,0 +1,13 @@
+#version 440 core
+
+#include_part
+
+// Per-frame constants shared by all shader programs, uploaded once per frame by UniformBlockManager
+layout(std140, binding = 0) uniform FrameConstantsBlock
+{
+    mat4 projectionMatrix;
+    mat4 viewMatrix;
+    vec4 eyePosition; // Position of the camera in world space (w is always 1.0)
+} frameConstants;
+
+#definition_part
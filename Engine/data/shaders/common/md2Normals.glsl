@@ -0,0 +1,172 @@
+#version 440 core
+
+#include_part
+
+// Precomputed normals of the MD2 format, quantized vertex refers to one of them with its normal index
+// (same table as MD2Model::ANORMS_TABLE)
+const vec3 MD2_NORMALS[162] = vec3[162](
+    vec3(-0.525731,  0.000000,  0.850651),
+    vec3(-0.442863,  0.238856,  0.864188),
+    vec3(-0.295242,  0.000000,  0.955423),
+    vec3(-0.309017,  0.500000,  0.809017),
+    vec3(-0.162460,  0.262866,  0.951056),
+    vec3( 0.000000,  0.000000,  1.000000),
+    vec3( 0.000000,  0.850651,  0.525731),
+    vec3(-0.147621,  0.716567,  0.681718),
+    vec3( 0.147621,  0.716567,  0.681718),
+    vec3( 0.000000,  0.525731,  0.850651),
+    vec3( 0.309017,  0.500000,  0.809017),
+    vec3( 0.525731,  0.000000,  0.850651),
+    vec3( 0.295242,  0.000000,  0.955423),
+    vec3( 0.442863,  0.238856,  0.864188),
+    vec3( 0.162460,  0.262866,  0.951056),
+    vec3(-0.681718,  0.147621,  0.716567),
+    vec3(-0.809017,  0.309017,  0.500000),
+    vec3(-0.587785,  0.425325,  0.688191),
+    vec3(-0.850651,  0.525731,  0.000000),
+    vec3(-0.864188,  0.442863,  0.238856),
+    vec3(-0.716567,  0.681718,  0.147621),
+    vec3(-0.688191,  0.587785,  0.425325),
+    vec3(-0.500000,  0.809017,  0.309017),
+    vec3(-0.238856,  0.864188,  0.442863),
+    vec3(-0.425325,  0.688191,  0.587785),
+    vec3(-0.716567,  0.681718, -0.147621),
+    vec3(-0.500000,  0.809017, -0.309017),
+    vec3(-0.525731,  0.850651,  0.000000),
+    vec3( 0.000000,  0.850651, -0.525731),
+    vec3(-0.238856,  0.864188, -0.442863),
+    vec3( 0.000000,  0.955423, -0.295242),
+    vec3(-0.262866,  0.951056, -0.162460),
+    vec3( 0.000000,  1.000000,  0.000000),
+    vec3( 0.000000,  0.955423,  0.295242),
+    vec3(-0.262866,  0.951056,  0.162460),
+    vec3( 0.238856,  0.864188,  0.442863),
+    vec3( 0.262866,  0.951056,  0.162460),
+    vec3( 0.500000,  0.809017,  0.309017),
+    vec3( 0.238856,  0.864188, -0.442863),
+    vec3( 0.262866,  0.951056, -0.162460),
+    vec3( 0.500000,  0.809017, -0.309017),
+    vec3( 0.850651,  0.525731,  0.000000),
+    vec3( 0.716567,  0.681718,  0.147621),
+    vec3( 0.716567,  0.681718, -0.147621),
+    vec3( 0.525731,  0.850651,  0.000000),
+    vec3( 0.425325,  0.688191,  0.587785),
+    vec3( 0.864188,  0.442863,  0.238856),
+    vec3( 0.688191,  0.587785,  0.425325),
+    vec3( 0.809017,  0.309017,  0.500000),
+    vec3( 0.681718,  0.147621,  0.716567),
+    vec3( 0.587785,  0.425325,  0.688191),
+    vec3( 0.955423,  0.295242,  0.000000),
+    vec3( 1.000000,  0.000000,  0.000000),
+    vec3( 0.951056,  0.162460,  0.262866),
+    vec3( 0.850651, -0.525731,  0.000000),
+    vec3( 0.955423, -0.295242,  0.000000),
+    vec3( 0.864188, -0.442863,  0.238856),
+    vec3( 0.951056, -0.162460,  0.262866),
+    vec3( 0.809017, -0.309017,  0.500000),
+    vec3( 0.681718, -0.147621,  0.716567),
+    vec3( 0.850651,  0.000000,  0.525731),
+    vec3( 0.864188,  0.442863, -0.238856),
+    vec3( 0.809017,  0.309017, -0.500000),
+    vec3( 0.951056,  0.162460, -0.262866),
+    vec3( 0.525731,  0.000000, -0.850651),
+    vec3( 0.681718,  0.147621, -0.716567),
+    vec3( 0.681718, -0.147621, -0.716567),
+    vec3( 0.850651,  0.000000, -0.525731),
+    vec3( 0.809017, -0.309017, -0.500000),
+    vec3( 0.864188, -0.442863, -0.238856),
+    vec3( 0.951056, -0.162460, -0.262866),
+    vec3( 0.147621,  0.716567, -0.681718),
+    vec3( 0.309017,  0.500000, -0.809017),
+    vec3( 0.425325,  0.688191, -0.587785),
+    vec3( 0.442863,  0.238856, -0.864188),
+    vec3( 0.587785,  0.425325, -0.688191),
+    vec3( 0.688191,  0.587785, -0.425325),
+    vec3(-0.147621,  0.716567, -0.681718),
+    vec3(-0.309017,  0.500000, -0.809017),
+    vec3( 0.000000,  0.525731, -0.850651),
+    vec3(-0.525731,  0.000000, -0.850651),
+    vec3(-0.442863,  0.238856, -0.864188),
+    vec3(-0.295242,  0.000000, -0.955423),
+    vec3(-0.162460,  0.262866, -0.951056),
+    vec3( 0.000000,  0.000000, -1.000000),
+    vec3( 0.295242,  0.000000, -0.955423),
+    vec3( 0.162460,  0.262866, -0.951056),
+    vec3(-0.442863, -0.238856, -0.864188),
+    vec3(-0.309017, -0.500000, -0.809017),
+    vec3(-0.162460, -0.262866, -0.951056),
+    vec3( 0.000000, -0.850651, -0.525731),
+    vec3(-0.147621, -0.716567, -0.681718),
+    vec3( 0.147621, -0.716567, -0.681718),
+    vec3( 0.000000, -0.525731, -0.850651),
+    vec3( 0.309017, -0.500000, -0.809017),
+    vec3( 0.442863, -0.238856, -0.864188),
+    vec3( 0.162460, -0.262866, -0.951056),
+    vec3( 0.238856, -0.864188, -0.442863),
+    vec3( 0.500000, -0.809017, -0.309017),
+    vec3( 0.425325, -0.688191, -0.587785),
+    vec3( 0.716567, -0.681718, -0.147621),
+    vec3( 0.688191, -0.587785, -0.425325),
+    vec3( 0.587785, -0.425325, -0.688191),
+    vec3( 0.000000, -0.955423, -0.295242),
+    vec3( 0.000000, -1.000000,  0.000000),
+    vec3( 0.262866, -0.951056, -0.162460),
+    vec3( 0.000000, -0.850651,  0.525731),
+    vec3( 0.000000, -0.955423,  0.295242),
+    vec3( 0.238856, -0.864188,  0.442863),
+    vec3( 0.262866, -0.951056,  0.162460),
+    vec3( 0.500000, -0.809017,  0.309017),
+    vec3( 0.716567, -0.681718,  0.147621),
+    vec3( 0.525731, -0.850651,  0.000000),
+    vec3(-0.238856, -0.864188, -0.442863),
+    vec3(-0.500000, -0.809017, -0.309017),
+    vec3(-0.262866, -0.951056, -0.162460),
+    vec3(-0.850651, -0.525731,  0.000000),
+    vec3(-0.716567, -0.681718, -0.147621),
+    vec3(-0.716567, -0.681718,  0.147621),
+    vec3(-0.525731, -0.850651,  0.000000),
+    vec3(-0.500000, -0.809017,  0.309017),
+    vec3(-0.238856, -0.864188,  0.442863),
+    vec3(-0.262866, -0.951056,  0.162460),
+    vec3(-0.864188, -0.442863,  0.238856),
+    vec3(-0.809017, -0.309017,  0.500000),
+    vec3(-0.688191, -0.587785,  0.425325),
+    vec3(-0.681718, -0.147621,  0.716567),
+    vec3(-0.442863, -0.238856,  0.864188),
+    vec3(-0.587785, -0.425325,  0.688191),
+    vec3(-0.309017, -0.500000,  0.809017),
+    vec3(-0.147621, -0.716567,  0.681718),
+    vec3(-0.425325, -0.688191,  0.587785),
+    vec3(-0.162460, -0.262866,  0.951056),
+    vec3( 0.442863, -0.238856,  0.864188),
+    vec3( 0.162460, -0.262866,  0.951056),
+    vec3( 0.309017, -0.500000,  0.809017),
+    vec3( 0.147621, -0.716567,  0.681718),
+    vec3( 0.000000, -0.525731,  0.850651),
+    vec3( 0.425325, -0.688191,  0.587785),
+    vec3( 0.587785, -0.425325,  0.688191),
+    vec3( 0.688191, -0.587785,  0.425325),
+    vec3(-0.955423,  0.295242,  0.000000),
+    vec3(-0.951056,  0.162460,  0.262866),
+    vec3(-1.000000,  0.000000,  0.000000),
+    vec3(-0.850651,  0.000000,  0.525731),
+    vec3(-0.955423, -0.295242,  0.000000),
+    vec3(-0.951056, -0.162460,  0.262866),
+    vec3(-0.864188,  0.442863, -0.238856),
+    vec3(-0.951056,  0.162460, -0.262866),
+    vec3(-0.809017,  0.309017, -0.500000),
+    vec3(-0.864188, -0.442863, -0.238856),
+    vec3(-0.951056, -0.162460, -0.262866),
+    vec3(-0.809017, -0.309017, -0.500000),
+    vec3(-0.681718,  0.147621, -0.716567),
+    vec3(-0.681718, -0.147621, -0.716567),
+    vec3(-0.850651,  0.000000, -0.525731),
+    vec3(-0.688191,  0.587785, -0.425325),
+    vec3(-0.587785,  0.425325, -0.688191),
+    vec3(-0.425325,  0.688191, -0.587785),
+    vec3(-0.425325, -0.688191, -0.587785),
+    vec3(-0.587785, -0.425325, -0.688191),
+    vec3(-0.688191, -0.587785, -0.425325)
+);
+
+#definition_part
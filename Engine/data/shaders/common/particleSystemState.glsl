@@ -0,0 +1,22 @@
+#version 440 core
+
+#include_part
+
+// Number of invocations in a work group of particle update shaders (must match ComputeParticleSystem::WORK_GROUP_SIZE)
+const int PARTICLES_WORK_GROUP_SIZE = 256;
+
+// State of the compute particle system, it never leaves the GPU (layout must match ParticleSystemState in computeParticleSystem.cpp)
+layout(std430, binding = 2) buffer ParticleSystemStateBlock
+{
+    uint numAliveParticles; // Number of particles in the input buffer
+    uint numWrittenParticles; // Number of particles written to the output buffer (atomic counter during the update)
+    uint dispatchNumGroupsX; // Indirect dispatch command of the update
+    uint dispatchNumGroupsY;
+    uint dispatchNumGroupsZ;
+    uint drawCount; // Indirect draw command of the rendering
+    uint drawInstanceCount;
+    uint drawFirst;
+    uint drawBaseInstance;
+} particleSystemState;
+
+#definition_part
@@ -0,0 +1,15 @@
+#version 440 core
+
+layout (location = 0) out vec4 outputColor;
+
+smooth in vec2 ioVertexTexCoord;
+flat in vec4 ioVertexColor;
+
+uniform sampler2D sampler;
+
+void main()
+{
+    // Atlas stores only coverage of the characters in the red channel
+    float coverage = texture(sampler, ioVertexTexCoord).r;
+    outputColor = vec4(ioVertexColor.rgb, ioVertexColor.a * coverage);
+}
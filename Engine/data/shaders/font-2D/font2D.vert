@@ -0,0 +1,21 @@
+#version 440 core
+
+uniform struct
+{
+    mat4 projectionMatrix;
+} matrices;
+
+layout (location = 0) in vec2 vertexPosition;
+layout (location = 1) in vec2 vertexTexCoord;
+layout (location = 2) in vec4 vertexColor;
+
+smooth out vec2 ioVertexTexCoord;
+flat out vec4 ioVertexColor;
+
+void main()
+{
+    // Characters are already positioned on the screen (in pixels), only orthographic projection is left
+    gl_Position = matrices.projectionMatrix * vec4(vertexPosition, 0.0, 1.0);
+    ioVertexTexCoord = vertexTexCoord;
+    ioVertexColor = vertexColor;
+}
@@ -2,69 +2,39 @@
 
 precision highp float;
 
-#include "../lighting/ambientLight.frag"
-#include "../lighting/diffuseLight.frag"
+#include "../lighting/lights.glsl"
 
 layout(location = 0) out vec4 outputColor;
 
 smooth in vec2 ioVertexTexCoord;
 smooth in vec3 ioVertexNormal;
-smooth in float ioHeight;
+smooth in vec4 ioSplatWeights;
 
 uniform vec4 color;
 
-uniform AmbientLight ambientLight;
-uniform DiffuseLight diffuseLight;
+uniform sampler2DArray terrainLayers; // One layer per splat weight component
 
-uniform sampler2D terrainSampler[16];
-uniform float levels[32];
-uniform int numLevels;
+uniform samplerCube environmentSampler;
+uniform float environmentFactor; // How much is the ambient light tinted by the environment (0.0 means not at all)
 
 void main()
 {
     vec3 normal = normalize(ioVertexNormal);
-    vec4 textureColor = vec4(0.0);
-    bool isTextureColorSet = false;
-    for(int i = 0; i < numLevels && !isTextureColorSet; i++)
-    {
-        if(ioHeight > levels[i]) {
-            continue; // Not yet in between the right level
-        }
 
-        // This is the index of current sampler that we're using (texture in current layer)
-        int currentSamplerIndex = i / 2;
+    // Weights are precomputed per vertex, so every fragment takes the same four samples without branching
+    vec4 textureColor = texture(terrainLayers, vec3(ioVertexTexCoord, 0.0))*ioSplatWeights.x
+        + texture(terrainLayers, vec3(ioVertexTexCoord, 1.0))*ioSplatWeights.y
+        + texture(terrainLayers, vec3(ioVertexTexCoord, 2.0))*ioSplatWeights.z
+        + texture(terrainLayers, vec3(ioVertexTexCoord, 3.0))*ioSplatWeights.w;
 
-        if(i % 2 == 0) {
-            // Here there is nothing special, just take the color of current texture
-            textureColor = texture(terrainSampler[currentSamplerIndex], ioVertexTexCoord);
-        }
-        else
-        {
-            // First, get color of the current texture and next texture
-            int nextSamplerIndex = currentSamplerIndex+1;
-            vec4 textureColorCurrent = texture(terrainSampler[currentSamplerIndex], ioVertexTexCoord);
-            vec4 textureColorNext = texture(terrainSampler[nextSamplerIndex], ioVertexTexCoord);
-
-            // Calculate factors, how much will each texture contribute
-            float levelDiff = levels[i] - levels[i-1];
-            float factorNext = (ioHeight - levels[i-1]) / levelDiff;
-            float factorCurrent = 1.0f - factorNext;
-            
-            // Calculate final texture color
-            textureColor = textureColorCurrent*factorCurrent + textureColorNext*factorNext;
-        }
-
-        isTextureColorSet = true;
-    }
+    vec4 objectColor = textureColor*color;
 
-    if(!isTextureColorSet)
-    {
-        int lastSamplerIndex = numLevels / 2;
-        textureColor = texture(terrainSampler[lastSamplerIndex], ioVertexTexCoord);
-    }
+    // One of the smallest mip levels of the environment is blurry enough to approximate the light coming from the sky
+    float environmentLevel = max(0.0, float(textureQueryLevels(environmentSampler) - 3));
+    vec3 environmentColor = textureLod(environmentSampler, normal, environmentLevel).rgb;
+    vec3 ambientColor = getAmbientLightColor(lights.ambientLight)*mix(vec3(1.0), environmentColor, environmentFactor);
 
-    vec4 objectColor = textureColor*color;
-    vec3 lightColor = getAmbientLightColor(ambientLight) + getDiffuseLightColor(diffuseLight, normal);
+    vec3 lightColor = ambientColor + getDiffuseLightColor(lights.diffuseLight, normal);
 
     outputColor = objectColor*vec4(lightColor, 1.0);
 }
\ No newline at end of file
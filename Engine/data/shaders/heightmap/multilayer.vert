@@ -1,9 +1,9 @@
 #version 440 core
 
+#include "../common/frameConstants.glsl"
+
 uniform struct
 {
-    mat4 projectionMatrix;
-    mat4 viewMatrix;
     mat4 modelMatrix;
     mat3 normalMatrix;
 } matrices;
@@ -11,17 +11,18 @@ uniform struct
 layout(location = 0) in vec3 vertexPosition;
 layout(location = 1) in vec2 vertexTexCoord;
 layout(location = 2) in vec3 vertexNormal;
+layout(location = 3) in vec4 vertexSplatWeights;
 
 smooth out vec2 ioVertexTexCoord;
 smooth out vec3 ioVertexNormal;
-smooth out float ioHeight;
+smooth out vec4 ioSplatWeights;
 
 void main()
 {
-    mat4 mvpMatrix = matrices.projectionMatrix * matrices.viewMatrix * matrices.modelMatrix;
+    mat4 mvpMatrix = frameConstants.projectionMatrix * frameConstants.viewMatrix * matrices.modelMatrix;
     gl_Position = mvpMatrix * vec4(vertexPosition, 1.0);
     
     ioVertexTexCoord = vertexTexCoord;
     ioVertexNormal = matrices.normalMatrix*vertexNormal;
-    ioHeight = vertexPosition.y;
+    ioSplatWeights = vertexSplatWeights;
 }
\ No newline at end of file
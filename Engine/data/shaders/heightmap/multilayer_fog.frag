@@ -2,9 +2,7 @@
 
 precision highp float;
 
-#include "../lighting/ambientLight.frag"
-#include "../lighting/diffuseLight.frag"
-#include "../fog/fog.frag"
+#include "../lighting/lights.glsl"
 
 layout(location = 0) out vec4 outputColor;
 
@@ -15,11 +13,7 @@ smooth in vec4 ioEyeSpacePosition;
 
 uniform vec4 color;
 
-uniform AmbientLight ambientLight;
-uniform DiffuseLight diffuseLight;
-uniform FogParameters fogParams;
-
-uniform sampler2D terrainSampler[16];
+uniform sampler2D terrainSampler[15]; // Unit 15 is reserved for the environment cube map (Heightmap::ENVIRONMENT_TEXTURE_UNIT)
 uniform float levels[32];
 uniform int numLevels;
 
@@ -67,14 +61,14 @@ void main()
     }
 
     vec4 objectColor = textureColor*color;
-    vec3 lightColor = getAmbientLightColor(ambientLight) + getDiffuseLightColor(diffuseLight, normal);
+    vec3 lightColor = getAmbientLightColor(lights.ambientLight) + getDiffuseLightColor(lights.diffuseLight, normal);
 
     outputColor = objectColor*vec4(lightColor, 1.0);
     
     // Apply fog calculation only if fog is enabled
-    if(fogParams.isEnabled)
+    if(lights.fogParams.isEnabled)
     {
         float fogCoordinate = abs(ioEyeSpacePosition.z / ioEyeSpacePosition.w);
-        outputColor = mix(outputColor, vec4(fogParams.color, 1.0), getFogFactor(fogParams, fogCoordinate));
+        outputColor = mix(outputColor, vec4(lights.fogParams.color, 1.0), getFogFactor(lights.fogParams, fogCoordinate));
     }
 }
\ No newline at end of file
@@ -1,9 +1,9 @@
 #version 440 core
 
+#include "../common/frameConstants.glsl"
+
 uniform struct
 {
-    mat4 projectionMatrix;
-    mat4 viewMatrix;
     mat4 modelMatrix;
     mat3 normalMatrix;
 } matrices;
@@ -19,8 +19,8 @@ smooth out vec4 ioEyeSpacePosition;
 
 void main()
 {
-    mat4 mvMatrix = matrices.viewMatrix * matrices.modelMatrix;
-    mat4 mvpMatrix = matrices.projectionMatrix * mvMatrix;
+    mat4 mvMatrix = frameConstants.viewMatrix * matrices.modelMatrix;
+    mat4 mvpMatrix = frameConstants.projectionMatrix * mvMatrix;
     gl_Position = mvpMatrix * vec4(vertexPosition, 1.0);
     
     ioVertexTexCoord = vertexTexCoord;
@@ -0,0 +1,22 @@
+#version 440 core
+
+#include "../common/frameConstants.glsl"
+
+layout(location = 0) in vec3 vertexPosition;
+layout(location = 1) in vec2 vertexTexCoord;
+layout(location = 2) in vec3 vertexNormal;
+layout(location = 4) in mat4 instanceModelMatrix; // Per-instance attribute, occupies locations 4 - 7
+
+smooth out vec2 ioVertexTexCoord;
+smooth out vec3 ioVertexNormal;
+
+void main()
+{
+	mat4 mvpMatrix = frameConstants.projectionMatrix * frameConstants.viewMatrix * instanceModelMatrix;
+	gl_Position = mvpMatrix * vec4(vertexPosition, 1.0);
+	ioVertexTexCoord = vertexTexCoord;
+
+	// Normal matrix is derived per vertex, which is still far cheaper than a draw call per instance
+	mat3 normalMatrix = transpose(inverse(mat3(instanceModelMatrix)));
+	ioVertexNormal = normalMatrix*vertexNormal;
+}
@@ -0,0 +1,23 @@
+#version 440 core
+
+#include "ambientLight.frag"
+#include "diffuseLight.frag"
+#include "pointLight.frag"
+#include "../fog/fog.frag"
+
+#include_part
+
+// Has to match UniformBlockManager::MAX_POINT_LIGHTS
+#define MAX_POINT_LIGHTS 32
+
+// Lights of the scene shared by all shader programs, uploaded by UniformBlockManager whenever they change
+layout(std140, binding = 1) uniform LightsBlock
+{
+    AmbientLight ambientLight;
+    DiffuseLight diffuseLight;
+    FogParameters fogParams;
+    int numPointLights;
+    PointLight pointLights[MAX_POINT_LIGHTS];
+} lights;
+
+#definition_part
@@ -0,0 +1,6 @@
+#version 440 core
+
+// Color writes are disabled while the boxes are rendered, only passed samples are counted
+void main()
+{
+}
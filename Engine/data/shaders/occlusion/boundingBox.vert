@@ -0,0 +1,15 @@
+#version 440 core
+
+#include "../common/frameConstants.glsl"
+
+layout(location = 0) in vec3 vertexPosition; // Vertex of unit cube centered at origin
+
+uniform vec3 boundsMin;
+uniform vec3 boundsMax;
+
+void main()
+{
+	// Unit cube is stretched to the world space bounding box
+	vec3 worldPosition = mix(boundsMin, boundsMax, vertexPosition + 0.5);
+	gl_Position = frameConstants.projectionMatrix * frameConstants.viewMatrix * vec4(worldPosition, 1.0);
+}
@@ -0,0 +1,13 @@
+#version 440 core
+
+layout(location = 0) out vec4 outputColor;
+
+smooth in vec3 ioDirection;
+
+uniform samplerCube skyboxSampler;
+uniform vec4 color;
+
+void main()
+{
+    outputColor = texture(skyboxSampler, ioDirection)*color;
+}
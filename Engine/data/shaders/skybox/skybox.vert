@@ -0,0 +1,19 @@
+#version 440 core
+
+#include "../common/frameConstants.glsl"
+
+layout(location = 0) in vec3 vertexPosition;
+
+smooth out vec3 ioDirection;
+
+void main()
+{
+    ioDirection = vertexPosition;
+
+    // Translation is removed from the view matrix, so that the skybox always surrounds the camera
+    mat4 rotationViewMatrix = mat4(mat3(frameConstants.viewMatrix));
+    vec4 position = frameConstants.projectionMatrix * rotationViewMatrix * vec4(vertexPosition, 1.0);
+
+    // Setting z to w puts the skybox exactly to the far plane (depth 1.0 after perspective division)
+    gl_Position = position.xyww;
+}
@@ -1,9 +1,9 @@
 #version 440 core
 
+#include "../common/frameConstants.glsl"
+
 uniform struct
 {
-    mat4 projectionMatrix;
-    mat4 viewMatrix;
     mat4 modelMatrix;
 } matrices;
 
@@ -14,7 +14,7 @@ smooth out vec2 ioVertexTexCoord;
 
 void main()
 {
-    mat4 mvpMatrix = matrices.projectionMatrix * matrices.viewMatrix * matrices.modelMatrix;
+    mat4 mvpMatrix = frameConstants.projectionMatrix * frameConstants.viewMatrix * matrices.modelMatrix;
     gl_Position = mvpMatrix * vec4(vertexPosition, 1.0);
     ioVertexTexCoord = vertexTexCoord;
 }
\ No newline at end of file
@@ -1,7 +1,6 @@
 #version 440 core
 
-#include "../lighting/ambientLight.frag"
-#include "../lighting/diffuseLight.frag"
+#include "../lighting/lights.glsl"
 
 layout(location = 0) out vec4 outputColor;
 
@@ -11,15 +10,12 @@ smooth in vec3 ioVertexNormal;
 uniform sampler2D sampler;
 uniform vec4 color;
 
-uniform AmbientLight ambientLight;
-uniform DiffuseLight diffuseLight;
-
 void main()
 {
 	vec3 normal = normalize(ioVertexNormal);
 	vec4 textureColor = texture(sampler, ioVertexTexCoord);
 	vec4 objectColor = textureColor*color;
-	vec3 lightColor = getAmbientLightColor(ambientLight) + getDiffuseLightColor(diffuseLight, normal);
+	vec3 lightColor = getAmbientLightColor(lights.ambientLight) + getDiffuseLightColor(lights.diffuseLight, normal);
 
 	outputColor = objectColor*vec4(lightColor, 1.0);
 }
\ No newline at end of file
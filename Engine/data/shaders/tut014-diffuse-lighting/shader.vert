@@ -1,9 +1,9 @@
 #version 440 core
 
+#include "../common/frameConstants.glsl"
+
 uniform struct
 {
-	mat4 projectionMatrix;
-	mat4 viewMatrix;
 	mat4 modelMatrix;
 	mat3 normalMatrix;
 } matrices;
@@ -17,7 +17,7 @@ smooth out vec3 ioVertexNormal;
 
 void main()
 {
-	mat4 mvpMatrix = matrices.projectionMatrix * matrices.viewMatrix * matrices.modelMatrix;
+	mat4 mvpMatrix = frameConstants.projectionMatrix * frameConstants.viewMatrix * matrices.modelMatrix;
 	gl_Position = mvpMatrix * vec4(vertexPosition, 1.0);
 	ioVertexTexCoord = vertexTexCoord;
 	ioVertexNormal = matrices.normalMatrix*vertexNormal;
@@ -1,13 +1,12 @@
 #version 440 core
 
-#include "../fog/fog.frag"
+#include "../lighting/lights.glsl"
 
 smooth in vec2 ioTexCoord;
 smooth in vec4 ioEyeSpacePosition;
 flat in vec4 ioColor;
 
 uniform sampler2D sampler;
-uniform FogParameters fogParams;
 
 out vec4 outputColor;
 
@@ -17,11 +16,11 @@ void main()
     vec4 inputColor = ioColor;
 
     // If fog is enabled, mix input color with fog
-    if(fogParams.isEnabled)
+    if(lights.fogParams.isEnabled)
     {
         float fogCoordinate = abs(ioEyeSpacePosition.z / ioEyeSpacePosition.w);
-        float fogFactor = getFogFactor(fogParams, fogCoordinate);
-        inputColor = vec4(mix(ioColor.xyz, fogParams.color, fogFactor), ioColor.a * (1.0 - fogFactor));
+        float fogFactor = getFogFactor(lights.fogParams, fogCoordinate);
+        inputColor = vec4(mix(ioColor.xyz, lights.fogParams.color, fogFactor), ioColor.a * (1.0 - fogFactor));
     }
 
     outputColor = vec4(textureColor.xyz, 1.0) * inputColor;
@@ -1,15 +1,18 @@
 #version 440 core
 
+layout (location = 0) in int inType;
 layout (location = 1) in vec3 inPosition;
 layout (location = 3) in float inLifetime;
 layout (location = 4) in float inSize;
 
 out float ioLifetime;
 out float ioSize;
+out int ioType;
 
 void main()
 {
     gl_Position = vec4(inPosition, 1.0);
+    ioType = inType;
     ioLifetime = inLifetime;
     ioSize = inSize;
 }
\ No newline at end of file
@@ -1,9 +1,6 @@
 #version 440 core
 
-#include "../lighting/ambientLight.frag"
-#include "../lighting/diffuseLight.frag"
-#include "../lighting/pointLight.frag"
-#include "../fog/fog.frag"
+#include "../lighting/lights.glsl"
 
 layout(location = 0) out vec4 outputColor;
 
@@ -12,10 +9,7 @@ smooth in vec3 ioVertexNormal;
 smooth in vec4 ioWorldPosition;
 smooth in vec4 ioEyeSpacePosition;
 
-uniform AmbientLight ambientLight;
-uniform DiffuseLight diffuseLight;
 uniform PointLight firePointLight;
-uniform FogParameters fogParams;
 
 uniform sampler2D snowSampler;
 uniform sampler2D pathSampler;
@@ -32,14 +26,14 @@ void main()
     float snowWeight = 1.0 - pathWeight;
     vec4 groundColor = pavementTexel*pathWeight + snowTexel*snowWeight;
 
-    vec3 lightColor = getAmbientLightColor(ambientLight) + getDiffuseLightColor(diffuseLight, normal) + getPointLightColor(firePointLight, ioWorldPosition.xyz, normal);
+    vec3 lightColor = getAmbientLightColor(lights.ambientLight) + getDiffuseLightColor(lights.diffuseLight, normal) + getPointLightColor(firePointLight, ioWorldPosition.xyz, normal);
 
     outputColor = groundColor*vec4(lightColor, 1.0);
     
     // Apply fog calculation only if fog is enabled
-    if(fogParams.isEnabled)
+    if(lights.fogParams.isEnabled)
     {
         float fogCoordinate = abs(ioEyeSpacePosition.z / ioEyeSpacePosition.w);
-        outputColor = mix(outputColor, vec4(fogParams.color, 1.0), getFogFactor(fogParams, fogCoordinate));
+        outputColor = mix(outputColor, vec4(lights.fogParams.color, 1.0), getFogFactor(lights.fogParams, fogCoordinate));
     }
 }
\ No newline at end of file
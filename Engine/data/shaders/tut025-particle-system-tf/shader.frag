@@ -1,9 +1,6 @@
 #version 440 core
 
-#include "../lighting/ambientLight.frag"
-#include "../lighting/diffuseLight.frag"
-#include "../lighting/pointLight.frag"
-#include "../fog/fog.frag"
+#include "../lighting/lights.glsl"
 
 layout(location = 0) out vec4 outputColor;
 
@@ -15,34 +12,25 @@ smooth in vec4 ioEyeSpacePosition;
 uniform sampler2D sampler;
 uniform vec4 color;
 
-uniform AmbientLight ambientLight;
-uniform DiffuseLight diffuseLight;
 uniform PointLight firePointLight;
 
-uniform FogParameters fogParams;
 uniform vec3 eyePosition;
 
-uniform int numPointLights;
-layout(std140, binding = 1) uniform PointLightsBlock
-{
-    PointLight lights[150];
-} block_pointLights;
-
 void main()
 {
     vec3 normal = normalize(ioVertexNormal);
     vec4 textureColor = texture(sampler, ioVertexTexCoord);
     vec4 objectColor = textureColor*color;
-    vec3 ambientColor = getAmbientLightColor(ambientLight);
-    vec3 diffuseColor = getDiffuseLightColor(diffuseLight, normal);
+    vec3 ambientColor = getAmbientLightColor(lights.ambientLight);
+    vec3 diffuseColor = getDiffuseLightColor(lights.diffuseLight, normal);
 	vec3 lightColor = ambientColor + diffuseColor + getPointLightColor(firePointLight, ioWorldPosition.xyz, normal);
 
     outputColor = objectColor * vec4(lightColor, 1.0);
 
     // Apply fog calculation only if fog is enabled
-    if(fogParams.isEnabled)
+    if(lights.fogParams.isEnabled)
     {
         float fogCoordinate = abs(ioEyeSpacePosition.z / ioEyeSpacePosition.w);
-        outputColor = mix(outputColor, vec4(fogParams.color, 1.0), getFogFactor(fogParams, fogCoordinate));
+        outputColor = mix(outputColor, vec4(lights.fogParams.color, 1.0), getFogFactor(lights.fogParams, fogCoordinate));
     }
 }
\ No newline at end of file
@@ -1,10 +1,6 @@
 #version 440 core
 
-layout(std140, binding = 0) uniform MatricesBlock
-{
-    mat4 projectionMatrix;
-    mat4 viewMatrix;
-} block_matrices;
+#include "../common/frameConstants.glsl"
 
 uniform struct
 {
@@ -23,8 +19,8 @@ smooth out vec4 ioEyeSpacePosition;
 
 void main()
 {
-    mat4 mvMatrix = block_matrices.viewMatrix * matrices.modelMatrix;
-    mat4 mvpMatrix = block_matrices.projectionMatrix * mvMatrix;
+    mat4 mvMatrix = frameConstants.viewMatrix * matrices.modelMatrix;
+    mat4 mvpMatrix = frameConstants.projectionMatrix * mvMatrix;
     gl_Position = mvpMatrix * vec4(vertexPosition, 1.0);
     
     // Output all out variables
@@ -1,9 +1,8 @@
 #version 440 core
 
-#include "../fog/fog.frag"
+#include "../lighting/lights.glsl"
 
 uniform sampler2D gSampler;
-uniform FogParameters fogParams;
 
 smooth in vec2 ioTexCoord;
 smooth in vec4 ioEyeSpacePosition;
@@ -17,11 +16,11 @@ void main()
     vec4 inputColor = ioColor;
 
     // If fog is enabled, mix input color with fog
-    if(fogParams.isEnabled)
+    if(lights.fogParams.isEnabled)
     {
         float fogCoordinate = abs(ioEyeSpacePosition.z / ioEyeSpacePosition.w);
-        float fogFactor = getFogFactor(fogParams, fogCoordinate);
-        inputColor = vec4(mix(ioColor.xyz, fogParams.color, fogFactor), ioColor.a * (1.0-fogFactor));
+        float fogFactor = getFogFactor(lights.fogParams, fogCoordinate);
+        inputColor = vec4(mix(ioColor.xyz, lights.fogParams.color, fogFactor), ioColor.a * (1.0-fogFactor));
     }
 
     outputColor = vec4(vTexColor.xyz, 1.0) * inputColor;
@@ -1,5 +1,6 @@
 #version 440 core
 
+layout (location = 0) in int inType;
 layout (location = 1) in vec3 inPosition;
 layout (location = 2) in float inSize;
 layout (location = 3) in float inAlpha;
@@ -8,10 +9,12 @@ layout (location = 4) in int inSnowflakeIndex;
 out float ioSize;
 out float ioAlpha;
 out int ioSnowflakeIndex;
+out int ioType;
 
 void main()
 {
     gl_Position = vec4(inPosition, 1.0);
+    ioType = inType;
     ioSize = inSize;
     ioAlpha = inAlpha;
     ioSnowflakeIndex = inSnowflakeIndex;
@@ -1,9 +1,10 @@
 #version 440 core
 
+#include "../common/frameConstants.glsl"
+#include "../common/md2Normals.glsl"
+
 uniform struct
 {
-    mat4 projectionMatrix;
-    mat4 viewMatrix;
     mat4 modelMatrix;
     mat3 normalMatrix;
 } matrices;
@@ -21,13 +22,37 @@ smooth out vec4 ioEyeSpacePosition;
 
 uniform float interpolationFactor;
 
+// If enabled, positions are quantized coordinates and normals hold just the normal index (in x)
+uniform struct
+{
+    int enabled;
+    vec3 scale;
+    vec3 translate;
+    vec3 nextScale;
+    vec3 nextTranslate;
+    mat4 transformMatrix; // Model transformation applied at load time otherwise
+    mat3 normalMatrix;
+} quantizedFrames;
+
 void main()
 {
-    mat4 mvMatrix = matrices.viewMatrix * matrices.modelMatrix;
-    mat4 mvpMatrix = matrices.projectionMatrix * mvMatrix;
+    mat4 mvMatrix = frameConstants.viewMatrix * matrices.modelMatrix;
+    mat4 mvpMatrix = frameConstants.projectionMatrix * mvMatrix;
+
+    vec3 position = vertexPosition;
+    vec3 normal = vertexNormal;
+    vec3 nextPosition = nextVertexPosition;
+    vec3 nextNormal = nextVertexNormal;
+    if (quantizedFrames.enabled != 0)
+    {
+        position = (quantizedFrames.transformMatrix * vec4(quantizedFrames.translate + vertexPosition*quantizedFrames.scale, 1.0)).xyz;
+        nextPosition = (quantizedFrames.transformMatrix * vec4(quantizedFrames.nextTranslate + nextVertexPosition*quantizedFrames.nextScale, 1.0)).xyz;
+        normal = quantizedFrames.normalMatrix * MD2_NORMALS[min(int(vertexNormal.x), 161)];
+        nextNormal = quantizedFrames.normalMatrix * MD2_NORMALS[min(int(nextVertexNormal.x), 161)];
+    }
 
-    vec4 interpolatedPosition = vec4(vertexPosition + (nextVertexPosition - vertexPosition)*interpolationFactor, 1.0);
-    vec3 interpolatedNormal = vertexNormal + (nextVertexNormal - vertexNormal)*interpolationFactor;
+    vec4 interpolatedPosition = vec4(position + (nextPosition - position)*interpolationFactor, 1.0);
+    vec3 interpolatedNormal = normal + (nextNormal - normal)*interpolationFactor;
     gl_Position = mvpMatrix*interpolatedPosition;
     ioVertexTexCoord = vertexTexCoord;
     ioEyeSpacePosition = mvMatrix * interpolatedPosition;
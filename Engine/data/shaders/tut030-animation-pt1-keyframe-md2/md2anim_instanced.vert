@@ -0,0 +1,73 @@
+#version 440 core
+
+#include "../common/frameConstants.glsl"
+#include "../common/md2Normals.glsl"
+
+layout (location = 0) in int frameVertexIndex;
+layout (location = 1) in vec2 vertexTexCoord;
+layout (location = 4) in mat4 instanceModelMatrix; // Per-instance attribute, occupies locations 4 - 7
+layout (location = 8) in ivec2 instanceFrames; // Per-instance current and next frame
+layout (location = 9) in float instanceInterpolationFactor; // Per-instance interpolation factor
+
+// Positions and normals of all frames, frame vertex occupies two consecutive texels (position, normal)
+layout (binding = 1) uniform samplerBuffer frameData;
+uniform int numFrameVertices;
+
+// Quantized frames have one texel per frame vertex (coordinates + normal index), scale and translation
+// of the frame are two consecutive texels of frameTransforms
+layout (binding = 2) uniform usamplerBuffer quantizedFrameData;
+layout (binding = 3) uniform samplerBuffer frameTransforms;
+
+uniform struct
+{
+    int enabled;
+    mat4 transformMatrix; // Model transformation applied at load time otherwise
+    mat3 normalMatrix;
+} quantizedFrames;
+
+smooth out vec2 ioVertexTexCoord;
+smooth out vec3 ioVertexNormal;
+smooth out vec4 ioWorldPosition;
+smooth out vec4 ioEyeSpacePosition;
+
+void main()
+{
+    vec3 vertexPosition;
+    vec3 vertexNormal;
+    vec3 nextVertexPosition;
+    vec3 nextVertexNormal;
+    if (quantizedFrames.enabled != 0)
+    {
+        uvec4 vertex = texelFetch(quantizedFrameData, instanceFrames.x * numFrameVertices + frameVertexIndex);
+        uvec4 nextVertex = texelFetch(quantizedFrameData, instanceFrames.y * numFrameVertices + frameVertexIndex);
+        vec3 position = texelFetch(frameTransforms, 2 * instanceFrames.x + 1).xyz + vec3(vertex.xyz) * texelFetch(frameTransforms, 2 * instanceFrames.x).xyz;
+        vec3 nextPosition = texelFetch(frameTransforms, 2 * instanceFrames.y + 1).xyz + vec3(nextVertex.xyz) * texelFetch(frameTransforms, 2 * instanceFrames.y).xyz;
+        vertexPosition = (quantizedFrames.transformMatrix * vec4(position, 1.0)).xyz;
+        nextVertexPosition = (quantizedFrames.transformMatrix * vec4(nextPosition, 1.0)).xyz;
+        vertexNormal = quantizedFrames.normalMatrix * MD2_NORMALS[min(vertex.w, 161u)];
+        nextVertexNormal = quantizedFrames.normalMatrix * MD2_NORMALS[min(nextVertex.w, 161u)];
+    }
+    else
+    {
+        int currentTexel = 2 * (instanceFrames.x * numFrameVertices + frameVertexIndex);
+        int nextTexel = 2 * (instanceFrames.y * numFrameVertices + frameVertexIndex);
+        vertexPosition = texelFetch(frameData, currentTexel).xyz;
+        vertexNormal = texelFetch(frameData, currentTexel + 1).xyz;
+        nextVertexPosition = texelFetch(frameData, nextTexel).xyz;
+        nextVertexNormal = texelFetch(frameData, nextTexel + 1).xyz;
+    }
+
+    mat4 mvMatrix = frameConstants.viewMatrix * instanceModelMatrix;
+    mat4 mvpMatrix = frameConstants.projectionMatrix * mvMatrix;
+
+    vec4 interpolatedPosition = vec4(mix(vertexPosition, nextVertexPosition, instanceInterpolationFactor), 1.0);
+    vec3 interpolatedNormal = mix(vertexNormal, nextVertexNormal, instanceInterpolationFactor);
+    gl_Position = mvpMatrix*interpolatedPosition;
+    ioVertexTexCoord = vertexTexCoord;
+    ioEyeSpacePosition = mvMatrix * interpolatedPosition;
+
+    // Normal matrix is derived per vertex, which is still far cheaper than a draw call per instance
+    mat3 normalMatrix = transpose(inverse(mat3(instanceModelMatrix)));
+    ioVertexNormal = normalMatrix * interpolatedNormal;
+    ioWorldPosition = instanceModelMatrix * interpolatedPosition;
+}
@@ -0,0 +1,144 @@
+#pragma once
+
+// STL
+#include <string>
+#include <vector>
+#include <cstdint>
+
+// GLM
+#include <glm/glm.hpp>
+
+// Project
+#include "md2model.h"
+
+namespace opengl4_mbsoftworks {
+namespace common_classes {
+namespace animated_meshes_3D {
+
+/**
+ * Animates many instances of one MD2 model at once (crowds). Animations are registered once and referred to
+ * by integer IDs, instance states are kept as structure of arrays holding only running time and copied animation
+ * parameters. Frames are computed in closed form from the running time (no loop over skipped frames), in chunks
+ * on multiple threads with AVX2 kernels (if the CPU supports them). Results are written straight into the mapped
+ * instance buffer owned by the system, which the model renders the instances from.
+ */
+class MD2AnimationSystem
+{
+public:
+    static const int MIN_INSTANCES_PER_THREAD{ 16384 }; // Instance update is just a few dozen instructions, so one thread gets at least this many
+
+    /**
+     * Creates animation system for instances of the model. Model must outlive the animation system and it must be
+     * loaded with instanced rendering enabled.
+     *
+     * @param model  Model, whose instances are animated and rendered
+     */
+    explicit MD2AnimationSystem(MD2Model& model);
+    ~MD2AnimationSystem();
+
+    MD2AnimationSystem(const MD2AnimationSystem&) = delete;
+    void operator=(const MD2AnimationSystem&) = delete;
+
+    /**
+     * Registers animation of the model, so that it can be assigned to the instances.
+     *
+     * @param animationName  Name of the animation of the model
+     * @param loop           True if the animation should run in loop
+     * @param fps            Frames per second (0 means default speed of the animation)
+     *
+     * @return ID of the animation or -1, if model has no such animation.
+     */
+    int addAnimation(const std::string& animationName, bool loop = true, size_t fps = 0);
+
+    /**
+     * Gets ID of the animation registered first with given name or -1, if there is none.
+     */
+    int getAnimationId(const std::string& animationName) const;
+
+    /**
+     * Adds new instance of the model.
+     *
+     * @param modelMatrix  Model matrix of the instance
+     * @param animationId  ID of the animation the instance runs
+     * @param startTime    Running time of the animation (so that instances don't move in sync)
+     *
+     * @return Index of the instance or -1, if animation ID is not valid.
+     */
+    int addInstance(const glm::mat4& modelMatrix, int animationId, float startTime = 0.0f);
+
+    /**
+     * Starts another animation on the instance (from the beginning).
+     */
+    void setInstanceAnimation(int instanceIndex, int animationId);
+
+    void setInstanceModelMatrix(int instanceIndex, const glm::mat4& modelMatrix);
+
+    void clearInstances();
+
+    /**
+     * Advances animations of all instances and writes their model matrices, frames and interpolation factors
+     * into the instance buffer (it's mapped for the time of the update). Requires OpenGL context.
+     *
+     * @param deltaTime  Time passed since last update (in seconds)
+     */
+    void updateAnimations(float deltaTime);
+
+    /**
+     * Renders instances written by the last update with a single instanced draw (see MD2Model::renderModelInstancedFromBuffer).
+     */
+    void renderInstances();
+
+    /**
+     * Switches between AVX2 and scalar kernel of the update. AVX2 kernel runs only on CPUs supporting it
+     * (see cpu_utils::isAvx2Supported), results of both kernels are the same.
+     */
+    void setSimdEnabled(bool simdEnabled);
+    bool isSimdEnabled() const;
+
+    /**
+     * Limits number of chunks the update is split into (0 lets the update use all hardware threads).
+     */
+    void setMaxThreads(int maxThreads);
+
+    int getNumInstances() const;
+
+private:
+    /**
+     * Parameters of the registered animation.
+     */
+    struct Animation
+    {
+        std::string name; // Name of the animation of the model
+        int32_t startFrame{ 0 }; // First frame of the animation
+        int32_t numFrames{ 0 }; // Number of frames of the animation
+        float fps{ 0.0f }; // Frames per second
+        bool loop{ true }; // True if the animation runs in loop
+    };
+
+    /**
+     * Advances animations of instances in range [begin, end) and writes them into the instance data.
+     */
+    void updateChunk(int begin, int end, float deltaTime, MD2Model::InstanceData* instanceData);
+
+    MD2Model& model_; // Model, whose instances are animated
+    std::vector<Animation> animations_; // Registered animations, index is the animation ID
+
+    // Instance states as structure of arrays, animation parameters are copied to avoid gathers in the kernels
+    std::vector<int32_t> animationIds_; // ID of the running animation
+    std::vector<float> runningTimes_; // Running time of the animation (wrapped to one cycle for looping animations)
+    std::vector<int32_t> startFrames_; // First frame of the running animation
+    std::vector<int32_t> numFrames_; // Number of frames of the running animation
+    std::vector<float> fps_; // Frames per second of the running animation
+    std::vector<int32_t> loopMasks_; // All bits set if the running animation loops, zero otherwise
+    std::vector<glm::mat4> modelMatrices_; // Model matrix of the instance
+
+    VertexBufferObject vboInstances_; // Instance data written by the last update, sourced by the instanced draw
+    int numUploadedInstances_{ 0 }; // Number of instances written into the instance buffer by the last update
+
+    bool isSimdEnabled_{ true }; // True, if AVX2 kernels should be used
+    int maxThreads_{ 0 }; // Maximal number of threads used for the update (0 means number of hardware threads)
+};
+
+} // namespace animated_meshes_3D
+} // namespace common_classes
+} // namespace opengl4_mbsoftworks
@@ -14,6 +14,8 @@
 // Project
 #include "../../common_classes/vertexBufferObject.h"
 #include "../../common_classes/texture.h"
+#include "../../common_classes/renderQueue.h"
+#include "../../common_classes/shaderProgram.h"
 
 namespace opengl4_mbsoftworks {
 namespace common_classes {
@@ -45,8 +47,23 @@ public:
         void updateAnimation(float deltaTime);
     };
 
+    /**
+     * Per-instance data of instanced (crowd) rendering, streamed into per-instance vertex attributes.
+     */
+    struct InstanceData
+    {
+        glm::mat4 modelMatrix{ 1.0f }; // Model matrix of the instance
+        int32_t currentFrame{ 0 }; // Frame interpolated from
+        int32_t nextFrame{ 0 }; // Frame interpolated to
+        float interpolationFactor{ 0.0f }; // Interpolation factor between the two frames
+    };
+
+    static const std::string SHADER_PROGRAM_KEY; // Key of the shader program for rendering single model (md2anim.vert)
+    static const std::string INSTANCED_SHADER_PROGRAM_KEY; // Key of the shader program for instanced rendering (md2anim_instanced.vert)
+
     MD2Model() = default;
-    explicit MD2Model(const std::string& filePath, const glm::mat4& modelTransformMatrix = glm::mat4(1.0f));
+    explicit MD2Model(const std::string& filePath, const glm::mat4& modelTransformMatrix = glm::mat4(1.0f), bool keepFramesQuantized = false,
+        bool enableInstancedRendering = false);
 
     MD2Model& operator=(const MD2Model& other) = delete; // Don't allow copy constructor
     MD2Model& operator=(const MD2Model&& other) = delete; // Don't allow move constructor
@@ -55,13 +72,74 @@ public:
     
     ~MD2Model();
 
-    void loadModel(const std::string& filePath, const glm::mat4& modelTransformMatrix = glm::mat4(1.0f));
+    /**
+     * Loads MD2 model from file together with its skin texture (same file name with image extension).
+     *
+     * @param filePath              Path to the MD2 file
+     * @param modelTransformMatrix  Transformation applied to all vertices of the model
+     * @param keepFramesQuantized   True to keep frames as in the file (4 bytes per vertex instead of 24) and decode them
+     *                              in the vertex shader, model transformation is then applied in the shader as well
+     * @param enableInstancedRendering  True to also build triangle list and frame data texture buffer for instanced rendering
+     *                                  (frames are then on the GPU once more, so enable it only for models rendered as crowds)
+     */
+    void loadModel(const std::string& filePath, const glm::mat4& modelTransformMatrix = glm::mat4(1.0f), bool keepFramesQuantized = false,
+        bool enableInstancedRendering = false);
     bool isLoaded() const;
+
+    /**
+     * Checks, if the model has been loaded with instanced rendering enabled.
+     */
+    bool isInstancedRenderingEnabled() const;
     void useQuake2AnimationList();
 
     void renderModelAnimated(const AnimationState& animationState);
     void renderModelStatic();
 
+    /**
+     * Renders many instances of the model, each in its own animation state, with a single instanced draw.
+     * Instances are drawn from indexed triangle list built at load time, vertex shader fetches positions
+     * and normals of both frames from the frame data texture buffer. Model must be loaded with instanced rendering
+     * enabled and INSTANCED_SHADER_PROGRAM_KEY program must be used and set up by the caller.
+     *
+     * @param instances     Pointer to the data of all instances
+     * @param numInstances  Number of instances to render
+     */
+    void renderModelInstanced(const InstanceData* instances, size_t numInstances);
+
+    /**
+     * Renders many instances of the model, each in its own animation state, with a single instanced draw.
+     *
+     * @param instances  Data of all instances
+     */
+    void renderModelInstanced(const std::vector<InstanceData>& instances);
+
+    /**
+     * Renders many instances of the model with a single instanced draw, instance data are sourced directly
+     * from given buffer (e.g. written there by MD2AnimationSystem) instead of being uploaded first.
+     *
+     * @param instanceBufferID  OpenGL buffer holding tightly packed InstanceData of all instances
+     * @param numInstances      Number of instances to render
+     */
+    void renderModelInstancedFromBuffer(GLuint instanceBufferID, size_t numInstances);
+
+    /**
+     * Gets instance data rendering the model in given animation state.
+     *
+     * @param modelMatrix     Model matrix of the instance
+     * @param animationState  Animation state to render the instance in
+     */
+    InstanceData getInstanceData(const glm::mat4& modelMatrix, const AnimationState& animationState) const;
+
+    /**
+     * Submits animated model to the render queue. Caller sets model matrix of the packet, model adds
+     * MD2 shader program, its skin texture, VAO and the draw call. Model must outlive the flush of the queue.
+     *
+     * @param renderQueue     Render queue to submit the model to
+     * @param packet          Draw packet with model matrix set
+     * @param animationState  Animation state to render the model in
+     */
+    void submitAnimated(RenderQueue& renderQueue, RenderQueue::DrawPacket packet, const AnimationState& animationState);
+
     const std::vector<std::string>& getAnimationNames();
     
     AnimationState startAnimation(const std::string& animationName, bool loop = true, size_t fps = 0) const;
@@ -73,6 +151,7 @@ private:
     static constexpr int MD2_VERSION = 8;
     static constexpr int ANORMS_TABLE_SIZE = 162;
     static constexpr int MAX_MD2_VERTICES = 2048;
+    static constexpr int MIN_FRAMES_PER_THREAD = 16; // Frames decoded by one thread at least when loading the model
 
     static constexpr int POSITION_ATTRIBUTE_INDEX = 0;
     static constexpr int TEXTURE_COORDINATE_ATTRIBUTE_INDEX = 1;
@@ -80,6 +159,15 @@ private:
     static constexpr int NEXT_POSITION_ATTRIBUTE_INDEX = 3;
     static constexpr int NEXT_NORMAL_ATTRIBUTE_INDEX = 4;
 
+    static constexpr int FRAME_VERTEX_INDEX_ATTRIBUTE_INDEX = 0; // Index of the vertex within the frame (instanced rendering)
+    static constexpr int INSTANCE_MATRIX_ATTRIBUTE_INDEX = 4; // Per-instance model matrix, occupies 4 - 7
+    static constexpr int INSTANCE_FRAMES_ATTRIBUTE_INDEX = 8; // Per-instance current and next frame
+    static constexpr int INSTANCE_INTERPOLATION_ATTRIBUTE_INDEX = 9; // Per-instance interpolation factor
+    static constexpr int INSTANCE_DATA_BUFFER_BINDING = 4; // Vertex buffer binding point of per-instance data (attributes 4 - 9 read from it)
+    static constexpr GLuint FRAME_DATA_TEXTURE_UNIT = 1; // Texture unit of the frame data texture buffer (skin uses unit 0)
+    static constexpr GLuint QUANTIZED_FRAME_DATA_TEXTURE_UNIT = 2; // Texture unit of the quantized frame data texture buffer
+    static constexpr GLuint FRAME_TRANSFORMS_TEXTURE_UNIT = 3; // Texture unit of the scale and translation of quantized frames
+
     static const glm::vec3 ANORMS_TABLE[ANORMS_TABLE_SIZE];
 
     // md2 header
@@ -123,11 +211,11 @@ private:
         MD2Vertex vertices[1]; // first vertex of this frame
     };
 
-    struct RenderCommandOpenGL
+    // Vertex of the indexed triangle list for instanced rendering, unique pair of frame vertex and texture coordinate
+    struct InstancedVertex
     {
-        GLenum renderMode{ 0 };
-        std::vector<int32_t> vertexIndex;
-        std::vector<glm::vec2> textureCoordinates;
+        glm::vec2 textureCoordinate;
+        int32_t frameVertexIndex;
     };
 
     struct Animation
@@ -150,6 +238,22 @@ private:
     std::vector<GLsizei> numRenderVertices; // with number of vertices
     size_t verticesPerFrame_ { 0 }; // Number of vertices stored per frame that cover whole rendering process
 
+    bool isFrameQuantized_{ false }; // True if frames are kept as in the file (MD2Vertex) and decoded in the vertex shader
+    glm::mat4 modelTransformMatrix_{ 1.0f }; // Transformation applied to all vertices (in the vertex shader for quantized frames)
+    std::vector<glm::vec3> frameScales_; // Scale of every quantized frame
+    std::vector<glm::vec3> frameTranslates_; // Translation of every quantized frame
+
+    GLuint instancedVAO_{ 0 }; // VAO for instanced rendering
+    VertexBufferObject vboInstancedVertices_; // Unique vertices of the triangle list (texture coordinate + frame vertex index)
+    VertexBufferObject vboInstancedIndices_; // Indices of the triangle list converted from strips and fans
+    VertexBufferObject vboInstances_; // Per-instance data (created with first instanced render)
+    VertexBufferObject vboFrameData_; // Positions and normals of all frames, interleaved per frame vertex
+    GLuint frameDataTexture_{ 0 }; // Texture buffer over vboFrameData_
+    VertexBufferObject vboFrameTransforms_; // Scale and translation of all quantized frames
+    GLuint frameTransformsTexture_{ 0 }; // Texture buffer over vboFrameTransforms_
+    GLsizei numInstancedIndices_{ 0 }; // Number of indices of the triangle list
+    GLenum instancedIndexType_{ GL_UNSIGNED_SHORT }; // Type of the indices (GL_UNSIGNED_SHORT or GL_UNSIGNED_INT)
+
     Texture skinTexture_;
 
     std::map<std::string, Animation> animations_;
@@ -157,6 +261,47 @@ private:
 
     void setupVAO(size_t currentFrame, size_t nextFrame = -1);
 
+    /**
+     * Sets uniforms decoding quantized frames in md2anim.vert (only tells the shader frames are not quantized otherwise).
+     */
+    void setQuantizedFramesUniforms(ShaderProgram& shaderProgram, size_t currentFrame, size_t nextFrame) const;
+
+    /**
+     * Copies header from the file data and validates it (including frames and OpenGL commands ranges) against the file size.
+     *
+     * @return True, if the header is valid or false otherwise.
+     */
+    bool readHeader(const unsigned char* data, size_t fileSize);
+
+    /**
+     * Reads OpenGL commands into render modes, number of vertices of every command and texture coordinates
+     * and frame vertex indices of all command vertices.
+     *
+     * @return True, if all commands and their vertex indices are valid or false otherwise.
+     */
+    bool readRenderCommands(const unsigned char* glCommandsData, std::vector<int32_t>& commandVertexIndices, std::vector<glm::vec2>& textureCoordinates);
+
+    /**
+     * Decodes one frame into its parts of preallocated upload buffers (frames can be decoded in parallel).
+     *
+     * @param frameData             Pointer to the frame in the file data
+     * @param frameIndex            Index of the frame
+     * @param commandVertexIndices  Frame vertex indices of all vertices of OpenGL commands
+     * @param frameVerticesData     Vertices of OpenGL commands for all frames (positions or quantized vertices)
+     * @param normalsData           Normals of OpenGL commands vertices for all frames (not used for quantized frames)
+     * @param instancedFrameData    Frame data for instanced rendering (interleaved position and normal or quantized vertex per frame vertex),
+     *                              nullptr if instanced rendering is not enabled
+     */
+    void decodeFrame(const unsigned char* frameData, size_t frameIndex, const std::vector<int32_t>& commandVertexIndices,
+        unsigned char* frameVerticesData, glm::vec3* normalsData, unsigned char* instancedFrameData);
+
+    /**
+     * Converts rendering commands into indexed triangle list and uploads it together with all frames
+     * (as a texture buffer) for instanced rendering.
+     */
+    void createInstancedRenderingData(const std::vector<int32_t>& commandVertexIndices, const std::vector<glm::vec2>& textureCoordinates,
+        const std::vector<unsigned char>& instancedFrameData);
+
     Animation& addNewAnimation(const std::string& animationName, size_t firstFrame, size_t lastFrame, size_t fps);
     static std::string getAnimationBaseName(const std::string& frameName);
 };
@@ -0,0 +1,115 @@
+#pragma once
+
+// STL
+#include <functional>
+#include <deque>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+
+/**
+ * Singleton class that loads assets asynchronously. CPU-heavy work (decoding images, parsing models,
+ * reading shader sources) runs on worker threads, while the creation of OpenGL objects is queued
+ * to the thread owning the OpenGL context, where it's processed under a per-frame time budget.
+ */
+class AsyncAssetLoader
+{
+public:
+    static const double DEFAULT_FRAME_BUDGET_SECONDS; // Default time spent by processing context tasks every frame
+
+    using FailureCallback = std::function<void(std::exception_ptr)>; // Marks the asset of a failed task as failed (e.g. sets exception of its promise)
+
+    /**
+     * Gets the one and only instance of the async asset loader.
+     */
+    static AsyncAssetLoader& getInstance();
+
+    ~AsyncAssetLoader();
+
+    /**
+     * Submits a task to be executed on one of the worker threads. Worker tasks must not call OpenGL,
+     * they should submit context task for that instead.
+     *
+     * @param task       Task to execute
+     * @param onFailure  Called with the exception thrown by the task (on the context thread, when processing context tasks)
+     */
+    void submitWorkerTask(std::function<void()> task, FailureCallback onFailure = nullptr);
+
+    /**
+     * Submits a task to be executed on the thread owning OpenGL context. Can be called from any thread.
+     *
+     * @param task       Task to execute
+     * @param onFailure  Called with the exception thrown by the task (right after the task, on the context thread)
+     */
+    void submitContextTask(std::function<void()> task, FailureCallback onFailure = nullptr);
+
+    /**
+     * Processes queued context tasks until there are none left or the time budget is exceeded.
+     * At least one task is always processed, so that loading progresses with any budget.
+     * Must be called from the thread owning OpenGL context.
+     *
+     * @param timeBudgetSeconds  How much time can be spent processing the tasks (in seconds)
+     *
+     * @return Number of context tasks processed.
+     */
+    size_t processContextTasks(double timeBudgetSeconds = DEFAULT_FRAME_BUDGET_SECONDS);
+
+    /**
+     * Blocks until all submitted worker and context tasks have finished, processing context tasks
+     * in the meantime. Must be called from the thread owning OpenGL context.
+     */
+    void waitForAllTasks();
+
+    /**
+     * Checks, if there are any worker or context tasks that haven't finished yet.
+     */
+    bool hasPendingTasks() const;
+
+    /**
+     * Stops all worker threads and discards tasks that haven't been started yet.
+     */
+    void shutdown();
+
+private:
+    AsyncAssetLoader() {} // Private constructor to make class singleton
+    AsyncAssetLoader(const AsyncAssetLoader&) = delete; // No copy constructor allowed
+    void operator=(const AsyncAssetLoader&) = delete; // No copy assignment allowed
+
+    /**
+     * Starts worker threads, if they are not running yet. Must be called with locked mutex.
+     */
+    void startWorkerThreads();
+
+    /**
+     * Main function of every worker thread - takes tasks from the queue until shutdown.
+     */
+    void workerThreadMain();
+
+    /**
+     * Task waiting in one of the queues together with its failure callback.
+     */
+    struct Task
+    {
+        std::function<void()> function; // Function performing the task
+        FailureCallback onFailure; // Called, when the function throws (may be empty)
+    };
+
+    /**
+     * Executes the task and catches anything it throws, so that a failed asset can't take down the thread
+     * processing the tasks. Failure is logged and returned.
+     *
+     * @return Exception thrown by the task or nullptr, if the task has succeeded.
+     */
+    static std::exception_ptr executeTask(const Task& task);
+
+    mutable std::mutex _mutex; // Mutex guarding both task queues and the counters
+    std::condition_variable _workerCondition; // Wakes workers up, when new task arrives or on shutdown
+    std::condition_variable _contextCondition; // Wakes context thread up, when a context task arrives or worker finishes
+    std::deque<Task> _workerTasks; // Tasks waiting for a worker thread
+    std::deque<Task> _contextTasks; // Tasks waiting for the context thread
+    std::vector<std::thread> _workerThreads; // Running worker threads
+    size_t _numRunningWorkerTasks = 0; // Number of worker tasks being executed right now
+    bool _isShuttingDown = false; // Flag telling the workers to finish
+};
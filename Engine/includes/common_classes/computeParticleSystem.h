@@ -0,0 +1,256 @@
+#pragma once
+
+// STL
+#include <string>
+#include <vector>
+
+// GLAD
+#include <glad/glad.h>
+
+// GLM
+#include <glm/glm.hpp>
+
+// Project
+#include "shaderProgram.h"
+
+/**
+ * Base class of a compute shader based particle system. Particles are stored in two shader storage buffers
+ * (one is read, other one is written during the update) and their count never leaves the GPU - update shader
+ * appends surviving and newly generated particles to the write buffer using an atomic counter (so the buffer
+ * is compacted in the same pass) and small helper passes turn the counter into indirect dispatch and draw commands.
+ * Particle variables are configured the same way as recorded variables of the TransformFeedbackParticleSystem.
+ */
+class ComputeParticleSystem
+{
+public:
+    const static int PARTICLE_TYPE_NORMAL{ 1 }; // Type of all particles (there are no generator particles, type is kept for the render shaders)
+    const static int WORK_GROUP_SIZE{ 256 }; // Number of invocations in a work group of update shaders (must match PARTICLES_WORK_GROUP_SIZE in the shaders)
+    const static int NUM_COUNT_READBACKS{ 4 }; // Number of slots in the ring reading back number of particles
+
+    const static GLuint INPUT_PARTICLES_BINDING{ 0 }; // Shader storage binding point of the read buffer
+    const static GLuint OUTPUT_PARTICLES_BINDING{ 1 }; // Shader storage binding point of the write buffer
+    const static GLuint STATE_BINDING{ 2 }; // Shader storage binding point of the particle system state
+    const static GLuint OUTPUT_COUNTER_BINDING{ 0 }; // Atomic counter binding point of the number of written particles
+
+    static const std::string PREPARE_UPDATE_PROGRAM_KEY; // Holds a key for the program preparing the indirect dispatch (used as shader key too)
+    static const std::string FINISH_UPDATE_PROGRAM_KEY; // Holds a key for the program preparing the indirect draw (used as shader key too)
+    static const std::string RANDOM_SHADER_KEY; // Holds a key for the compute shader with random number generator functions
+
+    struct ShaderConstants
+    {
+        DEFINE_SHADER_UNIFORM(numParticlesToGenerate, "numParticlesToGenerate")
+        DEFINE_SHADER_UNIFORM(numMaxParticles, "numMaxParticles")
+        DEFINE_SHADER_UNIFORM(initialRandomGeneratorSeed, "initialRandomGeneratorSeed")
+    };
+
+    /**
+     * Creates compute particle system instance.
+     *
+     * @param numMaxParticlesInBuffer  Maximal number of particles to be stored in the buffer
+     */
+    ComputeParticleSystem(const int numMaxParticlesInBuffer);
+
+    virtual ~ComputeParticleSystem();
+
+    /**
+     * Initializes particle system. This function must be called after constructing the object
+     * (it's deliberately not called in constructor to prevent virtual method invocation there).
+     *
+     * @return True, if initialization was successful or false otherwise.
+     */
+    bool initialize();
+
+    /**
+     * Renders all particles from the current read buffer. Number of particles is taken by the GPU
+     * from the indirect draw command written during the last update.
+     */
+    void renderParticles();
+
+    /**
+     * Updates all particles in the current read buffer, generates new ones and writes
+     * the survivors into the current write buffer. CPU never waits for the number of particles.
+     *
+     * @param deltaTime  Time passed since last frame (in seconds)
+     */
+    void updateParticles(const float deltaTime);
+
+    /**
+     * Calculates and caches vectors, that can be used for rendering
+     * billboarded particles (so it seems that particles always face you).
+     *
+     * @param cameraViewVector  Normalized view vector of camera
+     * @param cameraUpVector    Normalized up vector of camera
+     */
+    void calculateBillboardingVectors(const glm::vec3& cameraViewVector, const glm::vec3& cameraUpVector);
+
+    /**
+     * Gets maximal number of particles that can be stored in the buffer.
+     * This number is chosen when constructing the particle system.
+     */
+    int getNumMaxParticlesInBuffer() const;
+
+    /**
+     * Gets number of particles stored in the buffer a few frames ago. Number is read back
+     * asynchronously, only once the GPU has it available, so it's meant for display only.
+     */
+    int getNumParticles() const;
+
+    /**
+     * Releases all resources used by the particle system.
+     */
+    virtual void releaseParticleSystem();
+
+protected:
+    /**
+     * Abstract method, purpose of which is to load all shaders and shader programs used by the particle system
+     * and also to set up particle variables. Update program must have the RANDOM_SHADER_KEY compute shader added,
+     * if it uses random numbers, and its Particle struct must declare the variables in the order they are added.
+     */
+    virtual bool initializeShadersAndParticleVariables() = 0;
+
+    /**
+     * Abstract method that gets the linked update shader program. The program declares Particle struct
+     * and includes common/computeParticles.glsl.
+     */
+    virtual ShaderProgram& getUpdateShaderProgram() = 0;
+
+    /**
+     * Abstract method that is called before updating particles. Its responsibility is to use the update
+     * shader program and set up its uniforms (number of particles to generate is set by the base class).
+     *
+     * @param deltaTime  Time passed since last frame (in seconds)
+     *
+     * @return Number of particles to generate during this update.
+     */
+    virtual int prepareUpdateParticles(float deltaTime) = 0;
+
+    /**
+     * Abstract method that is called before rendering particles.
+     * Its responsibility is to use the appropriate shader program
+     * for rendering particles, set it up correctly and generally to set up
+     * anything that's needed for rendering of particles.
+     */
+    virtual void prepareRenderParticles() = 0;
+
+    /**
+     * Adds integer variable of the particle.
+     *
+     * @param name                Name of the variable in the Particle struct
+     * @param neededForRendering  True if this variable is needed for rendering of particles or false otherwise
+     */
+    void addParticleInt(const std::string& name, bool neededForRendering = true);
+
+    /**
+     * Adds float variable of the particle.
+     *
+     * @param name                Name of the variable in the Particle struct
+     * @param neededForRendering  True if this variable is needed for rendering of particles or false otherwise
+     */
+    void addParticleFloat(const std::string& name, bool neededForRendering = true);
+
+    /**
+     * Adds vec3 variable of the particle.
+     *
+     * @param name                Name of the variable in the Particle struct
+     * @param neededForRendering  True if this variable is needed for rendering of particles or false otherwise
+     */
+    void addParticleVec3(const std::string& name, bool neededForRendering = true);
+
+    /**
+     * Generates random number generator seed. This seed is a vec3 with random
+     * float values that can be passed to the shaders for random number generation.
+     */
+    static glm::vec3 generateRandomNumberGeneratorSeed();
+
+    /**
+     * Calculates byte size of particle depending on the particle variables and std430 layout rules.
+     *
+     * @return Size of one particle (in bytes).
+     */
+    GLsizei calculateParticleByteSize() const;
+
+    glm::vec3 billboardHorizontalVector_; // Vector for rendering billboarded particles (horizontal part)
+    glm::vec3 billboardVerticalVector_; // Vector for rendering billboarded particles (vertical part)
+
+private:
+    /**
+     * Helper struct that holds information about variables of the particle.
+     */
+    struct ParticleVariable
+    {
+        std::string name; // Name of the variable in the Particle struct
+        GLenum glType; // Type (GL_INT, GL_FLOAT etc.)
+        GLsizei count; // Count of elements (e.g. vec3 is 3 x GL_FLOAT)
+        bool neededForRendering; // True if this variable is needed for rendering as well (e.g. velocity of particle is not needed)
+        GLsizei byteOffset{ 0 }; // Byte offset of the variable within the particle (std430 layout)
+
+        /**
+         * Gets byte size of the variable.
+         */
+        GLsizei getByteSize() const;
+
+        /**
+         * Gets base alignment of the variable (std430 layout aligns vec3 like vec4).
+         */
+        GLsizei getBaseAlignment() const;
+
+        /**
+         * Enables and sets up vertex attribute pointer of this variable.
+         *
+         * @param index   Index of vertex attribute
+         * @param stride  Stride between two particles
+         */
+        void enableAndSetupVertexAttribPointer(GLuint index, GLsizei stride) const;
+    };
+
+    std::vector<ParticleVariable> particleVariables_; // List of particle variables
+
+    bool isInitialized_{ false }; // Flag telling if the particle system has been initialized
+
+    GLuint particlesBuffers_[2]; // IDs of shader storage buffers for particles, one is used as input and other one is used for output
+    GLuint renderVAOs_[2]; // VAOs for rendering particles for both buffers
+    GLuint stateBufferID_{ 0 }; // ID of buffer with particle counters, indirect dispatch and indirect draw commands
+
+    GLuint countReadbackBufferID_{ 0 }; // ID of buffer the number of particles is copied to for the CPU
+    const GLuint* mappedCountReadbacks_{ nullptr }; // Persistently mapped slots of the readback buffer
+    GLsync countReadbackFences_[NUM_COUNT_READBACKS]{}; // Fences of the copies, whose result hasn't been read yet
+    int nextCountReadbackIndex_{ 0 }; // Index of the readback slot to be used next (it's also the oldest one in the ring)
+
+    int numMaxParticlesInBuffer_; // Holds maximal number of particles stored in the buffers
+    int numberOfParticles_{ 0 }; // Holds number of particles read back from the GPU
+
+    int readBufferIndex_{ 0 }; // Current index of read buffer (write buffer is then 1-readBufferIndex_)
+
+    /**
+     * Loads shaders and links programs shared by all compute particle systems (only once).
+     */
+    static void prepareCommonShaderPrograms();
+
+    /**
+     * Computes std430 byte offsets of all particle variables.
+     */
+    void calculateParticleVariableOffsets();
+
+    /**
+     * Checks, that the Particle struct in the update program has the same layout as the particle variables.
+     *
+     * @return True, if the layouts match or false otherwise.
+     */
+    bool validateParticleLayout();
+
+    /**
+     * Generates all OpenGL objects required for the compute particle system.
+     * This includes particle buffers, state buffer, readback buffer and render VAOs.
+     */
+    void generateOpenGLObjects();
+
+    /**
+     * Copies number of particles into the readback ring, if there is a free slot.
+     */
+    void issueCountReadback();
+
+    /**
+     * Reads numbers of particles, whose copies have finished already (from the oldest one), never blocks.
+     */
+    void collectParticleCount();
+};
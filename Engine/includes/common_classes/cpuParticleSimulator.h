@@ -0,0 +1,177 @@
+#pragma once
+
+// STL
+#include <vector>
+#include <random>
+#include <cstdint>
+
+// GLAD
+#include <glad/glad.h>
+
+// GLM
+#include <glm/glm.hpp>
+
+/**
+ * CPU implementation of the fire and snow particle systems, it follows the same generation and update rules
+ * as their update shaders, but needs no OpenGL context - it can run in batch jobs, serve as a reference
+ * for the GPU implementations or feed landed particles into erosion. Particles are stored as structure of arrays
+ * and updated in chunks on multiple threads with AVX2 kernels (if the CPU supports them). Dead particles are
+ * removed preserving the order of the survivors, so the results don't depend on the thread count or kernel used.
+ * Particles can be optionally uploaded and rendered with the same render shaders as the GPU particle systems.
+ */
+class CpuParticleSimulator
+{
+public:
+    static const int PARTICLE_TYPE_NORMAL{ 1 }; // Type of all the uploaded particles (render shaders skip generators)
+    static const int MIN_PARTICLES_PER_THREAD{ 16384 }; // Chunks smaller than this are not worth another thread
+    static const float SNOW_FALL_SPEED; // How fast the snow particles fall relatively to their size (same as in the snow shader)
+
+    /**
+     * Which update shader the simulator follows.
+     */
+    enum class ParticleKind
+    {
+        Fire, // Particles fly with constant velocity until their lifetime runs out
+        Snow // Particles fall down with speed depending on their size until they hit the ground (y = 0)
+    };
+
+    /**
+     * Ranges of the properties of newly generated particles, same as the uniforms of the update shaders.
+     * Property is generated as min + range * random number from 0...1.
+     */
+    struct GenerationSettings
+    {
+        glm::vec3 positionMin{ 0.0f };
+        glm::vec3 positionRange{ 0.0f };
+        glm::vec3 velocityMin{ 0.0f }; // Used by fire only
+        glm::vec3 velocityRange{ 0.0f }; // Used by fire only
+        float sizeMin{ 0.0f };
+        float sizeRange{ 0.0f };
+        float lifetimeMin{ 0.0f }; // Used by fire only
+        float lifetimeRange{ 0.0f }; // Used by fire only
+        float alphaMin{ 0.0f }; // Used by snow only
+        float alphaRange{ 0.0f }; // Used by snow only
+    };
+
+    /**
+     * Particles stored as structure of arrays. Arrays not used by the particle kind stay empty.
+     */
+    struct Particles
+    {
+        std::vector<float> positionsX;
+        std::vector<float> positionsY;
+        std::vector<float> positionsZ;
+        std::vector<float> velocitiesX; // Fire only
+        std::vector<float> velocitiesY; // Fire only
+        std::vector<float> velocitiesZ; // Fire only
+        std::vector<float> lifetimes; // Fire only
+        std::vector<float> sizes;
+        std::vector<float> alphas; // Snow only
+        std::vector<int32_t> snowflakeIndices; // Snow only
+    };
+
+    /**
+     * Creates CPU particle simulator. No OpenGL objects are created until the particles are uploaded.
+     *
+     * @param particleKind             Which update shader to follow
+     * @param numMaxParticlesInBuffer  Maximal number of particles (generated particles beyond are dropped)
+     * @param seed                     Seed of the random number generator (same seed gives same particles)
+     */
+    CpuParticleSimulator(ParticleKind particleKind, int numMaxParticlesInBuffer, uint32_t seed = std::mt19937::default_seed);
+    ~CpuParticleSimulator();
+
+    CpuParticleSimulator(const CpuParticleSimulator&) = delete;
+    void operator=(const CpuParticleSimulator&) = delete;
+
+    void setGenerationSettings(const GenerationSettings& generationSettings);
+    const GenerationSettings& getGenerationSettings() const;
+
+    /**
+     * Updates all particles, removes the dead ones and then generates new particles.
+     *
+     * @param deltaTime               Time passed since last update (in seconds)
+     * @param numParticlesToGenerate  How many particles should be generated
+     */
+    void updateParticles(float deltaTime, int numParticlesToGenerate);
+
+    /**
+     * Sets, if AVX2 kernels are used (only if supported by the CPU, see cpu_utils::isAvx2Supported).
+     * Scalar kernels are the reference implementation.
+     */
+    void setSimdEnabled(bool simdEnabled);
+    bool isSimdEnabled() const;
+
+    /**
+     * Sets maximal number of threads used for the update (0 means number of hardware threads).
+     */
+    void setMaxThreads(int maxThreads);
+
+    /**
+     * Sets, if positions of the particles removed during the update should be recorded. Snow particles are removed
+     * when they land, so their positions can be used e.g. as starting points of erosion droplets.
+     */
+    void setRecordRemovedParticles(bool recordRemovedParticles);
+
+    /**
+     * Gets positions of the particles removed during the last update (if recording is enabled).
+     */
+    const std::vector<glm::vec3>& getRemovedParticlePositions() const;
+
+    const Particles& getParticles() const;
+    int getNumParticles() const;
+    int getNumMaxParticlesInBuffer() const;
+    ParticleKind getParticleKind() const;
+
+    /**
+     * Uploads particles into vertex buffer with the same attribute layout as the render shaders of the kind
+     * (fire_render / snow_render) expect. Requires OpenGL context, OpenGL objects are created with the first upload.
+     */
+    void uploadParticles();
+
+    /**
+     * Renders uploaded particles as points, render shader program must be used and set up by the caller.
+     */
+    void renderParticles() const;
+
+    /**
+     * Deletes OpenGL objects created by uploading (call before the OpenGL context is destroyed).
+     */
+    void releaseUploadedParticles();
+
+private:
+    /**
+     * Range of particles processed by one thread.
+     */
+    struct Chunk
+    {
+        int begin{ 0 }; // Index of the first particle of the chunk
+        int end{ 0 }; // Index after the last particle of the chunk
+        int numAlive{ 0 }; // Number of particles left at the beginning of the chunk after the update
+        std::vector<glm::vec3> removedPositions; // Positions of particles removed from the chunk
+    };
+
+    /**
+     * Updates particles of the chunk and moves survivors to the beginning of the chunk.
+     */
+    void updateChunk(Chunk& chunk, float deltaTime);
+
+    /**
+     * Generates new particles at the end of the arrays.
+     */
+    void generateParticles(int numParticlesToGenerate);
+
+    ParticleKind particleKind_; // Which update shader the simulator follows
+    GenerationSettings generationSettings_; // Ranges of properties of generated particles
+    Particles particles_; // All the particles, arrays have size of numMaxParticlesInBuffer_
+    int numParticles_{ 0 }; // Number of particles currently alive
+    int numMaxParticlesInBuffer_; // Maximal number of particles
+    std::mt19937 generator_; // Random number generator of generated particles
+    bool isSimdEnabled_{ true }; // True, if AVX2 kernels should be used
+    int maxThreads_{ 0 }; // Maximal number of threads used for the update (0 means number of hardware threads)
+    bool recordRemovedParticles_{ false }; // True, if positions of removed particles should be recorded
+    std::vector<glm::vec3> removedParticlePositions_; // Positions of particles removed during the last update
+
+    GLuint uploadVAO_{ 0 }; // VAO for rendering the uploaded particles
+    GLuint uploadVBO_{ 0 }; // VBO with the uploaded particles
+    int numUploadedParticles_{ 0 }; // Number of uploaded particles
+};
@@ -0,0 +1,60 @@
+#pragma once
+
+// STL
+#include <vector>
+#include <functional>
+
+// AVX2 kernels are compiled for x86 only, with the target enabled per function (so the rest of the engine doesn't need AVX2).
+// Kernels must be guarded by CPU_UTILS_AVX2_KERNELS and called only if cpu_utils::isAvx2Supported() says so
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define CPU_UTILS_AVX2_KERNELS
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#define AVX2_TARGET
+#else
+#define AVX2_TARGET __attribute__((target("avx2")))
+#endif
+#endif
+
+namespace cpu_utils
+{
+
+/**
+ * Range of items [begin, end) processed by one thread.
+ */
+struct ChunkRange
+{
+    int begin{ 0 }; // Index of the first item of the chunk
+    int end{ 0 }; // Index after the last item of the chunk
+};
+
+/**
+ * Checks, if the CPU (and OS) supports AVX2 instructions. Result is queried once and cached.
+ */
+bool isAvx2Supported();
+
+/**
+ * Splits items into contiguous chunks, one chunk per thread. Number of chunks is limited by the number of threads
+ * and by the minimal number of items per thread, there is always at least one (possibly empty) chunk.
+ *
+ * @param numItems           Number of items to split
+ * @param minItemsPerThread  Chunks smaller than this are not created (another thread would cost more than it saves)
+ * @param maxThreads         Maximal number of chunks (0 means number of hardware threads)
+ * @param chunkAlignment     Chunk sizes are rounded up to multiple of this (e.g. 8, so that only the last chunk has items left for scalar kernels)
+ *
+ * @return Chunks covering all the items in order.
+ */
+std::vector<ChunkRange> splitIntoChunks(int numItems, int minItemsPerThread, int maxThreads = 0, int chunkAlignment = 1);
+
+/**
+ * Processes chunks in parallel on persistent worker threads (created with the first call). Calling thread takes chunks
+ * too and returns after all the chunks have been processed. Exception thrown by a chunk is rethrown on the calling thread
+ * once all the chunks have finished. While another thread uses the workers (or when called from inside of a chunk),
+ * chunks are processed serially on the calling thread.
+ *
+ * @param chunks         Chunks to process (see splitIntoChunks)
+ * @param chunkFunction  Function called with index of the chunk and its range, must not touch items of other chunks
+ */
+void processChunksInParallel(const std::vector<ChunkRange>& chunks, const std::function<void(size_t chunkIndex, const ChunkRange& chunk)>& chunkFunction);
+
+} // namespace cpu_utils
@@ -0,0 +1,67 @@
+#pragma once
+
+// STL
+#include <string>
+#include <fstream>
+#include <functional>
+#include <filesystem>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+namespace file_utils
+{
+
+/**
+ * Gets path of a temporary file next to the given file, unique across threads and processes writing the same file.
+ *
+ * @param filePath  Path to the file the temporary file is for
+ */
+inline std::string getUniqueTemporaryFilePath(const std::string& filePath)
+{
+    static std::atomic<uint64_t> counter{ 0 };
+    const auto threadHash = std::hash<std::thread::id>{}(std::this_thread::get_id());
+    const auto timeStamp = std::chrono::steady_clock::now().time_since_epoch().count();
+    return filePath + "." + std::to_string(threadHash) + "_" + std::to_string(timeStamp) + "_" + std::to_string(counter++) + ".tmp";
+}
+
+/**
+ * Writes the file through a uniquely named temporary file, which replaces the file only when everything has been
+ * written successfully. Readers (even in another process) therefore see either the old or the new file, never
+ * a partially written one.
+ *
+ * @param filePath       Path to the file to write
+ * @param writeFunction  Function writing contents of the file into given stream
+ *
+ * @return True, if the file has been written and replaced successfully or false otherwise.
+ */
+inline bool writeFileAtomically(const std::string& filePath, const std::function<void(std::ostream&)>& writeFunction)
+{
+    const auto temporaryFilePath = getUniqueTemporaryFilePath(filePath);
+    {
+        std::ofstream out(temporaryFilePath, std::ios::binary | std::ios::trunc);
+        if (out) {
+            writeFunction(out);
+        }
+
+        out.close();
+        if (!out)
+        {
+            std::error_code errorCode;
+            std::filesystem::remove(temporaryFilePath, errorCode);
+            return false;
+        }
+    }
+
+    std::error_code errorCode;
+    std::filesystem::rename(temporaryFilePath, filePath, errorCode);
+    if (errorCode)
+    {
+        std::filesystem::remove(temporaryFilePath, errorCode);
+        return false;
+    }
+
+    return true;
+}
+
+} // namespace file_utils
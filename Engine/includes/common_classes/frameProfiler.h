@@ -0,0 +1,165 @@
+#pragma once
+
+// STL
+#include <string>
+#include <vector>
+#include <map>
+#include <chrono>
+#include <cstdint>
+
+// GLAD
+#include <glad/glad.h>
+
+/**
+ * Singleton class measuring named scopes of a frame both on the CPU and on the GPU. GPU times come from pairs
+ * of timestamp queries, which are read back only after several frames through a ring of query sets, so the profiler
+ * never waits for the GPU. Results are kept as rolling history shown in ImGui and can be dumped as Chrome trace JSON.
+ */
+class FrameProfiler
+{
+public:
+    static const int NUM_FRAMES_IN_FLIGHT{ 4 }; // Number of query sets in the ring (frames, after which results are read back)
+    static const int HISTORY_SIZE{ 120 }; // Number of frames kept in rolling history
+
+    /**
+     * Measures a scope for the lifetime of the object (scope begins in constructor and ends in destructor).
+     */
+    class Scope
+    {
+    public:
+        Scope(const std::string& name);
+        ~Scope();
+
+        Scope(const Scope&) = delete;
+        void operator=(const Scope&) = delete;
+    };
+
+    /**
+     * Gets the one and only instance of the frame profiler.
+     */
+    static FrameProfiler& getInstance();
+
+    /**
+     * Starts measuring new frame. Results of the frame measured NUM_FRAMES_IN_FLIGHT frames ago are collected first,
+     * if the GPU hasn't finished them yet, they are dropped rather than waited for.
+     */
+    void beginFrame();
+
+    /**
+     * Ends measuring of the current frame (scopes left open are ended as well).
+     */
+    void endFrame();
+
+    /**
+     * Begins named scope. Scopes can be nested and the same name can be used multiple times per frame
+     * (times of such scopes are summed in the history).
+     *
+     * @param name  Name of the scope
+     */
+    void beginScope(const std::string& name);
+
+    /**
+     * Ends the most recently begun scope.
+     */
+    void endScope();
+
+    /**
+     * Enables or disables profiling. Disabled profiler issues no queries and records nothing.
+     */
+    void setEnabled(bool enabled);
+
+    bool isEnabled() const;
+
+    /**
+     * Renders rolling charts of CPU and GPU times of all scopes into the current ImGui window.
+     */
+    void renderImGui();
+
+    /**
+     * Writes scopes of all frames in the history into Chrome trace JSON file (chrome://tracing or Perfetto UI).
+     * CPU and GPU times are shown as two separate threads.
+     *
+     * @param filePath  Path of the output file
+     *
+     * @return True, if the file has been written correctly or false otherwise.
+     */
+    bool dumpChromeTrace(const std::string& filePath) const;
+
+    /**
+     * Deletes all the OpenGL query objects (call before the OpenGL context is destroyed).
+     */
+    void deleteQueries();
+
+private:
+    FrameProfiler() {} // Private constructor to make class singleton
+    FrameProfiler(const FrameProfiler&) = delete; // No copy constructor allowed
+    void operator=(const FrameProfiler&) = delete; // No copy assignment allowed
+
+    /**
+     * One measured scope of a frame, times are in milliseconds since the profiler has been created.
+     */
+    struct ScopeRecord
+    {
+        std::string name; // Name of the scope
+        int depth{ 0 }; // Nesting depth of the scope
+        double cpuBeginMs{ 0.0 }; // CPU time, when the scope began
+        double cpuEndMs{ 0.0 }; // CPU time, when the scope ended
+        double gpuBeginMs{ 0.0 }; // GPU time, when the scope began (aligned to the CPU begin of the frame)
+        double gpuEndMs{ 0.0 }; // GPU time, when the scope ended (aligned to the CPU begin of the frame)
+        size_t beginQueryIndex{ 0 }; // Index of the timestamp query issued when the scope began
+        size_t endQueryIndex{ 0 }; // Index of the timestamp query issued when the scope ended
+    };
+
+    /**
+     * Query set of one frame in the ring, query objects are reused whenever the set comes around again.
+     */
+    struct FrameRecord
+    {
+        std::vector<ScopeRecord> scopes; // Scopes measured in the frame
+        std::vector<GLuint> queries; // Timestamp query objects owned by the set
+        size_t numUsedQueries{ 0 }; // Number of queries issued in the frame
+        double cpuBeginMs{ 0.0 }; // CPU time, when the frame began
+        bool isPending{ false }; // True, if the frame has ended and its GPU results haven't been collected yet
+    };
+
+    /**
+     * Rolling history of one scope name (values are in milliseconds).
+     */
+    struct ScopeHistory
+    {
+        std::vector<float> cpuMs = std::vector<float>(HISTORY_SIZE, 0.0f); // CPU times of the scope
+        std::vector<float> gpuMs = std::vector<float>(HISTORY_SIZE, 0.0f); // GPU times of the scope
+    };
+
+    /**
+     * Gets CPU time in milliseconds since the profiler has been created.
+     */
+    double getCpuTimeMs() const;
+
+    /**
+     * Issues timestamp query from the query set of the current frame (creates new query object if needed).
+     *
+     * @return Index of the issued query in the query set.
+     */
+    size_t issueTimestampQuery(FrameRecord& frame);
+
+    /**
+     * Collects GPU results of the ended frame and adds the frame into the history. Never blocks.
+     *
+     * @return True, if the results were available or false otherwise.
+     */
+    bool collectFrame(FrameRecord& frame);
+
+    using Clock = std::chrono::steady_clock;
+
+    std::vector<FrameRecord> _frames = std::vector<FrameRecord>(NUM_FRAMES_IN_FLIGHT); // Ring of query sets
+    std::vector<std::vector<ScopeRecord>> _completedFrames; // Scopes of the collected frames (ring of HISTORY_SIZE frames)
+    std::map<std::string, ScopeHistory> _history; // Rolling history of every scope name ever measured
+    std::vector<size_t> _openScopes; // Indices of the scopes of current frame, that haven't ended yet
+    int _historyOffset{ 0 }; // Index in the history, where the next collected frame is written
+    uint64_t _frameIndex{ 0 }; // Index of the current frame
+    uint64_t _numDroppedFrames{ 0 }; // Number of frames, whose GPU results were not ready in time
+    Clock::time_point _creationTime{ Clock::now() }; // Time of creation of the profiler (CPU times are relative to it)
+    bool _isFrameActive{ false }; // True, if a frame is being measured
+    bool _isEnabled{ true }; // True, if the profiler is enabled
+};
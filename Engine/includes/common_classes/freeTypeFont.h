@@ -5,6 +5,13 @@
 #include <string>
 #include <map>
 #include <memory>
+#include <cstdint>
+
+// GLAD
+#include <glad/glad.h>
+
+// GLM
+#include <glm/glm.hpp>
 
 // Project
 #include "vertexBufferObject.h"
@@ -14,7 +21,9 @@
 #include "stringUtils.h"
 
 /**
- * Class for loading and rendering arbitrary TrueType font.
+ * Class for loading and rendering arbitrary TrueType font. Characters are rasterized once into shared texture atlas
+ * pages. Printed text is not rendered immediately - quads of all the texts printed during the frame are gathered
+ * and rendered with one draw per atlas page, when the batch is flushed at the end of the frame.
  */
 class FreeTypeFont
 {
@@ -22,10 +31,19 @@ public:
     static const int CHARACTERS_TEXTURE_SIZE; // Size of texture atlas (in pixels) that stores characters
     static const std::string FREETYPE_FONT_PROGRAM_KEY; // Key for shader program for rendering fonts in 2D
     static const std::string FREETYPE_FONT_SAMPLER_KEY; // Key for sampler used for rendering fonts
+    static const int FAST_LOOKUP_TABLE_SIZE; // Characters with lower codes are looked up directly, without searching the map
 
     FreeTypeFont();
     ~FreeTypeFont();
 
+    FreeTypeFont(const FreeTypeFont&) = delete;
+    void operator=(const FreeTypeFont&) = delete;
+
+    /**
+     * Loads shaders, creates the font shader program (it's linked with all the other programs) and the font sampler.
+     */
+    static void prepareShaderProgram();
+
     /**
      * Adds character range to load from the fonts.
      *
@@ -44,7 +62,8 @@ public:
     bool loadFont(const std::string& fontFilePath, int pixelSize);
 
     /**
-     * Gets width of a given text and given pixel size.
+     * Gets width of a given text and given pixel size. Width is computed from the cached character advances,
+     * so it's cheap and doesn't touch OpenGL. Multiline text has width of its longest line.
      *
      * @param text       Text to get width of
      * @param pixelSize  Used pixel size. If -1, the loaded pixel size is used instead
@@ -71,7 +90,8 @@ public:
 
     /**
      * Template function, that prints text at given position with default (loaded) pixel size.
-     * The text might be formatted using custom formatter defined in string_utils.
+     * The text might be formatted using custom formatter defined in string_utils. Text is only added
+     * to the batch, it appears on the screen after calling flush.
      *
      * @param x     X position of text
      * @param y     Y position of text
@@ -79,7 +99,7 @@ public:
      * @param args  Arbitrary arguments to replace {} placeholders
      */
     template <typename... Args>
-    void print(int x, int y, const std::string& text, const Args&... args) const
+    void print(int x, int y, const std::string& text, const Args&... args)
     {
         printInternal(x, y, string_utils::formatString(text.c_str(), args...), -1);
     }
@@ -95,11 +115,17 @@ public:
      * @param args       Arbitrary arguments to replace {} placeholders
      */
     template <typename... Args>
-    void printWithCustomSize(int x, int y, int pixelSize, const std::string& text, const Args&... args) const
+    void printWithCustomSize(int x, int y, int pixelSize, const std::string& text, const Args&... args)
     {
-        print(x, y, text, pixelSize, string_utils::formatString(text.c_str(), args...));
+        printInternal(x, y, string_utils::formatString(text.c_str(), args...), pixelSize);
     }
 
+    /**
+     * Renders all the text printed since the last flush and clears the batch. Texts are rendered over
+     * the scene with orthographic projection from matrix manager, call it once at the end of the frame.
+     */
+    void flush();
+
     /**
      * Deletes font with all of its data.
      */
@@ -107,14 +133,14 @@ public:
 
 private:
     /**
-     * Prints text at given position with given pixel size.
+     * Adds quads of characters of the text at given position with given pixel size into the batch.
      *
      * @param x          X position of text
      * @param y          Y position of text
      * @param text       Text to print
      * @param pixelSize  Used pixel size. If -1, the loaded pixel size is used instead
      */
-    void printInternal(int x, int y, const std::string& text, int pixelSize) const;
+    void printInternal(int x, int y, const std::string& text, int pixelSize);
 
     /**
      * Gets shader program for rendering FreeType fonts.
@@ -141,10 +167,40 @@ private:
         int bearingY;
 
         // These are our properties used for rendering
-        int renderIndex;
-        int textureIndex;
+        glm::vec2 texCoordMin; // Texture coordinates of the top left corner of the character in the atlas
+        glm::vec2 texCoordMax; // Texture coordinates of the bottom right corner of the character in the atlas
+        int textureIndex; // Index of the atlas page holding the character
+    };
+
+    /**
+     * Vertex of the character quad in the batch.
+     */
+    struct GlyphVertex
+    {
+        glm::vec2 position; // Position on the screen (in pixels)
+        glm::vec2 texCoord; // Texture coordinate in the atlas page
+        uint32_t color; // Color packed as RGBA8 (normalized in the shader)
     };
 
+    /**
+     * Gets properties of the loaded character.
+     *
+     * @param characterCode  Unicode character code
+     *
+     * @return Pointer to the character properties or nullptr, if the character has not been loaded.
+     */
+    const CharacterProperties* getCharacterProperties(unsigned int characterCode) const;
+
+    /**
+     * Decodes next Unicode character from UTF-8 text. Invalid bytes are returned as they are.
+     *
+     * @param text      UTF-8 encoded text
+     * @param position  Position of the next byte to decode, it's moved after the decoded character
+     *
+     * @return Unicode character code.
+     */
+    static unsigned int decodeNextCharacter(const std::string& text, size_t& position);
+
     /**
      * Helper struct that holds unicode character range.
      */
@@ -162,11 +218,16 @@ private:
     
     bool _isLoaded = false; // Flag saying, if the font is loaded already
     std::vector<CharacterRange> _characterRanges; // List of unicode ranges to load characters from
-    int _pixelSize; // Loaded pixel size of characters
+    int _pixelSize = 0; // Loaded pixel size of characters
     glm::vec4 _color = glm::vec4(1.0f, 1.0f, 1.0f, 1.0f);
+    uint32_t _packedColor = 0xFFFFFFFF; // Color of the text packed same way as in the vertices
 
     std::vector<std::unique_ptr<Texture>> _textures; // Vector holding all texture atlases
     std::map<int, CharacterProperties> _characterProperties; // Map holding properties of each loaded character
-    GLuint _vao; // VAO for characters rendering
-    VertexBufferObject _vbo; // VBO holding characters rendering data
+    std::vector<const CharacterProperties*> _fastLookupTable; // Properties of characters with low codes indexed directly by the code
+
+    std::vector<std::vector<GlyphVertex>> _pageVertices; // Vertices printed since the last flush, one vector per atlas page
+    std::vector<GlyphVertex> _batchVertices; // All the vertices ordered by pages, uploaded at once during the flush
+    GLuint _vao = 0; // VAO for characters rendering
+    VertexBufferObject _vbo; // Streaming VBO holding vertices of the batch
 };
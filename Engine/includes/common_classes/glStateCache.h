@@ -0,0 +1,234 @@
+#pragma once
+
+// STL
+#include <array>
+#include <map>
+#include <vector>
+#include <cstdint>
+
+// GLAD
+#include <glad/glad.h>
+
+/**
+ * Singleton class that sits in front of frequently used OpenGL binding, enable / disable and write mask calls
+ * and skips the ones, that would not change the state. All the engine code binding programs, vertex arrays,
+ * textures, samplers and buffers or changing the masks should go through it, otherwise the cached state gets out of sync
+ * (call invalidate after a third party code changes the state without restoring it).
+ */
+class GLStateCache
+{
+public:
+    /**
+     * Gets the one and only instance of the OpenGL state cache.
+     */
+    static GLStateCache& getInstance();
+
+    /**
+     * Makes shader program current (glUseProgram).
+     *
+     * @param programID  OpenGL shader program ID
+     */
+    void useProgram(GLuint programID);
+
+    /**
+     * Binds vertex array object (glBindVertexArray). Element array buffer binding is part of the vertex array state,
+     * so its cached value is forgotten when vertex array changes.
+     *
+     * @param vertexArrayID  OpenGL vertex array object ID
+     */
+    void bindVertexArray(GLuint vertexArrayID);
+
+    /**
+     * Sets active texture unit (glActiveTexture).
+     *
+     * @param textureUnit  Index of texture unit (without GL_TEXTURE0)
+     */
+    void activeTexture(GLuint textureUnit);
+
+    /**
+     * Binds texture to the currently active texture unit (glBindTexture). Meant for texture creation and updates.
+     *
+     * @param target     Texture target (GL_TEXTURE_2D, GL_TEXTURE_CUBE_MAP...)
+     * @param textureID  OpenGL texture ID
+     */
+    void bindTexture(GLenum target, GLuint textureID);
+
+    /**
+     * Binds texture to given texture unit. Active texture unit is changed only if the binding changes.
+     *
+     * @param textureUnit  Index of texture unit (without GL_TEXTURE0)
+     * @param target       Texture target (GL_TEXTURE_2D, GL_TEXTURE_CUBE_MAP...)
+     * @param textureID    OpenGL texture ID
+     */
+    void bindTextureToUnit(GLuint textureUnit, GLenum target, GLuint textureID);
+
+    /**
+     * Binds sampler to given texture unit (glBindSampler).
+     *
+     * @param textureUnit  Index of texture unit (without GL_TEXTURE0)
+     * @param samplerID    OpenGL sampler ID
+     */
+    void bindSampler(GLuint textureUnit, GLuint samplerID);
+
+    /**
+     * Binds buffer to given target (glBindBuffer). Only array, element array and uniform buffer targets
+     * are cached, other targets are passed directly to OpenGL.
+     *
+     * @param target    Buffer target (GL_ARRAY_BUFFER, GL_ELEMENT_ARRAY_BUFFER...)
+     * @param bufferID  OpenGL buffer ID
+     */
+    void bindBuffer(GLenum target, GLuint bufferID);
+
+    /**
+     * Binds buffer to indexed binding point (glBindBufferBase). Never skipped, but the generic binding
+     * of the target is changed as well, so it's tracked here.
+     */
+    void bindBufferBase(GLenum target, GLuint index, GLuint bufferID);
+
+    /**
+     * Binds range of buffer to indexed binding point (glBindBufferRange). Never skipped, but the generic binding
+     * of the target is changed as well, so it's tracked here.
+     */
+    void bindBufferRange(GLenum target, GLuint index, GLuint bufferID, GLintptr offset, GLsizeiptr byteSize);
+
+    /**
+     * Enables or disables OpenGL capability (glEnable / glDisable).
+     *
+     * @param capability  OpenGL capability (GL_DEPTH_TEST, GL_PRIMITIVE_RESTART...)
+     * @param enable      True to enable the capability, false to disable it
+     */
+    void setEnabled(GLenum capability, bool enable);
+
+    /**
+     * Enables OpenGL capability (glEnable).
+     */
+    void enable(GLenum capability);
+
+    /**
+     * Disables OpenGL capability (glDisable).
+     */
+    void disable(GLenum capability);
+
+    /**
+     * Checks, if OpenGL capability is enabled. Unknown state is queried from OpenGL (glIsEnabled) once and cached,
+     * so that code changing the capability temporarily can restore it afterwards.
+     *
+     * @param capability  OpenGL capability (GL_DEPTH_TEST, GL_CULL_FACE...)
+     */
+    bool isEnabled(GLenum capability);
+
+    /**
+     * Enables or disables writing of color components into the framebuffer (glColorMask).
+     */
+    void colorMask(bool red, bool green, bool blue, bool alpha);
+
+    /**
+     * Gets write mask of red, green, blue and alpha components. Unknown state is queried from OpenGL once and cached.
+     */
+    std::array<bool, 4> getColorMask();
+
+    /**
+     * Enables or disables writing into the depth buffer (glDepthMask).
+     */
+    void depthMask(bool enable);
+
+    /**
+     * Checks, if writing into the depth buffer is enabled. Unknown state is queried from OpenGL once and cached.
+     */
+    bool isDepthMaskEnabled();
+
+    /**
+     * Sets function comparing incoming depth values with the depth buffer (glDepthFunc).
+     *
+     * @param function  Depth comparison function (GL_LESS, GL_LEQUAL...)
+     */
+    void depthFunc(GLenum function);
+
+    /**
+     * Gets depth comparison function. Unknown state is queried from OpenGL once and cached.
+     */
+    GLenum getDepthFunc();
+
+    /**
+     * Sets blending factors of both color and alpha (glBlendFunc).
+     *
+     * @param sourceFactor       Factor of the incoming (source) color (GL_SRC_ALPHA, GL_ONE...)
+     * @param destinationFactor  Factor of the color in the framebuffer (GL_ONE_MINUS_SRC_ALPHA, GL_ZERO...)
+     */
+    void blendFunc(GLenum sourceFactor, GLenum destinationFactor);
+
+    /**
+     * Forgets everything related to deleted object. Deleting bound object unbinds it and its ID might be reused.
+     */
+    void onProgramDeleted(GLuint programID);
+    void onVertexArrayDeleted(GLuint vertexArrayID);
+    void onTextureDeleted(GLuint textureID);
+    void onSamplerDeleted(GLuint samplerID);
+    void onBufferDeleted(GLuint bufferID);
+
+    /**
+     * Forgets all the cached state, so that next calls are issued to OpenGL again.
+     */
+    void invalidate();
+
+    /**
+     * Gets number of calls issued to OpenGL since the last reset of statistics.
+     */
+    uint64_t getNumIssuedCalls() const;
+
+    /**
+     * Gets number of redundant calls skipped since the last reset of statistics.
+     */
+    uint64_t getNumSkippedCalls() const;
+
+    /**
+     * Resets call statistics (usually at the start of every frame).
+     */
+    void resetStatistics();
+
+private:
+    GLStateCache() {} // Private constructor to make class singleton
+    GLStateCache(const GLStateCache&) = delete; // No copy constructor allowed
+    void operator=(const GLStateCache&) = delete; // No copy assignment allowed
+
+    static constexpr GLuint UNKNOWN_BINDING{ 0xFFFFFFFF }; // Marks binding, whose value is not known (next call is always issued)
+
+    /**
+     * Texture last bound to a texture unit (different targets of one unit are not tracked separately,
+     * binding to other target just replaces the cached value).
+     */
+    struct TextureUnitState
+    {
+        GLenum target{ 0 }; // Target of the last bound texture
+        GLuint textureID{ UNKNOWN_BINDING }; // ID of the last bound texture
+    };
+
+    /**
+     * Gets cached binding of given buffer target or nullptr, if the target is not cached.
+     */
+    GLuint* getBufferBinding(GLenum target);
+
+    /**
+     * Counts skipped call and returns true, if cached value equals the new one. Otherwise the cached value
+     * is updated, issued call is counted and false is returned.
+     */
+    bool skipIfEqual(GLuint& cachedValue, GLuint newValue);
+
+    GLuint _currentProgram{ UNKNOWN_BINDING }; // Currently used shader program
+    GLuint _currentVertexArray{ UNKNOWN_BINDING }; // Currently bound vertex array object
+    GLuint _activeTextureUnit{ UNKNOWN_BINDING }; // Currently active texture unit
+    GLuint _arrayBuffer{ UNKNOWN_BINDING }; // Buffer bound to GL_ARRAY_BUFFER
+    GLuint _elementArrayBuffer{ UNKNOWN_BINDING }; // Buffer bound to GL_ELEMENT_ARRAY_BUFFER (part of the vertex array state)
+    GLuint _uniformBuffer{ UNKNOWN_BINDING }; // Buffer bound to GL_UNIFORM_BUFFER
+    std::vector<TextureUnitState> _textureUnits; // Textures bound to texture units (grows on demand)
+    std::vector<GLuint> _samplers; // Samplers bound to texture units (grows on demand)
+    std::map<GLenum, bool> _capabilities; // Known states of capabilities (missing means unknown)
+    GLuint _colorMask{ UNKNOWN_BINDING }; // Color write mask, one bit per component (red is the lowest one)
+    GLuint _depthMask{ UNKNOWN_BINDING }; // Depth write mask (GL_TRUE or GL_FALSE)
+    GLenum _depthFunc{ UNKNOWN_BINDING }; // Depth comparison function
+    GLenum _blendSourceFactor{ UNKNOWN_BINDING }; // Source blending factor
+    GLenum _blendDestinationFactor{ UNKNOWN_BINDING }; // Destination blending factor
+
+    uint64_t _numIssuedCalls{ 0 }; // Number of calls issued to OpenGL since the last reset
+    uint64_t _numSkippedCalls{ 0 }; // Number of redundant calls skipped since the last reset
+};
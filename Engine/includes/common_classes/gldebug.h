@@ -1,5 +1,5 @@
-// STL
-#include <iostream>
+// Project
+#include "logManager.h"
 
 namespace gldebug {
 
@@ -8,7 +8,7 @@ inline void ClearOpenGLError()
     GLenum err;
     while ((err = glGetError()) != GL_NO_ERROR)
     {
-        std::cout << "Cleared OpenGL error " << std::hex << err << std::dec << std::endl;
+        LOG_DEBUG(Render, "Cleared OpenGL error {:#x}", err);
     }
 }
 
@@ -18,7 +18,7 @@ inline void CheckOpenGLError(const char* stmt, const char* fname, int line)
     if (err == GL_NO_ERROR) {
         return;
     }
-    std::cout << "OpenGL error " << std::hex << err << std::dec << " at " << fname << ":" << line << " - " << stmt << std::endl;
+    LOG_ERROR(Render, "OpenGL error {:#x} at {}:{} - {}", err, fname, line, stmt);
 }
 
 } // namespace gldebug
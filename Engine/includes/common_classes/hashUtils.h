@@ -0,0 +1,71 @@
+#pragma once
+
+// STL
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+namespace hash_utils
+{
+
+constexpr uint64_t FNV_OFFSET_BASIS = 14695981039346656037ULL; // Initial value of 64-bit FNV-1a hash
+constexpr uint64_t FNV_PRIME = 1099511628211ULL; // Prime multiplier of 64-bit FNV-1a hash
+
+/**
+ * Computes 64-bit FNV-1a hash of given data. Passing previous hash as seed
+ * allows to hash several blocks of data as if they were one.
+ *
+ * @param data           Pointer to the data to hash
+ * @param dataSizeBytes  Size of the data (in bytes)
+ * @param seed           Starting hash value (FNV offset basis or previously computed hash)
+ *
+ * @return Computed hash.
+ */
+inline uint64_t fnv1a(const void* data, size_t dataSizeBytes, uint64_t seed = FNV_OFFSET_BASIS)
+{
+    auto hash = seed;
+    const auto bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < dataSizeBytes; i++)
+    {
+        hash ^= bytes[i];
+        hash *= FNV_PRIME;
+    }
+
+    return hash;
+}
+
+/**
+ * Computes 64-bit FNV-1a hash of given string.
+ *
+ * @param s     String to hash
+ * @param seed  Starting hash value (FNV offset basis or previously computed hash)
+ *
+ * @return Computed hash.
+ */
+inline uint64_t fnv1a(const std::string& s, uint64_t seed = FNV_OFFSET_BASIS)
+{
+    return fnv1a(s.data(), s.size(), seed);
+}
+
+/**
+ * Computes 64-bit FNV-1a hash of given null-terminated string. Can be evaluated at compile-time,
+ * result is the same as of runtime fnv1a function for the same characters.
+ *
+ * @param s     Null-terminated string to hash
+ * @param seed  Starting hash value (FNV offset basis or previously computed hash)
+ *
+ * @return Computed hash.
+ */
+constexpr uint64_t fnv1aCString(const char* s, uint64_t seed = FNV_OFFSET_BASIS)
+{
+    auto hash = seed;
+    for (; *s != '\0'; s++)
+    {
+        hash ^= static_cast<unsigned char>(*s);
+        hash *= FNV_PRIME;
+    }
+
+    return hash;
+}
+
+} // namespace hash_utils
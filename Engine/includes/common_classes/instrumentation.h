@@ -0,0 +1,190 @@
+#pragma once
+
+// STL
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <map>
+#include <cstdint>
+
+/**
+ * Singleton class collecting CPU zones and counters from all the threads. Every thread writes finished zones
+ * into its own lock-free ring buffer (single producer, single consumer), so the hot paths never take a lock.
+ * The main thread collects the buffers once per frame, keeps the recent events for the trace export
+ * and statistics for the ImGui panel.
+ *
+ * Use the INSTRUMENT_ZONE and INSTRUMENT_COUNTER macros rather than the class directly, they compile to nothing
+ * when NO_INSTRUMENTATION is defined (release builds).
+ */
+class Instrumentation
+{
+public:
+    static const size_t THREAD_BUFFER_CAPACITY{ 1 << 14 }; // Number of zones every thread can hold until they're collected (power of two)
+    static const size_t MAX_RETAINED_ZONES; // Number of most recent zones kept for the trace export
+    static const int HISTORY_SIZE{ 120 }; // Number of frames kept in the counter history
+
+    /**
+     * Counters accumulated during a frame.
+     */
+    enum class Counter
+    {
+        DropletsSimulated, // Number of erosion droplets simulated
+        DropletSteps, // Number of simulation steps of all the droplets
+        VBOBytesUploaded, // Number of bytes uploaded into vertex buffer objects
+        DrawPackets, // Number of draw packets flushed by the render queue (one packet may issue several draw calls)
+        StateChangesSkipped, // Number of redundant OpenGL state changes skipped by the state cache
+        NumCounters
+    };
+
+    /**
+     * Measures a zone for the lifetime of the object. Zone name must be a string literal (only the pointer is stored).
+     */
+    class Zone
+    {
+    public:
+        Zone(const char* name);
+        ~Zone();
+
+        Zone(const Zone&) = delete;
+        void operator=(const Zone&) = delete;
+
+    private:
+        const char* name_; // Name of the zone
+        uint64_t beginNs_; // Time, when the zone began
+    };
+
+    /**
+     * Gets the one and only instance of the instrumentation.
+     */
+    static Instrumentation& getInstance();
+
+    /**
+     * Gets time in nanoseconds since the instrumentation has been created.
+     */
+    uint64_t getTimeNs() const;
+
+    /**
+     * Records finished zone into the buffer of the calling thread. If the buffer is full, zone is dropped.
+     */
+    void recordZone(const char* name, uint64_t beginNs, uint64_t endNs);
+
+    /**
+     * Adds value to the counter (can be called from any thread).
+     */
+    void addToCounter(Counter counter, int64_t value);
+
+    /**
+     * Sets name of the calling thread shown in the trace and in the panel.
+     */
+    void setThreadName(const std::string& threadName);
+
+    /**
+     * Collects zones of all the threads and closes the counters of the frame. Call once per frame from the main thread.
+     */
+    void collectFrame();
+
+    /**
+     * Renders counters and zone statistics of the last collected frame into the current ImGui window.
+     */
+    void renderImGui() const;
+
+    /**
+     * Writes retained zones and counters into Chrome trace JSON file (chrome://tracing or Perfetto UI).
+     *
+     * @param filePath  Path of the output file
+     *
+     * @return True, if the file has been written correctly or false otherwise.
+     */
+    bool dumpTrace(const std::string& filePath) const;
+
+    /**
+     * Gets name of the counter.
+     */
+    static const char* getCounterName(Counter counter);
+
+private:
+    Instrumentation() {} // Private constructor to make class singleton
+    Instrumentation(const Instrumentation&) = delete; // No copy constructor allowed
+    void operator=(const Instrumentation&) = delete; // No copy assignment allowed
+
+    static const int NUM_COUNTERS{ static_cast<int>(Counter::NumCounters) };
+
+    /**
+     * Finished zone, as it's stored in the buffers.
+     */
+    struct ZoneEvent
+    {
+        const char* name; // Name of the zone
+        uint64_t beginNs; // Time, when the zone began
+        uint64_t endNs; // Time, when the zone ended
+        uint32_t threadID; // Index of the thread, that recorded the zone
+    };
+
+    /**
+     * Ring buffer of one thread. The owning thread is the only writer of the write index and the collecting thread
+     * is the only writer of the read index, so no lock is needed.
+     */
+    struct ThreadBuffer
+    {
+        std::array<ZoneEvent, THREAD_BUFFER_CAPACITY> events; // Ring of recorded zones
+        std::atomic<uint64_t> writeIndex{ 0 }; // Number of zones ever written
+        std::atomic<uint64_t> readIndex{ 0 }; // Number of zones ever collected
+        std::atomic<uint64_t> numDroppedZones{ 0 }; // Number of zones dropped, because the ring was full
+        uint32_t threadID{ 0 }; // Index of the thread
+        std::string threadName; // Name of the thread (accessed under the registration mutex)
+    };
+
+    /**
+     * Statistics of one zone name in the last collected frame.
+     */
+    struct ZoneStatistics
+    {
+        double totalMs{ 0.0 }; // Total time spent in the zone
+        double maxMs{ 0.0 }; // Longest single zone
+        size_t numCalls{ 0 }; // Number of zones
+    };
+
+    /**
+     * Values of all the counters closed at the end of a frame.
+     */
+    struct CounterSample
+    {
+        uint64_t timeNs; // Time, when the frame has been collected
+        std::array<int64_t, NUM_COUNTERS> values; // Values of the counters in the frame
+    };
+
+    /**
+     * Gets buffer of the calling thread, buffer is registered on the first call from the thread.
+     */
+    ThreadBuffer& getThreadBuffer();
+
+    using Clock = std::chrono::steady_clock;
+
+    const Clock::time_point _creationTime{ Clock::now() }; // Origin of all the times
+    mutable std::mutex _registrationMutex; // Guards the list of thread buffers and the thread names
+    std::vector<std::unique_ptr<ThreadBuffer>> _threadBuffers; // Buffers of all the threads (never freed, threads may outlive collection)
+    std::array<std::atomic<int64_t>, NUM_COUNTERS> _counters{}; // Counters of the current frame
+
+    std::vector<ZoneEvent> _retainedZones; // Ring of the most recent collected zones
+    size_t _retainedZonesOffset{ 0 }; // Index, where the next collected zone is written once the ring is full
+    std::vector<CounterSample> _counterSamples; // Ring of counter values of the recent frames
+    int _counterSamplesOffset{ 0 }; // Index, where the next counter sample is written once the ring is full
+    std::map<std::string, ZoneStatistics> _lastFrameZones; // Zone statistics of the last collected frame
+    std::array<std::vector<float>, NUM_COUNTERS> _counterHistory; // Counter values of the recent frames for the charts
+    int _historyOffset{ 0 }; // Index in the counter history, where the next frame is written
+    uint64_t _numDroppedZones{ 0 }; // Number of zones dropped by all the threads
+};
+
+#ifndef NO_INSTRUMENTATION
+#define INSTRUMENT_CONCAT_IMPL(a, b) a##b
+#define INSTRUMENT_CONCAT(a, b) INSTRUMENT_CONCAT_IMPL(a, b)
+#define INSTRUMENT_ZONE(name) Instrumentation::Zone INSTRUMENT_CONCAT(instrumentationZone, __LINE__)(name)
+#define INSTRUMENT_COUNTER(counter, value) Instrumentation::getInstance().addToCounter(Instrumentation::Counter::counter, static_cast<int64_t>(value))
+#else
+#define INSTRUMENT_ZONE(name)
+#define INSTRUMENT_COUNTER(counter, value)
+#endif
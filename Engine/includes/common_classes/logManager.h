@@ -0,0 +1,84 @@
+#pragma once
+
+// STL
+#include <array>
+#include <memory>
+
+// Messages below this level are removed at compile time (release builds set it in CMake)
+#ifndef SPDLOG_ACTIVE_LEVEL
+#define SPDLOG_ACTIVE_LEVEL SPDLOG_LEVEL_DEBUG
+#endif
+
+// spdlog
+#include <spdlog/spdlog.h>
+
+/**
+ * Singleton class owning the loggers of the engine subsystems. Loggers are asynchronous - messages are formatted
+ * on the calling thread and written to the console by a background thread, so rendering and erosion never wait
+ * for the terminal. When the queue is full, the oldest messages are dropped rather than blocking the caller.
+ *
+ * Use the LOG_* macros, levels below SPDLOG_ACTIVE_LEVEL compile to nothing.
+ */
+class LogManager
+{
+public:
+    static const size_t QUEUE_SIZE; // Number of messages the background thread can lag behind
+    static const char* const LOG_PATTERN; // Pattern of every logged line
+
+    /**
+     * Subsystems of the engine, every one has its own logger (and its own level at runtime).
+     */
+    enum class Subsystem
+    {
+        Core, // Window, application and utilities
+        Render, // Render queue, framebuffers, queries and profilers
+        Buffers, // Vertex and uniform buffer objects
+        Shaders, // Shaders and shader programs
+        Assets, // Textures, models and asynchronous loading
+        Erosion, // Heightmap and erosion simulation
+        NumSubsystems
+    };
+
+    /**
+     * Gets the one and only instance of the log manager, loggers are created on the first call.
+     */
+    static LogManager& getInstance();
+
+    /**
+     * Gets logger of the subsystem.
+     */
+    spdlog::logger* getLogger(Subsystem subsystem) const;
+
+    /**
+     * Sets runtime level of the subsystem logger (levels removed at compile time can't be enabled).
+     */
+    void setLevel(Subsystem subsystem, spdlog::level::level_enum level);
+
+    /**
+     * Writes out all the queued messages and switches the loggers to synchronous mode, so that messages logged
+     * during destruction of static objects are still printed. Call once at the end of the application.
+     */
+    void shutdown();
+
+private:
+    LogManager(); // Private constructor to make class singleton
+    LogManager(const LogManager&) = delete; // No copy constructor allowed
+    void operator=(const LogManager&) = delete; // No copy assignment allowed
+
+    static const int NUM_SUBSYSTEMS{ static_cast<int>(Subsystem::NumSubsystems) };
+
+    /**
+     * Gets name of the subsystem, it's printed with every message.
+     */
+    static const char* getSubsystemName(Subsystem subsystem);
+
+    std::shared_ptr<spdlog::details::thread_pool> _threadPool; // Queue and background thread of the asynchronous loggers
+    std::array<std::shared_ptr<spdlog::logger>, NUM_SUBSYSTEMS> _loggers; // Loggers of all the subsystems
+};
+
+#define LOG_TRACE(subsystem, ...) SPDLOG_LOGGER_TRACE(LogManager::getInstance().getLogger(LogManager::Subsystem::subsystem), __VA_ARGS__)
+#define LOG_DEBUG(subsystem, ...) SPDLOG_LOGGER_DEBUG(LogManager::getInstance().getLogger(LogManager::Subsystem::subsystem), __VA_ARGS__)
+#define LOG_INFO(subsystem, ...) SPDLOG_LOGGER_INFO(LogManager::getInstance().getLogger(LogManager::Subsystem::subsystem), __VA_ARGS__)
+#define LOG_WARN(subsystem, ...) SPDLOG_LOGGER_WARN(LogManager::getInstance().getLogger(LogManager::Subsystem::subsystem), __VA_ARGS__)
+#define LOG_ERROR(subsystem, ...) SPDLOG_LOGGER_ERROR(LogManager::getInstance().getLogger(LogManager::Subsystem::subsystem), __VA_ARGS__)
+#define LOG_CRITICAL(subsystem, ...) SPDLOG_LOGGER_CRITICAL(LogManager::getInstance().getLogger(LogManager::Subsystem::subsystem), __VA_ARGS__)
@@ -0,0 +1,56 @@
+#pragma once
+
+// STL
+#include <string>
+#include <cstddef>
+
+/**
+ * Read-only view of a whole file mapped into memory. The file contents can be used
+ * directly (e.g. uploaded to GPU) without reading them into an intermediate buffer.
+ */
+class MemoryMappedFile
+{
+public:
+    MemoryMappedFile() = default;
+    ~MemoryMappedFile();
+
+    MemoryMappedFile(const MemoryMappedFile&) = delete;
+    MemoryMappedFile& operator=(const MemoryMappedFile&) = delete;
+
+    /**
+     * Maps given file into memory. Previously mapped file gets closed.
+     *
+     * @param filePath  Path to the file to map
+     *
+     * @return True, if the file has been mapped successfully or false otherwise.
+     */
+    bool open(const std::string& filePath);
+
+    /**
+     * Unmaps the file and releases all handles.
+     */
+    void close();
+
+    /**
+     * Checks, if a file is currently mapped.
+     */
+    bool isOpen() const;
+
+    /**
+     * Gets pointer to the beginning of the mapped file data.
+     */
+    const unsigned char* getData() const;
+
+    /**
+     * Gets size of the mapped file (in bytes).
+     */
+    size_t getSize() const;
+
+private:
+    const unsigned char* _data = nullptr; // Pointer to the mapped file data
+    size_t _size = 0; // Size of the mapped data in bytes
+#ifdef _WIN32
+    void* _fileHandle = nullptr; // Windows handle of the opened file
+    void* _mappingHandle = nullptr; // Windows handle of the file mapping object
+#endif
+};
@@ -0,0 +1,168 @@
+#pragma once
+
+// STL
+#include <memory>
+#include <string>
+#include <vector>
+
+// GLAD
+#include <glad/glad.h>
+
+// GLM
+#include <glm/glm.hpp>
+
+// Project
+#include "occlusionQuery.h"
+#include "renderQueue.h"
+#include "shaderProgram.h"
+#include "vertexBufferObject.h"
+
+/**
+ * Culls objects hidden behind other geometry using bounding box occlusion queries. Boxes are tested against
+ * the finished depth buffer at the end of the frame and their results are used in the next frames, so the CPU
+ * never waits for the GPU. Results are either read back once they are available (occluded objects are not
+ * even submitted) or consumed directly by the GPU with conditional rendering.
+ */
+class OcclusionCuller
+{
+public:
+    static const std::string SHADER_PROGRAM_KEY; // Holds a key for bounding box shader program (used as shaders key too)
+    static const float EYE_BOUNDS_MARGIN; // Distance, by which bounding boxes are enlarged when checking, if camera is inside them
+
+    /**
+     * How the query results are used.
+     */
+    enum class Mode
+    {
+        DelayedReadback, // Results are read once available, occluded objects are skipped on the CPU
+        ConditionalRender // Results are never read, GPU skips draw calls of occluded objects on its own
+    };
+
+    struct ShaderConstants
+    {
+        DEFINE_SHADER_UNIFORM(boundsMin, "boundsMin")
+        DEFINE_SHADER_UNIFORM(boundsMax, "boundsMax")
+    };
+
+    /**
+     * Statistics of the current frame.
+     */
+    struct Statistics
+    {
+        size_t numObjects{ 0 }; // Number of registered objects
+        size_t numOutsideFrustum{ 0 }; // Number of objects skipped, because they're outside of the view frustum
+        size_t numOccluded{ 0 }; // Number of objects skipped, because their last query result says they're occluded
+        size_t numConditional{ 0 }; // Number of objects left to the GPU to decide
+        size_t numPendingResults{ 0 }; // Number of query results still not available from the previous frames
+        size_t numQueriesIssued{ 0 }; // Number of queries issued at the end of the last frame
+    };
+
+    OcclusionCuller() = default;
+    OcclusionCuller(const OcclusionCuller&) = delete;
+    void operator=(const OcclusionCuller&) = delete;
+
+    /**
+     * Loads shaders and creates the bounding box shader program (it's linked with all the other programs).
+     */
+    static void prepareShaderProgram();
+    static ShaderProgram& getShaderProgram();
+
+    /**
+     * Registers new object. Object is considered visible until its first query result is known.
+     *
+     * @return Index of the object used by all the other methods.
+     */
+    int addObject();
+
+    /**
+     * Sets world space bounding box of the object from its model space bounding box.
+     *
+     * @param objectIndex  Index of the object
+     * @param boundsMin    Minimal corner of the model space bounding box
+     * @param boundsMax    Maximal corner of the model space bounding box
+     * @param modelMatrix  Model matrix of the object
+     */
+    void setObjectBounds(int objectIndex, const glm::vec3& boundsMin, const glm::vec3& boundsMax, const glm::mat4& modelMatrix = glm::mat4(1.0f));
+
+    /**
+     * Removes all the objects and deletes their queries.
+     */
+    void clearObjects();
+
+    /**
+     * Starts new frame - collects query results, that have become available since the last frame (never blocks)
+     * and tests the objects against the view frustum. Objects outside of the frustum are considered visible
+     * once they enter it again, so that they don't wait for a query result to appear.
+     *
+     * @param projectionMatrix  Projection matrix of the frame
+     * @param viewMatrix        View matrix of the frame
+     * @param eyePosition       Position of the camera (objects containing the camera are always visible)
+     */
+    void beginFrame(const glm::mat4& projectionMatrix, const glm::mat4& viewMatrix, const glm::vec3& eyePosition);
+
+    /**
+     * Prepares draw packet of the object. In conditional render mode, packet gets the query of the object,
+     * so that the GPU skips the draw calls, if the object was occluded.
+     *
+     * @param objectIndex  Index of the object
+     * @param packet       Draw packet of the object
+     *
+     * @return False, if the object is outside of the frustum or known to be occluded and shouldn't be submitted at all
+     *         or true otherwise.
+     */
+    bool prepareDrawPacket(int objectIndex, RenderQueue::DrawPacket& packet);
+
+    /**
+     * Issues queries of the bounding boxes of all the objects. Call once all the occluders of the frame have been
+     * rendered. Color and depth writes are disabled meanwhile. Queries, whose results have not been read yet,
+     * are not issued again in delayed readback mode.
+     */
+    void issueQueries();
+
+    void setMode(Mode mode);
+    Mode getMode() const;
+
+    /**
+     * Enables or disables culling. Disabled culler lets all the packets through and issues no queries.
+     */
+    void setEnabled(bool enabled);
+    bool isEnabled() const;
+
+    const Statistics& getStatistics() const;
+
+    /**
+     * Renders culling settings and statistics into the current ImGui window.
+     */
+    void renderImGui();
+
+    /**
+     * Deletes all the objects and OpenGL objects (call before the OpenGL context is destroyed).
+     */
+    void deleteAll();
+
+private:
+    /**
+     * Object tested by the queries.
+     */
+    struct CulledObject
+    {
+        glm::vec3 boundsMin{ 0.0f }; // Minimal corner of the world space bounding box
+        glm::vec3 boundsMax{ 0.0f }; // Maximal corner of the world space bounding box
+        std::unique_ptr<OcclusionQuery> query; // Query of the bounding box (created lazily on the context thread)
+        bool isVisible{ true }; // Visibility from the last available query result
+        bool isEyeInside{ false }; // True, if camera is inside the bounding box in the current frame
+        bool isInFrustum{ true }; // True, if the bounding box intersects the view frustum in the current frame
+    };
+
+    /**
+     * Creates VAO with unit cube used to render all the bounding boxes.
+     */
+    void createBoxMesh();
+
+    std::vector<CulledObject> _objects; // All the registered objects
+    Statistics _statistics; // Statistics of the current frame
+    Mode _mode{ Mode::DelayedReadback }; // How the query results are used
+    bool _isEnabled{ true }; // True, if the culling is enabled
+    GLuint _boxVAO{ 0 }; // VAO of the unit cube
+    VertexBufferObject _boxVBO; // VBO with vertices of the unit cube
+};
@@ -4,7 +4,8 @@
 #include <glad/glad.h>
 
 /**
- * Provides convenient access to occlusion query functionality.
+ * Provides convenient access to occlusion query functionality. Results are never waited for - they are
+ * read only once the GPU reports them available, or consumed by the GPU itself with conditional rendering.
  */
 class OcclusionQuery
 {
@@ -12,30 +13,74 @@ public:
     OcclusionQuery();
     ~OcclusionQuery();
 
+    OcclusionQuery(const OcclusionQuery&) = delete; // Query object is owned, no copies allowed
+    void operator=(const OcclusionQuery&) = delete; // Query object is owned, no copies allowed
+
     /**
      * Begins occlusion query. Until the query is ended, samples
      * that pass the rendering pipeline are counted.
      */
-    void beginQuery() const;
+    void beginQuery();
 
     /**
-     * Ends occlusion query and caches the result - number
-     * of samples that passed the rendering pipeline.
+     * Ends occlusion query. Result is not read here (that would stall the CPU until the GPU catches up),
+     * call updateResult in one of the next frames instead.
      */
     void endQuery();
 
     /**
-     * Gets number of samples that have passed the rendering pipeline.
+     * Reads result of the last ended query, if the GPU has it available already. Never blocks.
+     *
+     * @return True, if new result has been read or false otherwise.
+     */
+    bool updateResult();
+
+    /**
+     * Checks, if the last ended query still waits for its result to be read.
+     */
+    bool isResultPending() const;
+
+    /**
+     * Checks, if any query result has been read so far.
+     */
+    bool hasResult() const;
+
+    /**
+     * Checks, if the query has been ended at least once (so that it can be used for conditional rendering).
+     */
+    bool wasIssued() const;
+
+    /**
+     * Starts rendering conditioned by the last ended query, GPU discards the following draw calls,
+     * if no samples passed. With GL_QUERY_NO_WAIT, GPU renders anyway, if the result is not ready yet.
+     *
+     * @param mode  Conditional rendering mode (GL_QUERY_NO_WAIT, GL_QUERY_WAIT...)
+     */
+    void beginConditionalRender(GLenum mode = GL_QUERY_NO_WAIT) const;
+
+    /**
+     * Ends conditional rendering.
+     */
+    static void endConditionalRender();
+
+    /**
+     * Gets number of samples that have passed the rendering pipeline (in the last read result).
      */
     GLint getNumSamplesPassed() const;
 
     /**
-     * Helper method that returns if any samples have passed the rendering pipeline.
+     * Helper method that returns if any samples have passed the rendering pipeline (in the last read result).
      */
     bool anySamplesPassed() const;
 
+    /**
+     * Gets OpenGL query object ID.
+     */
+    GLuint getQueryID() const;
+
 private:
     GLuint queryID_{ 0 }; // OpenGL query object ID
-    GLint samplesPassed_{ 0 }; // Number of samples passed in last query
+    GLint samplesPassed_{ 0 }; // Number of samples passed in last read query
+    bool isResultPending_{ false }; // True, if the query has been ended and its result hasn't been read yet
+    bool hasResult_{ false }; // True, if any result has been read
 };
-
@@ -0,0 +1,125 @@
+#pragma once
+
+// STL
+#include <array>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+// GLAD
+#include <glad/glad.h>
+
+// GLM
+#include <glm/glm.hpp>
+
+// Project
+#include "shaderProgram.h"
+#include "occlusionQuery.h"
+
+/**
+ * Collects draw packets of the whole scene and renders them sorted by state, so that the number of state changes
+ * is minimal. Every packet gets 64-bit sort key (shader program > material > VAO > depth), packets are ordered
+ * with radix sort and the ones with the same program and material are rendered front-to-back to reduce overdraw.
+ */
+class RenderQueue
+{
+public:
+    static const int MAX_PACKET_TEXTURES{ 4 }; // Maximal number of textures bound by a single draw packet
+    static const GLuint KEEP_SAMPLER; // Sampler ID telling, that sampler bound to the texture unit should be kept
+
+    /**
+     * Texture bound to a texture unit before the draw packet is rendered.
+     */
+    struct TextureBinding
+    {
+        GLenum target{ 0 }; // Texture target (0 means no texture is bound)
+        GLuint textureID{ 0 }; // OpenGL texture ID
+        GLuint samplerID{ KEEP_SAMPLER }; // OpenGL sampler ID or KEEP_SAMPLER
+    };
+
+    /**
+     * Everything needed to render one mesh. Shader program, textures, VAO and model matrix are applied
+     * by the queue, draw function then only issues the draw call (and sets mesh-specific uniforms).
+     * Packet holds no owning members, so that submitting it never allocates.
+     */
+    struct DrawPacket
+    {
+        /**
+         * Function issuing the draw call - plain function (usually captureless lambda), that gets
+         * the object and the argument stored in the packet.
+         */
+        using DrawFunction = void (*)(const void* drawObject, uint64_t drawArgument);
+
+        ShaderProgram* shaderProgram{ nullptr }; // Shader program to render the mesh with
+        std::array<TextureBinding, MAX_PACKET_TEXTURES> textures; // Textures to bind, array index is the texture unit
+        GLuint vao{ 0 }; // Vertex array object of the mesh
+        glm::mat4 modelMatrix{ 1.0f }; // Model matrix of the mesh (its translation is used for depth sorting)
+        DrawFunction draw{ nullptr }; // Function issuing the draw call itself
+        const void* drawObject{ nullptr }; // Object rendered by the draw function (mesh, model...)
+        uint64_t drawArgument{ 0 }; // Additional argument of the draw function (mesh index, chunk index...)
+        const char* profileScope{ nullptr }; // Name of the frame profiler scope measuring the packet, must be a string literal (nullptr means not measured)
+        const OcclusionQuery* conditionalQuery{ nullptr }; // Query, whose result decides on the GPU if the packet is drawn (nullptr means always drawn)
+
+        /**
+         * Sets texture to bind to given texture unit.
+         *
+         * @param textureUnit  Texture unit (index into textures array)
+         * @param target       Texture target (GL_TEXTURE_2D, GL_TEXTURE_CUBE_MAP...)
+         * @param textureID    OpenGL texture ID
+         * @param samplerID    OpenGL sampler ID (KEEP_SAMPLER keeps whatever sampler is bound)
+         */
+        void setTexture(int textureUnit, GLenum target, GLuint textureID, GLuint samplerID = KEEP_SAMPLER);
+    };
+
+    /**
+     * Starts collecting packets of a new frame. Packets not flushed from previous frame are dropped.
+     *
+     * @param projectionMatrix  Perspective projection matrix (its far plane defines the depth range)
+     * @param viewMatrix        View matrix used to compute depth of the packets
+     */
+    void begin(const glm::mat4& projectionMatrix, const glm::mat4& viewMatrix);
+
+    /**
+     * Submits draw packet to the queue. Packet is rendered with next call of flush.
+     *
+     * @param packet  Draw packet to submit (must have shader program and draw function set)
+     */
+    void submit(const DrawPacket& packet);
+
+    /**
+     * Sorts all the submitted packets and renders them, then clears the queue. Normal matrix is computed
+     * only when the model matrix differs from the one of the previously rendered packet.
+     */
+    void flush();
+
+    /**
+     * Gets number of packets rendered by the last flush.
+     */
+    size_t getNumFlushedPackets() const;
+
+    /**
+     * Gets number of shader program switches done by the last flush.
+     */
+    size_t getNumProgramChanges() const;
+
+private:
+    /**
+     * Computes 64-bit sort key of the packet - program (16 bits), material (16 bits), VAO (16 bits)
+     * and quantized view depth (16 bits).
+     */
+    uint64_t computeSortKey(const DrawPacket& packet) const;
+
+    /**
+     * Sorts keys of submitted packets with LSD radix sort (8 bits per pass, passes where all the keys
+     * share the same byte are skipped).
+     */
+    void radixSortKeys();
+
+    std::vector<DrawPacket> _packets; // Packets submitted in this frame
+    std::vector<std::pair<uint64_t, uint32_t>> _sortKeys; // Sort keys paired with indices of packets
+    std::vector<std::pair<uint64_t, uint32_t>> _sortKeysTemp; // Ping-pong buffer used by radix sort
+    glm::mat4 _viewMatrix{ 1.0f }; // View matrix of the current frame
+    float _farPlane{ 1.0f }; // Distance of far plane of the current frame
+    size_t _numFlushedPackets{ 0 }; // Number of packets rendered by the last flush
+    size_t _numProgramChanges{ 0 }; // Number of shader program switches done by the last flush
+};
@@ -4,10 +4,22 @@
 #include <vector>
 #include <string>
 #include <set>
+#include <memory>
 
 // GLAD
 #include <glad/glad.h>
 
+// Tokens of GL_KHR_parallel_shader_compile (glad is generated without extensions)
+#ifndef GL_MAX_SHADER_COMPILER_THREADS_KHR
+#define GL_MAX_SHADER_COMPILER_THREADS_KHR 0x91B0
+#endif
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+
+// Project
+#include "uniform.h"
+
 #define DEFINE_SHADER_CONSTANT(constantName, constantValue) \
 static const std::string constantName()                     \
 {                                                           \
@@ -22,6 +34,21 @@ static const std::string constantName(const int index)                     \
     return std::string(constantValue) + "[" + std::to_string(index) + "]"; \
 }
 
+// Uniform constants are hashed at compile-time (static constexpr forces that)
+#define DEFINE_SHADER_UNIFORM(constantName, constantValue) \
+static UniformID constantName()                            \
+{                                                          \
+    static constexpr UniformID value(constantValue);       \
+    return value;                                          \
+}
+
+#define DEFINE_SHADER_UNIFORM_INDEX(constantName, constantValue) \
+DEFINE_SHADER_UNIFORM(constantName, constantValue)               \
+static UniformID constantName(const int index)                   \
+{                                                                \
+    return constantName().at(index);                             \
+}
+
 /**
  * Storage for commonly used shaders throughout the tutorials.
  */
@@ -42,34 +69,43 @@ class ShaderConstants
 {
 public:
     // Matrices
-    DEFINE_SHADER_CONSTANT(modelMatrix,      "matrices.modelMatrix");
-    DEFINE_SHADER_CONSTANT(projectionMatrix, "matrices.projectionMatrix");
-    DEFINE_SHADER_CONSTANT(viewMatrix,       "matrices.viewMatrix");
-    DEFINE_SHADER_CONSTANT(normalMatrix,     "matrices.normalMatrix");
+    DEFINE_SHADER_UNIFORM(modelMatrix,      "matrices.modelMatrix");
+    DEFINE_SHADER_UNIFORM(projectionMatrix, "matrices.projectionMatrix");
+    DEFINE_SHADER_UNIFORM(viewMatrix,       "matrices.viewMatrix");
+    DEFINE_SHADER_UNIFORM(normalMatrix,     "matrices.normalMatrix");
 
     // Color and textures
-    DEFINE_SHADER_CONSTANT(color, "color");
-    DEFINE_SHADER_CONSTANT(sampler, "sampler");
+    DEFINE_SHADER_UNIFORM(color, "color");
+    DEFINE_SHADER_UNIFORM(sampler, "sampler");
 
     // Lighting
-    DEFINE_SHADER_CONSTANT(ambientLight, "ambientLight");
-    DEFINE_SHADER_CONSTANT(diffuseLight, "diffuseLight");
-    DEFINE_SHADER_CONSTANT(pointLightA, "pointLightA");
-    DEFINE_SHADER_CONSTANT(pointLightB, "pointLightB");
-    DEFINE_SHADER_CONSTANT(normalLength, "normalLength");
-    DEFINE_SHADER_CONSTANT(material, "material");
-    DEFINE_SHADER_CONSTANT(eyePosition, "eyePosition");
-    DEFINE_SHADER_CONSTANT(numPointLights, "numPointLights");
+    DEFINE_SHADER_UNIFORM(ambientLight, "ambientLight");
+    DEFINE_SHADER_UNIFORM(diffuseLight, "diffuseLight");
+    DEFINE_SHADER_UNIFORM(pointLightA, "pointLightA");
+    DEFINE_SHADER_UNIFORM(pointLightB, "pointLightB");
+    DEFINE_SHADER_UNIFORM(normalLength, "normalLength");
+    DEFINE_SHADER_UNIFORM(material, "material");
+    DEFINE_SHADER_UNIFORM(eyePosition, "eyePosition");
+    DEFINE_SHADER_UNIFORM(numPointLights, "numPointLights");
     
     // Fog constants
-    DEFINE_SHADER_CONSTANT(fogParams, "fogParams");
+    DEFINE_SHADER_UNIFORM(fogParams, "fogParams");
 
     // MD2 Animation
-    DEFINE_SHADER_CONSTANT(interpolationFactor, "interpolationFactor")
+    DEFINE_SHADER_UNIFORM(interpolationFactor, "interpolationFactor")
+    DEFINE_SHADER_UNIFORM(numFrameVertices, "numFrameVertices")
+    DEFINE_SHADER_UNIFORM(quantizedFramesEnabled, "quantizedFrames.enabled")
+    DEFINE_SHADER_UNIFORM(quantizedFramesScale, "quantizedFrames.scale")
+    DEFINE_SHADER_UNIFORM(quantizedFramesTranslate, "quantizedFrames.translate")
+    DEFINE_SHADER_UNIFORM(quantizedFramesNextScale, "quantizedFrames.nextScale")
+    DEFINE_SHADER_UNIFORM(quantizedFramesNextTranslate, "quantizedFrames.nextTranslate")
+    DEFINE_SHADER_UNIFORM(quantizedFramesTransformMatrix, "quantizedFrames.transformMatrix")
+    DEFINE_SHADER_UNIFORM(quantizedFramesNormalMatrix, "quantizedFrames.normalMatrix")
 };
 
 /**
- * Wraps OpenGL shader loading and compilation into a very convenient class.
+ * Wraps OpenGL shader loading and compilation into a very convenient class. Shader keeps its preprocessed
+ * source and is compiled lazily - only if a program using it cannot be restored from the program binary cache.
  */
 class Shader
 {
@@ -77,29 +113,105 @@ public:
     ~Shader();
 
     /**
-     * Loads and compiles shader from a specified file.
+     * Loads shader source from a specified file. Shader is compiled later, when it's really needed.
      *
      * @param fileName    path to a file
      * @param shaderType  type of shader (vertex, fragment, geometry...)
      *
-     * @return True, if the shader has been successfully loaded and compiled, false otherwise.
+     * @return True, if the shader source has been successfully loaded, false otherwise.
      */
     bool loadShaderFromFile(const std::string& fileName, GLenum shaderType);
 
     /**
-     * Checks, if shader is loaded and compiled successfully.
+     * Reads shader source code from a specified file, resolving all the includes. Does not touch OpenGL,
+     * so it's safe to call from any thread.
+     *
+     * @param fileName     path to a file
+     * @param sourceLines  std::vector to store the source code lines into
+     *
+     * @return True, if the source has been read successfully, false otherwise.
+     */
+    static bool readShaderSource(const std::string& fileName, std::vector<std::string>& sourceLines);
+
+    /**
+     * Sets previously read source code of the shader. Does not touch OpenGL, shader is compiled later.
+     *
+     * @param sourceLines  Source code lines of the shader
+     * @param shaderType   type of shader (vertex, fragment, geometry...)
+     * @param fileName     path to the file the source comes from (used in error messages)
+     */
+    void setShaderSource(std::vector<std::string> sourceLines, GLenum shaderType, const std::string& fileName);
+
+    /**
+     * Compiles the shader from its source, if it hasn't been compiled yet. Waits for the compilation to finish.
+     *
+     * @return True, if the shader has been successfully compiled, false otherwise.
+     */
+    bool compile() const;
+
+    /**
+     * Submits compilation of the shader to the driver without querying its result, so that several shaders
+     * can be compiled in parallel. Result is collected with finishCompile.
+     *
+     * @return True, if the compilation has been submitted (or the shader is compiled already), false otherwise.
+     */
+    bool submitCompile() const;
+
+    /**
+     * Checks, if submitted compilation has finished and its result can be collected without stalling.
+     * Always true, if parallel compilation is not supported.
+     */
+    bool isCompileReady() const;
+
+    /**
+     * Collects result of the submitted compilation and reports compiler errors, if there are any.
      *
-     * @return True, if the shader has been successfully loaded and compiled, false otherwise.
+     * @return True, if the shader has been successfully compiled, false otherwise.
+     */
+    bool finishCompile() const;
+
+    /**
+     * Enables parallel compilation of shaders and programs (GL_KHR_parallel_shader_compile), if it's supported.
+     * Requires valid OpenGL context.
+     *
+     * @return True, if parallel compilation is supported, false otherwise.
+     */
+    static bool enableParallelCompile();
+
+    /**
+     * Checks, if parallel compilation has been enabled and completion status can be polled.
+     */
+    static bool isParallelCompileSupported();
+
+    /**
+     * Clears cache of shader files read so far (shared by all shaders).
+     */
+    static void clearSourceFileCache();
+
+    /**
+     * Checks, if shader source is loaded (shader can be added to a program).
+     */
+    bool isLoaded() const;
+
+    /**
+     * Checks, if shader is compiled successfully.
+     *
+     * @return True, if the shader has been successfully compiled, false otherwise.
      */
     bool isCompiled() const;
 
+    /**
+     * Gets hash of the preprocessed source code and shader type. Used to identify cached program binaries.
+     */
+    uint64_t getSourceHash() const;
+
     /**
      * Deletes shader object from OpenGL.
      */
     void deleteShader();
 
     /**
-     * Gets OpenGL assigned shader ID.
+     * Gets OpenGL assigned shader ID (0 if the shader hasn't been compiled yet).
      */
     GLuint getShaderID() const;
 
@@ -109,6 +221,16 @@ public:
     GLenum getShaderType() const;
 
 private:
+    /**
+     * Gets raw lines of specified file. Files are read only once per process, so common includes
+     * are not read again for every shader. Safe to call from any thread.
+     *
+     * @param fileName  Filename to read the lines from
+     *
+     * @return Lines of the file (including newline characters) or nullptr, if the file could not be read.
+     */
+    static std::shared_ptr<const std::vector<std::string>> getSourceFileLines(const std::string& fileName);
+
     /**
      * Gets all lines from specified shader file.
      *
@@ -118,9 +240,16 @@ private:
      *
      * @return True, if the loading has been successful, or false otherwise.
      */
-    bool getLinesFromFile(const std::string& fileName, std::vector<std::string>& result, std::set<std::string>& filesIncludedAlready, bool isReadingIncludedFile = false) const;
+    static bool getLinesFromFile(const std::string& fileName, std::vector<std::string>& result, std::set<std::string>& filesIncludedAlready, bool isReadingIncludedFile = false);
 
-    GLuint shaderID_{ 0 }; // OpenGL-assigned shader ID
+    std::vector<std::string> sourceLines_; // Preprocessed source code lines of the shader
+    std::string fileName_; // Path to the file the source comes from (used in error messages)
+    uint64_t sourceHash_{ 0 }; // Hash of the preprocessed source code and shader type
     GLenum shaderType_{ 0 }; // Type of shader (GL_VERTEX_SHADER, GL_FRAGMENT_SHADER...)
-    bool isCompiled_{ false }; // Flag telling, whether shader has been loaded and compiled successfully
+    bool isLoaded_{ false }; // Flag telling, whether shader source has been loaded
+
+    mutable GLuint shaderID_{ 0 }; // OpenGL-assigned shader ID (shader is compiled lazily)
+    mutable bool isCompiled_{ false }; // Flag telling, whether shader has been compiled successfully
+    mutable bool isCompileSubmitted_{ false }; // Flag telling, whether compilation has been submitted and its result not collected yet
+    mutable bool isCompileFinished_{ false }; // Flag telling, whether result of the compilation has been collected
 };
@@ -4,6 +4,7 @@
 #include <string>
 #include <map>
 #include <memory>
+#include <future>
 
 // GLAD
 #include <glad/glad.h>
@@ -44,6 +45,55 @@ public:
      */
     void loadGeometryShader(const std::string& key, const std::string &filePath);
 
+    /**
+     * Creates new compute shader and stores it with specified key.
+     *
+     * @param key  Key to store compute shader with
+     */
+    void loadComputeShader(const std::string& key, const std::string &filePath);
+
+    /**
+     * Creates new vertex shader asynchronously - source is read on a worker thread and the shader is stored
+     * on the context thread, when AsyncAssetLoader processes its tasks. Shaders are compiled only when
+     * a program using them is not found in the program binary cache.
+     *
+     * @param key       Key to store vertex shader with
+     * @param filePath  Path to vertex shader file
+     *
+     * @return Future that becomes ready once the shader is stored (holds std::runtime_error if loading has failed).
+     */
+    std::shared_future<void> loadVertexShaderAsync(const std::string& key, const std::string& filePath);
+
+    /**
+     * Creates new fragment shader asynchronously (see loadVertexShaderAsync).
+     *
+     * @param key       Key to store fragment shader with
+     * @param filePath  Path to fragment shader file
+     *
+     * @return Future that becomes ready once the shader is stored (holds std::runtime_error if loading has failed).
+     */
+    std::shared_future<void> loadFragmentShaderAsync(const std::string& key, const std::string& filePath);
+
+    /**
+     * Creates new geometry shader asynchronously (see loadVertexShaderAsync).
+     *
+     * @param key       Key to store geometry shader with
+     * @param filePath  Path to geometry shader file
+     *
+     * @return Future that becomes ready once the shader is stored (holds std::runtime_error if loading has failed).
+     */
+    std::shared_future<void> loadGeometryShaderAsync(const std::string& key, const std::string& filePath);
+
+    /**
+     * Creates new compute shader asynchronously (see loadVertexShaderAsync).
+     *
+     * @param key       Key to store compute shader with
+     * @param filePath  Path to compute shader file
+     *
+     * @return Future that becomes ready once the shader is stored (holds std::runtime_error if loading has failed).
+     */
+    std::shared_future<void> loadComputeShaderAsync(const std::string& key, const std::string& filePath);
+
     /**
      * Tries to load and store geometry shader with specified key.
      * This method doesn't throw exceptions, just returns true or false.
@@ -82,6 +132,15 @@ public:
      */
     const Shader& getGeometryShader(const std::string& key) const;
 
+    /**
+     * Retrieves compute shader with a specified key.
+     *
+     * @param key  Key to get compute shader from
+     *
+     * @return Compute shader instance from a specified key.
+     */
+    const Shader& getComputeShader(const std::string& key) const;
+
     /**
      * Checks, if vertex shader with specified key exists.
      *
@@ -109,6 +168,15 @@ public:
      */
     bool containsGeometryShader(const std::string& key) const;
 
+    /**
+     * Checks, if compute shader with specified key exists.
+     *
+     * @param key  Compute shader key to check existence of
+     *
+     * @return True if compute shader exists or false otherwise.
+     */
+    bool containsComputeShader(const std::string& key) const;
+
     /** 
      * Deletes all the loaded shaders from OpenGL and clears the shaders cache.
      */
@@ -119,7 +187,22 @@ private:
     ShaderManager(const ShaderManager&) = delete; // No copy constructor allowed
     void operator=(const ShaderManager&) = delete; // No copy assignment allowed
 
+    /**
+     * Common implementation of asynchronous shader loading for all shader types.
+     *
+     * @param shaderCache     Cache to store the shader into
+     * @param key             Key to store shader with
+     * @param filePath        Path to shader file
+     * @param shaderType      Type of shader (GL_VERTEX_SHADER, GL_FRAGMENT_SHADER...)
+     * @param shaderTypeName  Human readable name of the shader type used in error messages (e.g. vertex)
+     *
+     * @return Future that becomes ready once the shader is stored.
+     */
+    std::shared_future<void> loadShaderAsync(std::map<std::string, std::unique_ptr<Shader>>& shaderCache, const std::string& key,
+        const std::string& filePath, GLenum shaderType, const std::string& shaderTypeName);
+
     std::map<std::string, std::unique_ptr<Shader>> _vertexShaderCache; // Vertex shader cache - stores vertex shaders within their keys in std::map
     std::map<std::string, std::unique_ptr<Shader>> _fragmentShaderCache; // Fragment shader cache - stores fragment shaders within their keys in std::map
     std::map<std::string, std::unique_ptr<Shader>> _geometryShaderCache; // Gemetry shader cache - stores geometry shaders within their keys in std::map
+    std::map<std::string, std::unique_ptr<Shader>> _computeShaderCache; // Compute shader cache - stores compute shaders within their keys in std::map
 };
\ No newline at end of file
@@ -1,8 +1,9 @@
 #pragma once
 
 // STL
-#include <map>
+#include <set>
 #include <string>
+#include <vector>
 
 // GLAD
 #include <glad/glad.h>
@@ -15,11 +16,16 @@
 #include "uniform.h"
 
 /**
- * Wraps OpenGL shader program creation and linking into a very convenient class.
+ * Wraps OpenGL shader program creation and linking into a very convenient class. Linked programs are stored
+ * in a program binary cache, so that following runs can skip compiling and linking GLSL altogether.
  */
 class ShaderProgram
 {
 public:
+    static const std::string PROGRAM_CACHE_DIRECTORY; // Directory where program binaries are cached
+    static const std::string PROGRAM_CACHE_EXTENSION; // Extension of the cached program binary files
+    static const uint32_t PROGRAM_CACHE_VERSION; // Version of the cache format, bump it when the format changes
+
     ~ShaderProgram();
 
     /**
@@ -28,19 +34,44 @@ public:
     void createProgram();
 
     /**
-     * Adds a shader to shader program. Shader must be properly loaded and compiled.
+     * Adds a shader to shader program. Shader must be properly loaded and it must outlive the linking.
+     * Shader is compiled and attached only if the program is not found in the program binary cache.
      *
      * @return True, if the shader has been added or false otherwise.
      */
-    bool addShaderToProgram(const Shader& shader) const;
+    bool addShaderToProgram(const Shader& shader);
 
     /**
-     * Links the program. If the function succeeds, shader program is ready to use.
+     * Links the program. Program binary is restored from the cache if possible, otherwise all added shaders
+     * are compiled, linked and the resulting binary is cached. If the function succeeds, shader program is ready to use.
      *
      * @return True, if the shader has been linked or false otherwise.
      */
     bool linkProgram();
 
+    /**
+     * Submits linking of the program without waiting for the result. Program binary is restored from the cache
+     * if possible (then the program is linked right away), otherwise compilation of all added shaders and linking
+     * are submitted to the driver, which can process them in parallel. Result is collected with finishLink.
+     *
+     * @return True, if the linking has been submitted (or the program is linked already), false otherwise.
+     */
+    bool submitLink();
+
+    /**
+     * Checks, if submitted linking has finished and its result can be collected without stalling.
+     * Always true, if parallel compilation is not supported.
+     */
+    bool isLinkReady() const;
+
+    /**
+     * Collects results of the submitted compilation and linking, reports errors and caches the program binary.
+     * If the function succeeds, shader program is ready to use.
+     *
+     * @return True, if the shader has been linked or false otherwise.
+     */
+    bool finishLink();
+
     /**
      * Uses this shader program (makes current).
      */
@@ -57,13 +88,23 @@ public:
     GLuint getShaderProgramID() const;
 
     /**
-     * Gets uniform variable by name. If it's first time, it creates a new one, otherwise it's retrieved from cache.
+     * Gets uniform variable by name. The name is hashed at runtime, prefer uniform IDs on hot paths.
      *
      * @param varName  uniform variable name
      *
      * @return Uniform variable, even if it does not exist (it will be invalid).
      */
-    Uniform& operator[](const std::string& varName);
+    Uniform operator[](const std::string& varName);
+
+    /**
+     * Gets uniform variable by its ID. Locations of all active uniforms are resolved once after linking,
+     * so this is just a lookup in a flat table.
+     *
+     * @param uniformID  uniform variable ID
+     *
+     * @return Uniform variable, even if it does not exist (it will be invalid).
+     */
+    Uniform operator[](const UniformID& uniformID);
 
     /**
      * Sets model and normal matrix at once. Setting the two together is pretty common,
@@ -73,6 +114,14 @@ public:
      */
     void setModelAndNormalMatrix(const glm::mat4& modelMatrix);
 
+    /**
+     * Sets model matrix together with already computed normal matrix (when it's shared by more draws).
+     *
+     * @param modelMatrix   Model matrix to be set
+     * @param normalMatrix  Normal matrix computed out of the model matrix
+     */
+    void setModelAndNormalMatrix(const glm::mat4& modelMatrix, const glm::mat3& normalMatrix);
+
     /**
      * Gets index of given uniform block in this shader program.
      *
@@ -105,10 +154,73 @@ public:
 	 *
 	 * @see https://www.khronos.org/registry/OpenGL-Refpages/gl4/html/glTransformFeedbackVaryings.xhtml
 	 */
-	void setTransformFeedbackRecordedVariables(const std::vector<std::string>& recordedVariablesNames, GLenum bufferMode = GL_INTERLEAVED_ATTRIBS) const;
+	void setTransformFeedbackRecordedVariables(const std::vector<std::string>& recordedVariablesNames, GLenum bufferMode = GL_INTERLEAVED_ATTRIBS);
 
 private:
+    /**
+     * Gets key of this program in the program binary cache - hash of preprocessed sources of all shaders,
+     * transform feedback settings and OpenGL vendor, renderer and version strings.
+     */
+    uint64_t getProgramCacheKey() const;
+
+    /**
+     * Gets path to the cached program binary file for given cache key.
+     */
+    static std::string getProgramCacheFilePath(uint64_t cacheKey);
+
+    /**
+     * Tries to restore the program from the program binary cache.
+     *
+     * @return True, if the program has been restored and linked or false otherwise (cache miss, incompatible binary).
+     */
+    bool loadProgramBinary(uint64_t cacheKey);
+
+    /**
+     * Stores binary of the linked program into the program binary cache.
+     *
+     * @return True, if the binary has been stored or false otherwise.
+     */
+    bool saveProgramBinary(uint64_t cacheKey) const;
+
+    /**
+     * Slot of open-addressing table of uniform locations.
+     */
+    struct UniformSlot
+    {
+        uint64_t hash{ 0 }; // Hash of the full uniform name
+        GLint location{ -1 }; // Location of the uniform, -1 means empty slot
+    };
+
+    /**
+     * Queries all active uniforms of the linked program and stores their locations into the lookup table.
+     * Arrays are registered both by their base name and by every element name.
+     */
+    void resolveUniformLocations();
+
+    /**
+     * Inserts uniform location into the lookup table.
+     */
+    void insertUniformLocation(uint64_t hash, GLint location, const std::string& name);
+
+    /**
+     * Finds uniform location in the lookup table.
+     *
+     * @return Uniform location or -1, if there is no such active uniform.
+     */
+    GLint findUniformLocation(uint64_t hash) const;
+
+    /**
+     * Reports (only once) that uniform is not an active uniform of this program.
+     */
+    void reportMissingUniform(uint64_t hash, const char* name);
+
     GLuint shaderProgramID_{ 0 }; // OpenGL-assigned shader program ID
     bool _isLinked{ false }; // Flag teling, whether shader program has been linked successfully
-    std::map<std::string, Uniform> _uniforms; // Cache of uniform locations (reduces OpenGL calls)
+    bool _isLinkSubmitted{ false }; // Flag telling, whether linking has been submitted and its result not collected yet
+    uint64_t _programCacheKey{ 0 }; // Key of the program in the program binary cache (computed when linking is submitted)
+    std::vector<const Shader*> _shaders; // Shaders of this program (compiled and attached only on cache miss)
+    std::vector<std::string> _transformFeedbackVariables; // Names of variables recorded during transform feedback
+    GLenum _transformFeedbackBufferMode{ GL_INTERLEAVED_ATTRIBS }; // Buffer mode of transform feedback
+    std::vector<UniformSlot> _uniformSlots; // Open-addressing table of uniform locations (size is power of two)
+    std::set<uint64_t> _reportedMissingUniforms; // Hashes of missing uniforms that have already been reported
 };
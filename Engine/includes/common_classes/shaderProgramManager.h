@@ -41,7 +41,8 @@ public:
 	ShaderProgram& getShaderProgram(const std::string& key) const;
 
 	/**
-	 * Performs linkage of all existing shader programs.
+	 * Performs linkage of all existing shader programs. All programs are submitted at once and their results
+	 * are collected afterwards, so that shaders can be compiled in parallel if the driver supports it.
 	 */
 	void linkAllPrograms();
 
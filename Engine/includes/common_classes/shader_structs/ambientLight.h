@@ -10,12 +10,21 @@ namespace shader_structs {
  */
 struct AmbientLight : ShaderStruct
 {
+    /**
+     * Ambient light laid out according to std140 rules (as a member of uniform block).
+     */
+    struct Std140
+    {
+        glm::vec3 color;
+        GLint isOn;
+    };
+
     AmbientLight(const glm::vec3& color, const bool isOn = true);
 
     /**
      * Sets ambient light in a shader program.
      */
-    void setUniform(ShaderProgram& shaderProgram, const std::string& uniformName) const override;
+    void setUniform(ShaderProgram& shaderProgram, const UniformID& uniformID) const override;
 
     /**
      * Gets the final contributed color of this ambient light (depending if light is on or off).
@@ -23,6 +32,11 @@ struct AmbientLight : ShaderStruct
      */
     glm::vec3 getColorContribution() const;
 
+    /**
+     * Gets this ambient light laid out according to std140 rules.
+     */
+    Std140 getStd140() const;
+
     glm::vec3 color; // Color of the ambient light
     bool isOn; // Flag telling, if the light is on
 };
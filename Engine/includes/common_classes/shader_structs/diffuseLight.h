@@ -10,18 +10,36 @@ namespace shader_structs {
  */
 struct DiffuseLight : ShaderStruct
 {
+    /**
+     * Diffuse light laid out according to std140 rules (as a member of uniform block).
+     */
+    struct Std140
+    {
+        glm::vec3 color;
+        float __DUMMY_PADDING0__; // Direction starts at next vec4 boundary
+        glm::vec3 direction;
+        float factor;
+        GLint isOn;
+        float __DUMMY_PADDING1__[3]; // Structure size is rounded up to multiple of vec4
+    };
+
     DiffuseLight(const glm::vec3& color, const glm::vec3& direction, const float factor, const bool isOn = true);
 
     /**
      * Sets diffuse light in a shader program.
      */
-    void setUniform(ShaderProgram& shaderProgram, const std::string& uniformName) const override;
+    void setUniform(ShaderProgram& shaderProgram, const UniformID& uniformID) const override;
 
     /**
      * Returns a diffuse light that is off and does not contribute at all.
      */
     static const DiffuseLight& none();
 
+    /**
+     * Gets this diffuse light laid out according to std140 rules.
+     */
+    Std140 getStd140() const;
+
     glm::vec3 color; // Color of the diffuse light
     glm::vec3 direction; // Direction of the diffuse light
     float factor; // Factor to multiply dot product with (strength of light)
@@ -10,6 +10,19 @@ namespace shader_structs {
  */
 struct FogParameters : ShaderStruct
 {
+    /**
+     * Fog parameters laid out according to std140 rules (as a member of uniform block).
+     */
+    struct Std140
+    {
+        glm::vec3 color;
+        float linearStart;
+        float linearEnd;
+        float density;
+        GLint equation;
+        GLint isEnabled;
+    };
+
     static const int FOG_EQUATION_LINEAR;
     static const int FOG_EQUATION_EXP;
     static const int FOG_EQUATION_EXP2;
@@ -26,15 +39,20 @@ struct FogParameters : ShaderStruct
      * Sets fog parameters in a shader program.
      *
      * @param shaderProgram  Shader program to set fog parameters in
-     * @param uniformName    Name of the uniform variable
+     * @param uniformID      ID of the uniform variable
      */
-    void setUniform(ShaderProgram& shaderProgram, const std::string& uniformName) const override;
+    void setUniform(ShaderProgram& shaderProgram, const UniformID& uniformID) const override;
 
     /**
      * Translates used fog equation code to human-readable string.
      */
     std::string getFogEquationName() const;
 
+    /**
+     * Gets these fog parameters laid out according to std140 rules.
+     */
+    Std140 getStd140() const;
+
     glm::vec3 color; // Color to be used with fog, usually grayish
     float linearStart; // This is where linear fog starts (valid for linear equation only)
     float linearEnd; // This is where linear fog ends (valid for linear equation only)
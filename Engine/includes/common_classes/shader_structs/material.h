@@ -21,9 +21,9 @@ struct Material : ShaderStruct
      * Sets material structure in a shader program.
      *
      * @param shaderProgram  Shader program to set material in
-     * @param uniformName    Name of the uniform variable
+     * @param uniformID      ID of the uniform variable
      */
-    void setUniform(ShaderProgram& shaderProgram, const std::string& uniformName) const override;
+    void setUniform(ShaderProgram& shaderProgram, const UniformID& uniformID) const override;
 
     bool isEnabled; // Flag telling if calculations with material are enabled
     float specularIntensity; // Factor to multiply specular highlight by
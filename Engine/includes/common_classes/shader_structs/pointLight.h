@@ -13,6 +13,21 @@ namespace shader_structs {
  */
 struct PointLight : ShaderStruct
 {
+    /**
+     * Point light laid out according to std140 rules (as a member of uniform block).
+     */
+    struct Std140
+    {
+        glm::vec3 position;
+        float __DUMMY_PADDING0__; // Color starts at next vec4 boundary
+        glm::vec3 color;
+        float ambientFactor;
+        float constantAttenuation;
+        float linearAttenuation;
+        float exponentialAttenuation;
+        GLint isOn;
+    };
+
     PointLight(const glm::vec3& position, const glm::vec3& color, const float ambientFactor,
         const float constantAttenuation, const float linearAttenuation, const float exponentialAttenuation,
         const bool isOn = true);
@@ -21,9 +36,9 @@ struct PointLight : ShaderStruct
      * Sets point light in a shader program.
      *
      * @param shaderProgram  Shader program to set point light in
-     * @param uniformName    Name of the uniform variable
+     * @param uniformID      ID of the uniform variable
      */
-    void setUniform(ShaderProgram& shaderProgram, const std::string& uniformName) const override;
+    void setUniform(ShaderProgram& shaderProgram, const UniformID& uniformID) const override;
 
     /**
      * Gets data size of the structure (in bytes) according to std140 layout rules.
@@ -31,6 +46,11 @@ struct PointLight : ShaderStruct
     static GLsizeiptr getDataSizeStd140();
     void* getDataPointer() const override;
 
+    /**
+     * Gets this point light laid out according to std140 rules.
+     */
+    Std140 getStd140() const;
+
     /**
      * Returns a point light that is off and does not contribute at all.
      */
@@ -15,22 +15,11 @@ public:
      * Sets this shader structure as uniform variable.
      *
      * @param shaderProgram  Shader program to set uniform variable in
-     * @param uniformName    Name of the uniform variable
+     * @param uniformID      ID of the uniform variable (members are addressed with UniformID::member)
      */
-    virtual void setUniform(ShaderProgram& shaderProgram, const std::string& uniformName) const = 0;
+    virtual void setUniform(ShaderProgram& shaderProgram, const UniformID& uniformID) const = 0;
 
     virtual void* getDataPointer() const { return nullptr; }
-
-protected:
-    /**
-     * Constructs full uniform name containing of structure name and attribute name.
-     *
-     * @param uniformName    Name of the uniform variable
-     * @param attributeName  Name of the attribute in that structure
-     *
-     * @return Full uniform name.
-     */
-    static std::string constructAttributeName(const std::string& uniformName, const std::string& attributeName);
 };
 
 } // namespace shader_structs
\ No newline at end of file
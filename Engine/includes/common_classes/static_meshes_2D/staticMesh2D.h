@@ -2,6 +2,7 @@
 
 // Project
 #include "../vertexBufferObject.h"
+#include "../glStateCache.h"
 
 namespace static_meshes_2D {
 
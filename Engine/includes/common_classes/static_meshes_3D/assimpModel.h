@@ -3,6 +3,9 @@
 // STL
 #include <vector>
 #include <map>
+#include <cstdint>
+#include <future>
+#include <memory>
 
 // Assimp
 #include <assimp/Importer.hpp>
@@ -11,18 +14,26 @@
 #include <glm/glm.hpp>
 
 // Project
-#include "staticMesh3D.h"
+#include "staticMeshIndexed3D.h"
+#include "../memoryMappedFile.h"
 
 namespace static_meshes_3D {
 
 /**
- * Represents 3D model loaded with Assimp library.
+ * Represents 3D model loaded with Assimp library. Vertices shared by faces are stored only once
+ * and meshes are rendered from an index buffer with cache-optimized triangle order.
+ * Imported data are baked into a binary cache file next to the model, so that the next
+ * load can skip Assimp entirely and upload the memory-mapped cache directly.
  */
-class AssimpModel : public StaticMesh3D
+class AssimpModel : public StaticMeshIndexed3D
 {
 public:
+    static const std::string MESH_CACHE_EXTENSION; // Extension appended to the model path to get path of its baked cache
+    static const uint32_t MESH_CACHE_VERSION; // Version of the cache format, bump whenever the layout or import changes
+
     AssimpModel(const std::string& filePath, const std::string& defaultTextureName, bool withPositions, bool withTextureCoordinates, bool withNormals, const glm::mat4& modelTransformMatrix = glm::mat4(1.0f));
     AssimpModel(const std::string& filePath, bool withPositions = true, bool withTextureCoordinates = true, bool withNormals = true, const glm::mat4& modelTransformMatrix = glm::mat4(1.0f));
+    ~AssimpModel() override;
 
     /**
      * Loads a model from a given file using Assimp library. Default texture name should be provided,
@@ -36,18 +47,199 @@ public:
      */
     bool loadModelFromFile(const std::string& filePath, const std::string& defaultTextureName = "", const glm::mat4& modelTransformMatrix = glm::mat4(1.0f));
 
+    /**
+     * Loads a model asynchronously - hashing, reading the cache or importing with Assimp happens on a worker
+     * thread, GPU upload happens on the context thread, when AsyncAssetLoader processes its tasks. Model is not
+     * rendered until it's loaded and its textures might arrive a bit later. If the model gets destroyed (or starts
+     * loading another file) before the loading finishes, the loading is cancelled and the future holds an error.
+     *
+     * @param filePath              File path to load model from (can be of any format supported by Assimp)
+     * @param defaultTextureName    Optional default texture name, if model would be loaded without textures
+     * @param modelTransformMatrix  Optional parameter to transform the model data
+     *
+     * @return Future that becomes ready once the model is uploaded (holds std::runtime_error if loading has failed).
+     */
+    std::shared_future<void> loadModelFromFileAsync(const std::string& filePath, const std::string& defaultTextureName = "", const glm::mat4& modelTransformMatrix = glm::mat4(1.0f));
+
     void render() const override;
     void renderPoints() const override;
 
+    /**
+     * Submits every mesh of the model as a separate packet with its material texture bound to texture unit 0,
+     * so that the meshes with the same material are grouped together across all models.
+     */
+    void submit(RenderQueue& renderQueue, RenderQueue::DrawPacket packet) const override;
+
+    /**
+     * Gets minimal corner of the bounding box of all vertices (in model space, after the model transform).
+     */
+    glm::vec3 getBoundsMin() const;
+
+    /**
+     * Gets maximal corner of the bounding box of all vertices (in model space, after the model transform).
+     */
+    glm::vec3 getBoundsMax() const;
+
 protected:
-    void loadMaterialTexture(const int materialIndex, const std::string& textureFileName);
+    /**
+     * Header of the baked mesh cache file. It's followed by mesh ranges, material texture
+     * names, vertex data (in the layout of the VBO) and index data.
+     */
+    struct MeshCacheHeader
+    {
+        uint32_t magic; // Magic number identifying the cache file
+        uint32_t version; // Version of the cache format
+        uint64_t sourceHash; // Hash of the source model file contents
+        uint64_t importKeyHash; // Hash of the import flags, present attributes and model transform
+        uint32_t indexType; // Type of the indices (GL_UNSIGNED_SHORT or GL_UNSIGNED_INT)
+        uint32_t numMeshes; // Number of mesh ranges
+        int32_t numVertices; // Total number of vertices
+        int32_t numIndices; // Total number of indices
+        uint64_t materialTexturesOffset; // Byte offset of material texture names
+        uint64_t materialTexturesCount; // Number of material texture names
+        uint64_t vertexDataOffset; // Byte offset of the vertex data
+        uint64_t vertexDataSize; // Byte size of the vertex data
+        uint64_t indexDataOffset; // Byte offset of the index data
+        uint64_t indexDataSize; // Byte size of the index data
+    };
+
+    /**
+     * Model data prepared on CPU, ready to be uploaded to the GPU. Holds everything the preparation produces,
+     * so that a worker thread never touches members of the model - they are set from these on the context thread.
+     */
+    struct ModelData
+    {
+        bool hasPositions = true; // Flag telling, if the vertex data should have positions (copied from the model)
+        bool hasTextureCoordinates = true; // Flag telling, if the vertex data should have texture coordinates (copied from the model)
+        bool hasNormals = true; // Flag telling, if the vertex data should have normals (copied from the model)
+        std::string modelRootDirectoryPath; // Path of the directory where model (and possibly its assets) is located
+        std::vector<int> meshBaseVertices; // Indices of the first vertex of every mesh
+        std::vector<int> meshStartIndices; // Indices of where the meshes start in the index data
+        std::vector<int> meshIndicesCount; // How many indices are there for every mesh
+        std::vector<int> meshMaterialIndices; // Index of material for every mesh
+        GLenum indexType = GL_UNSIGNED_INT; // Type of indices in the index data
+        int numVertices = 0; // Total number of vertices
+        int numIndices = 0; // Total number of indices
+        MemoryMappedFile cacheFile; // Mapped baked cache, if the model has been loaded from it
+        std::vector<unsigned char> vertexData; // Vertex data, if the model has been imported with Assimp
+        std::vector<unsigned char> indexData; // Index data, if the model has been imported with Assimp
+        const unsigned char* vertexDataPtr = nullptr; // Pointer to the vertex data to upload (either from cache or imported)
+        size_t vertexDataSize = 0; // Byte size of the vertex data
+        const unsigned char* indexDataPtr = nullptr; // Pointer to the index data to upload (either from cache or imported)
+        size_t indexDataSize = 0; // Byte size of the index data
+        std::map<int, std::string> materialTextureFileNames; // Map for index of material -> texture file name
+
+        /**
+         * Gets byte size of one vertex (depending on present vertex attributes).
+         */
+        int getVertexByteSize() const;
+    };
+
+    /**
+     * State of the asynchronous loading shared with the loading tasks. Worker thread works only with this state,
+     * model itself is touched on the context thread and only if the loading hasn't been cancelled meanwhile.
+     */
+    struct ModelLoadingState
+    {
+        AssimpModel* model = nullptr; // Model being loaded, valid only until the loading is cancelled
+        std::string filePath; // File path to load model from
+        std::string defaultTextureName; // Default texture name (might be empty)
+        glm::mat4 modelTransformMatrix = glm::mat4(1.0f); // Matrix used to transform the model data
+        ModelData modelData; // Model data prepared by the worker thread
+        bool isCancelled = false; // Set, when model gets destroyed (or starts another loading) before the loading finishes
+    };
+
+    /**
+     * Copies vertex attributes present in the model into model data, so that they can be prepared without the model.
+     */
+    void setVertexLayout(ModelData& modelData) const;
+
+    /**
+     * Cancels asynchronous loading in progress (if any), its results are thrown away.
+     */
+    void cancelLoading();
+
+    /**
+     * Prepares model data either from baked cache or by importing with Assimp. Vertex layout of the model data
+     * must be set already. Does not touch OpenGL nor the model, so it's safe to call from a worker thread.
+     *
+     * @return True, if model data have been prepared successfully or false otherwise.
+     */
+    static bool prepareModelData(const std::string& filePath, const std::string& defaultTextureName, const glm::mat4& modelTransformMatrix, ModelData& modelData);
+
+    /**
+     * Takes over mesh ranges of prepared model data, uploads the data to the GPU and loads the material textures.
+     *
+     * @param modelData           Prepared model data
+     * @param defaultTextureName  Default texture name (might be empty)
+     * @param loadTexturesAsync   True, if the textures should be loaded asynchronously
+     */
+    void createFromModelData(ModelData& modelData, const std::string& defaultTextureName, bool loadTexturesAsync);
+
+    /**
+     * Imports the model using Assimp and flattens it into vertex and index data of model data ready for upload.
+     *
+     * @param filePath              File path to load model from
+     * @param defaultTextureName    Default texture name (if not empty, material textures are not parsed)
+     * @param modelTransformMatrix  Matrix used to transform the model data
+     * @param modelData             Output model data (mesh ranges, vertex and index data and material texture names)
+     *
+     * @return True, if model has been imported successfully or false otherwise.
+     */
+    static bool importModelWithAssimp(const std::string& filePath, const std::string& defaultTextureName, const glm::mat4& modelTransformMatrix, ModelData& modelData);
+
+    /**
+     * Maps the baked mesh cache into model data and reads mesh ranges and material texture names from it, if it's valid.
+     *
+     * @param cacheFilePath  Path to the cache file
+     * @param sourceHash     Expected hash of the source model file
+     * @param importKeyHash  Expected hash of the import settings
+     * @param modelData      Output model data (cache stays mapped in it, while it's uploaded)
+     *
+     * @return True, if cache exists and matches the source model and import settings or false otherwise.
+     */
+    static bool loadModelFromCache(const std::string& cacheFilePath, uint64_t sourceHash, uint64_t importKeyHash, ModelData& modelData);
+
+    /**
+     * Writes imported model data into a baked mesh cache file.
+     *
+     * @return True, if cache has been written successfully or false otherwise.
+     */
+    static bool saveModelToCache(const std::string& cacheFilePath, uint64_t sourceHash, uint64_t importKeyHash, const ModelData& modelData);
+
+    /**
+     * Creates VAO and uploads vertex and index data to the GPU.
+     */
+    void uploadModelData(const void* vertexData, size_t vertexDataSize, const void* indexData, size_t indexDataSize);
+
+    /**
+     * Computes hash of all the settings, that influence the imported data (including vertex layout of the model data).
+     */
+    static uint64_t getImportKeyHash(const ModelData& modelData, const std::string& defaultTextureName, const glm::mat4& modelTransformMatrix);
+
+    /**
+     * Issues draw call of one mesh of the model (VAO and textures must be bound already).
+     */
+    void renderMesh(size_t meshIndex) const;
+
+    /**
+     * Issues instanced draw calls of all meshes, binding their material textures.
+     */
+    void renderInstancedGeometry(GLsizei numInstances) const override;
+
+    void loadMaterialTexture(const int materialIndex, const std::string& textureFileName, bool loadAsync = false);
     static std::string aiStringToStdString(const aiString& aiStringStruct);
 
     std::string _modelRootDirectoryPath; // Path of the directory where model (and possibly its assets) is located
-    std::vector<int> _meshStartIndices; // Indices of where the meshes start in the VBO
-    std::vector<int> _meshVerticesCount; // How many vertices are there for every mesh
+    std::vector<int> _meshBaseVertices; // Indices of the first vertex of every mesh in the VBO
+    std::vector<int> _meshStartIndices; // Indices of where the meshes start in the indices VBO
+    std::vector<int> _meshIndicesCount; // How many indices are there for every mesh
     std::vector<int> _meshMaterialIndices; // Index of material for every mesh
     std::map<int, std::string> _materialTextureKeys; // Map for index of material -> texture key to be retrieved from TextureManager
+    GLenum _indexType = GL_UNSIGNED_INT; // Type of indices in the indices VBO (GL_UNSIGNED_SHORT if every mesh fits into 16 bits)
+    glm::vec3 _boundsMin = glm::vec3(0.0f); // Minimal corner of the bounding box of all vertices
+    glm::vec3 _boundsMax = glm::vec3(0.0f); // Maximal corner of the bounding box of all vertices
+    std::shared_ptr<ModelLoadingState> _loadingState; // State of the asynchronous loading in progress shared with the loading tasks
 };
 
 }; // namespace static_meshes_3D
\ No newline at end of file
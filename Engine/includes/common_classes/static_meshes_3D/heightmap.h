@@ -6,6 +6,7 @@
 
 #include "../shaderProgram.h"
 #include "../vertexBufferObject.h"
+#include "../textureArray.h"
 #include "staticMeshIndexed3D.h"
 
 namespace static_meshes_3D {
@@ -15,12 +16,42 @@ class Heightmap : public StaticMeshIndexed3D
 {
 public:
     static const std::string MULTILAYER_SHADER_PROGRAM_KEY; // Holds a key for multilayer heightmap shader program (used as shaders key too)
+    static const int ENVIRONMENT_TEXTURE_UNIT; // Texture unit, where environment cube map for ambient lighting is expected (units below are for terrain textures)
+    static constexpr int MAX_SPLAT_LAYERS{ 4 }; // Maximal number of terrain layers blended by splat weights (one per vec4 component)
+    static const int SPLAT_WEIGHTS_ATTRIBUTE_INDEX; // Vertex attribute location of the splat weights
+    static const int CHUNK_SIZE; // Number of quads along the side of a terrain chunk (chunks can be drawn and culled separately)
 
     struct ShaderConstants
     {
-        DEFINE_SHADER_CONSTANT_INDEX(terrainSampler, "terrainSampler")
-        DEFINE_SHADER_CONSTANT_INDEX(levels, "levels")
-        DEFINE_SHADER_CONSTANT(numLevels, "numLevels")
+        DEFINE_SHADER_UNIFORM(terrainLayers, "terrainLayers")
+        DEFINE_SHADER_UNIFORM(environmentSampler, "environmentSampler")
+        DEFINE_SHADER_UNIFORM(environmentFactor, "environmentFactor")
+    };
+
+    /**
+     * Parameters of computing per-vertex weights of the terrain layers. Height levels work the same way
+     * as they used to in the shader, slope and erosion wetness then blend in their own layers on top.
+     */
+    struct SplatParameters
+    {
+        std::vector<float> levels; // Heights, where layers start and end blending (two per layer transition)
+        int slopeLayer{ -1 }; // Layer covering steep terrain (-1 means slope is ignored)
+        float slopeStart{ 0.3f }; // Steepness (1 - normal.y), where slope layer starts blending in
+        float slopeEnd{ 0.5f }; // Steepness, where slope layer covers the terrain completely
+        int wetLayer{ -1 }; // Layer covering terrain, where eroding water flowed (-1 means wetness is ignored)
+        float wetnessSaturation{ 0.5f }; // Wetness (0 - 1, relative to the wettest spot of erosion runs), at which wet layer covers the terrain completely
+        float heightScale{ 1.0f }; // Rendered height divided by rendered width, so that slope matches the rendered terrain
+    };
+
+    /**
+     * Square part of the terrain with its own range in the index buffer, so that it can be drawn on its own.
+     */
+    struct Chunk
+    {
+        GLsizei firstIndex{ 0 }; // Index of the first chunk index in the index buffer
+        GLsizei numIndices{ 0 }; // Number of indices of the chunk (including primitive restarts)
+        glm::vec3 boundsMin{ 0.0f }; // Minimal corner of the chunk bounding box (in model space)
+        glm::vec3 boundsMax{ 0.0f }; // Maximal corner of the chunk bounding box (in model space)
     };
 
     struct HillAlgorithmParameters
@@ -47,6 +78,8 @@ public:
 
     Heightmap(const HillAlgorithmParameters& params, bool withPositions = true, bool withTextureCoordinates = true, bool withNormals = true);
     Heightmap(const std::string& fileName, bool withPositions = true, bool withTextureCoordinates = true, bool withNormals = true);
+    Heightmap(const std::vector<std::vector<float>>& heightData, bool withPositions = true, bool withTextureCoordinates = true, bool withNormals = true);
+    ~Heightmap();
 
     static void prepareMultiLayerShaderProgram();
     static ShaderProgram& getMultiLayerShaderProgram();
@@ -55,7 +88,57 @@ public:
 
     void render() const override;
 
-    void renderMultilayered(const std::vector<std::string>& textureKeys, const std::vector<float> levels) const;
+    void deleteMesh() override;
+
+    /**
+     * Loads images of the terrain layers into texture array used by multilayer rendering.
+     *
+     * @param filePaths  Paths to image files, one per layer (at most MAX_SPLAT_LAYERS)
+     *
+     * @return True, if the layers have been loaded correctly or false otherwise.
+     */
+    bool loadSplatLayers(const std::vector<std::string>& filePaths);
+
+    /**
+     * Sets parameters of the splat weights and recomputes the weights of all vertices.
+     */
+    void setSplatParameters(const SplatParameters& splatParameters);
+
+    /**
+     * Renders heightmap with multilayer shader program, layers are blended by precomputed splat weights.
+     */
+    void renderMultilayered() const;
+
+    /**
+     * Submits heightmap rendered with multilayer shader program to the render queue.
+     *
+     * @param renderQueue  Render queue to submit the heightmap to
+     * @param modelMatrix  Model matrix of the heightmap
+     */
+    void submitMultilayered(RenderQueue& renderQueue, const glm::mat4& modelMatrix) const;
+
+    /**
+     * Gets chunks of the terrain, they cover the whole heightmap and are rebuilt with the mesh.
+     */
+    const std::vector<Chunk>& getChunks() const;
+
+    /**
+     * Renders single chunk of the terrain (shader program must be in use).
+     *
+     * @param chunkIndex  Index of the chunk to render
+     */
+    void renderChunk(size_t chunkIndex) const;
+
+    /**
+     * Creates draw packet of single terrain chunk rendered with multilayer shader program, so that the caller
+     * can decide on its own, if and how the chunk is submitted (e.g. after occlusion culling).
+     *
+     * @param modelMatrix  Model matrix of the heightmap
+     * @param chunkIndex   Index of the chunk
+     *
+     * @return Draw packet of the chunk (without draw function, if the heightmap is not ready to be rendered).
+     */
+    RenderQueue::DrawPacket createMultilayeredChunkPacket(const glm::mat4& modelMatrix, size_t chunkIndex) const;
 
     void renderPoints() const override;
 
@@ -92,6 +175,7 @@ public:
     float depositionRate = 0.1;
     float minVol = 0.01;
     float friction = 0.05;
+    float wetnessRetention = 0.9f; // Part of the wetness kept from the previous erosion runs, so that old water trails fade out
 
     void set_dt(float _dt) { this->dt = _dt; }
 
@@ -100,12 +184,47 @@ private:
     void setUpVertices();
     void setUpTextureCoordinates();
     void setUpNormals();
+
+    /**
+     * Sets up index buffer chunk by chunk and computes bounding boxes of the chunks.
+     */
     void setUpIndexBuffer();
 
+    /**
+     * Creates draw packet with multilayer shader program and textures, but without the draw function.
+     */
+    RenderQueue::DrawPacket createMultilayeredPacket(const glm::mat4& modelMatrix) const;
+
+    /**
+     * Creates VBO with splat weights and sets up its vertex attribute (VAO must be bound).
+     */
+    void setUpSplatWeights();
+
+    /**
+     * Computes splat weights of all vertices and uploads them to the splat weights VBO.
+     */
+    void uploadSplatWeights();
+
+    /**
+     * Computes splat weights of a single vertex from its height, slope and accumulated wetness.
+     */
+    glm::vec4 computeSplatWeights(int row, int column) const;
+
+    /**
+     * Sets uniforms of the multilayer shader program (program must be in use).
+     */
+    static void setMultilayerUniforms();
+
  
     std::vector<std::vector<glm::vec3>> _vertices;
     std::vector<std::vector<glm::vec2>> _textureCoordinates;
     std::vector<std::vector<glm::vec3>> _normals;
+    std::vector<std::vector<float>> _wetness; // Wetness (0 - 1) averaged over erosion runs, indexed the same way as height data
+    std::vector<std::vector<float>> _erosionRunWetness; // Water volume that flowed over the terrain in the current erosion run
+    SplatParameters _splatParameters; // Parameters of computing splat weights
+    TextureArray _splatLayers; // Texture array with terrain layers
+    VertexBufferObject _splatWeightsVBO; // VBO with per-vertex weights of the terrain layers
+    std::vector<Chunk> _chunks; // Chunks of the terrain in the order of the index buffer
     int _rows = 0;
     int _columns = 0;
 
@@ -13,6 +13,13 @@ class HeightmapWithFog : public Heightmap
 public:
     static const std::string MULTILAYER_SHADER_PROGRAM_WITH_FOG_KEY; // Holds a key for multilayer heightmap shader program with a fog (used as shaders key too)
 
+    struct ShaderConstants
+    {
+        DEFINE_SHADER_UNIFORM_INDEX(terrainSampler, "terrainSampler")
+        DEFINE_SHADER_UNIFORM_INDEX(levels, "levels")
+        DEFINE_SHADER_UNIFORM(numLevels, "numLevels")
+    };
+
     HeightmapWithFog(const HillAlgorithmParameters& params, bool withPositions = true, bool withTextureCoordinates = true, bool withNormals = true);
     HeightmapWithFog(const std::string& fileName, bool withPositions = true, bool withTextureCoordinates = true, bool withNormals = true);
 
@@ -33,6 +33,7 @@ public:
     static glm::vec3 normals[6]; // Array of mesh normals
 
 private:
+    void renderInstancedGeometry(GLsizei numInstances) const override;
     void initializeData() override;
 };
 
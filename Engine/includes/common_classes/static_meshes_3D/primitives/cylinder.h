@@ -33,6 +33,7 @@ public:
     float getHeight() const;
 
 private:
+    void renderInstancedGeometry(GLsizei numInstances) const override;
     float _radius; // Cylinder radius (distance from the center of cylinder to surface)
     int _numSlices; // Number of cylinder slices
     float _height; // Height of the cylinder
@@ -23,6 +23,7 @@ public:
 	static glm::vec2 textureCoordinates[3]; // Array of mesh texture coordinates
 
 private:
+	void renderInstancedGeometry(GLsizei numInstances) const override;
 	void initializeData() override;
 };
 
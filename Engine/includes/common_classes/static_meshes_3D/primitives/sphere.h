@@ -35,6 +35,7 @@ public:
     int getNumStacks() const;
 
 private:
+    void renderInstancedGeometry(GLsizei numInstances) const override;
     float _radius; // Sphere radius
     int _numSlices; // Number of slices
     int _numStacks; // Number of stacks
@@ -28,6 +28,7 @@ public:
     float getTubeRadius() const;
 
 private:
+    void renderInstancedGeometry(GLsizei numInstances) const override;
     int _mainSegments; // Number of main subdivisons (around whole torus)
     int _tubeSegments; // Number of tube subdivisions
     float _mainRadius; // Radius of torus (distance from center of torus to the center of tube)
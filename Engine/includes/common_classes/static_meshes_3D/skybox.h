@@ -2,63 +2,109 @@
 
 // STL
 #include <string>
+#include <array>
+#include <memory>
+#include <mutex>
 
 // GLM
 #include <glm/glm.hpp>
 
 // Project
 #include "../shaderProgram.h"
+#include "../texture.h"
 #include "primitives/cube.h"
 
 namespace static_meshes_3D {
 
 /**
- * Skybox static mesh - basically cube with some additional textures
+ * Skybox static mesh - cube rendered with a cube map texture at the far plane.
  */
 class Skybox : public Cube
 {
 public:
     static const std::string SAMPLER_KEY; // Key to store skybox sampler with
+    static const std::string SHADER_PROGRAM_KEY; // Key to store skybox shader program with (used as shaders key too)
 
+    struct ShaderConstants
+    {
+        DEFINE_SHADER_UNIFORM(skyboxSampler, "skyboxSampler")
+    };
+
+    /**
+     * Creates skybox and starts loading its six faces in parallel. Faces are expected to be named
+     * right, left, top, bottom, front and back. Until all faces are loaded, skybox is not rendered.
+     *
+     * @param baseDirectory   Path to directory where skybox images are located
+     * @param imageExtension  Image extension of images (png, jpg etc.)
+     */
     Skybox(const std::string& baseDirectory, const std::string& imageExtension, bool withPositions = true, bool withTextureCoordinates = true, bool withNormals = true);
     ~Skybox();
 
     /**
-     * Renders skybox around given point.
-     * 
-     * @param renderPosition  Position to render skybox around (usually around the player or camera)
-     * @param shaderProgram   Shader program used for rendering
+     * Loads skybox shaders and creates its shader program (it still has to be linked).
      */
-    void render(const glm::vec3& renderPosition, ShaderProgram& shaderProgram) const;
+    static void prepareShaderProgram();
 
-private:
-    std::string _baseDirectory; // Path to directory where skybox images are located
-    std::string _imageExtension; // Image extension of images, should be consistent (png, jpg etc.)
+    /**
+     * Gets skybox shader program.
+     */
+    static ShaderProgram& getShaderProgram();
 
     /**
-     * Gets filename of a specified skybox side.
+     * Renders skybox around the camera in a single draw call. Skybox is rendered at the far plane,
+     * so it should be rendered after all opaque geometry - covered pixels are rejected by early depth test.
+     * Camera matrices are taken from the frame constants uniform block.
      *
-     * @param sideBit  Bit that represents the cube side (from cube.h)
+     * @param color  Color multiplying the skybox texture
+     */
+    void render(const glm::vec4& color = glm::vec4(1.0f)) const;
+
+    /**
+     * Binds skybox cube map together with skybox sampler to specified texture unit,
+     * so that it can be sampled by other shaders as well (e.g. for ambient lighting).
      *
-     * @return Combined directory path, side name and image extension.
+     * @param textureUnit  Texture unit index
      */
-    static std::string getSideFileName(const int sideBit);
+    void bindCubeMap(GLenum textureUnit) const;
 
     /**
-     * Gets texture key of a specified skybox side.
+     * Checks, if all the faces have been loaded and cube map has been created.
+     */
+    bool isLoaded() const;
+
+private:
+    /**
+     * Faces of the cube map being decoded on worker threads.
+     */
+    struct CubeMapLoadingState
+    {
+        std::array<Texture::ImageData, 6> faces; // Decoded faces in order of GL_TEXTURE_CUBE_MAP_POSITIVE_X + i
+        std::array<bool, 6> isFaceDecoded{}; // Flags telling, if the face has been decoded successfully
+        int numFacesRemaining = 6; // Number of faces that are still being decoded
+        std::mutex mutex; // Mutex guarding the number of remaining faces
+        bool isCancelled = false; // Set, when skybox gets destroyed before the loading finishes
+    };
+
+    std::string _baseDirectory; // Path to directory where skybox images are located
+    std::string _imageExtension; // Image extension of images, should be consistent (png, jpg etc.)
+    std::shared_ptr<CubeMapLoadingState> _loadingState; // State of the loading shared with the loading tasks
+    GLuint _cubeMapTextureID = 0; // OpenGL-assigned ID of the cube map texture
+
+    /**
+     * Gets file name of a specified cube map face.
      *
-     * @param sideBit  Bit that represents the cube side (from cube.h)
+     * @param faceIndex  Index of the face (0 to 5, in order of GL_TEXTURE_CUBE_MAP_POSITIVE_X + i)
      *
-     * @return Key, within which is texture of this skybox stored.
+     * @return Combined directory path, side name and image extension.
      */
-    std::string getTextureKey(const int sideBit) const;
+    std::string getFaceFileName(int faceIndex) const;
 
     /**
-     * Tries to load the texture of a specified skybox side. If suceeeds, texture is stored in manager.
-     * 
-     * @param sideBit  Bit that represents the cube side (from cube.h)
+     * Creates cube map texture with immutable storage from decoded faces.
+     *
+     * @param loadingState  State with all faces decoded
      */
-    void tryLoadTexture(const int sideBit) const;
+    void createCubeMap(const CubeMapLoadingState& loadingState);
 };
 
-} // namespace static_meshes_3D
\ No newline at end of file
+} // namespace static_meshes_3D
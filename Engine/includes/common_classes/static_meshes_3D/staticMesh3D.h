@@ -1,7 +1,15 @@
 #pragma once
 
+// STL
+#include <vector>
+
+// GLM
+#include <glm/glm.hpp>
+
 // Project
 #include "../vertexBufferObject.h"
+#include "../glStateCache.h"
+#include "../renderQueue.h"
 
 namespace static_meshes_3D {
 
@@ -14,6 +22,7 @@ public:
 	static const int POSITION_ATTRIBUTE_INDEX; // Vertex attribute index of vertex position (0)
 	static const int TEXTURE_COORDINATE_ATTRIBUTE_INDEX; // Vertex attribute index of texture coordinate (1)
 	static const int NORMAL_ATTRIBUTE_INDEX; // Vertex attribute index of vertex normal (2)
+	static const int INSTANCE_MATRIX_ATTRIBUTE_INDEX; // First vertex attribute index of per-instance model matrix (4, occupies 4 - 7)
 
 	StaticMesh3D(bool withPositions, bool withTextureCoordinates, bool withNormals);
 	virtual ~StaticMesh3D();
@@ -29,6 +38,40 @@ public:
 	 */
 	virtual void renderPoints() const {}
 
+	/**
+	 * Renders many instances of the static mesh with a single instanced draw. Model matrices are streamed
+	 * into per-instance vertex attribute (INSTANCE_MATRIX_ATTRIBUTE_INDEX), normal matrices are derived
+	 * in the vertex shader. Only meshes overriding renderInstancedGeometry support this.
+	 *
+	 * @param modelMatrices  Pointer to the model matrices of all instances
+	 * @param numInstances   Number of instances to render
+	 */
+	void renderInstanced(const glm::mat4* modelMatrices, size_t numInstances) const;
+
+	/**
+	 * Renders many instances of the static mesh with a single instanced draw.
+	 *
+	 * @param modelMatrices  Model matrices of all instances
+	 */
+	void renderInstanced(const std::vector<glm::mat4>& modelMatrices) const;
+
+	/**
+	 * Submits static mesh to the render queue. Caller sets shader program, textures and model matrix
+	 * of the packet, mesh adds its VAO and the draw call.
+	 *
+	 * @param renderQueue  Render queue to submit the mesh to
+	 * @param packet       Draw packet with shader program, textures and model matrix set
+	 */
+	virtual void submit(RenderQueue& renderQueue, RenderQueue::DrawPacket packet) const;
+
+	/**
+	 * Submits static mesh rendered as points to the render queue.
+	 *
+	 * @param renderQueue  Render queue to submit the mesh to
+	 * @param packet       Draw packet with shader program, textures and model matrix set
+	 */
+	virtual void submitPoints(RenderQueue& renderQueue, RenderQueue::DrawPacket packet) const;
+
 	/**
 	 * Deletes static mesh data.
 	 */
@@ -63,6 +106,17 @@ protected:
 	GLuint _vao = 0; // VAO ID from OpenGL
 	VertexBufferObject _vbo; // Our VBO wrapper class holding static mesh data
 
+	mutable VertexBufferObject _instanceVBO; // VBO with per-instance model matrices (created with first instanced render)
+	mutable bool _isUnsupportedInstancingReported = false; // Instanced rendering of mesh not supporting it is reported only once
+
+	/**
+	 * Issues instanced draw calls of the mesh (VAO with instance attributes is already bound). Default implementation
+	 * only reports, that the mesh doesn't support instancing (not all meshes do).
+	 *
+	 * @param numInstances  Number of instances to render
+	 */
+	virtual void renderInstancedGeometry(GLsizei numInstances) const;
+
 	/**
 	 * Initializes vertex data. Default implementation does nothing as its not needed for all classes
 	 */
@@ -2,6 +2,8 @@
 
 // STL
 #include <string>
+#include <vector>
+#include <cstdint>
 
 // GLAD
 #include <glad/glad.h>
@@ -12,6 +14,33 @@
 class Texture
 {
 public:
+    static const std::string TEXTURE_CACHE_EXTENSION; // Extension appended to the image path to get path of its decoded cache
+    static const uint32_t TEXTURE_CACHE_VERSION; // Version of the cache format, bump whenever the layout changes
+
+    /**
+     * One level of the mip chain stored in ImageData.
+     */
+    struct MipLevel
+    {
+        GLsizei width; // Width of the level in pixels
+        GLsizei height; // Height of the level in pixels
+        size_t offset; // Byte offset of the level in the pixels buffer
+        size_t size; // Byte size of the level
+    };
+
+    /**
+     * Image decoded into memory together with its whole mip chain, ready to be uploaded as a texture.
+     */
+    struct ImageData
+    {
+        std::vector<unsigned char> pixels; // Decoded pixels of all mip levels, rows are ordered bottom to top as OpenGL expects
+        std::vector<MipLevel> mipLevels; // Mip levels stored in pixels buffer, level 0 is the original image
+        GLsizei width = 0; // Width of the image in pixels
+        GLsizei height = 0; // Height of the image in pixels
+        GLenum format = 0; // Format of the pixels (e.g. GL_RGB)
+        std::string filePath; // Path of the file the image has been decoded from
+    };
+
     ~Texture();
 
     /**
@@ -36,6 +65,29 @@ public:
      */
     bool loadTexture2D(const std::string& filePath, bool generateMipmaps = true);
 
+    /**
+     * Decodes image file into memory and computes its mip chain. Decoded data are stored in a cache file next
+     * to the image (keyed by hash of the image file), which is preferred over decoding next time.
+     * Does not touch OpenGL, so it's safe to call from any thread.
+     *
+     * @param filePath         Path to an image file
+     * @param imageData        Output decoded image
+     * @param generateMipmaps  True to compute the mip chain, otherwise only level 0 is decoded (and cached)
+     *
+     * @return True, if the image has been decoded correctly or false otherwise.
+     */
+    static bool decodeImage(const std::string& filePath, ImageData& imageData, bool generateMipmaps = true);
+
+    /**
+     * Creates 2D OpenGL texture with immutable storage from previously decoded image.
+     *
+     * @param imageData        Decoded image
+     * @param generateMipmaps  True, if the precomputed mipmaps should be uploaded as well
+     *
+     * @return True, if the texture has been created correctly or false otherwise.
+     */
+    bool createFromImageData(const ImageData& imageData, bool generateMipmaps = true);
+
     /**
      * Binds texture to specified texture unit.
      * 
@@ -78,6 +130,15 @@ public:
      * Gets number of available OpenGL texture image units of current hardware.
      */
     static int getNumTextureImageUnits();
+
+    /**
+     * Gets sized internal format used for immutable storage of textures with given pixel format.
+     *
+     * @param format  Format of the pixels (e.g. GL_RGB)
+     *
+     * @return Sized internal format (e.g. GL_RGB8).
+     */
+    static GLenum getSizedInternalFormat(GLenum format);
     
 private:
     GLuint textureID_ = 0; // OpenGL-assigned texture ID
@@ -92,4 +153,31 @@ private:
      * @return True, if texture has been loaded correctly or false otherwise.
      */
     bool isLoadedCheck() const;
+
+    /**
+     * Tries to read decoded image from the texture cache.
+     *
+     * @param cacheFilePath    Path to the cache file
+     * @param sourceHash       Expected hash of the source image file
+     * @param generateMipmaps  True, if the whole mip chain is needed (cache with level 0 only doesn't do then)
+     * @param imageData        Output decoded image
+     *
+     * @return True, if cache exists and matches the source image or false otherwise.
+     */
+    static bool loadImageFromCache(const std::string& cacheFilePath, uint64_t sourceHash, bool generateMipmaps, ImageData& imageData);
+
+    /**
+     * Writes decoded image (with all its mip levels) into the texture cache.
+     *
+     * @return True, if cache has been written successfully or false otherwise.
+     */
+    static bool saveImageToCache(const std::string& cacheFilePath, uint64_t sourceHash, const ImageData& imageData);
+
+    /**
+     * Computes all mip levels of the image from its level 0 with a box filter.
+     *
+     * @param imageData      Image with level 0 already filled
+     * @param bytesPerPixel  Number of bytes of every pixel
+     */
+    static void generateMipChain(ImageData& imageData, int bytesPerPixel);
 };
\ No newline at end of file
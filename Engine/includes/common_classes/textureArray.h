@@ -0,0 +1,89 @@
+#pragma once
+
+// STL
+#include <string>
+#include <vector>
+
+// GLAD
+#include <glad/glad.h>
+
+// Project
+#include "texture.h"
+
+/**
+ * Wraps OpenGL 2D texture array (GL_TEXTURE_2D_ARRAY) into convenient class. All the layers share
+ * one immutable RGBA8 storage, so the whole array is bound to a single texture unit.
+ */
+class TextureArray
+{
+public:
+    ~TextureArray();
+
+    /**
+     * Loads image files as layers of 2D texture array. Images are decoded through the texture cache.
+     *
+     * @param filePaths        Paths to image files, one per layer
+     * @param generateMipmaps  True, if the precomputed mipmaps should be uploaded as well
+     *
+     * @return True, if the texture array has been loaded correctly or false otherwise.
+     */
+    bool loadTextureArray(const std::vector<std::string>& filePaths, bool generateMipmaps = true);
+
+    /**
+     * Creates texture array from previously decoded images. Layers have size of the smallest image,
+     * larger images contribute the mip level of exactly that size (so image sizes must differ by powers of two).
+     *
+     * @param layers           Decoded images, one per layer
+     * @param generateMipmaps  True, if the precomputed mipmaps should be uploaded as well
+     *
+     * @return True, if the texture array has been created correctly or false otherwise.
+     */
+    bool createFromImageData(const std::vector<Texture::ImageData>& layers, bool generateMipmaps = true);
+
+    /**
+     * Binds texture array to specified texture unit.
+     *
+     * @param textureUnit  Texture unit index (default is 0)
+     */
+    void bind(GLenum textureUnit = 0) const;
+
+    /**
+     * Deletes loaded texture array from OpenGL. Does nothing if the array has not been loaded correctly.
+     */
+    void deleteTextureArray();
+
+    /**
+     * Gets OpenGL-assigned texture ID
+     */
+    GLuint getID() const;
+
+    /**
+     * Gets width of every layer (in pixels).
+     */
+    GLsizei getWidth() const;
+
+    /**
+     * Gets height of every layer (in pixels).
+     */
+    GLsizei getHeight() const;
+
+    /**
+     * Gets number of layers of the texture array.
+     */
+    GLsizei getNumLayers() const;
+
+    bool isLoaded() const;
+
+private:
+    GLuint textureID_ = 0; // OpenGL-assigned texture ID
+    GLsizei width_ = 0; // Width of every layer in pixels
+    GLsizei height_ = 0; // Height of every layer in pixels
+    GLsizei numLayers_ = 0; // Number of layers
+
+    /**
+     * Finds mip level of the image with given size.
+     *
+     * @return Index of the mip level or -1, if the image has no such level.
+     */
+    static int findMipLevel(const Texture::ImageData& imageData, GLsizei width, GLsizei height);
+};
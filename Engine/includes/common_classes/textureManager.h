@@ -4,6 +4,7 @@
 #include <string>
 #include <map>
 #include <memory>
+#include <future>
 
 // Project
 #include "texture.h"
@@ -28,6 +29,19 @@ public:
     */
     void loadTexture2D(const std::string& key, const std::string& fileName, bool generateMipmaps = true);
 
+    /**
+     * Loads image file as 2D OpenGL texture asynchronously. Image is decoded on a worker thread and the texture
+     * is created on the context thread, when AsyncAssetLoader processes its tasks. Until then, texture is not
+     * contained in the manager. Loading the same key again returns the future of the pending load.
+     *
+     * @param key              key to store texture with
+     * @param fileName         path to an image file
+     * @param generateMipmaps  true, if mipmaps should be generated automatically
+     *
+     * @return Future that becomes ready once the texture is stored (holds std::runtime_error if loading has failed).
+     */
+    std::shared_future<void> loadTexture2DAsync(const std::string& key, const std::string& fileName, bool generateMipmaps = true);
+
     /**
      * Gets texture with a specified key.
      *
@@ -75,4 +89,5 @@ private:
 	void operator=(const TextureManager&) = delete; // No copy assignment allowed
 
     std::map<std::string, std::unique_ptr<Texture>> _textureCache; // Texture cache - stores textures within their keys in std::map
+    std::map<std::string, std::shared_future<void>> _pendingTextures; // Textures being loaded asynchronously, stored within their keys
 };
\ No newline at end of file
@@ -0,0 +1,67 @@
+#pragma once
+
+// STL
+#include <ostream>
+#include <string>
+#include <cstdint>
+#include <algorithm>
+
+/**
+ * Helpers shared by the frame profiler and the CPU instrumentation - rolling histories of per-frame values
+ * and writing of Chrome trace format (chrome://tracing, Perfetto).
+ */
+namespace trace_utils
+{
+
+/**
+ * Gets index following given index in a rolling history (ring buffer).
+ */
+inline int getNextHistoryIndex(int index, int historySize)
+{
+    return (index + 1) % historySize;
+}
+
+/**
+ * Gets index of the latest value in a rolling history. Offset points to the oldest value (the one overwritten next),
+ * so the latest value is just before it. Charts plotted from the offset scroll to the left.
+ */
+inline int getLatestHistoryIndex(int historyOffset, int historySize)
+{
+    return (historyOffset + historySize - 1) % historySize;
+}
+
+/**
+ * Writes string as JSON string literal (with quotes and escaped special characters).
+ */
+inline void writeJsonString(std::ostream& os, const std::string& value)
+{
+    os << '"';
+    for (const auto c : value)
+    {
+        if (c == '"' || c == '\\') {
+            os << '\\' << c;
+        }
+        else if (static_cast<unsigned char>(c) >= 0x20) {
+            os << c;
+        }
+    }
+    os << '"';
+}
+
+/**
+ * Writes one complete ("X") event of Chrome trace format (preceded by comma).
+ *
+ * @param os          Stream to write the event to
+ * @param name        Name of the event
+ * @param threadID    Thread (row of the trace) the event belongs to
+ * @param beginUs     Begin time of the event in microseconds
+ * @param durationUs  Duration of the event in microseconds (negative durations are written as zero)
+ */
+inline void writeCompleteEvent(std::ostream& os, const std::string& name, uint64_t threadID, double beginUs, double durationUs)
+{
+    os << ",\n{\"name\":";
+    writeJsonString(os, name);
+    os << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << threadID << ",\"ts\":" << beginUs << ",\"dur\":" << std::max(durationUs, 0.0) << "}";
+}
+
+} // namespace trace_utils
@@ -15,6 +15,7 @@ class TransformFeedbackParticleSystem
 public:
     const static int PARTICLE_TYPE_GENERATOR{ 0 }; // Represents generator particle
     const static int PARTICLE_TYPE_NORMAL{ 1 }; // Represents normal (non-generator) particle
+    const static int NUM_COUNT_QUERIES{ 4 }; // Number of queries in the ring reading back number of particles
     
     /**
      * Creates and initializes transform feedback particle system instance.
@@ -35,14 +36,17 @@ public:
 
     /**
      * Renders all particles from the current read buffer that were
-     * recorded during transform feedback.
+     * recorded during transform feedback. Number of particles is taken
+     * by the GPU directly from the transform feedback object, render shaders
+     * get particle type at attribute location 0 and must skip the generators.
      */
     void renderParticles();
 
     /**
      * Updates all particles in the current read buffer using render
      * process with transform feedback and records the updated particles
-     * into the current write buffer.
+     * into the current write buffer. CPU never waits for the number
+     * of recorded particles, the GPU draws exactly as many as were recorded.
      * 
      * @param deltaTime  Time passed since last frame (in seconds)
      */
@@ -64,7 +68,8 @@ public:
     int getNumMaxParticlesInBuffer() const;
 
     /**
-     * Gets number of particles currently stored in the buffer.
+     * Gets number of particles stored in the buffer a few frames ago. Number is read back
+     * asynchronously, only once the GPU has it available, so it's meant for display only.
      */
     int getNumParticles() const;
 
@@ -177,8 +182,11 @@ private:
 
     bool isInitialized_{ false }; // Flag telling if the particle system has been initialized
     
-    GLuint transformFeedbackID_; // ID of transform feedback (assigned by OpenGL)
-    GLuint numParticlesQueryID_; // ID of query (assigned by OpenGL) to ask about number of recorded primitives (particles in our case)
+    GLuint transformFeedbackIDs_[2]; // IDs of transform feedbacks (assigned by OpenGL), each one records into one of the VBOs and remembers the count
+    GLuint numParticlesQueryIDs_[NUM_COUNT_QUERIES]; // Ring of queries (assigned by OpenGL) to ask about number of recorded primitives (particles in our case)
+    bool isCountQueryPending_[NUM_COUNT_QUERIES]{}; // True for queries, whose result hasn't been read yet
+    int nextCountQueryIndex_{ 0 }; // Index of the query to issue next (it's also the oldest one in the ring)
+    bool isFeedbackRecorded_{ false }; // True, if particles have been recorded at least once (read buffer is not the initial one anymore)
 
     GLuint particlesVBOs_[2]; // IDs of VBOs for particles, one is used as input and other one is used for output
     GLuint updateVAOs_[2]; // VAOs for updating particles for both VBOs
@@ -191,7 +199,12 @@ private:
 
     /**
      * Generates all OpenGL objects required for the transform feedback particle system.
-     * This includes particles VBOs, all VAOs, transform feedback and query.
+     * This includes particles VBOs, all VAOs, transform feedbacks and queries.
      */
     void generateOpenGLObjects();
+
+    /**
+     * Reads results of the count queries, that are available already (from the oldest one), never blocks.
+     */
+    void collectParticleCount();
 };
\ No newline at end of file
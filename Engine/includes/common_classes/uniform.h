@@ -10,17 +10,89 @@
 // GLAD
 #include <glad/glad.h>
 
-// Forward class declaration of ShaderProgram (because of cross-inclusion)
-class ShaderProgram;
+// Project
+#include "hashUtils.h"
 
 /**
- * Wraps OpenGL shader uniform variable.
+ * Identifies uniform variable by hash of its full name (e.g. "matrices.modelMatrix" or "levels[2]").
+ * Constant IDs are hashed at compile-time, so looking up a uniform by ID costs no allocation and no string comparison.
+ */
+struct UniformID
+{
+    /**
+     * Creates uniform ID from uniform name. Name is kept only for diagnostic messages, so it has to outlive the ID
+     * (string literals are perfect for that).
+     */
+    constexpr explicit UniformID(const char* name)
+        : hash(hash_utils::fnv1aCString(name))
+        , name(name)
+    {
+    }
+
+    /**
+     * Creates uniform ID from runtime uniform name. Name is not stored.
+     */
+    explicit UniformID(const std::string& name)
+        : hash(hash_utils::fnv1a(name))
+    {
+    }
+
+    /**
+     * Gets ID of a member of this structure uniform (e.g. ambientLight -> ambientLight.color).
+     *
+     * @param memberName  Name of the member of the structure
+     */
+    constexpr UniformID member(const char* memberName) const
+    {
+        return UniformID(hash_utils::fnv1aCString(memberName, hash_utils::fnv1aCString(".", hash)), nullptr);
+    }
+
+    /**
+     * Gets ID of an element of this array uniform (e.g. levels -> levels[2]).
+     *
+     * @param index  Non-negative index of the element
+     */
+    constexpr UniformID at(const int index) const
+    {
+        auto result = hash_utils::fnv1aCString("[", hash);
+        auto divisor = 1;
+        while (index / divisor >= 10) {
+            divisor *= 10;
+        }
+
+        for (; divisor > 0; divisor /= 10)
+        {
+            const char digit[] = { static_cast<char>('0' + index / divisor % 10), '\0' };
+            result = hash_utils::fnv1aCString(digit, result);
+        }
+
+        return UniformID(hash_utils::fnv1aCString("]", result), nullptr);
+    }
+
+    uint64_t hash{ hash_utils::FNV_OFFSET_BASIS }; // FNV-1a hash of the full uniform name
+    const char* name{ nullptr }; // Name of the uniform (for diagnostic messages only), null for derived IDs
+
+private:
+    constexpr UniformID(const uint64_t hash, const char* name)
+        : hash(hash)
+        , name(name)
+    {
+    }
+};
+
+/**
+ * Wraps OpenGL shader uniform variable. It's just a resolved location, so it's cheap to create and copy.
  */
 class Uniform
 {
 public:
-    Uniform() = default; // Required to work with ShaderProgram [] operator
-    Uniform(const std::string& name, ShaderProgram* shaderProgram);
+    Uniform() = default;
+    explicit Uniform(GLint location);
+
+    /**
+     * Checks, if this uniform exists in the shader program (has valid location).
+     */
+    bool isValid() const;
 
     // Family of functions setting vec2 uniforms
     Uniform& operator=(const glm::vec2& vector2D);
@@ -59,7 +131,5 @@ public:
     void set(const glm::mat4* matrices, GLsizei count = 1) const;
 
 private:
-    std::string name_; // Name of the uniform variable
-    ShaderProgram* shaderProgram_{ nullptr }; // Pointer to shader program this uniform belongs to
-    GLint location_{ -1 }; // OpenGL assigned uniform location (cached in this variable)
+    GLint location_{ -1 }; // OpenGL assigned uniform location
 };
@@ -0,0 +1,110 @@
+#pragma once
+
+// STL
+#include <vector>
+
+// GLAD
+#include <glad/glad.h>
+
+// GLM
+#include <glm/glm.hpp>
+
+// Project
+#include "uniformBufferObject.h"
+#include "shader_structs/ambientLight.h"
+#include "shader_structs/diffuseLight.h"
+#include "shader_structs/pointLight.h"
+#include "shader_structs/fogParameters.h"
+
+/**
+ * Singleton class that manages uniform blocks shared by all shader programs - frame constants
+ * (common/frameConstants.glsl) and lights (lighting/lights.glsl). Both blocks live in one uniform buffer
+ * bound to fixed binding points, data are staged on CPU and uploaded at once with a single buffer update.
+ */
+class UniformBlockManager
+{
+public:
+    static const int MAX_POINT_LIGHTS{ 32 }; // Maximal number of point lights in lights block (has to match lights.glsl)
+
+    /**
+     * Frame constants block laid out according to std140 rules.
+     */
+    struct FrameConstantsStd140
+    {
+        glm::mat4 projectionMatrix;
+        glm::mat4 viewMatrix;
+        glm::vec4 eyePosition;
+    };
+
+    /**
+     * Lights block laid out according to std140 rules.
+     */
+    struct LightsStd140
+    {
+        shader_structs::AmbientLight::Std140 ambientLight;
+        shader_structs::DiffuseLight::Std140 diffuseLight;
+        shader_structs::FogParameters::Std140 fogParams;
+        GLint numPointLights;
+        GLint __DUMMY_PADDING0__[3]; // Array of structures starts at next vec4 boundary
+        shader_structs::PointLight::Std140 pointLights[MAX_POINT_LIGHTS];
+    };
+
+    /**
+     * Gets the one and only instance of the uniform block manager.
+     */
+    static UniformBlockManager& getInstance();
+
+    /**
+     * Creates uniform buffer holding all the blocks and binds the blocks to their binding points.
+     * Requires valid OpenGL context.
+     */
+    void createBlocks();
+
+    /**
+     * Sets frame constants. Data are uploaded with next call of uploadBlocks.
+     *
+     * @param projectionMatrix  Projection matrix of the current frame
+     * @param viewMatrix        View matrix of the current frame
+     * @param eyePosition       Position of the camera in world space
+     */
+    void setFrameConstants(const glm::mat4& projectionMatrix, const glm::mat4& viewMatrix, const glm::vec3& eyePosition);
+
+    /**
+     * Sets lights of the scene. Data are uploaded with next call of uploadBlocks.
+     *
+     * @param ambientLight  Ambient light of the scene
+     * @param diffuseLight  Diffuse (directional) light of the scene
+     * @param fogParams     Fog parameters of the scene
+     * @param pointLights   Point lights of the scene (only first MAX_POINT_LIGHTS are used)
+     */
+    void setLights(const shader_structs::AmbientLight& ambientLight, const shader_structs::DiffuseLight& diffuseLight,
+        const shader_structs::FogParameters& fogParams = shader_structs::FogParameters::noFog(),
+        const std::vector<shader_structs::PointLight>& pointLights = std::vector<shader_structs::PointLight>());
+
+    /**
+     * Uploads all the blocks that have changed since last upload with a single buffer update.
+     */
+    void uploadBlocks();
+
+    /**
+     * Deletes uniform buffer holding the blocks.
+     */
+    void deleteBlocks();
+
+private:
+    UniformBlockManager() {} // Private constructor to make class singleton
+    UniformBlockManager(const UniformBlockManager&) = delete; // No copy constructor allowed
+    void operator=(const UniformBlockManager&) = delete; // No copy assignment allowed
+
+    /**
+     * Marks byte range of staging data as changed.
+     */
+    void markDirty(size_t offset, size_t byteSize);
+
+    UniformBufferObject _uniformBuffer; // Uniform buffer holding data of all the blocks
+    std::vector<unsigned char> _stagingData; // CPU copy of the uniform buffer data
+    size_t _lightsOffset{ 0 }; // Byte offset of the lights block (aligned to GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT)
+    size_t _dirtyBegin{ 0 }; // Start of the range of staging data that has to be uploaded
+    size_t _dirtyEnd{ 0 }; // End of the range of staging data that has to be uploaded
+    bool _areBlocksCreated{ false }; // Flag telling, if the uniform buffer has been created
+};
@@ -1,5 +1,8 @@
 #pragma once
 
+// STL
+#include <cstddef>
+
 // GLAD
 #include <glad/glad.h>
 
@@ -40,6 +43,16 @@ public:
      */
     void bindBufferBaseToBindingPoint(const GLuint bindingPoint) const;
 
+    /**
+     * Binds part of the buffer to the given binding point. This way, one buffer can hold data
+     * of several uniform blocks. Offset must be multiple of GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT.
+     *
+     * @param bindingPoint  Binding point to bind buffer range to
+     * @param offset        Byte offset of the range
+     * @param byteSize      Size of the range in bytes
+     */
+    void bindBufferRangeToBindingPoint(const GLuint bindingPoint, const size_t offset, const size_t byteSize) const;
+
     /**
     * Gets OpenGL-assigned buffer ID.
     */
@@ -63,6 +76,6 @@ private:
 class UniformBlockBindingPoints
 {
 public:
-    static const int MATRICES{ 0 };
-    static const int POINT_LIGHTS{ 1 };
+    static const int FRAME_CONSTANTS{ 0 };
+    static const int LIGHTS{ 1 };
 };
\ No newline at end of file
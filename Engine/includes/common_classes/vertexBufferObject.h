@@ -59,6 +59,16 @@ public:
      */
     void uploadDataToGPU(GLenum usageHint);
 
+    /**
+     * Uploads data directly from given memory to the GPU, bypassing the in-memory buffer.
+     * Useful, when the data are already prepared somewhere (e.g. memory mapped file).
+     *
+     * @param ptrData        Pointer to the raw data (arbitrary type)
+     * @param dataSizeBytes  Size of the uploaded data (in bytes)
+     * @param usageHint      Hint for OpenGL, how is the data intended to be used (GL_STATIC_DRAW, GL_DYNAMIC_DRAW)
+     */
+    void uploadDataToGPU(const void* ptrData, size_t dataSizeBytes, GLenum usageHint);
+
     /**
      * Maps buffer data to a memory pointer.
      *
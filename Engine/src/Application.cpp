@@ -1,6 +1,7 @@
 // STL
-#include <iostream>
 #include <memory>
+#include <future>
+#include <vector>
 
 // GLM
 #include <glm/gtc/matrix_transform.hpp>
@@ -20,18 +21,37 @@
 #include "../includes/common_classes/textureManager.h"
 #include "../includes/common_classes/samplerManager.h"
 #include "../includes/common_classes/matrixManager.h"
+#include "../includes/common_classes/asyncAssetLoader.h"
+#include "../includes/common_classes/uniformBlockManager.h"
+#include "../includes/common_classes/glStateCache.h"
+#include "../includes/common_classes/renderQueue.h"
+#include "../includes/common_classes/frameProfiler.h"
+#include "../includes/common_classes/instrumentation.h"
+#include "../includes/common_classes/occlusionCuller.h"
 
 #include "../includes/common_classes/static_meshes_3D/skybox.h"
 #include "../includes/common_classes/static_meshes_3D/heightmap.h"
+#include "../includes/common_classes/static_meshes_3D/assimpModel.h"
+#include "../includes/common_classes/static_meshes_3D/primitives/sphere.h"
 
 #include "../includes/common_classes/shader_structs/ambientLight.h"
 #include "../includes/common_classes/shader_structs/diffuseLight.h"
+#include "../includes/common_classes/logManager.h"
+#include "../includes/common_classes/random.h"
 
 FlyingCamera camera(glm::vec3(0.0f, 25.0f, -60.0f), glm::vec3(0.0f, 25.0f, -59.0f), glm::vec3(0.0f, 1.0f, 0.0f), 15.0f);
 
 
 std::unique_ptr<static_meshes_3D::Heightmap> heightmap;
 std::unique_ptr<static_meshes_3D::Skybox> skybox;
+std::unique_ptr<static_meshes_3D::AssimpModel> houseModel;
+std::unique_ptr<static_meshes_3D::Sphere> rockMesh;
+std::vector<glm::vec4> rockPlacements; // XZ position, size and rotation angle of every rock
+std::vector<glm::mat4> rockModelMatrices; // Model matrices of the rocks rendered with a single instanced draw
+RenderQueue renderQueue;
+OcclusionCuller occlusionCuller;
+std::vector<int> terrainChunkObjects; // Occlusion culler objects of the terrain chunks
+std::vector<int> houseObjects; // Occlusion culler objects of the houses
 
 float rotationAngleRad = 0.0f;
 bool displayNormals = false;
@@ -42,6 +62,83 @@ shader_structs::DiffuseLight diffuseLight(glm::vec3(1.0f, 1.0f, 1.0f), glm::norm
 
 const glm::vec3 heightMapSize(200.0f, 50.0f, 200.0f);
 
+// Houses are scattered over the terrain, many of them end up hidden behind the ridges
+const std::vector<glm::vec2> housePositions = {
+	glm::vec2(-70.0f, -70.0f), glm::vec2(0.0f, -75.0f), glm::vec2(70.0f, -70.0f), glm::vec2(-75.0f, 0.0f),
+	glm::vec2(75.0f, 0.0f), glm::vec2(-70.0f, 70.0f), glm::vec2(0.0f, 75.0f), glm::vec2(70.0f, 70.0f),
+	glm::vec2(-35.0f, 35.0f), glm::vec2(35.0f, -35.0f)
+};
+const float houseHeight = 6.0f;
+
+// Rocks are too many to be drawn one by one, they are rendered with a single instanced draw
+const int numRocks = 4000;
+const float rockMinSize = 0.3f;
+const float rockMaxSize = 1.2f;
+
+/**
+ * Gets model matrix of the house standing on the terrain, model is scaled to the house height.
+ */
+glm::mat4 getHouseModelMatrix(const glm::vec2& position)
+{
+	const auto boundsMin = houseModel->getBoundsMin();
+	const auto boundsMax = houseModel->getBoundsMax();
+	const auto scale = boundsMax.y > boundsMin.y ? houseHeight / (boundsMax.y - boundsMin.y) : 1.0f;
+	const auto terrainHeight = heightmap->getRenderedHeightAtPosition(heightMapSize, glm::vec3(position.x, 0.0f, position.y));
+
+	auto modelMatrix = glm::translate(glm::mat4(1.0f), glm::vec3(position.x, terrainHeight, position.y));
+	modelMatrix = glm::scale(modelMatrix, glm::vec3(scale));
+	return glm::translate(modelMatrix, glm::vec3(-(boundsMin.x + boundsMax.x) / 2.0f, -boundsMin.y, -(boundsMin.z + boundsMax.z) / 2.0f));
+}
+
+/**
+ * Places rocks randomly over the terrain (their heights follow the terrain, see updateRockModelMatrices).
+ */
+void placeRocks()
+{
+	const auto halfSize = heightMapSize * 0.475f;
+	rockPlacements.clear();
+	for (auto i = 0; i < numRocks; i++)
+	{
+		const auto position = Random::getRandomVectorFromRectangleXZ(-halfSize, halfSize);
+		const auto size = rockMinSize + (rockMaxSize - rockMinSize) * static_cast<float>(Random::nextInt(1001)) / 1000.0f;
+		const auto rotationAngle = glm::radians(static_cast<float>(Random::nextInt(360)));
+		rockPlacements.emplace_back(position.x, position.z, size, rotationAngle);
+	}
+}
+
+/**
+ * Updates model matrices of the rocks, so that they lie on the terrain (it changes with erosion).
+ * Rocks are flattened spheres half sunk into the ground.
+ */
+void updateRockModelMatrices()
+{
+	rockModelMatrices.resize(rockPlacements.size());
+	for (size_t i = 0; i < rockPlacements.size(); i++)
+	{
+		const auto& placement = rockPlacements[i];
+		const auto terrainHeight = heightmap->getRenderedHeightAtPosition(heightMapSize, glm::vec3(placement.x, 0.0f, placement.y));
+
+		auto modelMatrix = glm::translate(glm::mat4(1.0f), glm::vec3(placement.x, terrainHeight, placement.y));
+		modelMatrix = glm::rotate(modelMatrix, placement.w, glm::vec3(0.0f, 1.0f, 0.0f));
+		rockModelMatrices[i] = glm::scale(modelMatrix, glm::vec3(placement.z, placement.z * 0.6f, placement.z));
+	}
+}
+
+/**
+ * Updates bounding boxes of the terrain chunks in the occlusion culler (chunks change with erosion).
+ */
+void updateTerrainChunkBounds(const glm::mat4& heightmapModelMatrix)
+{
+	const auto& chunks = heightmap->getChunks();
+	while (terrainChunkObjects.size() < chunks.size()) {
+		terrainChunkObjects.push_back(occlusionCuller.addObject());
+	}
+
+	for (size_t i = 0; i < chunks.size(); i++) {
+		occlusionCuller.setObjectBounds(terrainChunkObjects[i], chunks[i].boundsMin, chunks[i].boundsMax, heightmapModelMatrix);
+	}
+}
+
 void OpenGLWindow018::initializeScene()
 {
 	try
@@ -49,15 +146,38 @@ void OpenGLWindow018::initializeScene()
 		auto& sm = ShaderManager::getInstance();
 		auto& spm = ShaderProgramManager::getInstance();
 		auto& tm = TextureManager::getInstance();
+		auto& aal = AsyncAssetLoader::getInstance();
 
-		sm.loadVertexShader("tut014_main", "../../Engine/data/shaders/tut014-diffuse-lighting/shader.vert");
-		sm.loadFragmentShader("tut014_main", "../../Engine/data/shaders/tut014-diffuse-lighting/shader.frag");
-		sm.loadFragmentShader("ambientLight", "../../Engine/data/shaders/lighting/ambientLight.frag");
-		sm.loadFragmentShader("diffuseLight", "../../Engine/data/shaders/lighting/diffuseLight.frag");
+		// Start loading all the assets in parallel, shader sources are read and images are decoded on worker threads
+		std::vector<std::shared_future<void>> assetFutures;
+		assetFutures.push_back(sm.loadVertexShaderAsync("tut014_main", "../../Engine/data/shaders/tut014-diffuse-lighting/shader.vert"));
+		assetFutures.push_back(sm.loadFragmentShaderAsync("tut014_main", "../../Engine/data/shaders/tut014-diffuse-lighting/shader.frag"));
+		assetFutures.push_back(sm.loadFragmentShaderAsync("ambientLight", "../../Engine/data/shaders/lighting/ambientLight.frag"));
+		assetFutures.push_back(sm.loadFragmentShaderAsync("diffuseLight", "../../Engine/data/shaders/lighting/diffuseLight.frag"));
+		assetFutures.push_back(sm.loadVertexShaderAsync("instanced", "../../Engine/data/shaders/instancing/instanced.vert"));
 
-		sm.loadVertexShader("normals", "../../Engine/data/shaders/normals/normals.vert");
-		sm.loadGeometryShader("normals", "../../Engine/data/shaders/normals/normals.geom");
-		sm.loadFragmentShader("normals", "../../Engine/data/shaders/normals/normals.frag");
+		assetFutures.push_back(sm.loadVertexShaderAsync("normals", "../../Engine/data/shaders/normals/normals.vert"));
+		assetFutures.push_back(sm.loadGeometryShaderAsync("normals", "../../Engine/data/shaders/normals/normals.geom"));
+		assetFutures.push_back(sm.loadFragmentShaderAsync("normals", "../../Engine/data/shaders/normals/normals.frag"));
+
+		skybox = std::make_unique<static_meshes_3D::Skybox>("../../Engine/data/skyboxes/desert", "png");
+
+		SamplerManager::getInstance().createSampler("main", MAG_FILTER_BILINEAR, MIN_FILTER_TRILINEAR);
+		assetFutures.push_back(tm.loadTexture2DAsync("crate", "../../Engine/data/textures/crate.png"));
+		assetFutures.push_back(tm.loadTexture2DAsync("white_marble", "../../Engine/data/textures/white_marble.jpg"));
+		assetFutures.push_back(tm.loadTexture2DAsync("rock", "../../Engine/data/textures/rocky_terrain.jpg"));
+
+		auto heightDataPromise = std::make_shared<std::promise<std::vector<std::vector<float>>>>();
+		aal.submitWorkerTask([heightDataPromise]() {
+			heightDataPromise->set_value(static_meshes_3D::Heightmap::getHeightDataFromImage("../../Engine/data/heightmaps/tut017.png"));
+		}, [heightDataPromise](std::exception_ptr exception) { heightDataPromise->set_exception(exception); });
+		auto heightData = heightDataPromise->get_future();
+
+		// Startup takes roughly as long as the slowest asset, get() rethrows any loading error
+		aal.waitForAllTasks();
+		for (const auto& assetFuture : assetFutures) {
+			assetFuture.get();
+		}
 
 		auto& mainShaderProgram = spm.createShaderProgram("main");
 		mainShaderProgram.addShaderToProgram(sm.getVertexShader("tut014_main"));
@@ -65,25 +185,50 @@ void OpenGLWindow018::initializeScene()
 		mainShaderProgram.addShaderToProgram(sm.getFragmentShader(ShaderKeys::ambientLight()));
 		mainShaderProgram.addShaderToProgram(sm.getFragmentShader(ShaderKeys::diffuseLight()));
 
+		// Same shading as the main program, model matrices come from per-instance attribute
+		auto& instancedShaderProgram = spm.createShaderProgram("main_instanced");
+		instancedShaderProgram.addShaderToProgram(sm.getVertexShader("instanced"));
+		instancedShaderProgram.addShaderToProgram(sm.getFragmentShader("tut014_main"));
+		instancedShaderProgram.addShaderToProgram(sm.getFragmentShader(ShaderKeys::ambientLight()));
+		instancedShaderProgram.addShaderToProgram(sm.getFragmentShader(ShaderKeys::diffuseLight()));
+
 		auto& normalsShaderProgram = spm.createShaderProgram("normals");
 		normalsShaderProgram.addShaderToProgram(sm.getVertexShader("normals"));
 		normalsShaderProgram.addShaderToProgram(sm.getGeometryShader("normals"));
 		normalsShaderProgram.addShaderToProgram(sm.getFragmentShader("normals"));
 
-		skybox = std::make_unique<static_meshes_3D::Skybox>("../../Engine/data/skyboxes/desert", "png");
-
-		SamplerManager::getInstance().createSampler("main", MAG_FILTER_BILINEAR, MIN_FILTER_TRILINEAR);
-		TextureManager::getInstance().loadTexture2D("crate", "../../Engine/data/textures/crate.png");
-		TextureManager::getInstance().loadTexture2D("white_marble", "../../Engine/data/textures/white_marble.jpg");
-		TextureManager::getInstance().loadTexture2D("grass", "../../Engine/data/textures/grass.jpg");
-		TextureManager::getInstance().loadTexture2D("rocky_terrain", "../../Engine/data/textures/rocky_terrain.jpg");
-		TextureManager::getInstance().loadTexture2D("snow", "../../Engine/data/textures/snow.png");
-
-
+		static_meshes_3D::Skybox::prepareShaderProgram();
 		static_meshes_3D::Heightmap::prepareMultiLayerShaderProgram();
-		heightmap = std::make_unique<static_meshes_3D::Heightmap>("../../Engine/data/heightmaps/tut017.png", true, true, true);
+		OcclusionCuller::prepareShaderProgram();
+		heightmap = std::make_unique<static_meshes_3D::Heightmap>(heightData.get(), true, true, true);
+
+		// Terrain layers are blended by weights precomputed from height, slope and erosion wetness
+		if (!heightmap->loadSplatLayers({ "../../Engine/data/textures/rocky_terrain.jpg", "../../Engine/data/textures/grass.jpg", "../../Engine/data/textures/snow.png" })) {
+			throw std::runtime_error("Failed to load terrain layers!");
+		}
+
+		static_meshes_3D::Heightmap::SplatParameters splatParameters;
+		splatParameters.levels = { 0.0f, 0.0f, 1.0f, 0.0f };
+		// Steep slopes are rocky, grass grows along the trails of the eroding water
+		splatParameters.slopeLayer = 0;
+		splatParameters.wetLayer = 1;
+		splatParameters.heightScale = heightMapSize.y / heightMapSize.x;
+		heightmap->setSplatParameters(splatParameters);
+		updateTerrainChunkBounds(glm::scale(glm::mat4(1.0f), heightMapSize));
+
+		houseModel = std::make_unique<static_meshes_3D::AssimpModel>("../../Engine/data/models/house/house.3ds", "house.jpg", true, true, true);
+		for (const auto& housePosition : housePositions)
+		{
+			houseObjects.push_back(occlusionCuller.addObject());
+			occlusionCuller.setObjectBounds(houseObjects.back(), houseModel->getBoundsMin(), houseModel->getBoundsMax(), getHouseModelMatrix(housePosition));
+		}
+
+		rockMesh = std::make_unique<static_meshes_3D::Sphere>(1.0f, 10, 6);
+		placeRocks();
+		updateRockModelMatrices();
 
 		spm.linkAllPrograms();
+		UniformBlockManager::getInstance().createBlocks();
 
 
 		IMGUI_CHECKVERSION();
@@ -95,12 +240,12 @@ void OpenGLWindow018::initializeScene()
 	}
 	catch (const std::runtime_error& ex)
 	{
-		std::cout << "Error occured during initialization: " << ex.what() << std::endl;
+		LOG_ERROR(Core, "Error occured during initialization: {}", ex.what());
 		closeWindow(true);
 		return;
 	}
 
-	glEnable(GL_DEPTH_TEST);
+	GLStateCache::getInstance().enable(GL_DEPTH_TEST);
 	glClearDepth(1.0);
 	glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
 }
@@ -112,65 +257,123 @@ void OpenGLWindow018::renderScene()
 	auto& mm = MatrixManager::getInstance();
 
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	GLStateCache::getInstance().resetStatistics();
 
 	// Set matrices in matrix manager
 	mm.setProjectionMatrix(getProjectionMatrix());
 	mm.setOrthoProjectionMatrix(getOrthoProjectionMatrix());
 	mm.setViewMatrix(camera.getViewMatrix());
 
+	// Camera and lights are shared by all shader programs through uniform blocks, one buffer update per frame
+	auto& ubm = UniformBlockManager::getInstance();
+	ubm.setFrameConstants(getProjectionMatrix(), camera.getViewMatrix(), camera.getEye());
+	ubm.setLights(ambientLight, diffuseLight);
+	{
+		FrameProfiler::Scope uploadScope("upload");
+		ubm.uploadBlocks();
+	}
+
 	// Set up some common properties in the main shader program
 	auto& mainProgram = spm.getShaderProgram("main");
 	mainProgram.useProgram();
-	mainProgram[ShaderConstants::projectionMatrix()] = getProjectionMatrix();
-	mainProgram[ShaderConstants::viewMatrix()] = camera.getViewMatrix();
 	mainProgram.setModelAndNormalMatrix(glm::mat4(1.0f));
 	mainProgram[ShaderConstants::color()] = glm::vec4(1.0f, 1.0f, 1.0f, 1.0f);
 	mainProgram[ShaderConstants::sampler()] = 0;
-
-	// Render skybox first with only ambient light
-	shader_structs::AmbientLight(glm::vec3(0.8f, 0.8f, 0.8f), true).setUniform(mainProgram, ShaderConstants::ambientLight());
-	shader_structs::DiffuseLight::none().setUniform(mainProgram, ShaderConstants::diffuseLight());
-	skybox->render(camera.getEye(), mainProgram);
-
-	// Set up ambient and diffuse light in the shader program
 	SamplerManager::getInstance().getSampler("main").bind();
-	ambientLight.setUniform(mainProgram, ShaderConstants::ambientLight());
-	diffuseLight.setUniform(mainProgram, ShaderConstants::diffuseLight());
 
 
 	// Render heightmap
-	if (checkErosion) {
-		heightmap->erode(50);
+	const auto heightmapModelMatrix = glm::scale(glm::mat4(1.0f), heightMapSize);
+	if (checkErosion)
+	{
+		{
+			FrameProfiler::Scope erosionScope("erosion");
+			heightmap->erode(50);
+		}
+
+		FrameProfiler::Scope uploadScope("upload");
 		heightmap->createFromHeightData(heightmap->_heightData);
-	} 
+		updateTerrainChunkBounds(heightmapModelMatrix);
+		updateRockModelMatrices();
+	}
 
 	auto& heightmapShaderProgram = static_meshes_3D::Heightmap::getMultiLayerShaderProgram();
 	heightmapShaderProgram.useProgram();
-	heightmapShaderProgram[ShaderConstants::projectionMatrix()] = getProjectionMatrix();
-	heightmapShaderProgram[ShaderConstants::viewMatrix()] = camera.getViewMatrix();
-	heightmapShaderProgram.setModelAndNormalMatrix(glm::mat4(1.0f));
 	heightmapShaderProgram[ShaderConstants::color()] = glm::vec4(1.0f, 1.0f, 1.0f, 1.0f);
-	ambientLight.setUniform(heightmapShaderProgram, ShaderConstants::ambientLight());
-	diffuseLight.setUniform(heightmapShaderProgram, ShaderConstants::diffuseLight());
 
-	const auto heightmapModelMatrix = glm::scale(glm::mat4(1.0f), heightMapSize);
-	heightmapShaderProgram.setModelAndNormalMatrix(heightmapModelMatrix);
-	heightmap->renderMultilayered({ "rocky_terrain", "grass", "snow" }, { 0.0f, 0.0f, 1.0f, 0.0f });
+	// Ambient light of the terrain is tinted by the skybox
+	skybox->bindCubeMap(static_meshes_3D::Heightmap::ENVIRONMENT_TEXTURE_UNIT);
+	heightmapShaderProgram[static_meshes_3D::Heightmap::ShaderConstants::environmentFactor()] = skybox->isLoaded() ? 0.5f : 0.0f;
+
+	// Meshes are submitted to the render queue and rendered sorted by state and depth. Terrain chunks and houses
+	// hidden behind the ridges are culled by the occlusion results of the previous frames, nothing waits for the GPU
+	renderQueue.begin(getProjectionMatrix(), camera.getViewMatrix());
+	occlusionCuller.beginFrame(getProjectionMatrix(), camera.getViewMatrix(), camera.getEye());
+	for (size_t i = 0; i < terrainChunkObjects.size(); i++)
+	{
+		auto chunkPacket = heightmap->createMultilayeredChunkPacket(heightmapModelMatrix, i);
+		if (occlusionCuller.prepareDrawPacket(terrainChunkObjects[i], chunkPacket)) {
+			renderQueue.submit(chunkPacket);
+		}
+	}
+
+	for (size_t i = 0; i < housePositions.size(); i++)
+	{
+		// Houses follow the terrain as it erodes
+		const auto houseModelMatrix = getHouseModelMatrix(housePositions[i]);
+		occlusionCuller.setObjectBounds(houseObjects[i], houseModel->getBoundsMin(), houseModel->getBoundsMax(), houseModelMatrix);
+
+		RenderQueue::DrawPacket housePacket;
+		housePacket.shaderProgram = &mainProgram;
+		housePacket.modelMatrix = houseModelMatrix;
+		housePacket.profileScope = "houses";
+		if (occlusionCuller.prepareDrawPacket(houseObjects[i], housePacket)) {
+			houseModel->submit(renderQueue, std::move(housePacket));
+		}
+	}
 
 	if (displayNormals)
 	{
 		// Set up some common properties in the normals shader program
 		auto& normalsShaderProgram = spm.getShaderProgram("normals");
 		normalsShaderProgram.useProgram();
-		normalsShaderProgram[ShaderConstants::projectionMatrix()] = getProjectionMatrix();
-		normalsShaderProgram[ShaderConstants::viewMatrix()] = camera.getViewMatrix();
 		normalsShaderProgram[ShaderConstants::normalLength()] = 0.5f;
 
+		RenderQueue::DrawPacket normalsPacket;
+		normalsPacket.shaderProgram = &normalsShaderProgram;
+		normalsPacket.modelMatrix = heightmapModelMatrix;
+		normalsPacket.profileScope = "normals";
+		heightmap->submitPoints(renderQueue, std::move(normalsPacket));
+	}
 
-		normalsShaderProgram.setModelAndNormalMatrix(heightmapModelMatrix);
-		heightmap->renderPoints();
+	renderQueue.flush();
+
+	// All the rocks are rendered with one instanced draw (normal matrices are derived in the vertex shader)
+	{
+		FrameProfiler::Scope rocksScope("rocks");
+		auto& instancedProgram = spm.getShaderProgram("main_instanced");
+		instancedProgram.useProgram();
+		instancedProgram[ShaderConstants::color()] = glm::vec4(1.0f, 1.0f, 1.0f, 1.0f);
+		instancedProgram[ShaderConstants::sampler()] = 0;
+		tm.getTexture("rock").bind(0);
+		SamplerManager::getInstance().getSampler("main").bind(0);
+		rockMesh->renderInstanced(rockModelMatrices);
+	}
+
+	// Render skybox last, only the pixels not covered by any geometry pass the depth test
+	{
+		FrameProfiler::Scope skyboxScope("skybox");
+		skybox->render(glm::vec4(0.8f, 0.8f, 0.8f, 1.0f));
+	}
+
+	// Depth buffer is complete now, bounding boxes are tested against it and results are used in the next frames
+	{
+		FrameProfiler::Scope occlusionScope("occlusion queries");
+		occlusionCuller.issueQueries();
 	}
 
+	FrameProfiler::Scope imGuiScope("ImGui");
+
 	ImGuiIO& io = ImGui::GetIO();
 	io.DisplaySize.x = static_cast<float>(OpenGLWindow::getScreenWidth());
 	io.DisplaySize.y = static_cast<float>(OpenGLWindow::getScreenHeight());
@@ -193,6 +396,27 @@ void OpenGLWindow018::renderScene()
 	ImGui::InputFloat("min volume", &heightmap->minVol, 0.01, 0.01);
 	ImGui::InputFloat("friction", &heightmap->friction, 0.01, 0.01);
 
+	//Redundant state changes skipped by the state cache this frame
+	const auto& gsc = GLStateCache::getInstance();
+	ImGui::Text("GL state calls: %llu issued, %llu skipped", static_cast<unsigned long long>(gsc.getNumIssuedCalls()), static_cast<unsigned long long>(gsc.getNumSkippedCalls()));
+
+	//CPU and GPU times of the frame passes
+	auto& fp = FrameProfiler::getInstance();
+	fp.renderImGui();
+	if (ImGui::Button("Dump profiler trace")) {
+		fp.dumpChromeTrace("frame_profile.json");
+	}
+
+	//Terrain chunks and houses culled by occlusion queries
+	occlusionCuller.renderImGui();
+
+	//Counters and zones of the CPU hot paths
+	auto& instrumentation = Instrumentation::getInstance();
+	instrumentation.renderImGui();
+	if (ImGui::Button("Dump instrumentation trace")) {
+		instrumentation.dumpTrace("instrumentation_trace.json");
+	}
+
 	ImGui::Button("Test");
 
 	ImGui::End();
@@ -218,7 +442,7 @@ void OpenGLWindow018::updateScene()
 
 	if (keyPressedOnce(GLFW_KEY_Q)) {
 		checkErosion = !checkErosion;
-		std::cout << "start erosion" << std::endl;
+		LOG_INFO(Erosion, "Erosion {}", checkErosion ? "started" : "stopped");
 	}
 	if (keyPressedOnce(GLFW_KEY_SPACE)) {
 		checkCursor = !checkCursor;
@@ -247,6 +471,13 @@ void OpenGLWindow018::updateScene()
 void OpenGLWindow018::releaseScene()
 {
 	skybox.reset();
+	houseModel.reset();
+	rockMesh.reset();
+	rockPlacements.clear();
+	rockModelMatrices.clear();
+	occlusionCuller.deleteAll();
+	terrainChunkObjects.clear();
+	houseObjects.clear();
 
 	ImGui_ImplOpenGL3_Shutdown();
 	ImGui_ImplGlfw_Shutdown();
@@ -256,6 +487,7 @@ void OpenGLWindow018::releaseScene()
 	ShaderProgramManager::getInstance().clearShaderProgramCache();
 	TextureManager::getInstance().clearTextureCache();
 	SamplerManager::getInstance().clearSamplerCache();
+	UniformBlockManager::getInstance().deleteBlocks();
 
 
 	heightmap.reset();
@@ -6,6 +6,11 @@
 
 // Project
 #include "../includes/common_classes/OpenGLWindow.h"
+#include "../includes/common_classes/asyncAssetLoader.h"
+#include "../includes/common_classes/frameProfiler.h"
+#include "../includes/common_classes/instrumentation.h"
+#include "../includes/common_classes/glStateCache.h"
+#include "../includes/common_classes/logManager.h"
 
 std::map<GLFWwindow*, OpenGLWindow*> OpenGLWindow::_windows;
 
@@ -84,6 +89,7 @@ void OpenGLWindow::runApp()
 {
     setVerticalSynchronization(true);
     recalculateProjectionMatrix();
+    Instrumentation::getInstance().setThreadName("Main");
     initializeScene();
     
     // Update time at the beginning, so that calculations are correct
@@ -92,13 +98,28 @@ void OpenGLWindow::runApp()
     while (glfwWindowShouldClose(_window) == 0)
     {
         updateDeltaTimeAndFPS();
+        FrameProfiler::getInstance().beginFrame();
+
+        // Finish assets loaded in the background (GL objects can be created only here on the context thread)
+        {
+            FrameProfiler::Scope uploadScope("upload");
+            AsyncAssetLoader::getInstance().processContextTasks();
+        }
+
         renderScene();
+        FrameProfiler::getInstance().endFrame();
+
+        // Zones of all the threads are gathered once per frame, so that the thread buffers never fill up
+        INSTRUMENT_COUNTER(StateChangesSkipped, GLStateCache::getInstance().getNumSkippedCalls());
+        Instrumentation::getInstance().collectFrame();
 
         glfwSwapBuffers(_window);
         glfwPollEvents();
         updateScene();
     }
 
+    AsyncAssetLoader::getInstance().shutdown();
+    FrameProfiler::getInstance().deleteQueries();
     releaseScene();
 
     glfwDestroyWindow(_window);
@@ -107,6 +128,9 @@ void OpenGLWindow::runApp()
     if (_windows.empty())
     {
         glfwTerminate();
+
+        // Messages still queued are written now, objects destroyed later log synchronously
+        LogManager::getInstance().shutdown();
     }
 }
 
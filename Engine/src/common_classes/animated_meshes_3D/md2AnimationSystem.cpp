@@ -0,0 +1,297 @@
+// STL
+#include <algorithm>
+#include <cmath>
+
+// Project
+#include "../includes/common_classes/animated_meshes_3D/md2AnimationSystem.h"
+#include "../includes/common_classes/cpuUtils.h"
+#include "../includes/common_classes/instrumentation.h"
+#include "../includes/common_classes/logManager.h"
+
+namespace opengl4_mbsoftworks {
+namespace common_classes {
+namespace animated_meshes_3D {
+
+namespace {
+
+/**
+ * Instance state arrays read and written by the kernels, output instance data point into the mapped instance buffer.
+ */
+struct InstanceArrays
+{
+    float* runningTimes;
+    const int32_t* startFrames;
+    const int32_t* numFrames;
+    const float* fps;
+    const int32_t* loopMasks;
+    const glm::mat4* modelMatrices;
+    MD2Model::InstanceData* instanceData;
+};
+
+/**
+ * Writes whole instance at once, instance buffer is write-only (possibly write-combined) memory.
+ */
+void writeInstance(MD2Model::InstanceData& instance, const glm::mat4& modelMatrix, const int32_t currentFrame, const int32_t nextFrame, const float interpolationFactor)
+{
+    MD2Model::InstanceData instanceData;
+    instanceData.modelMatrix = modelMatrix;
+    instanceData.currentFrame = currentFrame;
+    instanceData.nextFrame = nextFrame;
+    instanceData.interpolationFactor = interpolationFactor;
+    instance = instanceData;
+}
+
+/**
+ * Computes frames of instances in range [first, end). Running time t covers k = ceil(t * fps) - 1 frame steps
+ * (MD2Model::AnimationState::updateAnimation steps while more than one frame duration is left), so current frame
+ * is k-th frame of the animation and next frame is the following one (first one for looping animations).
+ * Looping animations keep the time within one cycle, others stop at the end of the last frame.
+ */
+void updateAnimationsScalar(const InstanceArrays& a, const int first, const int end, const float deltaTime)
+{
+    for (auto i = first; i < end; i++)
+    {
+        const auto numFramesFloat = static_cast<float>(a.numFrames[i]);
+        const auto cycleDuration = numFramesFloat / a.fps[i];
+        auto runningTime = a.runningTimes[i] + deltaTime;
+        runningTime = a.loopMasks[i] != 0 ? runningTime - cycleDuration * std::floor(runningTime / cycleDuration) : std::min(runningTime, cycleDuration);
+        a.runningTimes[i] = runningTime;
+
+        const auto framePosition = runningTime * a.fps[i];
+        const auto frameStep = std::min(std::max(std::ceil(framePosition) - 1.0f, 0.0f), numFramesFloat - 1.0f);
+        auto nextFrameStep = frameStep + 1.0f;
+        if (nextFrameStep >= numFramesFloat) {
+            nextFrameStep = a.loopMasks[i] != 0 ? 0.0f : numFramesFloat - 1.0f;
+        }
+
+        writeInstance(a.instanceData[i], a.modelMatrices[i], a.startFrames[i] + static_cast<int32_t>(frameStep),
+            a.startFrames[i] + static_cast<int32_t>(nextFrameStep), framePosition - frameStep);
+    }
+}
+
+#ifdef CPU_UTILS_AVX2_KERNELS
+
+/**
+ * AVX2 version of updateAnimationsScalar - 8 instances are computed at once with exactly the same operations,
+ * results are then written into the interleaved instance data.
+ */
+AVX2_TARGET int updateAnimationsAvx2(const InstanceArrays& a, const int first, const int end, const float deltaTime)
+{
+    const auto deltaTimes = _mm256_set1_ps(deltaTime);
+    const auto zeros = _mm256_setzero_ps();
+    const auto ones = _mm256_set1_ps(1.0f);
+
+    auto i = first;
+    for (; i + 8 <= end; i += 8)
+    {
+        const auto fps = _mm256_loadu_ps(a.fps + i);
+        const auto loopMasks = _mm256_castsi256_ps(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(a.loopMasks + i)));
+        const auto numFrames = _mm256_cvtepi32_ps(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(a.numFrames + i)));
+        const auto lastFrameSteps = _mm256_sub_ps(numFrames, ones);
+        const auto cycleDurations = _mm256_div_ps(numFrames, fps);
+
+        auto runningTimes = _mm256_add_ps(_mm256_loadu_ps(a.runningTimes + i), deltaTimes);
+        const auto wrappedTimes = _mm256_sub_ps(runningTimes, _mm256_mul_ps(cycleDurations, _mm256_floor_ps(_mm256_div_ps(runningTimes, cycleDurations))));
+        runningTimes = _mm256_blendv_ps(_mm256_min_ps(runningTimes, cycleDurations), wrappedTimes, loopMasks);
+        _mm256_storeu_ps(a.runningTimes + i, runningTimes);
+
+        const auto framePositions = _mm256_mul_ps(runningTimes, fps);
+        const auto frameSteps = _mm256_min_ps(_mm256_max_ps(_mm256_sub_ps(_mm256_ceil_ps(framePositions), ones), zeros), lastFrameSteps);
+        auto nextFrameSteps = _mm256_add_ps(frameSteps, ones);
+        const auto pastEnd = _mm256_cmp_ps(nextFrameSteps, numFrames, _CMP_GE_OQ);
+        nextFrameSteps = _mm256_blendv_ps(nextFrameSteps, _mm256_blendv_ps(lastFrameSteps, zeros, loopMasks), pastEnd);
+
+        const auto startFrames = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a.startFrames + i));
+        alignas(32) int32_t currentFrames[8];
+        alignas(32) int32_t nextFrames[8];
+        alignas(32) float interpolationFactors[8];
+        _mm256_store_si256(reinterpret_cast<__m256i*>(currentFrames), _mm256_add_epi32(startFrames, _mm256_cvttps_epi32(frameSteps)));
+        _mm256_store_si256(reinterpret_cast<__m256i*>(nextFrames), _mm256_add_epi32(startFrames, _mm256_cvttps_epi32(nextFrameSteps)));
+        _mm256_store_ps(interpolationFactors, _mm256_sub_ps(framePositions, frameSteps));
+
+        for (auto lane = 0; lane < 8; lane++) {
+            writeInstance(a.instanceData[i + lane], a.modelMatrices[i + lane], currentFrames[lane], nextFrames[lane], interpolationFactors[lane]);
+        }
+    }
+
+    return i;
+}
+
+#endif
+
+} // namespace
+
+MD2AnimationSystem::MD2AnimationSystem(MD2Model& model)
+    : model_(model)
+{
+}
+
+MD2AnimationSystem::~MD2AnimationSystem()
+{
+    vboInstances_.deleteVBO();
+}
+
+int MD2AnimationSystem::addAnimation(const std::string& animationName, const bool loop, const size_t fps)
+{
+    const auto animationState = model_.startAnimation(animationName, loop, fps);
+    if (!animationState.isRunning() || animationState.fps == 0)
+    {
+        LOG_WARN(Assets, "MD2 model has no animation '{}', it cannot be added to the animation system!", animationName);
+        return -1;
+    }
+
+    Animation animation;
+    animation.name = animationName;
+    animation.startFrame = static_cast<int32_t>(animationState.startFrame);
+    animation.numFrames = static_cast<int32_t>(animationState.endFrame - animationState.startFrame + 1);
+    animation.fps = static_cast<float>(animationState.fps);
+    animation.loop = loop;
+    animations_.push_back(animation);
+    return static_cast<int>(animations_.size()) - 1;
+}
+
+int MD2AnimationSystem::getAnimationId(const std::string& animationName) const
+{
+    for (size_t i = 0; i < animations_.size(); i++)
+    {
+        if (animations_[i].name == animationName) {
+            return static_cast<int>(i);
+        }
+    }
+
+    return -1;
+}
+
+int MD2AnimationSystem::addInstance(const glm::mat4& modelMatrix, const int animationId, const float startTime)
+{
+    if (animationId < 0 || animationId >= static_cast<int>(animations_.size())) {
+        return -1;
+    }
+
+    animationIds_.push_back(0);
+    runningTimes_.push_back(0.0f);
+    startFrames_.push_back(0);
+    numFrames_.push_back(0);
+    fps_.push_back(0.0f);
+    loopMasks_.push_back(0);
+    modelMatrices_.emplace_back(1.0f);
+
+    const auto instanceIndex = getNumInstances() - 1;
+    setInstanceAnimation(instanceIndex, animationId);
+    setInstanceModelMatrix(instanceIndex, modelMatrix);
+    runningTimes_[instanceIndex] = startTime;
+    return instanceIndex;
+}
+
+void MD2AnimationSystem::setInstanceAnimation(const int instanceIndex, const int animationId)
+{
+    if (instanceIndex < 0 || instanceIndex >= getNumInstances() || animationId < 0 || animationId >= static_cast<int>(animations_.size())) {
+        return;
+    }
+
+    const auto& animation = animations_[animationId];
+    animationIds_[instanceIndex] = animationId;
+    runningTimes_[instanceIndex] = 0.0f;
+    startFrames_[instanceIndex] = animation.startFrame;
+    numFrames_[instanceIndex] = animation.numFrames;
+    fps_[instanceIndex] = animation.fps;
+    loopMasks_[instanceIndex] = animation.loop ? -1 : 0;
+}
+
+void MD2AnimationSystem::setInstanceModelMatrix(const int instanceIndex, const glm::mat4& modelMatrix)
+{
+    if (instanceIndex < 0 || instanceIndex >= getNumInstances()) {
+        return;
+    }
+
+    modelMatrices_[instanceIndex] = modelMatrix;
+}
+
+void MD2AnimationSystem::clearInstances()
+{
+    animationIds_.clear();
+    runningTimes_.clear();
+    startFrames_.clear();
+    numFrames_.clear();
+    fps_.clear();
+    loopMasks_.clear();
+    modelMatrices_.clear();
+    numUploadedInstances_ = 0;
+}
+
+void MD2AnimationSystem::updateAnimations(const float deltaTime)
+{
+    INSTRUMENT_ZONE("MD2AnimationSystem::updateAnimations");
+    const auto numInstances = getNumInstances();
+    numUploadedInstances_ = 0;
+    if (numInstances == 0) {
+        return;
+    }
+
+    // Instance buffer is orphaned and mapped, kernels write the instances straight into it - there's no other copy
+    if (vboInstances_.getBufferID() == 0) {
+        vboInstances_.createVBO();
+    }
+
+    const auto bufferSize = sizeof(MD2Model::InstanceData) * numInstances;
+    vboInstances_.bindVBO();
+    vboInstances_.uploadDataToGPU(nullptr, bufferSize, GL_STREAM_DRAW);
+    auto instanceData = static_cast<MD2Model::InstanceData*>(vboInstances_.mapSubBufferToMemory(GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT, 0, bufferSize));
+    if (instanceData == nullptr)
+    {
+        LOG_ERROR(Buffers, "Failed to map instance buffer of MD2 animation system!");
+        return;
+    }
+
+    // Chunk sizes are multiples of 8 (AVX2 lanes), chunks don't overlap so no synchronization is needed
+    const auto chunks = cpu_utils::splitIntoChunks(numInstances, MIN_INSTANCES_PER_THREAD, maxThreads_, 8);
+    cpu_utils::processChunksInParallel(chunks, [this, instanceData, deltaTime](const size_t, const cpu_utils::ChunkRange& chunk) {
+        updateChunk(chunk.begin, chunk.end, deltaTime, instanceData);
+    });
+
+    vboInstances_.unmapBuffer();
+    numUploadedInstances_ = numInstances;
+}
+
+void MD2AnimationSystem::renderInstances()
+{
+    model_.renderModelInstancedFromBuffer(vboInstances_.getBufferID(), static_cast<size_t>(numUploadedInstances_));
+}
+
+void MD2AnimationSystem::setSimdEnabled(const bool simdEnabled)
+{
+    isSimdEnabled_ = simdEnabled;
+}
+
+bool MD2AnimationSystem::isSimdEnabled() const
+{
+    return isSimdEnabled_;
+}
+
+void MD2AnimationSystem::setMaxThreads(const int maxThreads)
+{
+    maxThreads_ = std::max(maxThreads, 0);
+}
+
+int MD2AnimationSystem::getNumInstances() const
+{
+    return static_cast<int>(modelMatrices_.size());
+}
+
+void MD2AnimationSystem::updateChunk(const int begin, const int end, const float deltaTime, MD2Model::InstanceData* instanceData)
+{
+    const InstanceArrays arrays{ runningTimes_.data(), startFrames_.data(), numFrames_.data(), fps_.data(), loopMasks_.data(), modelMatrices_.data(), instanceData };
+
+    auto first = begin;
+#ifdef CPU_UTILS_AVX2_KERNELS
+    if (isSimdEnabled_ && cpu_utils::isAvx2Supported()) {
+        first = updateAnimationsAvx2(arrays, begin, end, deltaTime);
+    }
+#endif
+
+    updateAnimationsScalar(arrays, first, end, deltaTime);
+}
+
+} // namespace animated_meshes_3D
+} // namespace common_classes
+} // namespace opengl4_mbsoftworks
@@ -1,16 +1,27 @@
 // STL
-#include <iostream>
-#include <fstream>
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <map>
+#include <tuple>
 
 // Project
 #include "../includes/common_classes/animated_meshes_3D/md2model.h"
 #include "../includes/common_classes/shaderProgram.h"
 #include "../includes/common_classes/shaderProgramManager.h"
+#include "../includes/common_classes/glStateCache.h"
+#include "../includes/common_classes/logManager.h"
+#include "../includes/common_classes/memoryMappedFile.h"
+#include "../includes/common_classes/cpuUtils.h"
+#include "../includes/common_classes/instrumentation.h"
 
 namespace opengl4_mbsoftworks {
 namespace common_classes {
 namespace animated_meshes_3D {
 
+const std::string MD2Model::SHADER_PROGRAM_KEY = "md2";
+const std::string MD2Model::INSTANCED_SHADER_PROGRAM_KEY = "md2_instanced";
+
 const glm::vec3 MD2Model::ANORMS_TABLE[ANORMS_TABLE_SIZE] =
 {
     { -0.525731f,  0.000000f,  0.850651f },
@@ -198,9 +209,9 @@ void MD2Model::AnimationState::updateAnimation(float deltaTime)
     interpolationFactor = static_cast<float>(fps) * (totalRunningTime - previousNextFrameTime);
 }
 
-MD2Model::MD2Model(const std::string& filePath, const glm::mat4& modelTransformMatrix)
+MD2Model::MD2Model(const std::string& filePath, const glm::mat4& modelTransformMatrix, const bool keepFramesQuantized, const bool enableInstancedRendering)
 {
-    loadModel(filePath, modelTransformMatrix);
+    loadModel(filePath, modelTransformMatrix, keepFramesQuantized, enableInstancedRendering);
 }
 
 MD2Model::~MD2Model()
@@ -208,49 +219,45 @@ MD2Model::~MD2Model()
     deleteModel();
 }
 
-void MD2Model::loadModel(const std::string& filePath, const glm::mat4& modelTransformMatrix)
+void MD2Model::loadModel(const std::string& filePath, const glm::mat4& modelTransformMatrix, const bool keepFramesQuantized, const bool enableInstancedRendering)
 {
-    std::ifstream in(filePath, std::ios::binary);
-    if(!in.is_open())
+    INSTRUMENT_ZONE("MD2Model::loadModel");
+    deleteModel();
+
+    MemoryMappedFile file;
+    if(!file.open(filePath))
     {
+        LOG_WARN(Assets, "Could not open MD2 model '{}'!", filePath);
         return;
     }
 
-    // Read header where all info about model is stored
-    in.read(reinterpret_cast<char*>(&header_), sizeof(MD2Header));
-
-    // Read all the frames into a buffer which will then be processed
-    // Might seem a bit counter-intuitive, but it has to be done like this, because sizeof(MD2Frame) is not same as header_.frameSize
-    size_t allFramesSizeBytes = header_.numFrames * header_.frameSize;
-    std::vector<char> allFramesData(allFramesSizeBytes);
-    in.seekg(header_.offsetFrames);
-    in.read(allFramesData.data(), allFramesSizeBytes);
-
-    // Read vertices and normals from all frames data in a per-frame manner
-    std::vector<std::vector<glm::vec3>> perFrameVertices(header_.numFrames, std::vector<glm::vec3>(header_.numVertices));
-    std::vector<std::vector<glm::vec3>> perFrameNormals(header_.numFrames, std::vector<glm::vec3>(header_.numVertices));
-    const auto normalTransformMatrix = glm::transpose(glm::inverse(glm::mat3(modelTransformMatrix)));
+    // Header and all the ranges it points to are validated against the file size first, so that corrupted file can't make us read outside of it
+    if(!readHeader(file.getData(), file.getSize()))
+    {
+        LOG_WARN(Assets, "MD2 model '{}' is corrupted or not an MD2 model, it won't be loaded!", filePath);
+        return;
+    }
 
-    for(size_t frameIndex = 0; frameIndex < static_cast<size_t>(header_.numFrames); frameIndex++)
+    // Now let's read OpenGL rendering commands, which define how to render a single frame (there are also texture coordinates mixed within)
+    std::vector<int32_t> commandVertexIndices;
+    std::vector<glm::vec2> textureCoordinates;
+    if(!readRenderCommands(file.getData() + header_.offsetGlCommands, commandVertexIndices, textureCoordinates))
     {
-        const auto& frame = *reinterpret_cast<MD2Frame*>(allFramesData.data() + frameIndex * header_.frameSize);
-        for(size_t vertexIndex = 0; vertexIndex < static_cast<size_t>(header_.numVertices); vertexIndex++)
-        {
-            const auto& frameVertex = frame.vertices[vertexIndex];
-            glm::vec3 position(frame.translate[0] + static_cast<float>(frameVertex.v[0]) * frame.scale[0],
-                frame.translate[1] + static_cast<float>(frameVertex.v[1]) * frame.scale[1],
-                frame.translate[2] + static_cast<float>(frameVertex.v[2]) * frame.scale[2]);
-            perFrameVertices[frameIndex][vertexIndex] = glm::vec3(modelTransformMatrix * glm::vec4(position, 1.0f));
-            perFrameNormals[frameIndex][vertexIndex] = normalTransformMatrix * ANORMS_TABLE[frameVertex.normal_index];
-        }
+        LOG_WARN(Assets, "MD2 model '{}' has corrupted OpenGL commands, it won't be loaded!", filePath);
+        return;
     }
 
     // Now try to determine all different animations in the file based on frame names
+    const auto framesData = file.getData() + header_.offsetFrames;
+    animations_.clear();
+    animationNamesCached_.clear();
     Animation* activeAnimation = nullptr;
     for(size_t frameIndex = 0; frameIndex < static_cast<size_t>(header_.numFrames); frameIndex++)
     {
-        const auto& frame = *reinterpret_cast<MD2Frame*>(allFramesData.data() + frameIndex * header_.frameSize);
-        const auto animationBaseName = getAnimationBaseName(frame.name);
+        // Frame name doesn't have to be null-terminated, if it uses all 16 characters
+        char frameName[sizeof(MD2Frame::name)];
+        memcpy(frameName, framesData + frameIndex * header_.frameSize + offsetof(MD2Frame, name), sizeof(frameName));
+        const auto animationBaseName = getAnimationBaseName(std::string(frameName, strnlen(frameName, sizeof(frameName))));
         if(animations_.count(animationBaseName) == 0)
         {
             if(activeAnimation) {
@@ -267,67 +274,49 @@ void MD2Model::loadModel(const std::string& filePath, const glm::mat4& modelTran
         }
     }
 
-    // Now let's read OpenGL rendering commands, which define how to render a single frame
-    // There are also texture coordinates mixed within, everything will be buffered in renderCommands
-    std::vector<RenderCommandOpenGL> renderCommands;
-    std::vector<int32_t> rawGlCommands(header_.numGlCommands);
-    in.seekg(header_.offsetGlCommands);
-    in.read(reinterpret_cast<char*>(rawGlCommands.data()), static_cast<std::streamsize>(header_.numGlCommands) * sizeof(int32_t));
-
-    // Loop until raw OpenGL command is zero
-    verticesPerFrame_ = 0;
-    for(auto i = 0; i < header_.numGlCommands && rawGlCommands[i] != 0;) // We while loop until we come to 0 value, which is the end of OpenGL commands
+    // Frames are decoded straight into preallocated upload buffers, every frame writes only its own part of them
+    isFrameQuantized_ = keepFramesQuantized;
+    modelTransformMatrix_ = modelTransformMatrix;
+    const auto numFrames = static_cast<size_t>(header_.numFrames);
+    const auto numFrameVertices = static_cast<size_t>(header_.numVertices);
+    const auto frameVertexByteSize = keepFramesQuantized ? sizeof(MD2Vertex) : 2 * sizeof(glm::vec3);
+    std::vector<unsigned char> frameVerticesData(numFrames * verticesPerFrame_ * (keepFramesQuantized ? sizeof(MD2Vertex) : sizeof(glm::vec3)));
+    std::vector<glm::vec3> normalsData(keepFramesQuantized ? 0 : numFrames * verticesPerFrame_);
+    std::vector<unsigned char> instancedFrameData(enableInstancedRendering ? numFrames * numFrameVertices * frameVertexByteSize : 0);
+    frameScales_.assign(numFrames, glm::vec3(0.0f));
+    frameTranslates_.assign(numFrames, glm::vec3(0.0f));
+
+    const auto frameChunks = cpu_utils::splitIntoChunks(header_.numFrames, MIN_FRAMES_PER_THREAD);
+    cpu_utils::processChunksInParallel(frameChunks, [&](const size_t, const cpu_utils::ChunkRange& chunk)
     {
-        const auto command = rawGlCommands[i]; // Here is encoded rendering mode and number of vertices
-        GLenum renderMode = command < 0 ? GL_TRIANGLE_FAN : GL_TRIANGLE_STRIP; // Rendering mode is one of the two options, depending on the sign
-        const auto numVertices = command < 0 ? -command : command; // Number of vertices is just absolute value of the command
-        i++;
-
-        // Store render mode and all of the associated drawing commands here
-        RenderCommandOpenGL glCommandRender;
-        glCommandRender.renderMode = renderMode;
-
-        renderModes.push_back(renderMode); // Remember the values
-        numRenderVertices.push_back(numVertices);
-        for(auto j = 0; j < numVertices; j++)
-        {
-            const auto u = *reinterpret_cast<float*>(&rawGlCommands[i++]); // Extract texture coordinates
-            const auto v = 1.0f - *reinterpret_cast<float*>(&rawGlCommands[i++]); // Flip t, because it is (for some reasons) stored from top to bottom
-            GLint vertexIndex = rawGlCommands[i++];
-            glCommandRender.textureCoordinates.emplace_back(u, v);
-            glCommandRender.vertexIndex.push_back(vertexIndex);
-            verticesPerFrame_++;
+        for(auto frameIndex = static_cast<size_t>(chunk.begin); frameIndex < static_cast<size_t>(chunk.end); frameIndex++) {
+            decodeFrame(framesData + frameIndex * header_.frameSize, frameIndex, commandVertexIndices, frameVerticesData.data(), normalsData.data(),
+                enableInstancedRendering ? instancedFrameData.data() : nullptr);
         }
-
-        renderCommands.push_back(glCommandRender);
-    }
+    });
 
     // Now that we have all the information (per-frame vertices, texture coordinates and per-frame normals), we can construct the VBOs
+    // Quantized frames keep vertices as they are in the file (4 bytes with normal index), so there is no normals VBO
+    // Don't set up VAO though, it is always setup dynamically
+    glGenVertexArrays(1, &vao_);
     vboFrameVertices_.createVBO();
+    vboFrameVertices_.bindVBO();
+    vboFrameVertices_.uploadDataToGPU(frameVerticesData.data(), frameVerticesData.size(), GL_STATIC_DRAW);
     vboTextureCoordinates_.createVBO();
-    vboNormals_.createVBO();
-    for(auto i = 0; i < header_.numFrames; i++)
+    vboTextureCoordinates_.bindVBO();
+    vboTextureCoordinates_.uploadDataToGPU(textureCoordinates.data(), textureCoordinates.size() * sizeof(glm::vec2), GL_STATIC_DRAW);
+    if (!keepFramesQuantized)
     {
-        for(const auto& glCommand : renderCommands)
-        {
-            for(size_t j = 0; j < glCommand.vertexIndex.size(); j++)
-            {
-                const auto vertexIndex = glCommand.vertexIndex[j];
-                vboFrameVertices_.addData(perFrameVertices[i][vertexIndex]);
-                vboTextureCoordinates_.addData(glCommand.textureCoordinates[j]);
-                vboNormals_.addData(perFrameNormals[i][vertexIndex]);
-            }
-        }
+        vboNormals_.createVBO();
+        vboNormals_.bindVBO();
+        vboNormals_.uploadDataToGPU(normalsData.data(), normalsData.size() * sizeof(glm::vec3), GL_STATIC_DRAW);
     }
 
-    // Now all necessary data are extracted, let's create VAO for rendering MD2 model. Don't set it up though, it is always setup dynamically
-    glGenVertexArrays(1, &vao_);
-    vboFrameVertices_.bindVBO();
-    vboFrameVertices_.uploadDataToGPU(GL_STATIC_DRAW);
-    vboTextureCoordinates_.bindVBO();
-    vboTextureCoordinates_.uploadDataToGPU(GL_STATIC_DRAW);
-    vboNormals_.bindVBO();
-    vboNormals_.uploadDataToGPU(GL_STATIC_DRAW);
+    LOG_DEBUG(Assets, "MD2 model '{}' has {} bytes of {} frame data", filePath, frameVerticesData.size() + normalsData.size() * sizeof(glm::vec3),
+        keepFramesQuantized ? "quantized" : "float");
+    if (enableInstancedRendering) {
+        createInstancedRenderingData(commandVertexIndices, textureCoordinates, instancedFrameData);
+    }
 
     // I have read, that if you read the data from header.numSkins and header.offsetSkins,
     // these data are Quake2 specific paths. So usually you will find models on internet
@@ -353,7 +342,6 @@ void MD2Model::loadModel(const std::string& filePath, const glm::mat4& modelTran
     }
 
     filePath_ = filePath;
-    in.close();
 }
 
 bool MD2Model::isLoaded() const
@@ -361,6 +349,11 @@ bool MD2Model::isLoaded() const
     return vao_ != 0;
 }
 
+bool MD2Model::isInstancedRenderingEnabled() const
+{
+    return instancedVAO_ != 0;
+}
+
 void MD2Model::useQuake2AnimationList()
 {
     animations_.clear();
@@ -391,16 +384,17 @@ void MD2Model::renderModelAnimated(const AnimationState& animationState)
 {
     if (!isLoaded())
     {
-        std::cout << "MD2 model has not been loaded, cannot render it!" << std::endl;
+        LOG_WARN(Assets, "MD2 model has not been loaded, cannot render it!");
         return;
     }
-    auto& shaderProgram = ShaderProgramManager::getInstance().getShaderProgram("md2");
+    auto& shaderProgram = ShaderProgramManager::getInstance().getShaderProgram(SHADER_PROGRAM_KEY);
     skinTexture_.bind();
 
     // Setup vertex attributes for current and next frame
     setupVAO(animationState.currentFrame, animationState.nextFrame);
 
     shaderProgram[ShaderConstants::interpolationFactor()] = animationState.interpolationFactor;
+    setQuantizedFramesUniforms(shaderProgram, animationState.currentFrame, animationState.nextFrame);
     GLint totalOffset = 0;
     for (size_t i = 0; i < renderModes.size(); i++)
     {
@@ -413,14 +407,16 @@ void MD2Model::renderModelStatic()
 {
     if(!isLoaded())
     {
-        std::cout << "MD2 model has not been loaded, cannot render it!" << std::endl;
+        LOG_WARN(Assets, "MD2 model has not been loaded, cannot render it!");
         return;
     }
 
     skinTexture_.bind();
     setupVAO(0);
 
-    ShaderProgramManager::getInstance().getShaderProgram("md2")[ShaderConstants::interpolationFactor()] = 0;
+    auto& shaderProgram = ShaderProgramManager::getInstance().getShaderProgram(SHADER_PROGRAM_KEY);
+    shaderProgram[ShaderConstants::interpolationFactor()] = 0;
+    setQuantizedFramesUniforms(shaderProgram, 0, 0);
     GLint totalOffset = 0;
     for (size_t i = 0; i < renderModes.size(); i++) // Just render using previously extracted render modes
     {
@@ -429,6 +425,114 @@ void MD2Model::renderModelStatic()
     }
 }
 
+void MD2Model::renderModelInstanced(const InstanceData* instances, const size_t numInstances)
+{
+    if (!isInstancedRenderingEnabled())
+    {
+        LOG_WARN(Assets, "MD2 model '{}' has not been loaded with instanced rendering enabled, cannot render its instances!", filePath_);
+        return;
+    }
+
+    if (numInstances == 0) {
+        return;
+    }
+
+    // Instance buffer is created lazily. Whole buffer is respecified every time, so the driver can orphan
+    // the old storage instead of waiting for previous draws
+    if (vboInstances_.getBufferID() == 0) {
+        vboInstances_.createVBO(sizeof(InstanceData) * numInstances);
+    }
+
+    vboInstances_.bindVBO();
+    vboInstances_.uploadDataToGPU(instances, sizeof(InstanceData) * numInstances, GL_STREAM_DRAW);
+    renderModelInstancedFromBuffer(vboInstances_.getBufferID(), numInstances);
+}
+
+void MD2Model::renderModelInstanced(const std::vector<InstanceData>& instances)
+{
+    renderModelInstanced(instances.data(), instances.size());
+}
+
+void MD2Model::renderModelInstancedFromBuffer(const GLuint instanceBufferID, const size_t numInstances)
+{
+    if (!isInstancedRenderingEnabled())
+    {
+        LOG_WARN(Assets, "MD2 model '{}' has not been loaded with instanced rendering enabled, cannot render its instances!", filePath_);
+        return;
+    }
+
+    if (numInstances == 0) {
+        return;
+    }
+
+    auto& gsc = GLStateCache::getInstance();
+    gsc.bindVertexArray(instancedVAO_);
+
+    // Format of instance attributes is stored in the VAO, only the buffer (which may differ between draws) is switched
+    glBindVertexBuffer(INSTANCE_DATA_BUFFER_BINDING, instanceBufferID, 0, sizeof(InstanceData));
+
+    skinTexture_.bind();
+    gsc.bindTextureToUnit(isFrameQuantized_ ? QUANTIZED_FRAME_DATA_TEXTURE_UNIT : FRAME_DATA_TEXTURE_UNIT, GL_TEXTURE_BUFFER, frameDataTexture_);
+    auto& shaderProgram = ShaderProgramManager::getInstance().getShaderProgram(INSTANCED_SHADER_PROGRAM_KEY);
+    shaderProgram[ShaderConstants::numFrameVertices()] = header_.numVertices;
+    shaderProgram[ShaderConstants::quantizedFramesEnabled()] = isFrameQuantized_ ? 1 : 0;
+    if (isFrameQuantized_)
+    {
+        gsc.bindTextureToUnit(FRAME_TRANSFORMS_TEXTURE_UNIT, GL_TEXTURE_BUFFER, frameTransformsTexture_);
+        shaderProgram[ShaderConstants::quantizedFramesTransformMatrix()] = modelTransformMatrix_;
+        shaderProgram[ShaderConstants::quantizedFramesNormalMatrix()] = glm::transpose(glm::inverse(glm::mat3(modelTransformMatrix_)));
+    }
+
+    glDrawElementsInstanced(GL_TRIANGLES, numInstancedIndices_, instancedIndexType_, nullptr, static_cast<GLsizei>(numInstances));
+}
+
+MD2Model::InstanceData MD2Model::getInstanceData(const glm::mat4& modelMatrix, const AnimationState& animationState) const
+{
+    // Same fallback as in setupVAO - frame out of range is not interpolated to
+    const auto numFrames = static_cast<size_t>(header_.numFrames);
+    const auto currentFrame = animationState.currentFrame < numFrames ? animationState.currentFrame : 0;
+    const auto nextFrame = animationState.nextFrame < numFrames ? animationState.nextFrame : currentFrame;
+
+    InstanceData instanceData;
+    instanceData.modelMatrix = modelMatrix;
+    instanceData.currentFrame = static_cast<int32_t>(currentFrame);
+    instanceData.nextFrame = static_cast<int32_t>(nextFrame);
+    instanceData.interpolationFactor = animationState.interpolationFactor;
+    return instanceData;
+}
+
+void MD2Model::submitAnimated(RenderQueue& renderQueue, RenderQueue::DrawPacket packet, const AnimationState& animationState)
+{
+    if (!isLoaded()) {
+        return;
+    }
+
+    // Vertex attributes point to the frames being interpolated, so they are set up right before the draw
+    packet.shaderProgram = &ShaderProgramManager::getInstance().getShaderProgram(SHADER_PROGRAM_KEY);
+    packet.setTexture(0, GL_TEXTURE_2D, skinTexture_.getID());
+    packet.vao = vao_;
+    packet.draw = [](const void* drawObject, const uint64_t drawArgument)
+    {
+        AnimationState drawnAnimationState;
+        drawnAnimationState.currentFrame = static_cast<size_t>(drawArgument & 0xFFFF);
+        drawnAnimationState.nextFrame = static_cast<size_t>((drawArgument >> 16) & 0xFFFF);
+        const auto interpolationFactorBits = static_cast<uint32_t>(drawArgument >> 32);
+        std::memcpy(&drawnAnimationState.interpolationFactor, &interpolationFactorBits, sizeof(float));
+
+        // Model was submitted through non-const method, so casting constness away is safe
+        const_cast<MD2Model*>(static_cast<const MD2Model*>(drawObject))->renderModelAnimated(drawnAnimationState);
+    };
+    packet.drawObject = this;
+
+    // Only the interpolated frames are needed for the draw, they are packed into the argument (MD2 has at most 512 frames)
+    uint32_t interpolationFactorBits;
+    std::memcpy(&interpolationFactorBits, &animationState.interpolationFactor, sizeof(float));
+    packet.drawArgument = static_cast<uint64_t>(animationState.currentFrame & 0xFFFF)
+        | (static_cast<uint64_t>(animationState.nextFrame & 0xFFFF) << 16)
+        | (static_cast<uint64_t>(interpolationFactorBits) << 32);
+    renderQueue.submit(packet);
+}
+
 const std::vector<std::string>& MD2Model::getAnimationNames()
 {
     if(animationNamesCached_.empty())
@@ -465,15 +569,33 @@ void MD2Model::deleteModel()
         return;
     }
 
-    std::cout << "Deleting MD2 model '" << filePath_ << "':" << std::endl;
-    std::cout << "Deleting VAO #" << vao_ << std::endl;
+    LOG_DEBUG(Assets, "Deleting MD2 model '{}' with VAO #{}", filePath_, vao_);
     glDeleteVertexArrays(1, &vao_);
+    GLStateCache::getInstance().onVertexArrayDeleted(vao_);
     vao_ = 0;
 
     vboFrameVertices_.deleteVBO();
     vboTextureCoordinates_.deleteVBO();
     vboNormals_.deleteVBO();
 
+    glDeleteVertexArrays(1, &instancedVAO_);
+    GLStateCache::getInstance().onVertexArrayDeleted(instancedVAO_);
+    instancedVAO_ = 0;
+
+    vboInstancedVertices_.deleteVBO();
+    vboInstancedIndices_.deleteVBO();
+    vboInstances_.deleteVBO();
+
+    glDeleteTextures(1, &frameDataTexture_);
+    GLStateCache::getInstance().onTextureDeleted(frameDataTexture_);
+    frameDataTexture_ = 0;
+    vboFrameData_.deleteVBO();
+
+    glDeleteTextures(1, &frameTransformsTexture_);
+    GLStateCache::getInstance().onTextureDeleted(frameTransformsTexture_);
+    frameTransformsTexture_ = 0;
+    vboFrameTransforms_.deleteVBO();
+
     skinTexture_.deleteTexture();
 }
 
@@ -503,32 +625,316 @@ void MD2Model::setupVAO(size_t currentFrame, size_t nextFrame)
         return;
     }
 
-    glBindVertexArray(vao_);
-    const auto currentFrameByteOffset = currentFrame * verticesPerFrame_ * sizeof(glm::vec3);
-    const auto nextFrameByteOffset = nextFrame < static_cast<size_t>(header_.numFrames) ? nextFrame * verticesPerFrame_ * sizeof(glm::vec3) : currentFrameByteOffset;
-
-    // Setup pointers to vertices for current and next frame to perform interpolation
-    vboFrameVertices_.bindVBO();
-    glEnableVertexAttribArray(POSITION_ATTRIBUTE_INDEX);
-    glVertexAttribPointer(POSITION_ATTRIBUTE_INDEX, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), reinterpret_cast<void*>(currentFrameByteOffset));
-
-    glEnableVertexAttribArray(NEXT_POSITION_ATTRIBUTE_INDEX);
-    glVertexAttribPointer(NEXT_POSITION_ATTRIBUTE_INDEX, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), reinterpret_cast<void*>(nextFrameByteOffset));
+    GLStateCache::getInstance().bindVertexArray(vao_);
+    const auto frameVertexByteSize = isFrameQuantized_ ? sizeof(MD2Vertex) : sizeof(glm::vec3);
+    const auto currentFrameByteOffset = currentFrame * verticesPerFrame_ * frameVertexByteSize;
+    const auto nextFrameByteOffset = nextFrame < static_cast<size_t>(header_.numFrames) ? nextFrame * verticesPerFrame_ * frameVertexByteSize : currentFrameByteOffset;
 
     // Setup pointers to texture coordinates
     vboTextureCoordinates_.bindVBO();
     glEnableVertexAttribArray(TEXTURE_COORDINATE_ATTRIBUTE_INDEX);
     glVertexAttribPointer(TEXTURE_COORDINATE_ATTRIBUTE_INDEX, 2, GL_FLOAT, GL_FALSE, sizeof(glm::vec2), nullptr);
 
+    glEnableVertexAttribArray(POSITION_ATTRIBUTE_INDEX);
+    glEnableVertexAttribArray(NEXT_POSITION_ATTRIBUTE_INDEX);
+    glEnableVertexAttribArray(NORMAL_ATTRIBUTE_INDEX);
+    glEnableVertexAttribArray(NEXT_NORMAL_ATTRIBUTE_INDEX);
+    if (isFrameQuantized_)
+    {
+        // Quantized coordinates come as non-normalized bytes, normal attribute gets just the normal index (in x)
+        vboFrameVertices_.bindVBO();
+        glVertexAttribPointer(POSITION_ATTRIBUTE_INDEX, 3, GL_UNSIGNED_BYTE, GL_FALSE, sizeof(MD2Vertex), reinterpret_cast<void*>(currentFrameByteOffset));
+        glVertexAttribPointer(NEXT_POSITION_ATTRIBUTE_INDEX, 3, GL_UNSIGNED_BYTE, GL_FALSE, sizeof(MD2Vertex), reinterpret_cast<void*>(nextFrameByteOffset));
+        glVertexAttribPointer(NORMAL_ATTRIBUTE_INDEX, 1, GL_UNSIGNED_BYTE, GL_FALSE, sizeof(MD2Vertex), reinterpret_cast<void*>(currentFrameByteOffset + offsetof(MD2Vertex, normal_index)));
+        glVertexAttribPointer(NEXT_NORMAL_ATTRIBUTE_INDEX, 1, GL_UNSIGNED_BYTE, GL_FALSE, sizeof(MD2Vertex), reinterpret_cast<void*>(nextFrameByteOffset + offsetof(MD2Vertex, normal_index)));
+        return;
+    }
+
+    // Setup pointers to vertices for current and next frame to perform interpolation
+    vboFrameVertices_.bindVBO();
+    glVertexAttribPointer(POSITION_ATTRIBUTE_INDEX, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), reinterpret_cast<void*>(currentFrameByteOffset));
+    glVertexAttribPointer(NEXT_POSITION_ATTRIBUTE_INDEX, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), reinterpret_cast<void*>(nextFrameByteOffset));
+
     // Setup pointers to normals for current and next frame to perform interpolation
     vboNormals_.bindVBO();
-    glEnableVertexAttribArray(NORMAL_ATTRIBUTE_INDEX);
     glVertexAttribPointer(NORMAL_ATTRIBUTE_INDEX, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), reinterpret_cast<void*>(currentFrameByteOffset));
-
-    glEnableVertexAttribArray(NEXT_NORMAL_ATTRIBUTE_INDEX);
     glVertexAttribPointer(NEXT_NORMAL_ATTRIBUTE_INDEX, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), reinterpret_cast<void*>(nextFrameByteOffset));
 }
 
+void MD2Model::setQuantizedFramesUniforms(ShaderProgram& shaderProgram, size_t currentFrame, size_t nextFrame) const
+{
+    shaderProgram[ShaderConstants::quantizedFramesEnabled()] = isFrameQuantized_ ? 1 : 0;
+    if (!isFrameQuantized_ || currentFrame >= frameScales_.size()) {
+        return;
+    }
+
+    nextFrame = nextFrame < frameScales_.size() ? nextFrame : currentFrame;
+    shaderProgram[ShaderConstants::quantizedFramesScale()] = frameScales_[currentFrame];
+    shaderProgram[ShaderConstants::quantizedFramesTranslate()] = frameTranslates_[currentFrame];
+    shaderProgram[ShaderConstants::quantizedFramesNextScale()] = frameScales_[nextFrame];
+    shaderProgram[ShaderConstants::quantizedFramesNextTranslate()] = frameTranslates_[nextFrame];
+    shaderProgram[ShaderConstants::quantizedFramesTransformMatrix()] = modelTransformMatrix_;
+    shaderProgram[ShaderConstants::quantizedFramesNormalMatrix()] = glm::transpose(glm::inverse(glm::mat3(modelTransformMatrix_)));
+}
+
+void MD2Model::createInstancedRenderingData(const std::vector<int32_t>& commandVertexIndices, const std::vector<glm::vec2>& textureCoordinates,
+    const std::vector<unsigned char>& instancedFrameData)
+{
+    // Strips and fans share vertices, so every unique pair of frame vertex and texture coordinate is stored only once
+    std::map<std::tuple<int32_t, float, float>, GLuint> vertexIndices;
+    std::vector<InstancedVertex> vertices;
+    std::vector<GLuint> indices;
+    std::vector<GLuint> commandIndices;
+    size_t firstCommandVertex = 0;
+    for (size_t i = 0; i < renderModes.size(); i++)
+    {
+        commandIndices.clear();
+        for (auto j = firstCommandVertex; j < firstCommandVertex + numRenderVertices[i]; j++)
+        {
+            const auto& textureCoordinate = textureCoordinates[j];
+            const auto key = std::make_tuple(commandVertexIndices[j], textureCoordinate.x, textureCoordinate.y);
+            const auto it = vertexIndices.find(key);
+            if (it != vertexIndices.end())
+            {
+                commandIndices.push_back(it->second);
+                continue;
+            }
+
+            const auto newIndex = static_cast<GLuint>(vertices.size());
+            vertexIndices[key] = newIndex;
+            vertices.push_back(InstancedVertex{ textureCoordinate, commandVertexIndices[j] });
+            commandIndices.push_back(newIndex);
+        }
+
+        firstCommandVertex += numRenderVertices[i];
+
+        // Every vertex after the first two forms one triangle, every other triangle of a strip has swapped winding
+        for (size_t j = 2; j < commandIndices.size(); j++)
+        {
+            if (renderModes[i] == GL_TRIANGLE_FAN) {
+                indices.insert(indices.end(), { commandIndices[0], commandIndices[j - 1], commandIndices[j] });
+            }
+            else if (j % 2 == 0) {
+                indices.insert(indices.end(), { commandIndices[j - 2], commandIndices[j - 1], commandIndices[j] });
+            }
+            else {
+                indices.insert(indices.end(), { commandIndices[j - 1], commandIndices[j - 2], commandIndices[j] });
+            }
+        }
+    }
+
+    glGenVertexArrays(1, &instancedVAO_);
+    GLStateCache::getInstance().bindVertexArray(instancedVAO_);
+
+    vboInstancedVertices_.createVBO();
+    vboInstancedVertices_.bindVBO();
+    vboInstancedVertices_.uploadDataToGPU(vertices.data(), vertices.size() * sizeof(InstancedVertex), GL_STATIC_DRAW);
+
+    glEnableVertexAttribArray(FRAME_VERTEX_INDEX_ATTRIBUTE_INDEX);
+    glVertexAttribIPointer(FRAME_VERTEX_INDEX_ATTRIBUTE_INDEX, 1, GL_INT, sizeof(InstancedVertex), reinterpret_cast<void*>(offsetof(InstancedVertex, frameVertexIndex)));
+    glEnableVertexAttribArray(TEXTURE_COORDINATE_ATTRIBUTE_INDEX);
+    glVertexAttribPointer(TEXTURE_COORDINATE_ATTRIBUTE_INDEX, 2, GL_FLOAT, GL_FALSE, sizeof(InstancedVertex), reinterpret_cast<void*>(offsetof(InstancedVertex, textureCoordinate)));
+
+    // Instance attributes read from their own binding point advancing once per instance, buffer is bound to it with every draw
+    for (auto column = 0; column < 4; column++)
+    {
+        const auto attributeIndex = INSTANCE_MATRIX_ATTRIBUTE_INDEX + column;
+        glEnableVertexAttribArray(attributeIndex);
+        glVertexAttribFormat(attributeIndex, 4, GL_FLOAT, GL_FALSE, static_cast<GLuint>(offsetof(InstanceData, modelMatrix) + sizeof(glm::vec4) * column));
+        glVertexAttribBinding(attributeIndex, INSTANCE_DATA_BUFFER_BINDING);
+    }
+
+    glEnableVertexAttribArray(INSTANCE_FRAMES_ATTRIBUTE_INDEX);
+    glVertexAttribIFormat(INSTANCE_FRAMES_ATTRIBUTE_INDEX, 2, GL_INT, static_cast<GLuint>(offsetof(InstanceData, currentFrame)));
+    glVertexAttribBinding(INSTANCE_FRAMES_ATTRIBUTE_INDEX, INSTANCE_DATA_BUFFER_BINDING);
+
+    glEnableVertexAttribArray(INSTANCE_INTERPOLATION_ATTRIBUTE_INDEX);
+    glVertexAttribFormat(INSTANCE_INTERPOLATION_ATTRIBUTE_INDEX, 1, GL_FLOAT, GL_FALSE, static_cast<GLuint>(offsetof(InstanceData, interpolationFactor)));
+    glVertexAttribBinding(INSTANCE_INTERPOLATION_ATTRIBUTE_INDEX, INSTANCE_DATA_BUFFER_BINDING);
+    glVertexBindingDivisor(INSTANCE_DATA_BUFFER_BINDING, 1);
+
+    // Short indices are enough for almost any MD2 model
+    vboInstancedIndices_.createVBO();
+    vboInstancedIndices_.bindVBO(GL_ELEMENT_ARRAY_BUFFER);
+    numInstancedIndices_ = static_cast<GLsizei>(indices.size());
+    if (vertices.size() <= 0xFFFF)
+    {
+        const std::vector<GLushort> shortIndices(indices.begin(), indices.end());
+        instancedIndexType_ = GL_UNSIGNED_SHORT;
+        vboInstancedIndices_.uploadDataToGPU(shortIndices.data(), shortIndices.size() * sizeof(GLushort), GL_STATIC_DRAW);
+    }
+    else
+    {
+        instancedIndexType_ = GL_UNSIGNED_INT;
+        vboInstancedIndices_.uploadDataToGPU(indices.data(), indices.size() * sizeof(GLuint), GL_STATIC_DRAW);
+    }
+
+    // Quantized frames are stored as they are in the file (one texel per frame vertex), scale and translation
+    // of every frame are two consecutive texels of another texture buffer
+    if (isFrameQuantized_)
+    {
+        vboFrameTransforms_.createVBO(frameScales_.size() * 2 * sizeof(glm::vec3));
+        for (size_t i = 0; i < frameScales_.size(); i++)
+        {
+            vboFrameTransforms_.addData(frameScales_[i]);
+            vboFrameTransforms_.addData(frameTranslates_[i]);
+        }
+
+        vboFrameTransforms_.bindVBO(GL_TEXTURE_BUFFER);
+        vboFrameTransforms_.uploadDataToGPU(GL_STATIC_DRAW);
+
+        glGenTextures(1, &frameTransformsTexture_);
+        GLStateCache::getInstance().bindTextureToUnit(FRAME_TRANSFORMS_TEXTURE_UNIT, GL_TEXTURE_BUFFER, frameTransformsTexture_);
+        glTexBuffer(GL_TEXTURE_BUFFER, GL_RGB32F, vboFrameTransforms_.getBufferID());
+    }
+
+    // Otherwise all frames are in one buffer, position and normal of the frame vertex are two consecutive texels
+    vboFrameData_.createVBO();
+    vboFrameData_.bindVBO(GL_TEXTURE_BUFFER);
+    vboFrameData_.uploadDataToGPU(instancedFrameData.data(), instancedFrameData.size(), GL_STATIC_DRAW);
+
+    const auto frameDataTextureUnit = isFrameQuantized_ ? QUANTIZED_FRAME_DATA_TEXTURE_UNIT : FRAME_DATA_TEXTURE_UNIT;
+    glGenTextures(1, &frameDataTexture_);
+    GLStateCache::getInstance().bindTextureToUnit(frameDataTextureUnit, GL_TEXTURE_BUFFER, frameDataTexture_);
+    glTexBuffer(GL_TEXTURE_BUFFER, isFrameQuantized_ ? GL_RGBA8UI : GL_RGB32F, vboFrameData_.getBufferID());
+
+    LOG_DEBUG(Assets, "MD2 model instanced rendering data: {} unique vertices, {} triangles, {} bytes of frame data", vertices.size(),
+        indices.size() / 3, vboFrameData_.getBufferSize());
+}
+
+bool MD2Model::readHeader(const unsigned char* data, const size_t fileSize)
+{
+    if (fileSize < sizeof(MD2Header)) {
+        return false;
+    }
+
+    memcpy(&header_, data, sizeof(MD2Header));
+    if (header_.ident != MD2_IDENT || header_.version != MD2_VERSION) {
+        return false;
+    }
+
+    // Sizes are computed in 64 bits, so that huge counts can't overflow
+    const auto minFrameSize = static_cast<int64_t>(offsetof(MD2Frame, vertices)) + static_cast<int64_t>(header_.numVertices) * sizeof(MD2Vertex);
+    const auto framesEnd = static_cast<int64_t>(header_.offsetFrames) + static_cast<int64_t>(header_.numFrames) * header_.frameSize;
+    const auto glCommandsEnd = static_cast<int64_t>(header_.offsetGlCommands) + static_cast<int64_t>(header_.numGlCommands) * sizeof(int32_t);
+    return header_.numVertices > 0 && header_.numVertices <= MAX_MD2_VERTICES && header_.numFrames > 0 && header_.numGlCommands > 0
+        && header_.frameSize >= minFrameSize && header_.offsetFrames >= 0 && header_.offsetGlCommands >= 0
+        && framesEnd <= static_cast<int64_t>(fileSize) && glCommandsEnd <= static_cast<int64_t>(fileSize);
+}
+
+bool MD2Model::readRenderCommands(const unsigned char* glCommandsData, std::vector<int32_t>& commandVertexIndices, std::vector<glm::vec2>& textureCoordinates)
+{
+    // Commands don't have to be aligned in the file, so every value is copied out
+    const auto readValue = [glCommandsData](const int32_t index)
+    {
+        int32_t value = 0;
+        memcpy(&value, glCommandsData + static_cast<size_t>(index) * sizeof(int32_t), sizeof(int32_t));
+        return value;
+    };
+
+    renderModes.clear();
+    numRenderVertices.clear();
+    verticesPerFrame_ = 0;
+
+    // Loop until raw OpenGL command is zero (or until the end of commands)
+    for(int32_t i = 0; i < header_.numGlCommands && readValue(i) != 0;)
+    {
+        const auto command = static_cast<int64_t>(readValue(i)); // Here is encoded rendering mode and number of vertices
+        const auto renderMode = command < 0 ? GL_TRIANGLE_FAN : GL_TRIANGLE_STRIP; // Rendering mode is one of the two options, depending on the sign
+        const auto numVertices = command < 0 ? -command : command; // Number of vertices is just absolute value of the command
+        i++;
+
+        // Every vertex takes 3 values (texture coordinates and vertex index), all of them must be within the commands
+        if (numVertices * 3 > header_.numGlCommands - i) {
+            return false;
+        }
+
+        renderModes.push_back(renderMode); // Remember the values
+        numRenderVertices.push_back(static_cast<GLsizei>(numVertices));
+        for(int64_t j = 0; j < numVertices; j++)
+        {
+            float u = 0.0f;
+            float v = 0.0f;
+            const auto rawU = readValue(i++);
+            const auto rawV = readValue(i++);
+            memcpy(&u, &rawU, sizeof(float)); // Extract texture coordinates
+            memcpy(&v, &rawV, sizeof(float));
+            const auto vertexIndex = readValue(i++);
+            if (vertexIndex < 0 || vertexIndex >= header_.numVertices) {
+                return false;
+            }
+
+            textureCoordinates.emplace_back(u, 1.0f - v); // Flip t, because it is (for some reasons) stored from top to bottom
+            commandVertexIndices.push_back(vertexIndex);
+            verticesPerFrame_++;
+        }
+    }
+
+    return verticesPerFrame_ > 0;
+}
+
+void MD2Model::decodeFrame(const unsigned char* frameData, const size_t frameIndex, const std::vector<int32_t>& commandVertexIndices,
+    unsigned char* frameVerticesData, glm::vec3* normalsData, unsigned char* instancedFrameData)
+{
+    float scale[3];
+    float translate[3];
+    memcpy(scale, frameData + offsetof(MD2Frame, scale), sizeof(scale));
+    memcpy(translate, frameData + offsetof(MD2Frame, translate), sizeof(translate));
+    frameScales_[frameIndex] = glm::vec3(scale[0], scale[1], scale[2]);
+    frameTranslates_[frameIndex] = glm::vec3(translate[0], translate[1], translate[2]);
+
+    // Quantized vertices are just copied, once per frame vertex and once per vertex of OpenGL commands
+    const auto numFrameVertices = static_cast<size_t>(header_.numVertices);
+    const auto frameVertices = frameData + offsetof(MD2Frame, vertices);
+    if (isFrameQuantized_)
+    {
+        if (instancedFrameData != nullptr) {
+            memcpy(instancedFrameData + frameIndex * numFrameVertices * sizeof(MD2Vertex), frameVertices, numFrameVertices * sizeof(MD2Vertex));
+        }
+
+        auto commandFrameVertices = frameVerticesData + frameIndex * verticesPerFrame_ * sizeof(MD2Vertex);
+        for (size_t j = 0; j < verticesPerFrame_; j++) {
+            memcpy(commandFrameVertices + j * sizeof(MD2Vertex), frameVertices + commandVertexIndices[j] * sizeof(MD2Vertex), sizeof(MD2Vertex));
+        }
+
+        return;
+    }
+
+    const auto normalTransformMatrix = glm::transpose(glm::inverse(glm::mat3(modelTransformMatrix_)));
+    const auto decodeVertex = [&](const size_t vertexIndex, glm::vec3& position, glm::vec3& normal)
+    {
+        const auto frameVertex = frameVertices + vertexIndex * sizeof(MD2Vertex);
+        const glm::vec3 framePosition(translate[0] + static_cast<float>(frameVertex[0]) * scale[0],
+            translate[1] + static_cast<float>(frameVertex[1]) * scale[1],
+            translate[2] + static_cast<float>(frameVertex[2]) * scale[2]);
+        position = glm::vec3(modelTransformMatrix_ * glm::vec4(framePosition, 1.0f));
+        normal = normalTransformMatrix * ANORMS_TABLE[frameVertex[3] % ANORMS_TABLE_SIZE];
+    };
+
+    auto commandPositions = reinterpret_cast<glm::vec3*>(frameVerticesData) + frameIndex * verticesPerFrame_;
+    auto commandNormals = normalsData + frameIndex * verticesPerFrame_;
+    if (instancedFrameData == nullptr)
+    {
+        for (size_t j = 0; j < verticesPerFrame_; j++) {
+            decodeVertex(commandVertexIndices[j], commandPositions[j], commandNormals[j]);
+        }
+
+        return;
+    }
+
+    // With instanced rendering every frame vertex is decoded only once (position and normal interleaved), vertices of OpenGL commands copy them
+    const auto decodedVertices = reinterpret_cast<glm::vec3*>(instancedFrameData) + frameIndex * numFrameVertices * 2;
+    for (size_t vertexIndex = 0; vertexIndex < numFrameVertices; vertexIndex++) {
+        decodeVertex(vertexIndex, decodedVertices[vertexIndex * 2], decodedVertices[vertexIndex * 2 + 1]);
+    }
+
+    for (size_t j = 0; j < verticesPerFrame_; j++)
+    {
+        commandPositions[j] = decodedVertices[commandVertexIndices[j] * 2];
+        commandNormals[j] = decodedVertices[commandVertexIndices[j] * 2 + 1];
+    }
+}
+
 } // namespace animated_meshes_3D
 } // namespace common_classes
 } // namespace opengl4_mbsoftworks
\ No newline at end of file
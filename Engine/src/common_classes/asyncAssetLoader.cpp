@@ -0,0 +1,197 @@
+// STL
+#include <chrono>
+#include <algorithm>
+#include <limits>
+
+// Project
+#include "../includes/common_classes/asyncAssetLoader.h"
+#include "../includes/common_classes/instrumentation.h"
+#include "../includes/common_classes/logManager.h"
+
+const double AsyncAssetLoader::DEFAULT_FRAME_BUDGET_SECONDS = 0.002;
+
+AsyncAssetLoader& AsyncAssetLoader::getInstance()
+{
+    static AsyncAssetLoader aal;
+    return aal;
+}
+
+AsyncAssetLoader::~AsyncAssetLoader()
+{
+    shutdown();
+}
+
+void AsyncAssetLoader::submitWorkerTask(std::function<void()> task, FailureCallback onFailure)
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (_isShuttingDown) {
+            return;
+        }
+
+        startWorkerThreads();
+        _workerTasks.push_back(Task{ std::move(task), std::move(onFailure) });
+    }
+
+    _workerCondition.notify_one();
+}
+
+void AsyncAssetLoader::submitContextTask(std::function<void()> task, FailureCallback onFailure)
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (_isShuttingDown) {
+            return;
+        }
+
+        _contextTasks.push_back(Task{ std::move(task), std::move(onFailure) });
+    }
+
+    _contextCondition.notify_one();
+}
+
+size_t AsyncAssetLoader::processContextTasks(double timeBudgetSeconds)
+{
+    INSTRUMENT_ZONE("AsyncAssetLoader::processContextTasks");
+    const auto startTime = std::chrono::steady_clock::now();
+    size_t numProcessedTasks = 0;
+
+    while (true)
+    {
+        Task task;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (_contextTasks.empty()) {
+                break;
+            }
+
+            task = std::move(_contextTasks.front());
+            _contextTasks.pop_front();
+        }
+
+        const auto exception = executeTask(task);
+        if (exception && task.onFailure) {
+            task.onFailure(exception);
+        }
+
+        numProcessedTasks++;
+
+        const std::chrono::duration<double> elapsedTime = std::chrono::steady_clock::now() - startTime;
+        if (elapsedTime.count() >= timeBudgetSeconds) {
+            break;
+        }
+    }
+
+    return numProcessedTasks;
+}
+
+void AsyncAssetLoader::waitForAllTasks()
+{
+    while (true)
+    {
+        // Budget is unlimited, we are waiting for everything anyway
+        processContextTasks(std::numeric_limits<double>::max());
+
+        std::unique_lock<std::mutex> lock(_mutex);
+        if (_workerTasks.empty() && _numRunningWorkerTasks == 0 && _contextTasks.empty()) {
+            break;
+        }
+
+        _contextCondition.wait(lock, [this]() {
+            return !_contextTasks.empty() || (_workerTasks.empty() && _numRunningWorkerTasks == 0);
+        });
+    }
+}
+
+bool AsyncAssetLoader::hasPendingTasks() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return !_workerTasks.empty() || _numRunningWorkerTasks > 0 || !_contextTasks.empty();
+}
+
+void AsyncAssetLoader::shutdown()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _isShuttingDown = true;
+        _workerTasks.clear();
+    }
+
+    _workerCondition.notify_all();
+    for (auto& workerThread : _workerThreads) {
+        workerThread.join();
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    _workerThreads.clear();
+    _contextTasks.clear();
+}
+
+void AsyncAssetLoader::startWorkerThreads()
+{
+    if (!_workerThreads.empty()) {
+        return;
+    }
+
+    // Leave one hardware thread for the context (main) thread
+    const auto numHardwareThreads = static_cast<int>(std::thread::hardware_concurrency());
+    const auto numWorkerThreads = std::max(1, numHardwareThreads - 1);
+    for (auto i = 0; i < numWorkerThreads; i++) {
+        _workerThreads.emplace_back(&AsyncAssetLoader::workerThreadMain, this);
+    }
+
+    LOG_INFO(Assets, "Started {} asset loading worker threads", numWorkerThreads);
+}
+
+void AsyncAssetLoader::workerThreadMain()
+{
+    Instrumentation::getInstance().setThreadName("Asset worker");
+    while (true)
+    {
+        Task task;
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _workerCondition.wait(lock, [this]() { return _isShuttingDown || !_workerTasks.empty(); });
+            if (_isShuttingDown) {
+                return;
+            }
+
+            task = std::move(_workerTasks.front());
+            _workerTasks.pop_front();
+            _numRunningWorkerTasks++;
+        }
+
+        // Failure callback goes to the context thread, where the rest of the asset would have been created
+        const auto exception = executeTask(task);
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _numRunningWorkerTasks--;
+            if (exception && task.onFailure && !_isShuttingDown)
+            {
+                auto onFailure = std::move(task.onFailure);
+                _contextTasks.push_back(Task{ [onFailure, exception]() { onFailure(exception); }, nullptr });
+            }
+        }
+
+        _contextCondition.notify_all();
+    }
+}
+
+std::exception_ptr AsyncAssetLoader::executeTask(const Task& task)
+{
+    try
+    {
+        task.function();
+        return nullptr;
+    }
+    catch (const std::exception& ex)
+    {
+        LOG_ERROR(Assets, "Asset loading task has failed: {}", ex.what());
+        return std::current_exception();
+    }
+    catch (...)
+    {
+        LOG_ERROR(Assets, "Asset loading task has failed with unknown exception!");
+        return std::current_exception();
+    }
+}
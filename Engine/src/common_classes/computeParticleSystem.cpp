@@ -0,0 +1,425 @@
+// STL
+#include <random>
+#include <cstddef>
+#include <algorithm>
+#include <stdexcept>
+
+// Project
+#include "../includes/common_classes/computeParticleSystem.h"
+#include "../includes/common_classes/shaderManager.h"
+#include "../includes/common_classes/shaderProgramManager.h"
+#include "../includes/common_classes/glStateCache.h"
+#include "../includes/common_classes/logManager.h"
+
+const std::string ComputeParticleSystem::PREPARE_UPDATE_PROGRAM_KEY = "compute_particles_prepare_update";
+const std::string ComputeParticleSystem::FINISH_UPDATE_PROGRAM_KEY = "compute_particles_finish_update";
+const std::string ComputeParticleSystem::RANDOM_SHADER_KEY = "compute_random";
+
+namespace {
+
+/**
+ * State of the particle system kept in the state buffer, layout must match ParticleSystemStateBlock
+ * in common/particleSystemState.glsl. Commands have the layouts required by indirect dispatch / draw.
+ */
+struct ParticleSystemState
+{
+    GLuint numAliveParticles; // Number of particles in the read buffer
+    GLuint numWrittenParticles; // Number of particles written to the write buffer (atomic counter during the update)
+    GLuint dispatchNumGroups[3]; // Indirect dispatch command of the update
+    GLuint drawCount; // Indirect draw command - number of particles to render
+    GLuint drawInstanceCount; // Indirect draw command - number of instances (always 1)
+    GLuint drawFirst; // Indirect draw command - first particle
+    GLuint drawBaseInstance; // Indirect draw command - base instance
+};
+
+const GLintptr OUTPUT_COUNTER_OFFSET = offsetof(ParticleSystemState, numWrittenParticles);
+const GLintptr DISPATCH_COMMAND_OFFSET = offsetof(ParticleSystemState, dispatchNumGroups);
+const GLintptr DRAW_COMMAND_OFFSET = offsetof(ParticleSystemState, drawCount);
+
+} // namespace
+
+ComputeParticleSystem::ComputeParticleSystem(const int numMaxParticlesInBuffer)
+    : numMaxParticlesInBuffer_(numMaxParticlesInBuffer)
+{
+}
+
+ComputeParticleSystem::~ComputeParticleSystem()
+{
+    releaseParticleSystem();
+}
+
+bool ComputeParticleSystem::initialize()
+{
+    // If the initialization went successfully in the past, just return true
+    if (isInitialized_) {
+        return true;
+    }
+
+    prepareCommonShaderPrograms();
+
+    // Type and position come first, so that the particles are read by the same render shaders as transform feedback ones
+    addParticleInt("type");
+    addParticleVec3("position");
+
+    // If the initialization of shaders and particle variables fails, don't continue
+    if (!initializeShadersAndParticleVariables())
+    {
+        particleVariables_.clear();
+        return false;
+    }
+
+    calculateParticleVariableOffsets();
+    if (!validateParticleLayout())
+    {
+        particleVariables_.clear();
+        return false;
+    }
+
+    // Now that all went through just fine, let's generate all necessary OpenGL objects
+    generateOpenGLObjects();
+    isInitialized_ = true;
+
+    return true;
+}
+
+void ComputeParticleSystem::renderParticles()
+{
+    // Can't render if system is not initialized
+    if (!isInitialized_) {
+        return;
+    }
+
+    prepareRenderParticles();
+
+    // Number of particles is written by the finishing pass of the last update, CPU doesn't know it
+    auto& gsc = GLStateCache::getInstance();
+    gsc.bindVertexArray(renderVAOs_[readBufferIndex_]);
+    gsc.bindBuffer(GL_DRAW_INDIRECT_BUFFER, stateBufferID_);
+    glDrawArraysIndirect(GL_POINTS, reinterpret_cast<const void*>(DRAW_COMMAND_OFFSET));
+}
+
+void ComputeParticleSystem::updateParticles(const float deltaTime)
+{
+    // Can't update if system is not initialized
+    if (!isInitialized_) {
+        return;
+    }
+
+    collectParticleCount();
+
+    // Calculate write buffer index and let the particle system set up its update program
+    const auto writeBufferIndex = 1 - readBufferIndex_;
+    const auto numParticlesToGenerate = std::max(prepareUpdateParticles(deltaTime), 0);
+
+    auto& gsc = GLStateCache::getInstance();
+    gsc.bindBufferBase(GL_SHADER_STORAGE_BUFFER, INPUT_PARTICLES_BINDING, particlesBuffers_[readBufferIndex_]);
+    gsc.bindBufferBase(GL_SHADER_STORAGE_BUFFER, OUTPUT_PARTICLES_BINDING, particlesBuffers_[writeBufferIndex]);
+    gsc.bindBufferBase(GL_SHADER_STORAGE_BUFFER, STATE_BINDING, stateBufferID_);
+    gsc.bindBufferBase(GL_ATOMIC_COUNTER_BUFFER, OUTPUT_COUNTER_BINDING, stateBufferID_);
+
+    // Reset the counter of written particles and size the dispatch to cover all alive particles plus the generated ones
+    auto& prepareUpdateProgram = ShaderProgramManager::getInstance().getShaderProgram(PREPARE_UPDATE_PROGRAM_KEY);
+    prepareUpdateProgram.useProgram();
+    prepareUpdateProgram[ShaderConstants::numParticlesToGenerate()] = numParticlesToGenerate;
+    glDispatchCompute(1, 1, 1);
+    glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT | GL_ATOMIC_COUNTER_BARRIER_BIT);
+
+    // Every invocation either updates one particle or generates one, survivors are appended to the write buffer
+    auto& updateProgram = getUpdateShaderProgram();
+    updateProgram.useProgram();
+    updateProgram[ShaderConstants::numParticlesToGenerate()] = numParticlesToGenerate;
+    updateProgram[ShaderConstants::numMaxParticles()] = numMaxParticlesInBuffer_;
+    gsc.bindBuffer(GL_DISPATCH_INDIRECT_BUFFER, stateBufferID_);
+    glDispatchComputeIndirect(DISPATCH_COMMAND_OFFSET);
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_ATOMIC_COUNTER_BARRIER_BIT);
+
+    // Clamp the counter (appends beyond the capacity are dropped) and turn it into the draw command
+    auto& finishUpdateProgram = ShaderProgramManager::getInstance().getShaderProgram(FINISH_UPDATE_PROGRAM_KEY);
+    finishUpdateProgram.useProgram();
+    finishUpdateProgram[ShaderConstants::numMaxParticles()] = numMaxParticlesInBuffer_;
+    glDispatchCompute(1, 1, 1);
+    glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+
+    issueCountReadback();
+
+    // Swap read / write buffers for the next frame
+    readBufferIndex_ = writeBufferIndex;
+}
+
+void ComputeParticleSystem::calculateBillboardingVectors(const glm::vec3& cameraViewVector, const glm::vec3& cameraUpVector)
+{
+    billboardHorizontalVector_ = glm::normalize(glm::cross(cameraViewVector, cameraUpVector));
+    billboardVerticalVector_ = glm::normalize(glm::cross(cameraViewVector, -billboardHorizontalVector_));
+}
+
+int ComputeParticleSystem::getNumMaxParticlesInBuffer() const
+{
+    return numMaxParticlesInBuffer_;
+}
+
+int ComputeParticleSystem::getNumParticles() const
+{
+    return numberOfParticles_;
+}
+
+void ComputeParticleSystem::releaseParticleSystem()
+{
+    // Don't release anything if the system was not initialized
+    if (!isInitialized_) {
+        return;
+    }
+
+    for (auto& countReadbackFence : countReadbackFences_)
+    {
+        if (countReadbackFence != nullptr)
+        {
+            glDeleteSync(countReadbackFence);
+            countReadbackFence = nullptr;
+        }
+    }
+
+    glDeleteVertexArrays(2, renderVAOs_);
+    for (const auto renderVAO : renderVAOs_) {
+        GLStateCache::getInstance().onVertexArrayDeleted(renderVAO);
+    }
+
+    LOG_DEBUG(Render, "Deleting buffers for compute particle system with IDs [{}, {}]", particlesBuffers_[0], particlesBuffers_[1]);
+    const GLuint bufferIDs[] = { particlesBuffers_[0], particlesBuffers_[1], stateBufferID_, countReadbackBufferID_ };
+    glDeleteBuffers(4, bufferIDs);
+    for (const auto bufferID : bufferIDs) {
+        GLStateCache::getInstance().onBufferDeleted(bufferID);
+    }
+
+    mappedCountReadbacks_ = nullptr;
+    stateBufferID_ = 0;
+    countReadbackBufferID_ = 0;
+    particleVariables_.clear();
+    isInitialized_ = false;
+}
+
+void ComputeParticleSystem::addParticleInt(const std::string& name, bool neededForRendering)
+{
+    particleVariables_.push_back(ParticleVariable{ name, GL_INT, 1, neededForRendering });
+}
+
+void ComputeParticleSystem::addParticleFloat(const std::string& name, bool neededForRendering)
+{
+    particleVariables_.push_back(ParticleVariable{ name, GL_FLOAT, 1, neededForRendering });
+}
+
+void ComputeParticleSystem::addParticleVec3(const std::string& name, bool neededForRendering)
+{
+    particleVariables_.push_back(ParticleVariable{ name, GL_FLOAT, 3, neededForRendering });
+}
+
+glm::vec3 ComputeParticleSystem::generateRandomNumberGeneratorSeed()
+{
+    static std::random_device rd;
+    static std::mt19937 generator(rd());
+    std::uniform_real_distribution<float> seedDistribution(-10.0f, 10.0f);
+
+    return glm::vec3(seedDistribution(generator), seedDistribution(generator), seedDistribution(generator));
+}
+
+GLsizei ComputeParticleSystem::calculateParticleByteSize() const
+{
+    // Struct in std430 array is aligned to the largest alignment of its members
+    GLsizei particleByteSize = 0;
+    GLsizei particleAlignment = 4;
+    for (const auto& particleVariable : particleVariables_)
+    {
+        const auto alignment = particleVariable.getBaseAlignment();
+        particleByteSize = (particleByteSize + alignment - 1) / alignment * alignment + particleVariable.getByteSize();
+        particleAlignment = std::max(particleAlignment, alignment);
+    }
+
+    return (particleByteSize + particleAlignment - 1) / particleAlignment * particleAlignment;
+}
+
+GLsizei ComputeParticleSystem::ParticleVariable::getByteSize() const
+{
+    if (glType == GL_INT) {
+        return count * sizeof(int32_t);
+    }
+    else if (glType == GL_FLOAT) {
+        return count * sizeof(float);
+    }
+
+    throw std::runtime_error("Unsupported GL data type for compute particle system!");
+}
+
+GLsizei ComputeParticleSystem::ParticleVariable::getBaseAlignment() const
+{
+    // Scalars are aligned to their size, vec3 is aligned like vec4 (its last 4 bytes can hold following scalar though)
+    return count == 1 ? getByteSize() : 4 * getByteSize() / count;
+}
+
+void ComputeParticleSystem::ParticleVariable::enableAndSetupVertexAttribPointer(GLuint index, GLsizei stride) const
+{
+    glEnableVertexAttribArray(index);
+    if (glType == GL_INT)
+    {
+        // If OpenGL type is an integer or consists of integers, the glVertexAttribIPointer must be called (notice the I letter)
+        glVertexAttribIPointer(index, count, glType, stride, reinterpret_cast<const GLvoid*>(static_cast<GLintptr>(byteOffset)));
+    }
+    else
+    {
+        // If OpenGL type is float or consists of floats, the glVertexAttribPointer must be called
+        glVertexAttribPointer(index, count, glType, GL_FALSE, stride, reinterpret_cast<const GLvoid*>(static_cast<GLintptr>(byteOffset)));
+    }
+}
+
+void ComputeParticleSystem::prepareCommonShaderPrograms()
+{
+    auto& sm = ShaderManager::getInstance();
+    if (sm.containsComputeShader(PREPARE_UPDATE_PROGRAM_KEY)) {
+        return;
+    }
+
+    sm.loadComputeShader(PREPARE_UPDATE_PROGRAM_KEY, "../../Engine/data/shaders/particle-system-compute/prepareUpdate.comp");
+    sm.loadComputeShader(FINISH_UPDATE_PROGRAM_KEY, "../../Engine/data/shaders/particle-system-compute/finishUpdate.comp");
+    sm.loadComputeShader(RANDOM_SHADER_KEY, "../../Engine/data/shaders/common/computeRandom.glsl");
+
+    auto& spm = ShaderProgramManager::getInstance();
+    for (const auto& programKey : { PREPARE_UPDATE_PROGRAM_KEY, FINISH_UPDATE_PROGRAM_KEY })
+    {
+        auto& shaderProgram = spm.createShaderProgram(programKey);
+        shaderProgram.addShaderToProgram(sm.getComputeShader(programKey));
+        if (!shaderProgram.linkProgram())
+        {
+            auto msg = "Could not link shader program with key '" + programKey + "'!";
+            throw std::runtime_error(msg.c_str());
+        }
+    }
+}
+
+void ComputeParticleSystem::calculateParticleVariableOffsets()
+{
+    GLsizei byteOffset = 0;
+    for (auto& particleVariable : particleVariables_)
+    {
+        const auto alignment = particleVariable.getBaseAlignment();
+        particleVariable.byteOffset = (byteOffset + alignment - 1) / alignment * alignment;
+        byteOffset = particleVariable.byteOffset + particleVariable.getByteSize();
+    }
+}
+
+bool ComputeParticleSystem::validateParticleLayout()
+{
+    // Layout is queried from the input buffer, the particles are rendered straight from these buffers
+    const auto programID = getUpdateShaderProgram().getShaderProgramID();
+    const auto particleByteSize = calculateParticleByteSize();
+    for (const auto& particleVariable : particleVariables_)
+    {
+        const auto resourceName = "inputParticles[0]." + particleVariable.name;
+        const auto resourceIndex = glGetProgramResourceIndex(programID, GL_BUFFER_VARIABLE, resourceName.c_str());
+        if (resourceIndex == GL_INVALID_INDEX)
+        {
+            LOG_ERROR(Shaders, "Particle variable {} not found in the update program of compute particle system!", particleVariable.name);
+            return false;
+        }
+
+        const GLenum properties[] = { GL_OFFSET, GL_TOP_LEVEL_ARRAY_STRIDE };
+        GLint values[2] = { 0, 0 };
+        glGetProgramResourceiv(programID, GL_BUFFER_VARIABLE, resourceIndex, 2, properties, 2, nullptr, values);
+        if (values[0] != particleVariable.byteOffset || values[1] != particleByteSize)
+        {
+            LOG_ERROR(Shaders, "Particle variable {} has offset {} and stride {} in the shader, but {} and {} were expected (are the variables added in the same order?)",
+                particleVariable.name, values[0], values[1], particleVariable.byteOffset, particleByteSize);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void ComputeParticleSystem::generateOpenGLObjects()
+{
+    // Gather some constants
+    const auto particleByteSize = calculateParticleByteSize();
+    const auto bufferByteSize = static_cast<GLsizeiptr>(particleByteSize) * numMaxParticlesInBuffer_;
+    auto& gsc = GLStateCache::getInstance();
+
+    // Generate two buffers - one serves as source of data (read buffer) and one is written to (write buffer)
+    glGenBuffers(2, particlesBuffers_);
+    for (const auto particlesBuffer : particlesBuffers_)
+    {
+        gsc.bindBuffer(GL_SHADER_STORAGE_BUFFER, particlesBuffer);
+        glBufferStorage(GL_SHADER_STORAGE_BUFFER, bufferByteSize, nullptr, 0);
+    }
+
+    LOG_DEBUG(Render, "Created buffers for compute particle system with IDs [{}, {}] and size {}", particlesBuffers_[0], particlesBuffers_[1], bufferByteSize);
+
+    // System starts empty, zeroed state means no alive particles and nothing to draw
+    const ParticleSystemState initialState{};
+    glGenBuffers(1, &stateBufferID_);
+    gsc.bindBuffer(GL_SHADER_STORAGE_BUFFER, stateBufferID_);
+    glBufferStorage(GL_SHADER_STORAGE_BUFFER, sizeof(ParticleSystemState), &initialState, 0);
+
+    // Readback buffer stays mapped, CPU reads the copied counts once their fences are signaled
+    const auto readbackFlags = GL_MAP_READ_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    glGenBuffers(1, &countReadbackBufferID_);
+    gsc.bindBuffer(GL_COPY_WRITE_BUFFER, countReadbackBufferID_);
+    glBufferStorage(GL_COPY_WRITE_BUFFER, NUM_COUNT_READBACKS * sizeof(GLuint), nullptr, readbackFlags);
+    mappedCountReadbacks_ = static_cast<const GLuint*>(glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, NUM_COUNT_READBACKS * sizeof(GLuint), readbackFlags));
+
+    // Set up VAOs for rendering of particles, particles are read right from the shader storage buffers
+    glGenVertexArrays(2, renderVAOs_);
+    for (auto i = 0; i < 2; i++)
+    {
+        gsc.bindVertexArray(renderVAOs_[i]);
+        gsc.bindBuffer(GL_ARRAY_BUFFER, particlesBuffers_[i]);
+
+        for (size_t j = 0; j < particleVariables_.size(); j++)
+        {
+            // Enable vertex attribute only if it's needed for rendering
+            if (particleVariables_[j].neededForRendering) {
+                particleVariables_[j].enableAndSetupVertexAttribPointer(static_cast<GLuint>(j), particleByteSize);
+            }
+        }
+    }
+
+    // Initialize read buffer index, number of particles and the readback ring
+    readBufferIndex_ = 0;
+    numberOfParticles_ = 0;
+    nextCountReadbackIndex_ = 0;
+}
+
+void ComputeParticleSystem::issueCountReadback()
+{
+    // If the oldest slot still waits for its copy, this update is simply not observed
+    const auto readbackIndex = nextCountReadbackIndex_;
+    if (mappedCountReadbacks_ == nullptr || countReadbackFences_[readbackIndex] != nullptr) {
+        return;
+    }
+
+    auto& gsc = GLStateCache::getInstance();
+    gsc.bindBuffer(GL_COPY_READ_BUFFER, stateBufferID_);
+    gsc.bindBuffer(GL_COPY_WRITE_BUFFER, countReadbackBufferID_);
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, offsetof(ParticleSystemState, numAliveParticles), readbackIndex * sizeof(GLuint), sizeof(GLuint));
+
+    countReadbackFences_[readbackIndex] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    nextCountReadbackIndex_ = (readbackIndex + 1) % NUM_COUNT_READBACKS;
+}
+
+void ComputeParticleSystem::collectParticleCount()
+{
+    // Copies complete in the order they were issued, so the first unfinished one ends the search
+    for (auto i = 0; i < NUM_COUNT_READBACKS; i++)
+    {
+        const auto readbackIndex = (nextCountReadbackIndex_ + i) % NUM_COUNT_READBACKS;
+        auto& countReadbackFence = countReadbackFences_[readbackIndex];
+        if (countReadbackFence == nullptr) {
+            continue;
+        }
+
+        const auto waitResult = glClientWaitSync(countReadbackFence, 0, 0);
+        if (waitResult != GL_ALREADY_SIGNALED && waitResult != GL_CONDITION_SATISFIED) {
+            break;
+        }
+
+        numberOfParticles_ = static_cast<int>(mappedCountReadbacks_[readbackIndex]);
+        glDeleteSync(countReadbackFence);
+        countReadbackFence = nullptr;
+    }
+}
@@ -0,0 +1,555 @@
+// STL
+#include <algorithm>
+#include <cstddef>
+
+// Project
+#include "../includes/common_classes/cpuParticleSimulator.h"
+#include "../includes/common_classes/cpuUtils.h"
+#include "../includes/common_classes/glStateCache.h"
+#include "../includes/common_classes/instrumentation.h"
+#include "../includes/common_classes/logManager.h"
+
+const float CpuParticleSimulator::SNOW_FALL_SPEED = 40.0f;
+
+namespace {
+
+/**
+ * Raw pointers to the particle arrays, so that the kernels don't depend on the containers.
+ */
+struct ParticleArrays
+{
+    float* positionsX;
+    float* positionsY;
+    float* positionsZ;
+    float* velocitiesX;
+    float* velocitiesY;
+    float* velocitiesZ;
+    float* lifetimes;
+    float* sizes;
+    float* alphas;
+    int32_t* snowflakeIndices;
+};
+
+/**
+ * Particle layouts expected by fire_render.vert / snow_render.vert (attribute locations are set up accordingly).
+ */
+struct UploadedFireParticle
+{
+    int32_t type;
+    float position[3];
+    float lifetime;
+    float size;
+};
+
+struct UploadedSnowParticle
+{
+    int32_t type;
+    float position[3];
+    float size;
+    float alpha;
+    int32_t snowflakeIndex;
+};
+
+ParticleArrays getParticleArrays(CpuParticleSimulator::Particles& particles)
+{
+    const auto data = [](auto& values) {
+        return values.empty() ? nullptr : values.data();
+    };
+
+    return ParticleArrays{ data(particles.positionsX), data(particles.positionsY), data(particles.positionsZ),
+        data(particles.velocitiesX), data(particles.velocitiesY), data(particles.velocitiesZ),
+        data(particles.lifetimes), data(particles.sizes), data(particles.alphas), data(particles.snowflakeIndices) };
+}
+
+/**
+ * Calls the function for every particle array in use.
+ */
+template <typename Function>
+void forEachUsedArray(CpuParticleSimulator::Particles& particles, Function function)
+{
+    for (auto* values : { &particles.positionsX, &particles.positionsY, &particles.positionsZ, &particles.velocitiesX, &particles.velocitiesY,
+        &particles.velocitiesZ, &particles.lifetimes, &particles.sizes, &particles.alphas })
+    {
+        if (!values->empty()) {
+            function(*values);
+        }
+    }
+
+    if (!particles.snowflakeIndices.empty()) {
+        function(particles.snowflakeIndices);
+    }
+}
+
+/**
+ * Updates fire particles from the first to the end and writes the survivors from the write index on (write index never
+ * overtakes the read one, so it can be done in place). Same rules as in fire_update.geom.
+ *
+ * @return Write index after the last survivor.
+ */
+int updateFireParticlesScalar(const ParticleArrays& a, const int first, const int end, int writeIndex, const float deltaTime, std::vector<glm::vec3>* removedPositions)
+{
+    for (auto i = first; i < end; i++)
+    {
+        const auto lifetime = a.lifetimes[i] - deltaTime;
+        const auto positionX = a.positionsX[i] + a.velocitiesX[i] * deltaTime;
+        const auto positionY = a.positionsY[i] + a.velocitiesY[i] * deltaTime;
+        const auto positionZ = a.positionsZ[i] + a.velocitiesZ[i] * deltaTime;
+        if (!(lifetime > 0.0f))
+        {
+            if (removedPositions != nullptr) {
+                removedPositions->emplace_back(positionX, positionY, positionZ);
+            }
+            continue;
+        }
+
+        a.lifetimes[writeIndex] = lifetime;
+        a.positionsX[writeIndex] = positionX;
+        a.positionsY[writeIndex] = positionY;
+        a.positionsZ[writeIndex] = positionZ;
+        a.velocitiesX[writeIndex] = a.velocitiesX[i];
+        a.velocitiesY[writeIndex] = a.velocitiesY[i];
+        a.velocitiesZ[writeIndex] = a.velocitiesZ[i];
+        a.sizes[writeIndex] = a.sizes[i];
+        writeIndex++;
+    }
+
+    return writeIndex;
+}
+
+/**
+ * Updates snow particles the same way as updateFireParticlesScalar. Same rules as in snow_update.geom.
+ */
+int updateSnowParticlesScalar(const ParticleArrays& a, const int first, const int end, int writeIndex, const float deltaTime, std::vector<glm::vec3>* removedPositions)
+{
+    for (auto i = first; i < end; i++)
+    {
+        const auto positionY = a.positionsY[i] - CpuParticleSimulator::SNOW_FALL_SPEED * a.sizes[i] * deltaTime;
+        if (!(positionY > 0.0f))
+        {
+            if (removedPositions != nullptr) {
+                removedPositions->emplace_back(a.positionsX[i], positionY, a.positionsZ[i]);
+            }
+            continue;
+        }
+
+        a.positionsX[writeIndex] = a.positionsX[i];
+        a.positionsY[writeIndex] = positionY;
+        a.positionsZ[writeIndex] = a.positionsZ[i];
+        a.sizes[writeIndex] = a.sizes[i];
+        a.alphas[writeIndex] = a.alphas[i];
+        a.snowflakeIndices[writeIndex] = a.snowflakeIndices[i];
+        writeIndex++;
+    }
+
+    return writeIndex;
+}
+
+#ifdef CPU_UTILS_AVX2_KERNELS
+
+/**
+ * Permutations moving lanes selected by the mask to the beginning of AVX register (left packing).
+ */
+struct LeftPackTable
+{
+    alignas(32) int32_t permutations[256][8];
+    int32_t counts[256];
+
+    LeftPackTable()
+    {
+        for (auto mask = 0; mask < 256; mask++)
+        {
+            auto count = 0;
+            for (auto lane = 0; lane < 8; lane++)
+            {
+                permutations[mask][lane] = 0;
+                if (mask & (1 << lane)) {
+                    permutations[mask][count++] = lane;
+                }
+            }
+
+            counts[mask] = count;
+        }
+    }
+};
+
+const LeftPackTable& getLeftPackTable()
+{
+    static const LeftPackTable table;
+    return table;
+}
+
+AVX2_TARGET void recordRemovedLanes(const __m256 positionsX, const __m256 positionsY, const __m256 positionsZ, const int aliveMask, std::vector<glm::vec3>& removedPositions)
+{
+    alignas(32) float lanesX[8], lanesY[8], lanesZ[8];
+    _mm256_store_ps(lanesX, positionsX);
+    _mm256_store_ps(lanesY, positionsY);
+    _mm256_store_ps(lanesZ, positionsZ);
+    for (auto lane = 0; lane < 8; lane++)
+    {
+        if ((aliveMask & (1 << lane)) == 0) {
+            removedPositions.emplace_back(lanesX[lane], lanesY[lane], lanesZ[lane]);
+        }
+    }
+}
+
+/**
+ * AVX2 version of updateFireParticlesScalar - 8 particles are updated at once and survivors are left packed,
+ * storing whole registers is safe, as the write index never overtakes the read one. Rest is done by scalar kernel.
+ */
+AVX2_TARGET int updateFireParticlesAvx2(const ParticleArrays& a, const int first, const int end, int writeIndex, const float deltaTime, std::vector<glm::vec3>* removedPositions)
+{
+    const auto& leftPackTable = getLeftPackTable();
+    const auto deltaTimes = _mm256_set1_ps(deltaTime);
+    const auto zeros = _mm256_setzero_ps();
+
+    auto i = first;
+    for (; i + 8 <= end; i += 8)
+    {
+        // No FMA here, results have to match the scalar kernel bit by bit
+        const auto lifetimes = _mm256_sub_ps(_mm256_loadu_ps(a.lifetimes + i), deltaTimes);
+        const auto velocitiesX = _mm256_loadu_ps(a.velocitiesX + i);
+        const auto velocitiesY = _mm256_loadu_ps(a.velocitiesY + i);
+        const auto velocitiesZ = _mm256_loadu_ps(a.velocitiesZ + i);
+        const auto positionsX = _mm256_add_ps(_mm256_loadu_ps(a.positionsX + i), _mm256_mul_ps(velocitiesX, deltaTimes));
+        const auto positionsY = _mm256_add_ps(_mm256_loadu_ps(a.positionsY + i), _mm256_mul_ps(velocitiesY, deltaTimes));
+        const auto positionsZ = _mm256_add_ps(_mm256_loadu_ps(a.positionsZ + i), _mm256_mul_ps(velocitiesZ, deltaTimes));
+        const auto sizes = _mm256_loadu_ps(a.sizes + i);
+
+        const auto aliveMask = _mm256_movemask_ps(_mm256_cmp_ps(lifetimes, zeros, _CMP_GT_OQ));
+        if (removedPositions != nullptr && aliveMask != 0xFF) {
+            recordRemovedLanes(positionsX, positionsY, positionsZ, aliveMask, *removedPositions);
+        }
+
+        const auto permutation = _mm256_load_si256(reinterpret_cast<const __m256i*>(leftPackTable.permutations[aliveMask]));
+        _mm256_storeu_ps(a.lifetimes + writeIndex, _mm256_permutevar8x32_ps(lifetimes, permutation));
+        _mm256_storeu_ps(a.positionsX + writeIndex, _mm256_permutevar8x32_ps(positionsX, permutation));
+        _mm256_storeu_ps(a.positionsY + writeIndex, _mm256_permutevar8x32_ps(positionsY, permutation));
+        _mm256_storeu_ps(a.positionsZ + writeIndex, _mm256_permutevar8x32_ps(positionsZ, permutation));
+        _mm256_storeu_ps(a.velocitiesX + writeIndex, _mm256_permutevar8x32_ps(velocitiesX, permutation));
+        _mm256_storeu_ps(a.velocitiesY + writeIndex, _mm256_permutevar8x32_ps(velocitiesY, permutation));
+        _mm256_storeu_ps(a.velocitiesZ + writeIndex, _mm256_permutevar8x32_ps(velocitiesZ, permutation));
+        _mm256_storeu_ps(a.sizes + writeIndex, _mm256_permutevar8x32_ps(sizes, permutation));
+        writeIndex += leftPackTable.counts[aliveMask];
+    }
+
+    return updateFireParticlesScalar(a, i, end, writeIndex, deltaTime, removedPositions);
+}
+
+/**
+ * AVX2 version of updateSnowParticlesScalar (see updateFireParticlesAvx2).
+ */
+AVX2_TARGET int updateSnowParticlesAvx2(const ParticleArrays& a, const int first, const int end, int writeIndex, const float deltaTime, std::vector<glm::vec3>* removedPositions)
+{
+    const auto& leftPackTable = getLeftPackTable();
+    const auto deltaTimes = _mm256_set1_ps(deltaTime);
+    const auto fallSpeeds = _mm256_set1_ps(CpuParticleSimulator::SNOW_FALL_SPEED);
+    const auto zeros = _mm256_setzero_ps();
+
+    auto i = first;
+    for (; i + 8 <= end; i += 8)
+    {
+        const auto sizes = _mm256_loadu_ps(a.sizes + i);
+        const auto positionsX = _mm256_loadu_ps(a.positionsX + i);
+        const auto positionsY = _mm256_sub_ps(_mm256_loadu_ps(a.positionsY + i), _mm256_mul_ps(_mm256_mul_ps(fallSpeeds, sizes), deltaTimes));
+        const auto positionsZ = _mm256_loadu_ps(a.positionsZ + i);
+        const auto alphas = _mm256_loadu_ps(a.alphas + i);
+        const auto snowflakeIndices = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a.snowflakeIndices + i));
+
+        const auto aliveMask = _mm256_movemask_ps(_mm256_cmp_ps(positionsY, zeros, _CMP_GT_OQ));
+        if (removedPositions != nullptr && aliveMask != 0xFF) {
+            recordRemovedLanes(positionsX, positionsY, positionsZ, aliveMask, *removedPositions);
+        }
+
+        const auto permutation = _mm256_load_si256(reinterpret_cast<const __m256i*>(leftPackTable.permutations[aliveMask]));
+        _mm256_storeu_ps(a.positionsX + writeIndex, _mm256_permutevar8x32_ps(positionsX, permutation));
+        _mm256_storeu_ps(a.positionsY + writeIndex, _mm256_permutevar8x32_ps(positionsY, permutation));
+        _mm256_storeu_ps(a.positionsZ + writeIndex, _mm256_permutevar8x32_ps(positionsZ, permutation));
+        _mm256_storeu_ps(a.sizes + writeIndex, _mm256_permutevar8x32_ps(sizes, permutation));
+        _mm256_storeu_ps(a.alphas + writeIndex, _mm256_permutevar8x32_ps(alphas, permutation));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(a.snowflakeIndices + writeIndex), _mm256_permutevar8x32_epi32(snowflakeIndices, permutation));
+        writeIndex += leftPackTable.counts[aliveMask];
+    }
+
+    return updateSnowParticlesScalar(a, i, end, writeIndex, deltaTime, removedPositions);
+}
+
+#endif
+
+} // namespace
+
+CpuParticleSimulator::CpuParticleSimulator(const ParticleKind particleKind, const int numMaxParticlesInBuffer, const uint32_t seed)
+    : particleKind_(particleKind)
+    , numMaxParticlesInBuffer_(std::max(numMaxParticlesInBuffer, 0))
+    , generator_(seed)
+{
+    const auto numMaxParticles = static_cast<size_t>(numMaxParticlesInBuffer_);
+    particles_.positionsX.resize(numMaxParticles);
+    particles_.positionsY.resize(numMaxParticles);
+    particles_.positionsZ.resize(numMaxParticles);
+    particles_.sizes.resize(numMaxParticles);
+    if (particleKind_ == ParticleKind::Fire)
+    {
+        particles_.velocitiesX.resize(numMaxParticles);
+        particles_.velocitiesY.resize(numMaxParticles);
+        particles_.velocitiesZ.resize(numMaxParticles);
+        particles_.lifetimes.resize(numMaxParticles);
+    }
+    else
+    {
+        particles_.alphas.resize(numMaxParticles);
+        particles_.snowflakeIndices.resize(numMaxParticles);
+    }
+}
+
+CpuParticleSimulator::~CpuParticleSimulator()
+{
+    releaseUploadedParticles();
+}
+
+void CpuParticleSimulator::setGenerationSettings(const GenerationSettings& generationSettings)
+{
+    generationSettings_ = generationSettings;
+}
+
+const CpuParticleSimulator::GenerationSettings& CpuParticleSimulator::getGenerationSettings() const
+{
+    return generationSettings_;
+}
+
+void CpuParticleSimulator::updateParticles(const float deltaTime, const int numParticlesToGenerate)
+{
+    INSTRUMENT_ZONE("CpuParticleSimulator::updateParticles");
+    removedParticlePositions_.clear();
+
+    // Chunk sizes are multiples of 8 (AVX2 lanes), each chunk compacts its survivors and records removed particles separately
+    const auto chunkRanges = cpu_utils::splitIntoChunks(numParticles_, MIN_PARTICLES_PER_THREAD, maxThreads_, 8);
+    const auto numChunks = static_cast<int>(chunkRanges.size());
+    std::vector<Chunk> chunks(numChunks);
+    cpu_utils::processChunksInParallel(chunkRanges, [this, &chunks, deltaTime](const size_t chunkIndex, const cpu_utils::ChunkRange& chunkRange) {
+        auto& chunk = chunks[chunkIndex];
+        chunk.begin = chunkRange.begin;
+        chunk.end = chunkRange.end;
+        updateChunk(chunk, deltaTime);
+    });
+
+    // Survivors of every chunk are at its beginning, so they just have to be moved right after the previous ones
+    auto numAlive = chunks[0].numAlive;
+    for (auto i = 1; i < numChunks; i++)
+    {
+        const auto& chunk = chunks[i];
+        if (chunk.begin != numAlive)
+        {
+            forEachUsedArray(particles_, [&chunk, numAlive](auto& values) {
+                std::copy(values.begin() + chunk.begin, values.begin() + chunk.begin + chunk.numAlive, values.begin() + numAlive);
+            });
+        }
+
+        numAlive += chunk.numAlive;
+    }
+
+    numParticles_ = numAlive;
+    if (recordRemovedParticles_)
+    {
+        for (const auto& chunk : chunks) {
+            removedParticlePositions_.insert(removedParticlePositions_.end(), chunk.removedPositions.begin(), chunk.removedPositions.end());
+        }
+    }
+
+    generateParticles(numParticlesToGenerate);
+}
+
+void CpuParticleSimulator::setSimdEnabled(const bool simdEnabled)
+{
+    isSimdEnabled_ = simdEnabled;
+}
+
+bool CpuParticleSimulator::isSimdEnabled() const
+{
+    return isSimdEnabled_;
+}
+
+void CpuParticleSimulator::setMaxThreads(const int maxThreads)
+{
+    maxThreads_ = std::max(maxThreads, 0);
+}
+
+void CpuParticleSimulator::setRecordRemovedParticles(const bool recordRemovedParticles)
+{
+    recordRemovedParticles_ = recordRemovedParticles;
+    if (!recordRemovedParticles_) {
+        removedParticlePositions_.clear();
+    }
+}
+
+const std::vector<glm::vec3>& CpuParticleSimulator::getRemovedParticlePositions() const
+{
+    return removedParticlePositions_;
+}
+
+const CpuParticleSimulator::Particles& CpuParticleSimulator::getParticles() const
+{
+    return particles_;
+}
+
+int CpuParticleSimulator::getNumParticles() const
+{
+    return numParticles_;
+}
+
+int CpuParticleSimulator::getNumMaxParticlesInBuffer() const
+{
+    return numMaxParticlesInBuffer_;
+}
+
+CpuParticleSimulator::ParticleKind CpuParticleSimulator::getParticleKind() const
+{
+    return particleKind_;
+}
+
+void CpuParticleSimulator::uploadParticles()
+{
+    auto& gsc = GLStateCache::getInstance();
+    if (uploadVAO_ == 0)
+    {
+        glGenVertexArrays(1, &uploadVAO_);
+        glGenBuffers(1, &uploadVBO_);
+        gsc.bindVertexArray(uploadVAO_);
+        gsc.bindBuffer(GL_ARRAY_BUFFER, uploadVBO_);
+        LOG_DEBUG(Render, "Created VBO for uploading CPU particles with ID {}", uploadVBO_);
+
+        // Locations are the same as the ones used by the transform feedback particle systems
+        if (particleKind_ == ParticleKind::Fire)
+        {
+            const auto stride = static_cast<GLsizei>(sizeof(UploadedFireParticle));
+            glEnableVertexAttribArray(0);
+            glVertexAttribIPointer(0, 1, GL_INT, stride, reinterpret_cast<const GLvoid*>(offsetof(UploadedFireParticle, type)));
+            glEnableVertexAttribArray(1);
+            glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<const GLvoid*>(offsetof(UploadedFireParticle, position)));
+            glEnableVertexAttribArray(3);
+            glVertexAttribPointer(3, 1, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<const GLvoid*>(offsetof(UploadedFireParticle, lifetime)));
+            glEnableVertexAttribArray(4);
+            glVertexAttribPointer(4, 1, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<const GLvoid*>(offsetof(UploadedFireParticle, size)));
+        }
+        else
+        {
+            const auto stride = static_cast<GLsizei>(sizeof(UploadedSnowParticle));
+            glEnableVertexAttribArray(0);
+            glVertexAttribIPointer(0, 1, GL_INT, stride, reinterpret_cast<const GLvoid*>(offsetof(UploadedSnowParticle, type)));
+            glEnableVertexAttribArray(1);
+            glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<const GLvoid*>(offsetof(UploadedSnowParticle, position)));
+            glEnableVertexAttribArray(2);
+            glVertexAttribPointer(2, 1, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<const GLvoid*>(offsetof(UploadedSnowParticle, size)));
+            glEnableVertexAttribArray(3);
+            glVertexAttribPointer(3, 1, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<const GLvoid*>(offsetof(UploadedSnowParticle, alpha)));
+            glEnableVertexAttribArray(4);
+            glVertexAttribIPointer(4, 1, GL_INT, stride, reinterpret_cast<const GLvoid*>(offsetof(UploadedSnowParticle, snowflakeIndex)));
+        }
+    }
+
+    // Data are interleaved here, buffer storage is orphaned, so the upload doesn't wait for the last frame's draw
+    const auto& p = particles_;
+    gsc.bindBuffer(GL_ARRAY_BUFFER, uploadVBO_);
+    if (particleKind_ == ParticleKind::Fire)
+    {
+        std::vector<UploadedFireParticle> uploadedParticles(numParticles_);
+        for (auto i = 0; i < numParticles_; i++) {
+            uploadedParticles[i] = UploadedFireParticle{ PARTICLE_TYPE_NORMAL, { p.positionsX[i], p.positionsY[i], p.positionsZ[i] }, p.lifetimes[i], p.sizes[i] };
+        }
+
+        glBufferData(GL_ARRAY_BUFFER, uploadedParticles.size() * sizeof(UploadedFireParticle), uploadedParticles.data(), GL_STREAM_DRAW);
+    }
+    else
+    {
+        std::vector<UploadedSnowParticle> uploadedParticles(numParticles_);
+        for (auto i = 0; i < numParticles_; i++) {
+            uploadedParticles[i] = UploadedSnowParticle{ PARTICLE_TYPE_NORMAL, { p.positionsX[i], p.positionsY[i], p.positionsZ[i] }, p.sizes[i], p.alphas[i], p.snowflakeIndices[i] };
+        }
+
+        glBufferData(GL_ARRAY_BUFFER, uploadedParticles.size() * sizeof(UploadedSnowParticle), uploadedParticles.data(), GL_STREAM_DRAW);
+    }
+
+    numUploadedParticles_ = numParticles_;
+}
+
+void CpuParticleSimulator::renderParticles() const
+{
+    if (uploadVAO_ == 0 || numUploadedParticles_ == 0) {
+        return;
+    }
+
+    GLStateCache::getInstance().bindVertexArray(uploadVAO_);
+    glDrawArrays(GL_POINTS, 0, numUploadedParticles_);
+}
+
+void CpuParticleSimulator::releaseUploadedParticles()
+{
+    if (uploadVAO_ == 0) {
+        return;
+    }
+
+    LOG_DEBUG(Render, "Deleting VBO for uploading CPU particles with ID {}", uploadVBO_);
+    glDeleteVertexArrays(1, &uploadVAO_);
+    GLStateCache::getInstance().onVertexArrayDeleted(uploadVAO_);
+    glDeleteBuffers(1, &uploadVBO_);
+    GLStateCache::getInstance().onBufferDeleted(uploadVBO_);
+
+    uploadVAO_ = 0;
+    uploadVBO_ = 0;
+    numUploadedParticles_ = 0;
+}
+
+void CpuParticleSimulator::updateChunk(Chunk& chunk, const float deltaTime)
+{
+    const auto arrays = getParticleArrays(particles_);
+    const auto removedPositions = recordRemovedParticles_ ? &chunk.removedPositions : nullptr;
+    const auto isFire = particleKind_ == ParticleKind::Fire;
+
+    auto writeIndex = chunk.begin;
+#ifdef CPU_UTILS_AVX2_KERNELS
+    if (isSimdEnabled_ && cpu_utils::isAvx2Supported())
+    {
+        writeIndex = isFire ? updateFireParticlesAvx2(arrays, chunk.begin, chunk.end, chunk.begin, deltaTime, removedPositions)
+            : updateSnowParticlesAvx2(arrays, chunk.begin, chunk.end, chunk.begin, deltaTime, removedPositions);
+        chunk.numAlive = writeIndex - chunk.begin;
+        return;
+    }
+#endif
+
+    writeIndex = isFire ? updateFireParticlesScalar(arrays, chunk.begin, chunk.end, chunk.begin, deltaTime, removedPositions)
+        : updateSnowParticlesScalar(arrays, chunk.begin, chunk.end, chunk.begin, deltaTime, removedPositions);
+    chunk.numAlive = writeIndex - chunk.begin;
+}
+
+void CpuParticleSimulator::generateParticles(const int numParticlesToGenerate)
+{
+    // Properties are generated in the same order as in the update shaders
+    std::uniform_real_distribution<float> unitDistribution(0.0f, 1.0f);
+    const auto randomFloat = [this, &unitDistribution](const float min, const float range) {
+        return min + range * unitDistribution(generator_);
+    };
+
+    const auto& gs = generationSettings_;
+    const auto numGenerated = std::min(std::max(numParticlesToGenerate, 0), numMaxParticlesInBuffer_ - numParticles_);
+    for (auto i = numParticles_; i < numParticles_ + numGenerated; i++)
+    {
+        particles_.positionsX[i] = randomFloat(gs.positionMin.x, gs.positionRange.x);
+        particles_.positionsY[i] = randomFloat(gs.positionMin.y, gs.positionRange.y);
+        particles_.positionsZ[i] = randomFloat(gs.positionMin.z, gs.positionRange.z);
+        if (particleKind_ == ParticleKind::Fire)
+        {
+            particles_.velocitiesX[i] = randomFloat(gs.velocityMin.x, gs.velocityRange.x);
+            particles_.velocitiesY[i] = randomFloat(gs.velocityMin.y, gs.velocityRange.y);
+            particles_.velocitiesZ[i] = randomFloat(gs.velocityMin.z, gs.velocityRange.z);
+            particles_.lifetimes[i] = randomFloat(gs.lifetimeMin, gs.lifetimeRange);
+            particles_.sizes[i] = randomFloat(gs.sizeMin, gs.sizeRange);
+        }
+        else
+        {
+            particles_.sizes[i] = randomFloat(gs.sizeMin, gs.sizeRange);
+            particles_.alphas[i] = randomFloat(gs.alphaMin, gs.alphaRange);
+            particles_.snowflakeIndices[i] = std::uniform_int_distribution<int32_t>(0, 3)(generator_);
+        }
+    }
+
+    numParticles_ += numGenerated;
+}
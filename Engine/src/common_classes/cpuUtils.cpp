@@ -0,0 +1,228 @@
+// STL
+#include <algorithm>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+
+#if defined(CPU_UTILS_AVX2_KERNELS) && defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// Project
+#include "../includes/common_classes/cpuUtils.h"
+
+namespace cpu_utils
+{
+
+namespace {
+
+thread_local bool isProcessingChunk = false; // True, if the thread is running a chunk function right now (nested calls run serially)
+
+/**
+ * Persistent worker threads processing chunks of one job at a time. Threads sleep between the jobs, so that updates
+ * running every frame don't pay for creating and joining threads. Calling thread processes chunks of its job too.
+ */
+class ChunkWorkerPool
+{
+public:
+    using ChunkFunction = std::function<void(size_t chunkIndex, const ChunkRange& chunk)>;
+
+    static ChunkWorkerPool& getInstance()
+    {
+        static ChunkWorkerPool pool;
+        return pool;
+    }
+
+    ~ChunkWorkerPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _isShuttingDown = true;
+        }
+
+        _workerCondition.notify_all();
+        for (auto& workerThread : _workerThreads) {
+            workerThread.join();
+        }
+    }
+
+    /**
+     * Processes all the chunks and waits for them. Exception thrown by any chunk is rethrown here (once all the chunks
+     * have finished), if more chunks throw, only the first exception is kept.
+     *
+     * @return False, if the pool is busy with a job of another thread and nothing has been processed or true otherwise.
+     */
+    bool tryProcessChunks(const std::vector<ChunkRange>& chunks, const ChunkFunction& chunkFunction)
+    {
+        std::unique_lock<std::mutex> jobLock(_jobMutex, std::try_to_lock);
+        if (!jobLock.owns_lock()) {
+            return false;
+        }
+
+        std::unique_lock<std::mutex> lock(_mutex);
+        startWorkerThreads();
+        _chunks = &chunks;
+        _chunkFunction = &chunkFunction;
+        _nextChunkIndex = 0;
+        _numJobChunks = chunks.size();
+        _numRemainingChunks = chunks.size();
+        _workerCondition.notify_all();
+
+        while (_nextChunkIndex < _numJobChunks) {
+            processNextChunk(lock);
+        }
+
+        _jobDoneCondition.wait(lock, [this]() { return _numRemainingChunks == 0; });
+        _chunks = nullptr;
+        _chunkFunction = nullptr;
+        _nextChunkIndex = 0;
+        _numJobChunks = 0;
+
+        const auto exception = _exception;
+        _exception = nullptr;
+        lock.unlock();
+
+        if (exception) {
+            std::rethrow_exception(exception);
+        }
+
+        return true;
+    }
+
+private:
+    ChunkWorkerPool() {}
+
+    /**
+     * Starts worker threads, if they are not running yet. Must be called with locked mutex.
+     */
+    void startWorkerThreads()
+    {
+        if (!_workerThreads.empty()) {
+            return;
+        }
+
+        // Calling thread takes chunks too, so one hardware thread is left for it
+        const auto numWorkerThreads = std::max(static_cast<int>(std::thread::hardware_concurrency()) - 1, 1);
+        for (auto i = 0; i < numWorkerThreads; i++) {
+            _workerThreads.emplace_back(&ChunkWorkerPool::workerThreadMain, this);
+        }
+    }
+
+    void workerThreadMain()
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        while (true)
+        {
+            _workerCondition.wait(lock, [this]() { return _isShuttingDown || _nextChunkIndex < _numJobChunks; });
+            if (_isShuttingDown) {
+                return;
+            }
+
+            processNextChunk(lock);
+        }
+    }
+
+    /**
+     * Takes next chunk of the current job and processes it with the mutex unlocked. Must be called with locked mutex,
+     * job must have chunks left. Job stays alive until its last chunk is finished, so the chunk can be used unlocked.
+     */
+    void processNextChunk(std::unique_lock<std::mutex>& lock)
+    {
+        const auto chunkIndex = _nextChunkIndex++;
+        const auto& chunk = (*_chunks)[chunkIndex];
+        const auto& chunkFunction = *_chunkFunction;
+        lock.unlock();
+
+        std::exception_ptr exception;
+        isProcessingChunk = true;
+        try {
+            chunkFunction(chunkIndex, chunk);
+        }
+        catch (...) {
+            exception = std::current_exception();
+        }
+        isProcessingChunk = false;
+
+        lock.lock();
+        if (exception && !_exception) {
+            _exception = exception;
+        }
+
+        if (--_numRemainingChunks == 0) {
+            _jobDoneCondition.notify_all();
+        }
+    }
+
+    std::mutex _jobMutex; // Held by the calling thread for the whole job, so that there's only one job at a time
+    std::mutex _mutex; // Mutex guarding the job state
+    std::condition_variable _workerCondition; // Wakes workers up, when new job arrives or on shutdown
+    std::condition_variable _jobDoneCondition; // Wakes calling thread up, when the last chunk of the job is finished
+    std::vector<std::thread> _workerThreads; // Running worker threads
+    const std::vector<ChunkRange>* _chunks = nullptr; // Chunks of the current job
+    const ChunkFunction* _chunkFunction = nullptr; // Chunk function of the current job
+    size_t _nextChunkIndex = 0; // Index of the next chunk to take
+    size_t _numJobChunks = 0; // Number of chunks of the current job (zero, if there's no job)
+    size_t _numRemainingChunks = 0; // Number of chunks of the current job, that haven't finished yet
+    std::exception_ptr _exception; // First exception thrown by a chunk of the current job
+    bool _isShuttingDown = false; // Flag telling the workers to finish
+};
+
+} // namespace
+
+bool isAvx2Supported()
+{
+#if defined(CPU_UTILS_AVX2_KERNELS) && defined(_MSC_VER)
+    static const auto isSupported = []() {
+        // AVX2 flag of the CPU and OS support of saving YMM registers (OSXSAVE and XCR0 bits)
+        int cpuInfo[4];
+        __cpuid(cpuInfo, 1);
+        const auto isOSXSaveSupported = (cpuInfo[2] & (1 << 27)) != 0 && (cpuInfo[2] & (1 << 28)) != 0;
+        if (!isOSXSaveSupported || (_xgetbv(0) & 0x6) != 0x6) {
+            return false;
+        }
+
+        __cpuidex(cpuInfo, 7, 0);
+        return (cpuInfo[1] & (1 << 5)) != 0;
+    }();
+    return isSupported;
+#elif defined(CPU_UTILS_AVX2_KERNELS)
+    static const auto isSupported = __builtin_cpu_supports("avx2") != 0;
+    return isSupported;
+#else
+    return false;
+#endif
+}
+
+std::vector<ChunkRange> splitIntoChunks(const int numItems, const int minItemsPerThread, const int maxThreads, const int chunkAlignment)
+{
+    const auto numHardwareThreads = std::max(static_cast<int>(std::thread::hardware_concurrency()), 1);
+    const auto usedMaxThreads = maxThreads > 0 ? maxThreads : numHardwareThreads;
+    const auto numChunks = std::max(std::min(usedMaxThreads, numItems / std::max(minItemsPerThread, 1)), 1);
+    const auto alignment = std::max(chunkAlignment, 1);
+    const auto chunkSize = ((numItems + numChunks - 1) / numChunks + alignment - 1) / alignment * alignment;
+
+    std::vector<ChunkRange> chunks(numChunks);
+    for (auto i = 0; i < numChunks; i++)
+    {
+        chunks[i].begin = std::min(i * chunkSize, numItems);
+        chunks[i].end = std::min(chunks[i].begin + chunkSize, numItems);
+    }
+
+    return chunks;
+}
+
+void processChunksInParallel(const std::vector<ChunkRange>& chunks, const std::function<void(size_t chunkIndex, const ChunkRange& chunk)>& chunkFunction)
+{
+    // Pool is not worth waking up for a single chunk. Nested calls and calls made while another thread
+    // uses the pool run serially on the calling thread, so that they can never wait for themselves
+    if (chunks.size() > 1 && !isProcessingChunk && ChunkWorkerPool::getInstance().tryProcessChunks(chunks, chunkFunction)) {
+        return;
+    }
+
+    for (size_t i = 0; i < chunks.size(); i++) {
+        chunkFunction(i, chunks[i]);
+    }
+}
+
+} // namespace cpu_utils
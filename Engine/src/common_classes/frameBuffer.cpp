@@ -1,9 +1,7 @@
-// STL
-#include <iostream>
-
 // Project
 #include "../includes/common_classes/OpenGLWindow.h"
 #include "../includes/common_classes/frameBuffer.h"
+#include "../includes/common_classes/logManager.h"
 
 FrameBuffer::~FrameBuffer()
 {
@@ -28,18 +26,18 @@ bool FrameBuffer::createFrameBufferWithColorAndDepth(const GLsizei width, const
     glGenFramebuffers(1, &frameBufferID_);
     if(frameBufferID_ == 0)
     {
-        std::cerr << "Unable to create framebuffer!" << std::endl;
+        LOG_ERROR(Render, "Unable to create framebuffer!");
         return false;
     }
 
     glBindFramebuffer(GL_FRAMEBUFFER, frameBufferID_);
-    std::cout << "Created framebuffer with ID #" << frameBufferID_ << ", its dimensions will be [" << width << ", " << height << "]" << std::endl;
+    LOG_DEBUG(Render, "Created framebuffer with ID #{}, its dimensions will be [{}, {}]", frameBufferID_, width, height);
 
     // Create color render buffer and attach it to FBO
     auto colorRenderBuffer = std::make_unique<RenderBuffer>();
     if(!colorRenderBuffer->create(GL_RGBA8, width, height))
     {
-        std::cerr << "Unable to create color attachment for the framebuffer #" << frameBufferID_ << "!" << std::endl;
+        LOG_ERROR(Render, "Unable to create color attachment for the framebuffer #{}!", frameBufferID_);
         deleteFrameBuffer();
         return false;
     }
@@ -50,7 +48,7 @@ bool FrameBuffer::createFrameBufferWithColorAndDepth(const GLsizei width, const
     auto depthRenderBuffer = std::make_unique<RenderBuffer>();
     if(!depthRenderBuffer->create(GL_DEPTH_COMPONENT24, width, height))
     {
-        std::cerr << "Unable to create depth attachment for the framebuffer #" << frameBufferID_ << "!" << std::endl;
+        LOG_ERROR(Render, "Unable to create depth attachment for the framebuffer #{}!", frameBufferID_);
         deleteFrameBuffer();
         return false;
     }
@@ -98,18 +96,18 @@ bool FrameBuffer::resize(GLsizei newWidth, GLsizei newHeight)
     glGenFramebuffers(1, &frameBufferID_);
     if (frameBufferID_ == 0)
     {
-        std::cerr << "Unable to create framebuffer during resizing!" << std::endl;
+        LOG_ERROR(Render, "Unable to create framebuffer during resizing!");
         return false;
     }
 
     glBindFramebuffer(GL_FRAMEBUFFER, frameBufferID_);
-    std::cout << "Resizing framebuffer with ID #" << frameBufferID_ << ", its dimensions will be [" << newWidth << ", " << newHeight << "]" << std::endl;
+    LOG_DEBUG(Render, "Resizing framebuffer with ID #{}, its dimensions will be [{}, {}]", frameBufferID_, newWidth, newHeight);
 
     if (colorRenderBuffer_)
     {
         if (!colorRenderBuffer_->resize(newWidth, newHeight))
         {
-            std::cerr << "Unable to resize color attachment for the framebuffer #" << frameBufferID_ << "!" << std::endl;
+            LOG_ERROR(Render, "Unable to resize color attachment for the framebuffer #{}!", frameBufferID_);
             deleteFrameBuffer();
             return false;
         }
@@ -121,7 +119,7 @@ bool FrameBuffer::resize(GLsizei newWidth, GLsizei newHeight)
     {
         if (!depthRenderBuffer_->resize(newWidth, newHeight))
         {
-            std::cerr << "Unable to resize depth attachment for the framebuffer #" << frameBufferID_ << "!" << std::endl;
+            LOG_ERROR(Render, "Unable to resize depth attachment for the framebuffer #{}!", frameBufferID_);
             deleteFrameBuffer();
             return false;
         }
@@ -133,7 +131,7 @@ bool FrameBuffer::resize(GLsizei newWidth, GLsizei newHeight)
     {
         if(!texture_->resize(newWidth, newHeight))
         {
-            std::cerr << "Unable to resize depth attachment for the framebuffer #" << frameBufferID_ << "!" << std::endl;
+            LOG_ERROR(Render, "Unable to resize depth attachment for the framebuffer #{}!", frameBufferID_);
             deleteFrameBuffer();
             return false;
         }
@@ -204,8 +202,7 @@ GLint FrameBuffer::getDepthBits()
     const auto error = glGetError();
     if (error != GL_NO_ERROR)
     {
-        std::cerr << "Could not read number of depth bits for framebuffer #" << frameBufferID_ << " (error " << error << ")! "
-            << "Probably it has no depth attachment!" << std::endl;
+        LOG_ERROR(Render, "Could not read number of depth bits for framebuffer #{} (error {})! Probably it has no depth attachment!", frameBufferID_, error);
     }
 
     return depthBits_;
@@ -222,8 +219,7 @@ GLint FrameBuffer::getStencilBits()
     const auto error = glGetError();
     if(error != GL_NO_ERROR)
     {
-        std::cerr << "Could not read number of stencil bits for framebuffer #" << frameBufferID_ << " (error " << error << ")! "
-            << "Probably it has no stencil attachment!" << std::endl;
+        LOG_ERROR(Render, "Could not read number of stencil bits for framebuffer #{} (error {})! Probably it has no stencil attachment!", frameBufferID_, error);
     }
 
     return stencilBits_;
@@ -344,12 +340,12 @@ bool FrameBuffer::createAndBind(GLsizei width, GLsizei height)
     glGenFramebuffers(1, &frameBufferID_);
     if (frameBufferID_ == 0)
     {
-        std::cerr << "Unable to create framebuffer!" << std::endl;
+        LOG_ERROR(Render, "Unable to create framebuffer!");
         return false;
     }
 
     glBindFramebuffer(GL_FRAMEBUFFER, frameBufferID_);
-    std::cout << "Created framebuffer with ID #" << frameBufferID_ << ", its dimensions will be [" << width << ", " << height << "]" << std::endl;
+    LOG_DEBUG(Render, "Created framebuffer with ID #{}, its dimensions will be [{}, {}]", frameBufferID_, width, height);
     width_ = width;
     height_ = height;
 
@@ -366,7 +362,7 @@ bool FrameBuffer::withColorAttachment(GLenum internalFormat)
     auto colorRenderBuffer = std::make_unique<RenderBuffer>();
     if (!colorRenderBuffer->create(internalFormat, width_, height_))
     {
-        std::cerr << "Unable to create color attachment for the framebuffer #" << frameBufferID_ << "!" << std::endl;
+        LOG_ERROR(Render, "Unable to create color attachment for the framebuffer #{}!", frameBufferID_);
         deleteFrameBuffer();
         return false;
     }
@@ -396,7 +392,7 @@ bool FrameBuffer::withDepthAttachment(GLenum internalFormat)
     auto depthRenderBuffer = std::make_unique<RenderBuffer>();
     if (!depthRenderBuffer->create(internalFormat, width_, height_))
     {
-        std::cerr << "Unable to create depth attachment for the framebuffer #" << frameBufferID_ << "!" << std::endl;
+        LOG_ERROR(Render, "Unable to create depth attachment for the framebuffer #{}!", frameBufferID_);
         deleteFrameBuffer();
         return false;
     }
@@ -427,7 +423,7 @@ void FrameBuffer::deleteOnlyFrameBuffer()
         return;
     }
 
-    std::cout << "Deleting framebuffer with ID #" << frameBufferID_ << std::endl;
+    LOG_DEBUG(Render, "Deleting framebuffer with ID #{}", frameBufferID_);
     glDeleteFramebuffers(1, &frameBufferID_);
     frameBufferID_ = 0;
     width_ = 0;
@@ -0,0 +1,239 @@
+// STL
+#include <fstream>
+#include <algorithm>
+
+#include <imgui/imgui.h>
+
+// Project
+#include "../includes/common_classes/frameProfiler.h"
+#include "../includes/common_classes/logManager.h"
+#include "../includes/common_classes/traceUtils.h"
+
+FrameProfiler::Scope::Scope(const std::string& name)
+{
+    getInstance().beginScope(name);
+}
+
+FrameProfiler::Scope::~Scope()
+{
+    getInstance().endScope();
+}
+
+FrameProfiler& FrameProfiler::getInstance()
+{
+    static FrameProfiler fp;
+    return fp;
+}
+
+void FrameProfiler::beginFrame()
+{
+    if (!_isEnabled) {
+        return;
+    }
+
+    // Set is reused after NUM_FRAMES_IN_FLIGHT frames, GPU should be long done with it, but it's never waited for
+    auto& frame = _frames[_frameIndex % NUM_FRAMES_IN_FLIGHT];
+    if (frame.isPending && !collectFrame(frame)) {
+        _numDroppedFrames++;
+    }
+
+    frame.scopes.clear();
+    frame.numUsedQueries = 0;
+    frame.cpuBeginMs = getCpuTimeMs();
+    frame.isPending = false;
+    _openScopes.clear();
+    _isFrameActive = true;
+}
+
+void FrameProfiler::endFrame()
+{
+    if (!_isFrameActive) {
+        return;
+    }
+
+    while (!_openScopes.empty()) {
+        endScope();
+    }
+
+    _frames[_frameIndex % NUM_FRAMES_IN_FLIGHT].isPending = true;
+    _frameIndex++;
+    _isFrameActive = false;
+}
+
+void FrameProfiler::beginScope(const std::string& name)
+{
+    if (!_isFrameActive) {
+        return;
+    }
+
+    auto& frame = _frames[_frameIndex % NUM_FRAMES_IN_FLIGHT];
+    ScopeRecord scope;
+    scope.name = name;
+    scope.depth = static_cast<int>(_openScopes.size());
+    scope.beginQueryIndex = issueTimestampQuery(frame);
+    scope.cpuBeginMs = getCpuTimeMs();
+
+    _openScopes.push_back(frame.scopes.size());
+    frame.scopes.push_back(std::move(scope));
+}
+
+void FrameProfiler::endScope()
+{
+    if (!_isFrameActive || _openScopes.empty()) {
+        return;
+    }
+
+    auto& frame = _frames[_frameIndex % NUM_FRAMES_IN_FLIGHT];
+    auto& scope = frame.scopes[_openScopes.back()];
+    scope.cpuEndMs = getCpuTimeMs();
+    scope.endQueryIndex = issueTimestampQuery(frame);
+    _openScopes.pop_back();
+}
+
+void FrameProfiler::setEnabled(const bool enabled)
+{
+    if (!enabled) {
+        endFrame();
+    }
+
+    _isEnabled = enabled;
+}
+
+bool FrameProfiler::isEnabled() const
+{
+    return _isEnabled;
+}
+
+void FrameProfiler::renderImGui()
+{
+    if (!ImGui::CollapsingHeader("Profiler")) {
+        return;
+    }
+
+    auto isEnabled = _isEnabled;
+    if (ImGui::Checkbox("Enabled", &isEnabled)) {
+        setEnabled(isEnabled);
+    }
+
+    ImGui::Text("Frames dropped (GPU results late): %llu", static_cast<unsigned long long>(_numDroppedFrames));
+
+    const auto latestIndex = trace_utils::getLatestHistoryIndex(_historyOffset, HISTORY_SIZE);
+    for (const auto& nameHistoryPair : _history)
+    {
+        const auto& name = nameHistoryPair.first;
+        const auto& history = nameHistoryPair.second;
+        ImGui::Text("%s: CPU %.3f ms, GPU %.3f ms", name.c_str(), history.cpuMs[latestIndex], history.gpuMs[latestIndex]);
+        ImGui::PlotLines(("##cpu_" + name).c_str(), history.cpuMs.data(), HISTORY_SIZE, _historyOffset, "CPU", 0.0f, 3.4e38f, ImVec2(0.0f, 40.0f));
+        ImGui::PlotLines(("##gpu_" + name).c_str(), history.gpuMs.data(), HISTORY_SIZE, _historyOffset, "GPU", 0.0f, 3.4e38f, ImVec2(0.0f, 40.0f));
+    }
+}
+
+bool FrameProfiler::dumpChromeTrace(const std::string& filePath) const
+{
+    std::ofstream traceFile(filePath);
+    if (!traceFile.is_open())
+    {
+        LOG_ERROR(Render, "Failed to open file {} for writing the profiler trace!", filePath);
+        return false;
+    }
+
+    traceFile << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    traceFile << "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"CPU\"}}";
+    traceFile << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":2,\"args\":{\"name\":\"GPU\"}}";
+
+    for (const auto& scopes : _completedFrames)
+    {
+        for (const auto& scope : scopes)
+        {
+            // Times in the trace format are in microseconds
+            trace_utils::writeCompleteEvent(traceFile, scope.name, 1, scope.cpuBeginMs * 1000.0, (scope.cpuEndMs - scope.cpuBeginMs) * 1000.0);
+            trace_utils::writeCompleteEvent(traceFile, scope.name, 2, scope.gpuBeginMs * 1000.0, (scope.gpuEndMs - scope.gpuBeginMs) * 1000.0);
+        }
+    }
+
+    traceFile << "\n]}\n";
+    LOG_INFO(Render, "Profiler trace of {} frames written to {}", _completedFrames.size(), filePath);
+    return traceFile.good();
+}
+
+void FrameProfiler::deleteQueries()
+{
+    for (auto& frame : _frames)
+    {
+        if (!frame.queries.empty()) {
+            glDeleteQueries(static_cast<GLsizei>(frame.queries.size()), frame.queries.data());
+        }
+
+        frame = FrameRecord();
+    }
+
+    _openScopes.clear();
+    _isFrameActive = false;
+}
+
+double FrameProfiler::getCpuTimeMs() const
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - _creationTime).count();
+}
+
+size_t FrameProfiler::issueTimestampQuery(FrameRecord& frame)
+{
+    if (frame.numUsedQueries == frame.queries.size())
+    {
+        GLuint queryID = 0;
+        glGenQueries(1, &queryID);
+        frame.queries.push_back(queryID);
+    }
+
+    // Unlike GL_TIME_ELAPSED queries, timestamps can be nested, so every scope just records its two ends
+    const auto queryIndex = frame.numUsedQueries++;
+    glQueryCounter(frame.queries[queryIndex], GL_TIMESTAMP);
+    return queryIndex;
+}
+
+bool FrameProfiler::collectFrame(FrameRecord& frame)
+{
+    // Queries complete in order, so when the last one is available, all of them are
+    if (frame.numUsedQueries > 0)
+    {
+        GLint isAvailable = GL_FALSE;
+        glGetQueryObjectiv(frame.queries[frame.numUsedQueries - 1], GL_QUERY_RESULT_AVAILABLE, &isAvailable);
+        if (isAvailable == GL_FALSE) {
+            return false;
+        }
+    }
+
+    std::vector<GLuint64> timestamps(frame.numUsedQueries);
+    for (size_t i = 0; i < frame.numUsedQueries; i++) {
+        glGetQueryObjectui64v(frame.queries[i], GL_QUERY_RESULT, &timestamps[i]);
+    }
+
+    // GPU clock has its own origin, so GPU times are shown relative to the frame begin on the CPU
+    for (auto& history : _history)
+    {
+        history.second.cpuMs[_historyOffset] = 0.0f;
+        history.second.gpuMs[_historyOffset] = 0.0f;
+    }
+
+    const auto gpuOriginNs = timestamps.empty() ? 0 : timestamps[0];
+    for (auto& scope : frame.scopes)
+    {
+        scope.gpuBeginMs = frame.cpuBeginMs + (timestamps[scope.beginQueryIndex] - gpuOriginNs) / 1000000.0;
+        scope.gpuEndMs = frame.cpuBeginMs + (timestamps[scope.endQueryIndex] - gpuOriginNs) / 1000000.0;
+
+        auto& history = _history[scope.name];
+        history.cpuMs[_historyOffset] += static_cast<float>(scope.cpuEndMs - scope.cpuBeginMs);
+        history.gpuMs[_historyOffset] += static_cast<float>(scope.gpuEndMs - scope.gpuBeginMs);
+    }
+
+    if (_completedFrames.size() < static_cast<size_t>(HISTORY_SIZE)) {
+        _completedFrames.push_back(frame.scopes);
+    }
+    else {
+        _completedFrames[_historyOffset] = frame.scopes;
+    }
+
+    _historyOffset = trace_utils::getNextHistoryIndex(_historyOffset, HISTORY_SIZE);
+    frame.isPending = false;
+    return true;
+}
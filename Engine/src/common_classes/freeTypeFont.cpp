@@ -0,0 +1,430 @@
+// STL
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <cstddef>
+
+// FreeType
+#include <ft2build.h>
+#include FT_FREETYPE_H
+
+// Project
+#include "../includes/common_classes/freeTypeFont.h"
+#include "../includes/common_classes/shaderManager.h"
+#include "../includes/common_classes/shaderProgramManager.h"
+#include "../includes/common_classes/samplerManager.h"
+#include "../includes/common_classes/matrixManager.h"
+#include "../includes/common_classes/glStateCache.h"
+#include "../includes/common_classes/instrumentation.h"
+#include "../includes/common_classes/logManager.h"
+
+const int FreeTypeFont::CHARACTERS_TEXTURE_SIZE = 512;
+const std::string FreeTypeFont::FREETYPE_FONT_PROGRAM_KEY = "freetype_font";
+const std::string FreeTypeFont::FREETYPE_FONT_SAMPLER_KEY = "freetype_font";
+const int FreeTypeFont::FAST_LOOKUP_TABLE_SIZE = 256;
+
+namespace {
+
+const int CHARACTER_PADDING = 1; // Empty pixels between characters in the atlas, so that bilinear filtering doesn't bleed
+
+/**
+ * Packs color into RGBA8 (red in the lowest byte), as expected by normalized unsigned byte attribute.
+ */
+uint32_t packColor(const glm::vec4& color)
+{
+    const auto packComponent = [](const float value) {
+        return static_cast<uint32_t>(std::lround(std::min(std::max(value, 0.0f), 1.0f) * 255.0f));
+    };
+
+    return packComponent(color.x) | (packComponent(color.y) << 8) | (packComponent(color.z) << 16) | (packComponent(color.w) << 24);
+}
+
+} // namespace
+
+FreeTypeFont::FreeTypeFont()
+{
+    addCharacterRange(32, 127);
+}
+
+FreeTypeFont::~FreeTypeFont()
+{
+    deleteFont();
+}
+
+void FreeTypeFont::prepareShaderProgram()
+{
+    auto& sm = ShaderManager::getInstance();
+    sm.loadVertexShader(FREETYPE_FONT_PROGRAM_KEY, "../../Engine/data/shaders/font-2D/font2D.vert");
+    sm.loadFragmentShader(FREETYPE_FONT_PROGRAM_KEY, "../../Engine/data/shaders/font-2D/font2D.frag");
+
+    auto& fontShaderProgram = ShaderProgramManager::getInstance().createShaderProgram(FREETYPE_FONT_PROGRAM_KEY);
+    fontShaderProgram.addShaderToProgram(sm.getVertexShader(FREETYPE_FONT_PROGRAM_KEY));
+    fontShaderProgram.addShaderToProgram(sm.getFragmentShader(FREETYPE_FONT_PROGRAM_KEY));
+
+    auto& fontSampler = SamplerManager::getInstance().createSampler(FREETYPE_FONT_SAMPLER_KEY, MAG_FILTER_BILINEAR, MIN_FILTER_BILINEAR);
+    fontSampler.setRepeat(false);
+}
+
+void FreeTypeFont::addCharacterRange(unsigned int characterFrom, unsigned int characterTo)
+{
+    _characterRanges.push_back(CharacterRange(characterFrom, characterTo));
+}
+
+bool FreeTypeFont::loadFont(const std::string& fontFilePath, int pixelSize)
+{
+    INSTRUMENT_ZONE("FreeTypeFont::loadFont");
+    deleteFont();
+    if (pixelSize <= 0)
+    {
+        LOG_ERROR(Assets, "Cannot load font {} with pixel size {}!", fontFilePath, pixelSize);
+        return false;
+    }
+
+    FT_Library freeTypeLibrary;
+    if (FT_Init_FreeType(&freeTypeLibrary))
+    {
+        LOG_ERROR(Assets, "Failed to initialize FreeType library!");
+        return false;
+    }
+
+    FT_Face freeTypeFace;
+    if (FT_New_Face(freeTypeLibrary, fontFilePath.c_str(), 0, &freeTypeFace))
+    {
+        LOG_ERROR(Assets, "Failed to load font {}!", fontFilePath);
+        FT_Done_FreeType(freeTypeLibrary);
+        return false;
+    }
+
+    FT_Set_Pixel_Sizes(freeTypeFace, 0, pixelSize);
+    _pixelSize = pixelSize;
+
+    // Characters are packed into rows of the atlas pages, new page is started when the current one is full
+    const auto pageSizeBytes = static_cast<size_t>(CHARACTERS_TEXTURE_SIZE) * CHARACTERS_TEXTURE_SIZE;
+    std::vector<std::vector<unsigned char>> pagesData(1, std::vector<unsigned char>(pageSizeBytes, 0));
+    auto rowX = CHARACTER_PADDING;
+    auto rowY = CHARACTER_PADDING;
+    auto rowHeight = 0;
+
+    for (const auto& characterRange : _characterRanges)
+    {
+        for (auto characterCode = characterRange.characterCodeFrom; characterCode <= characterRange.characterCodeTo; characterCode++)
+        {
+            if (_characterProperties.count(characterCode) > 0 || FT_Get_Char_Index(freeTypeFace, characterCode) == 0) {
+                continue;
+            }
+
+            if (FT_Load_Char(freeTypeFace, characterCode, FT_LOAD_RENDER))
+            {
+                LOG_WARN(Assets, "Failed to render character {} of font {}!", characterCode, fontFilePath);
+                continue;
+            }
+
+            const auto& glyph = freeTypeFace->glyph;
+            const auto& bitmap = glyph->bitmap;
+            const auto width = static_cast<int>(bitmap.width);
+            const auto height = static_cast<int>(bitmap.rows);
+            if (width + 2 * CHARACTER_PADDING > CHARACTERS_TEXTURE_SIZE || height + 2 * CHARACTER_PADDING > CHARACTERS_TEXTURE_SIZE)
+            {
+                LOG_WARN(Assets, "Character {} of font {} doesn't fit into the texture atlas!", characterCode, fontFilePath);
+                continue;
+            }
+
+            if (rowX + width + CHARACTER_PADDING > CHARACTERS_TEXTURE_SIZE)
+            {
+                rowX = CHARACTER_PADDING;
+                rowY += rowHeight + CHARACTER_PADDING;
+                rowHeight = 0;
+            }
+
+            if (rowY + height + CHARACTER_PADDING > CHARACTERS_TEXTURE_SIZE)
+            {
+                pagesData.emplace_back(pageSizeBytes, 0);
+                rowX = CHARACTER_PADDING;
+                rowY = CHARACTER_PADDING;
+                rowHeight = 0;
+            }
+
+            // Rows of the bitmap are copied top to bottom, so the top of the character has the lower texture coordinate
+            auto& pageData = pagesData.back();
+            for (auto row = 0; row < height; row++)
+            {
+                const auto* sourceRow = bitmap.buffer + static_cast<ptrdiff_t>(row) * bitmap.pitch;
+                std::memcpy(pageData.data() + static_cast<size_t>(rowY + row) * CHARACTERS_TEXTURE_SIZE + rowX, sourceRow, width);
+            }
+
+            CharacterProperties properties;
+            properties.characterCode = static_cast<int>(characterCode);
+            properties.width = width;
+            properties.height = height;
+            properties.advanceX = static_cast<int>(glyph->advance.x >> 6);
+            properties.bearingX = glyph->bitmap_left;
+            properties.bearingY = glyph->bitmap_top;
+            properties.texCoordMin = glm::vec2(rowX, rowY) / static_cast<float>(CHARACTERS_TEXTURE_SIZE);
+            properties.texCoordMax = glm::vec2(rowX + width, rowY + height) / static_cast<float>(CHARACTERS_TEXTURE_SIZE);
+            properties.textureIndex = static_cast<int>(pagesData.size()) - 1;
+            _characterProperties[properties.characterCode] = properties;
+
+            rowX += width + CHARACTER_PADDING;
+            rowHeight = std::max(rowHeight, height);
+        }
+    }
+
+    FT_Done_Face(freeTypeFace);
+    FT_Done_FreeType(freeTypeLibrary);
+
+    // Characters are rasterized, only uploading of the atlas pages is left
+    for (const auto& pageData : pagesData)
+    {
+        auto texture = std::make_unique<Texture>();
+        texture->createFromData(pageData.data(), CHARACTERS_TEXTURE_SIZE, CHARACTERS_TEXTURE_SIZE, GL_RED);
+        _textures.push_back(std::move(texture));
+    }
+
+    _fastLookupTable.assign(FAST_LOOKUP_TABLE_SIZE, nullptr);
+    for (const auto& characterProperties : _characterProperties)
+    {
+        if (characterProperties.first >= 0 && characterProperties.first < FAST_LOOKUP_TABLE_SIZE) {
+            _fastLookupTable[characterProperties.first] = &characterProperties.second;
+        }
+    }
+
+    _pageVertices.resize(_textures.size());
+
+    glGenVertexArrays(1, &_vao);
+    GLStateCache::getInstance().bindVertexArray(_vao);
+    _vbo.createVBO();
+    _vbo.bindVBO();
+
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(GlyphVertex), reinterpret_cast<void*>(offsetof(GlyphVertex, position)));
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(GlyphVertex), reinterpret_cast<void*>(offsetof(GlyphVertex, texCoord)));
+    glEnableVertexAttribArray(2);
+    glVertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(GlyphVertex), reinterpret_cast<void*>(offsetof(GlyphVertex, color)));
+
+    LOG_INFO(Assets, "Loaded font {} with {} characters in {} atlas page(s)", fontFilePath, _characterProperties.size(), _textures.size());
+    _isLoaded = true;
+    return true;
+}
+
+int FreeTypeFont::getTextWidth(const std::string& text, int pixelSize) const
+{
+    const auto usedPixelSize = pixelSize == -1 ? _pixelSize : pixelSize;
+    auto advanceSum = 0;
+    auto maxAdvanceSum = 0;
+
+    size_t position = 0;
+    while (position < text.size())
+    {
+        const auto characterCode = decodeNextCharacter(text, position);
+        if (characterCode == '\n')
+        {
+            maxAdvanceSum = std::max(maxAdvanceSum, advanceSum);
+            advanceSum = 0;
+            continue;
+        }
+
+        if (const auto* properties = getCharacterProperties(characterCode)) {
+            advanceSum += properties->advanceX;
+        }
+    }
+
+    maxAdvanceSum = std::max(maxAdvanceSum, advanceSum);
+    if (_pixelSize == 0) {
+        return 0;
+    }
+
+    return static_cast<int>(std::ceil(static_cast<float>(maxAdvanceSum) * usedPixelSize / _pixelSize));
+}
+
+int FreeTypeFont::getTextHeight(int pixelSize) const
+{
+    return pixelSize == -1 ? _pixelSize : pixelSize;
+}
+
+void FreeTypeFont::setTextColor(const glm::vec4& color)
+{
+    _color = color;
+    _packedColor = packColor(color);
+}
+
+void FreeTypeFont::printInternal(int x, int y, const std::string& text, int pixelSize)
+{
+    if (!_isLoaded) {
+        return;
+    }
+
+    const auto usedPixelSize = pixelSize == -1 ? _pixelSize : pixelSize;
+    const auto scale = static_cast<float>(usedPixelSize) / static_cast<float>(_pixelSize);
+
+    // Y axis of orthographic projection goes up, so the next line is below the current one
+    glm::vec2 currentPosition(static_cast<float>(x), static_cast<float>(y));
+    size_t position = 0;
+    while (position < text.size())
+    {
+        const auto characterCode = decodeNextCharacter(text, position);
+        if (characterCode == '\n')
+        {
+            currentPosition.x = static_cast<float>(x);
+            currentPosition.y -= static_cast<float>(usedPixelSize);
+            continue;
+        }
+
+        const auto* properties = getCharacterProperties(characterCode);
+        if (properties == nullptr) {
+            continue;
+        }
+
+        if (properties->width > 0 && properties->height > 0)
+        {
+            const auto left = currentPosition.x + properties->bearingX * scale;
+            const auto top = currentPosition.y + properties->bearingY * scale;
+            const auto right = left + properties->width * scale;
+            const auto bottom = top - properties->height * scale;
+            const auto& uvMin = properties->texCoordMin;
+            const auto& uvMax = properties->texCoordMax;
+
+            auto& vertices = _pageVertices[properties->textureIndex];
+            vertices.push_back({ glm::vec2(left, top), glm::vec2(uvMin.x, uvMin.y), _packedColor });
+            vertices.push_back({ glm::vec2(left, bottom), glm::vec2(uvMin.x, uvMax.y), _packedColor });
+            vertices.push_back({ glm::vec2(right, top), glm::vec2(uvMax.x, uvMin.y), _packedColor });
+            vertices.push_back({ glm::vec2(right, top), glm::vec2(uvMax.x, uvMin.y), _packedColor });
+            vertices.push_back({ glm::vec2(left, bottom), glm::vec2(uvMin.x, uvMax.y), _packedColor });
+            vertices.push_back({ glm::vec2(right, bottom), glm::vec2(uvMax.x, uvMax.y), _packedColor });
+        }
+
+        currentPosition.x += properties->advanceX * scale;
+    }
+}
+
+void FreeTypeFont::flush()
+{
+    INSTRUMENT_ZONE("FreeTypeFont::flush");
+    if (!_isLoaded) {
+        return;
+    }
+
+    // Vertices of all pages are uploaded at once, each page is then rendered from its own range of the buffer
+    _batchVertices.clear();
+    for (const auto& vertices : _pageVertices) {
+        _batchVertices.insert(_batchVertices.end(), vertices.begin(), vertices.end());
+    }
+
+    if (_batchVertices.empty()) {
+        return;
+    }
+
+    auto& gsc = GLStateCache::getInstance();
+    gsc.bindVertexArray(_vao);
+    _vbo.bindVBO();
+    _vbo.uploadDataToGPU(_batchVertices.data(), _batchVertices.size() * sizeof(GlyphVertex), GL_STREAM_DRAW);
+
+    auto& fontShaderProgram = getFreetypeFontShaderProgram();
+    fontShaderProgram.useProgram();
+    fontShaderProgram[ShaderConstants::projectionMatrix()] = MatrixManager::getInstance().getOrthoProjectionMatrix();
+    fontShaderProgram[ShaderConstants::sampler()] = 0;
+    getFreetypeFontSampler().bind(0);
+
+    // Text is rendered over everything that has been rendered so far, previous state is restored afterwards
+    const auto wasDepthTestEnabled = gsc.isEnabled(GL_DEPTH_TEST);
+    const auto wasBlendEnabled = gsc.isEnabled(GL_BLEND);
+    gsc.disable(GL_DEPTH_TEST);
+    gsc.enable(GL_BLEND);
+    gsc.blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+    GLint firstVertex = 0;
+    for (size_t page = 0; page < _pageVertices.size(); page++)
+    {
+        auto& vertices = _pageVertices[page];
+        if (vertices.empty()) {
+            continue;
+        }
+
+        _textures[page]->bind(0);
+        glDrawArrays(GL_TRIANGLES, firstVertex, static_cast<GLsizei>(vertices.size()));
+        firstVertex += static_cast<GLint>(vertices.size());
+        vertices.clear();
+    }
+
+    gsc.setEnabled(GL_BLEND, wasBlendEnabled);
+    gsc.setEnabled(GL_DEPTH_TEST, wasDepthTestEnabled);
+}
+
+void FreeTypeFont::deleteFont()
+{
+    if (!_isLoaded) {
+        return;
+    }
+
+    _textures.clear();
+    _characterProperties.clear();
+    _fastLookupTable.clear();
+    _pageVertices.clear();
+    _batchVertices.clear();
+
+    _vbo.deleteVBO();
+    glDeleteVertexArrays(1, &_vao);
+    GLStateCache::getInstance().onVertexArrayDeleted(_vao);
+    _vao = 0;
+    _isLoaded = false;
+}
+
+ShaderProgram& FreeTypeFont::getFreetypeFontShaderProgram() const
+{
+    return ShaderProgramManager::getInstance().getShaderProgram(FREETYPE_FONT_PROGRAM_KEY);
+}
+
+const Sampler& FreeTypeFont::getFreetypeFontSampler() const
+{
+    return SamplerManager::getInstance().getSampler(FREETYPE_FONT_SAMPLER_KEY);
+}
+
+const FreeTypeFont::CharacterProperties* FreeTypeFont::getCharacterProperties(unsigned int characterCode) const
+{
+    if (characterCode < _fastLookupTable.size()) {
+        return _fastLookupTable[characterCode];
+    }
+
+    const auto it = _characterProperties.find(static_cast<int>(characterCode));
+    return it != _characterProperties.end() ? &it->second : nullptr;
+}
+
+unsigned int FreeTypeFont::decodeNextCharacter(const std::string& text, size_t& position)
+{
+    const auto firstByte = static_cast<unsigned char>(text[position++]);
+    auto numContinuationBytes = 0;
+    unsigned int characterCode = firstByte;
+    if ((firstByte & 0xE0) == 0xC0)
+    {
+        numContinuationBytes = 1;
+        characterCode = firstByte & 0x1F;
+    }
+    else if ((firstByte & 0xF0) == 0xE0)
+    {
+        numContinuationBytes = 2;
+        characterCode = firstByte & 0x0F;
+    }
+    else if ((firstByte & 0xF8) == 0xF0)
+    {
+        numContinuationBytes = 3;
+        characterCode = firstByte & 0x07;
+    }
+
+    // Truncated or malformed sequence is not decoded at all, first byte stands for itself
+    if (position + numContinuationBytes > text.size()) {
+        return firstByte;
+    }
+
+    for (auto i = 0; i < numContinuationBytes; i++)
+    {
+        if ((static_cast<unsigned char>(text[position + i]) & 0xC0) != 0x80) {
+            return firstByte;
+        }
+    }
+
+    for (auto i = 0; i < numContinuationBytes; i++) {
+        characterCode = (characterCode << 6) | (static_cast<unsigned char>(text[position++]) & 0x3F);
+    }
+
+    return characterCode;
+}
@@ -0,0 +1,352 @@
+// Project
+#include "../includes/common_classes/glStateCache.h"
+
+GLStateCache& GLStateCache::getInstance()
+{
+    static GLStateCache gsc;
+    return gsc;
+}
+
+void GLStateCache::useProgram(const GLuint programID)
+{
+    if (skipIfEqual(_currentProgram, programID)) {
+        return;
+    }
+
+    glUseProgram(programID);
+}
+
+void GLStateCache::bindVertexArray(const GLuint vertexArrayID)
+{
+    if (skipIfEqual(_currentVertexArray, vertexArrayID)) {
+        return;
+    }
+
+    glBindVertexArray(vertexArrayID);
+    _elementArrayBuffer = UNKNOWN_BINDING;
+}
+
+void GLStateCache::activeTexture(const GLuint textureUnit)
+{
+    if (skipIfEqual(_activeTextureUnit, textureUnit)) {
+        return;
+    }
+
+    glActiveTexture(GL_TEXTURE0 + textureUnit);
+}
+
+void GLStateCache::bindTexture(const GLenum target, const GLuint textureID)
+{
+    // Without knowing the active unit, the binding can't be tracked
+    if (_activeTextureUnit == UNKNOWN_BINDING)
+    {
+        _numIssuedCalls++;
+        glBindTexture(target, textureID);
+        return;
+    }
+
+    bindTextureToUnit(_activeTextureUnit, target, textureID);
+}
+
+void GLStateCache::bindTextureToUnit(const GLuint textureUnit, const GLenum target, const GLuint textureID)
+{
+    if (textureUnit >= _textureUnits.size()) {
+        _textureUnits.resize(textureUnit + 1);
+    }
+
+    auto& unitState = _textureUnits[textureUnit];
+    if (unitState.target == target && unitState.textureID == textureID)
+    {
+        _numSkippedCalls++;
+        return;
+    }
+
+    activeTexture(textureUnit);
+    glBindTexture(target, textureID);
+    unitState.target = target;
+    unitState.textureID = textureID;
+    _numIssuedCalls++;
+}
+
+void GLStateCache::bindSampler(const GLuint textureUnit, const GLuint samplerID)
+{
+    if (textureUnit >= _samplers.size()) {
+        _samplers.resize(textureUnit + 1, UNKNOWN_BINDING);
+    }
+
+    if (skipIfEqual(_samplers[textureUnit], samplerID)) {
+        return;
+    }
+
+    glBindSampler(textureUnit, samplerID);
+}
+
+void GLStateCache::bindBuffer(const GLenum target, const GLuint bufferID)
+{
+    const auto cachedBinding = getBufferBinding(target);
+    if (cachedBinding == nullptr)
+    {
+        _numIssuedCalls++;
+        glBindBuffer(target, bufferID);
+        return;
+    }
+
+    if (skipIfEqual(*cachedBinding, bufferID)) {
+        return;
+    }
+
+    glBindBuffer(target, bufferID);
+}
+
+void GLStateCache::bindBufferBase(const GLenum target, const GLuint index, const GLuint bufferID)
+{
+    glBindBufferBase(target, index, bufferID);
+    _numIssuedCalls++;
+
+    const auto cachedBinding = getBufferBinding(target);
+    if (cachedBinding != nullptr) {
+        *cachedBinding = bufferID;
+    }
+}
+
+void GLStateCache::bindBufferRange(const GLenum target, const GLuint index, const GLuint bufferID, const GLintptr offset, const GLsizeiptr byteSize)
+{
+    glBindBufferRange(target, index, bufferID, offset, byteSize);
+    _numIssuedCalls++;
+
+    const auto cachedBinding = getBufferBinding(target);
+    if (cachedBinding != nullptr) {
+        *cachedBinding = bufferID;
+    }
+}
+
+void GLStateCache::setEnabled(const GLenum capability, const bool enable)
+{
+    const auto itCapability = _capabilities.find(capability);
+    if (itCapability != _capabilities.end() && itCapability->second == enable)
+    {
+        _numSkippedCalls++;
+        return;
+    }
+
+    if (enable) {
+        glEnable(capability);
+    }
+    else {
+        glDisable(capability);
+    }
+
+    _capabilities[capability] = enable;
+    _numIssuedCalls++;
+}
+
+void GLStateCache::enable(const GLenum capability)
+{
+    setEnabled(capability, true);
+}
+
+void GLStateCache::disable(const GLenum capability)
+{
+    setEnabled(capability, false);
+}
+
+bool GLStateCache::isEnabled(const GLenum capability)
+{
+    const auto itCapability = _capabilities.find(capability);
+    if (itCapability != _capabilities.end()) {
+        return itCapability->second;
+    }
+
+    const auto isCapabilityEnabled = glIsEnabled(capability) == GL_TRUE;
+    _capabilities[capability] = isCapabilityEnabled;
+    return isCapabilityEnabled;
+}
+
+void GLStateCache::colorMask(const bool red, const bool green, const bool blue, const bool alpha)
+{
+    const auto mask = (red ? 1u : 0u) | (green ? 2u : 0u) | (blue ? 4u : 0u) | (alpha ? 8u : 0u);
+    if (skipIfEqual(_colorMask, mask)) {
+        return;
+    }
+
+    glColorMask(red, green, blue, alpha);
+}
+
+std::array<bool, 4> GLStateCache::getColorMask()
+{
+    if (_colorMask == UNKNOWN_BINDING)
+    {
+        GLboolean colorWriteMask[4] = { GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE };
+        glGetBooleanv(GL_COLOR_WRITEMASK, colorWriteMask);
+        _colorMask = 0;
+        for (auto i = 0; i < 4; i++) {
+            _colorMask |= colorWriteMask[i] == GL_TRUE ? 1u << i : 0u;
+        }
+    }
+
+    return { (_colorMask & 1u) != 0, (_colorMask & 2u) != 0, (_colorMask & 4u) != 0, (_colorMask & 8u) != 0 };
+}
+
+void GLStateCache::depthMask(const bool enable)
+{
+    if (skipIfEqual(_depthMask, enable ? GL_TRUE : GL_FALSE)) {
+        return;
+    }
+
+    glDepthMask(enable ? GL_TRUE : GL_FALSE);
+}
+
+bool GLStateCache::isDepthMaskEnabled()
+{
+    if (_depthMask == UNKNOWN_BINDING)
+    {
+        GLboolean depthWriteMask = GL_TRUE;
+        glGetBooleanv(GL_DEPTH_WRITEMASK, &depthWriteMask);
+        _depthMask = depthWriteMask;
+    }
+
+    return _depthMask == GL_TRUE;
+}
+
+void GLStateCache::depthFunc(const GLenum function)
+{
+    if (skipIfEqual(_depthFunc, function)) {
+        return;
+    }
+
+    glDepthFunc(function);
+}
+
+GLenum GLStateCache::getDepthFunc()
+{
+    if (_depthFunc == UNKNOWN_BINDING)
+    {
+        GLint function = GL_LESS;
+        glGetIntegerv(GL_DEPTH_FUNC, &function);
+        _depthFunc = static_cast<GLenum>(function);
+    }
+
+    return _depthFunc;
+}
+
+void GLStateCache::blendFunc(const GLenum sourceFactor, const GLenum destinationFactor)
+{
+    if (_blendSourceFactor == sourceFactor && _blendDestinationFactor == destinationFactor)
+    {
+        _numSkippedCalls++;
+        return;
+    }
+
+    glBlendFunc(sourceFactor, destinationFactor);
+    _blendSourceFactor = sourceFactor;
+    _blendDestinationFactor = destinationFactor;
+    _numIssuedCalls++;
+}
+
+void GLStateCache::onProgramDeleted(const GLuint programID)
+{
+    if (_currentProgram == programID) {
+        _currentProgram = UNKNOWN_BINDING;
+    }
+}
+
+void GLStateCache::onVertexArrayDeleted(const GLuint vertexArrayID)
+{
+    if (_currentVertexArray == vertexArrayID)
+    {
+        _currentVertexArray = UNKNOWN_BINDING;
+        _elementArrayBuffer = UNKNOWN_BINDING;
+    }
+}
+
+void GLStateCache::onTextureDeleted(const GLuint textureID)
+{
+    for (auto& unitState : _textureUnits)
+    {
+        if (unitState.textureID == textureID) {
+            unitState.textureID = UNKNOWN_BINDING;
+        }
+    }
+}
+
+void GLStateCache::onSamplerDeleted(const GLuint samplerID)
+{
+    for (auto& sampler : _samplers)
+    {
+        if (sampler == samplerID) {
+            sampler = UNKNOWN_BINDING;
+        }
+    }
+}
+
+void GLStateCache::onBufferDeleted(const GLuint bufferID)
+{
+    for (auto cachedBinding : { &_arrayBuffer, &_elementArrayBuffer, &_uniformBuffer })
+    {
+        if (*cachedBinding == bufferID) {
+            *cachedBinding = UNKNOWN_BINDING;
+        }
+    }
+}
+
+void GLStateCache::invalidate()
+{
+    _currentProgram = UNKNOWN_BINDING;
+    _currentVertexArray = UNKNOWN_BINDING;
+    _activeTextureUnit = UNKNOWN_BINDING;
+    _arrayBuffer = UNKNOWN_BINDING;
+    _elementArrayBuffer = UNKNOWN_BINDING;
+    _uniformBuffer = UNKNOWN_BINDING;
+    _textureUnits.clear();
+    _samplers.clear();
+    _capabilities.clear();
+    _colorMask = UNKNOWN_BINDING;
+    _depthMask = UNKNOWN_BINDING;
+    _depthFunc = UNKNOWN_BINDING;
+    _blendSourceFactor = UNKNOWN_BINDING;
+    _blendDestinationFactor = UNKNOWN_BINDING;
+}
+
+uint64_t GLStateCache::getNumIssuedCalls() const
+{
+    return _numIssuedCalls;
+}
+
+uint64_t GLStateCache::getNumSkippedCalls() const
+{
+    return _numSkippedCalls;
+}
+
+void GLStateCache::resetStatistics()
+{
+    _numIssuedCalls = 0;
+    _numSkippedCalls = 0;
+}
+
+GLuint* GLStateCache::getBufferBinding(const GLenum target)
+{
+    switch (target)
+    {
+        case GL_ARRAY_BUFFER:
+            return &_arrayBuffer;
+        case GL_ELEMENT_ARRAY_BUFFER:
+            return &_elementArrayBuffer;
+        case GL_UNIFORM_BUFFER:
+            return &_uniformBuffer;
+        default:
+            return nullptr;
+    }
+}
+
+bool GLStateCache::skipIfEqual(GLuint& cachedValue, const GLuint newValue)
+{
+    if (cachedValue == newValue)
+    {
+        _numSkippedCalls++;
+        return true;
+    }
+
+    cachedValue = newValue;
+    _numIssuedCalls++;
+    return false;
+}
@@ -0,0 +1,239 @@
+// STL
+#include <fstream>
+#include <algorithm>
+
+#include <imgui/imgui.h>
+
+// Project
+#include "../includes/common_classes/instrumentation.h"
+#include "../includes/common_classes/logManager.h"
+#include "../includes/common_classes/traceUtils.h"
+
+const size_t Instrumentation::MAX_RETAINED_ZONES = 1 << 18;
+
+Instrumentation::Zone::Zone(const char* name)
+    : name_(name)
+    , beginNs_(getInstance().getTimeNs())
+{
+}
+
+Instrumentation::Zone::~Zone()
+{
+    auto& instrumentation = getInstance();
+    instrumentation.recordZone(name_, beginNs_, instrumentation.getTimeNs());
+}
+
+Instrumentation& Instrumentation::getInstance()
+{
+    static Instrumentation instrumentation;
+    return instrumentation;
+}
+
+uint64_t Instrumentation::getTimeNs() const
+{
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - _creationTime).count());
+}
+
+void Instrumentation::recordZone(const char* name, const uint64_t beginNs, const uint64_t endNs)
+{
+    auto& threadBuffer = getThreadBuffer();
+
+    // Only this thread writes the write index, reader may only free more space meanwhile
+    const auto writeIndex = threadBuffer.writeIndex.load(std::memory_order_relaxed);
+    if (writeIndex - threadBuffer.readIndex.load(std::memory_order_acquire) >= THREAD_BUFFER_CAPACITY)
+    {
+        threadBuffer.numDroppedZones.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    threadBuffer.events[writeIndex & (THREAD_BUFFER_CAPACITY - 1)] = ZoneEvent{ name, beginNs, endNs, threadBuffer.threadID };
+    threadBuffer.writeIndex.store(writeIndex + 1, std::memory_order_release);
+}
+
+void Instrumentation::addToCounter(const Counter counter, const int64_t value)
+{
+    _counters[static_cast<int>(counter)].fetch_add(value, std::memory_order_relaxed);
+}
+
+void Instrumentation::setThreadName(const std::string& threadName)
+{
+    auto& threadBuffer = getThreadBuffer();
+    std::lock_guard<std::mutex> lock(_registrationMutex);
+    threadBuffer.threadName = threadName;
+}
+
+void Instrumentation::collectFrame()
+{
+    _lastFrameZones.clear();
+    if (_retainedZones.capacity() < MAX_RETAINED_ZONES) {
+        _retainedZones.reserve(MAX_RETAINED_ZONES);
+    }
+
+    // Mutex only guards the list of buffers against threads registering right now, zones are read lock-free
+    {
+        std::lock_guard<std::mutex> lock(_registrationMutex);
+        _numDroppedZones = 0;
+        for (const auto& threadBuffer : _threadBuffers)
+        {
+            _numDroppedZones += threadBuffer->numDroppedZones.load(std::memory_order_relaxed);
+
+            const auto readIndex = threadBuffer->readIndex.load(std::memory_order_relaxed);
+            const auto writeIndex = threadBuffer->writeIndex.load(std::memory_order_acquire);
+            for (auto i = readIndex; i < writeIndex; i++)
+            {
+                const auto& zone = threadBuffer->events[i & (THREAD_BUFFER_CAPACITY - 1)];
+                const auto durationMs = (zone.endNs - zone.beginNs) / 1000000.0;
+                auto& statistics = _lastFrameZones[zone.name];
+                statistics.totalMs += durationMs;
+                statistics.maxMs = std::max(statistics.maxMs, durationMs);
+                statistics.numCalls++;
+
+                if (_retainedZones.size() < MAX_RETAINED_ZONES) {
+                    _retainedZones.push_back(zone);
+                }
+                else
+                {
+                    _retainedZones[_retainedZonesOffset] = zone;
+                    _retainedZonesOffset = (_retainedZonesOffset + 1) % MAX_RETAINED_ZONES;
+                }
+            }
+
+            threadBuffer->readIndex.store(writeIndex, std::memory_order_release);
+        }
+    }
+
+    // Counters are per frame, so they start from zero again
+    CounterSample counterSample;
+    counterSample.timeNs = getTimeNs();
+    for (auto i = 0; i < NUM_COUNTERS; i++)
+    {
+        counterSample.values[i] = _counters[i].exchange(0, std::memory_order_relaxed);
+
+        auto& history = _counterHistory[i];
+        history.resize(HISTORY_SIZE, 0.0f);
+        history[_historyOffset] = static_cast<float>(counterSample.values[i]);
+    }
+    _historyOffset = trace_utils::getNextHistoryIndex(_historyOffset, HISTORY_SIZE);
+
+    if (_counterSamples.size() < static_cast<size_t>(HISTORY_SIZE)) {
+        _counterSamples.push_back(counterSample);
+    }
+    else
+    {
+        _counterSamples[_counterSamplesOffset] = counterSample;
+        _counterSamplesOffset = trace_utils::getNextHistoryIndex(_counterSamplesOffset, HISTORY_SIZE);
+    }
+}
+
+void Instrumentation::renderImGui() const
+{
+    if (!ImGui::CollapsingHeader("CPU instrumentation")) {
+        return;
+    }
+
+    const auto latestIndex = trace_utils::getLatestHistoryIndex(_historyOffset, HISTORY_SIZE);
+    for (auto i = 0; i < NUM_COUNTERS; i++)
+    {
+        const auto& history = _counterHistory[i];
+        if (history.empty()) {
+            continue;
+        }
+
+        const auto counterName = getCounterName(static_cast<Counter>(i));
+        ImGui::Text("%s: %.0f", counterName, history[latestIndex]);
+        ImGui::PlotLines((std::string("##") + counterName).c_str(), history.data(), HISTORY_SIZE, _historyOffset, nullptr, 0.0f, 3.4e38f, ImVec2(0.0f, 30.0f));
+    }
+
+    const auto& dropletsHistory = _counterHistory[static_cast<int>(Counter::DropletsSimulated)];
+    const auto& stepsHistory = _counterHistory[static_cast<int>(Counter::DropletSteps)];
+    if (!dropletsHistory.empty() && dropletsHistory[latestIndex] > 0.0f) {
+        ImGui::Text("Steps per droplet: %.1f", stepsHistory[latestIndex] / dropletsHistory[latestIndex]);
+    }
+
+    ImGui::Separator();
+    for (const auto& nameStatisticsPair : _lastFrameZones)
+    {
+        const auto& statistics = nameStatisticsPair.second;
+        ImGui::BulletText("%s: %.3f ms total, %.3f ms max, %zu calls", nameStatisticsPair.first.c_str(), statistics.totalMs, statistics.maxMs, statistics.numCalls);
+    }
+
+    if (_numDroppedZones > 0) {
+        ImGui::Text("Zones dropped (full thread buffers): %llu", static_cast<unsigned long long>(_numDroppedZones));
+    }
+}
+
+bool Instrumentation::dumpTrace(const std::string& filePath) const
+{
+    std::ofstream traceFile(filePath);
+    if (!traceFile.is_open())
+    {
+        LOG_ERROR(Core, "Failed to open file {} for writing the instrumentation trace!", filePath);
+        return false;
+    }
+
+    traceFile << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    traceFile << "\n{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"CPU\"}}";
+    {
+        std::lock_guard<std::mutex> lock(_registrationMutex);
+        for (const auto& threadBuffer : _threadBuffers)
+        {
+            const auto threadName = threadBuffer->threadName.empty() ? "Thread " + std::to_string(threadBuffer->threadID) : threadBuffer->threadName;
+            traceFile << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << threadBuffer->threadID << ",\"args\":{\"name\":";
+            trace_utils::writeJsonString(traceFile, threadName);
+            traceFile << "}}";
+        }
+    }
+
+    // Times in the trace format are in microseconds
+    for (const auto& zone : _retainedZones)
+    {
+        trace_utils::writeCompleteEvent(traceFile, zone.name, zone.threadID, zone.beginNs / 1000.0, (zone.endNs - zone.beginNs) / 1000.0);
+    }
+
+    for (const auto& counterSample : _counterSamples)
+    {
+        for (auto i = 0; i < NUM_COUNTERS; i++)
+        {
+            traceFile << ",\n{\"name\":\"" << getCounterName(static_cast<Counter>(i)) << "\",\"ph\":\"C\",\"pid\":1,\"ts\":" << counterSample.timeNs / 1000.0
+                << ",\"args\":{\"value\":" << counterSample.values[i] << "}}";
+        }
+    }
+
+    traceFile << "\n]}\n";
+    LOG_INFO(Core, "Instrumentation trace with {} zones written to {}", _retainedZones.size(), filePath);
+    return traceFile.good();
+}
+
+const char* Instrumentation::getCounterName(const Counter counter)
+{
+    switch (counter)
+    {
+        case Counter::DropletsSimulated:
+            return "Droplets simulated";
+        case Counter::DropletSteps:
+            return "Droplet steps";
+        case Counter::VBOBytesUploaded:
+            return "VBO bytes uploaded";
+        case Counter::DrawPackets:
+            return "Draw packets";
+        case Counter::StateChangesSkipped:
+            return "State changes skipped";
+        default:
+            return "Unknown";
+    }
+}
+
+Instrumentation::ThreadBuffer& Instrumentation::getThreadBuffer()
+{
+    // Registration takes the lock only once per thread, then the buffer is reached through thread local pointer
+    thread_local ThreadBuffer* threadBuffer = nullptr;
+    if (threadBuffer == nullptr)
+    {
+        std::lock_guard<std::mutex> lock(_registrationMutex);
+        _threadBuffers.push_back(std::make_unique<ThreadBuffer>());
+        threadBuffer = _threadBuffers.back().get();
+        threadBuffer->threadID = static_cast<uint32_t>(_threadBuffers.size());
+    }
+
+    return *threadBuffer;
+}
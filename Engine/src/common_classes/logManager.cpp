@@ -0,0 +1,84 @@
+// spdlog
+#include <spdlog/async.h>
+#include <spdlog/sinks/stdout_color_sinks.h>
+
+// Project
+#include "../includes/common_classes/logManager.h"
+
+const size_t LogManager::QUEUE_SIZE = 8192;
+const char* const LogManager::LOG_PATTERN = "[%H:%M:%S.%e] [%n] [%^%l%$] %v";
+
+LogManager& LogManager::getInstance()
+{
+    // Never destroyed, static objects may still log while they're being destructed
+    static auto lm = new LogManager();
+    return *lm;
+}
+
+LogManager::LogManager()
+{
+    _threadPool = std::make_shared<spdlog::details::thread_pool>(QUEUE_SIZE, 1);
+
+    // All the subsystems share one console sink and one background thread
+    const auto consoleSink = std::make_shared<spdlog::sinks::stdout_color_sink_mt>();
+    for (auto i = 0; i < NUM_SUBSYSTEMS; i++)
+    {
+        auto logger = std::make_shared<spdlog::async_logger>(getSubsystemName(static_cast<Subsystem>(i)), consoleSink, _threadPool,
+            spdlog::async_overflow_policy::overrun_oldest);
+        logger->set_pattern(LOG_PATTERN);
+        logger->set_level(static_cast<spdlog::level::level_enum>(SPDLOG_ACTIVE_LEVEL));
+        logger->flush_on(spdlog::level::err);
+        _loggers[i] = std::move(logger);
+    }
+}
+
+spdlog::logger* LogManager::getLogger(const Subsystem subsystem) const
+{
+    return _loggers[static_cast<int>(subsystem)].get();
+}
+
+void LogManager::setLevel(const Subsystem subsystem, const spdlog::level::level_enum level)
+{
+    _loggers[static_cast<int>(subsystem)]->set_level(level);
+}
+
+void LogManager::shutdown()
+{
+    if (_threadPool == nullptr) {
+        return;
+    }
+
+    for (auto& logger : _loggers)
+    {
+        logger->flush();
+
+        auto synchronousLogger = std::make_shared<spdlog::logger>(logger->name(), logger->sinks().begin(), logger->sinks().end());
+        synchronousLogger->set_pattern(LOG_PATTERN);
+        synchronousLogger->set_level(logger->level());
+        logger = std::move(synchronousLogger);
+    }
+
+    // Releasing the pool waits until the background thread writes out everything
+    _threadPool.reset();
+}
+
+const char* LogManager::getSubsystemName(const Subsystem subsystem)
+{
+    switch (subsystem)
+    {
+        case Subsystem::Core:
+            return "core";
+        case Subsystem::Render:
+            return "render";
+        case Subsystem::Buffers:
+            return "buffers";
+        case Subsystem::Shaders:
+            return "shaders";
+        case Subsystem::Assets:
+            return "assets";
+        case Subsystem::Erosion:
+            return "erosion";
+        default:
+            return "unknown";
+    }
+}
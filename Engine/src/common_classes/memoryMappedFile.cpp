@@ -0,0 +1,116 @@
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+// Project
+#include "../includes/common_classes/memoryMappedFile.h"
+
+MemoryMappedFile::~MemoryMappedFile()
+{
+    close();
+}
+
+bool MemoryMappedFile::open(const std::string& filePath)
+{
+    close();
+
+#ifdef _WIN32
+    const auto fileHandle = CreateFileA(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (fileHandle == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(fileHandle, &fileSize) || fileSize.QuadPart == 0)
+    {
+        CloseHandle(fileHandle);
+        return false;
+    }
+
+    const auto mappingHandle = CreateFileMappingA(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mappingHandle == nullptr)
+    {
+        CloseHandle(fileHandle);
+        return false;
+    }
+
+    const auto data = MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0);
+    if (data == nullptr)
+    {
+        CloseHandle(mappingHandle);
+        CloseHandle(fileHandle);
+        return false;
+    }
+
+    _fileHandle = fileHandle;
+    _mappingHandle = mappingHandle;
+    _data = static_cast<const unsigned char*>(data);
+    _size = static_cast<size_t>(fileSize.QuadPart);
+#else
+    const auto fileDescriptor = ::open(filePath.c_str(), O_RDONLY);
+    if (fileDescriptor == -1) {
+        return false;
+    }
+
+    struct stat fileStat;
+    if (fstat(fileDescriptor, &fileStat) == -1 || fileStat.st_size == 0)
+    {
+        ::close(fileDescriptor);
+        return false;
+    }
+
+    const auto data = mmap(nullptr, static_cast<size_t>(fileStat.st_size), PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+    // Mapping stays valid after closing the descriptor
+    ::close(fileDescriptor);
+    if (data == MAP_FAILED) {
+        return false;
+    }
+
+    _data = static_cast<const unsigned char*>(data);
+    _size = static_cast<size_t>(fileStat.st_size);
+#endif
+
+    return true;
+}
+
+void MemoryMappedFile::close()
+{
+    if (!isOpen()) {
+        return;
+    }
+
+#ifdef _WIN32
+    UnmapViewOfFile(_data);
+    CloseHandle(_mappingHandle);
+    CloseHandle(_fileHandle);
+    _mappingHandle = nullptr;
+    _fileHandle = nullptr;
+#else
+    munmap(const_cast<unsigned char*>(_data), _size);
+#endif
+
+    _data = nullptr;
+    _size = 0;
+}
+
+bool MemoryMappedFile::isOpen() const
+{
+    return _data != nullptr;
+}
+
+const unsigned char* MemoryMappedFile::getData() const
+{
+    return _data;
+}
+
+size_t MemoryMappedFile::getSize() const
+{
+    return _size;
+}
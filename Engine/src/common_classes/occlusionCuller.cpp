@@ -0,0 +1,290 @@
+// STL
+#include <algorithm>
+
+#include <imgui/imgui.h>
+
+// Project
+#include "../includes/common_classes/occlusionCuller.h"
+#include "../includes/common_classes/shaderManager.h"
+#include "../includes/common_classes/shaderProgramManager.h"
+#include "../includes/common_classes/glStateCache.h"
+#include "../includes/common_classes/instrumentation.h"
+#include "../includes/common_classes/static_meshes_3D/primitives/cube.h"
+
+const std::string OcclusionCuller::SHADER_PROGRAM_KEY = "occlusion_bounding_box";
+const float OcclusionCuller::EYE_BOUNDS_MARGIN = 1.0f;
+
+namespace {
+
+/**
+ * Checks, if the box lies completely outside of one of the frustum planes (planes are extracted
+ * from the rows of view projection matrix).
+ */
+bool isBoxOutsideFrustum(const glm::mat4& viewProjectionMatrix, const glm::vec3& boundsMin, const glm::vec3& boundsMax)
+{
+    const auto row = [&viewProjectionMatrix](const int index) {
+        return glm::vec4(viewProjectionMatrix[0][index], viewProjectionMatrix[1][index], viewProjectionMatrix[2][index], viewProjectionMatrix[3][index]);
+    };
+
+    const glm::vec4 planes[] = { row(3) + row(0), row(3) - row(0), row(3) + row(1), row(3) - row(1), row(3) + row(2), row(3) - row(2) };
+    for (const auto& plane : planes)
+    {
+        // Corner of the box furthest along the plane normal, if even that one is behind the plane, whole box is
+        const auto farthestCorner = glm::vec3(plane.x >= 0.0f ? boundsMax.x : boundsMin.x, plane.y >= 0.0f ? boundsMax.y : boundsMin.y,
+            plane.z >= 0.0f ? boundsMax.z : boundsMin.z);
+        if (glm::dot(glm::vec3(plane), farthestCorner) + plane.w < 0.0f) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+} // namespace
+
+void OcclusionCuller::prepareShaderProgram()
+{
+    auto& sm = ShaderManager::getInstance();
+    sm.loadVertexShader(SHADER_PROGRAM_KEY, "../../Engine/data/shaders/occlusion/boundingBox.vert");
+    sm.loadFragmentShader(SHADER_PROGRAM_KEY, "../../Engine/data/shaders/occlusion/boundingBox.frag");
+
+    auto& boundingBoxShaderProgram = ShaderProgramManager::getInstance().createShaderProgram(SHADER_PROGRAM_KEY);
+    boundingBoxShaderProgram.addShaderToProgram(sm.getVertexShader(SHADER_PROGRAM_KEY));
+    boundingBoxShaderProgram.addShaderToProgram(sm.getFragmentShader(SHADER_PROGRAM_KEY));
+}
+
+ShaderProgram& OcclusionCuller::getShaderProgram()
+{
+    return ShaderProgramManager::getInstance().getShaderProgram(SHADER_PROGRAM_KEY);
+}
+
+int OcclusionCuller::addObject()
+{
+    _objects.emplace_back();
+    return static_cast<int>(_objects.size()) - 1;
+}
+
+void OcclusionCuller::setObjectBounds(const int objectIndex, const glm::vec3& boundsMin, const glm::vec3& boundsMax, const glm::mat4& modelMatrix)
+{
+    if (objectIndex < 0 || objectIndex >= static_cast<int>(_objects.size())) {
+        return;
+    }
+
+    // World space box encloses all 8 transformed corners of the model space box
+    auto& object = _objects[objectIndex];
+    for (auto i = 0; i < 8; i++)
+    {
+        const auto corner = glm::vec3(i & 1 ? boundsMax.x : boundsMin.x, i & 2 ? boundsMax.y : boundsMin.y, i & 4 ? boundsMax.z : boundsMin.z);
+        const auto worldCorner = glm::vec3(modelMatrix * glm::vec4(corner, 1.0f));
+        object.boundsMin = i == 0 ? worldCorner : glm::min(object.boundsMin, worldCorner);
+        object.boundsMax = i == 0 ? worldCorner : glm::max(object.boundsMax, worldCorner);
+    }
+}
+
+void OcclusionCuller::clearObjects()
+{
+    _objects.clear();
+}
+
+void OcclusionCuller::beginFrame(const glm::mat4& projectionMatrix, const glm::mat4& viewMatrix, const glm::vec3& eyePosition)
+{
+    const auto numQueriesIssued = _statistics.numQueriesIssued;
+    _statistics = Statistics();
+    _statistics.numObjects = _objects.size();
+    _statistics.numQueriesIssued = numQueriesIssued;
+    if (!_isEnabled) {
+        return;
+    }
+
+    const auto viewProjectionMatrix = projectionMatrix * viewMatrix;
+    for (auto& object : _objects)
+    {
+        if (object.query != nullptr && _mode == Mode::DelayedReadback)
+        {
+            // Results not available yet are simply kept for the next frame, last known visibility is used meanwhile
+            if (object.query->updateResult()) {
+                object.isVisible = object.query->anySamplesPassed();
+            }
+            else if (object.query->isResultPending()) {
+                _statistics.numPendingResults++;
+            }
+        }
+
+        // Box containing the camera gets clipped by the near plane, its query could report no samples even if visible
+        const auto margin = glm::vec3(EYE_BOUNDS_MARGIN);
+        object.isEyeInside = glm::all(glm::greaterThanEqual(eyePosition, object.boundsMin - margin)) && glm::all(glm::lessThanEqual(eyePosition, object.boundsMax + margin));
+        object.isInFrustum = object.isEyeInside || !isBoxOutsideFrustum(viewProjectionMatrix, object.boundsMin, object.boundsMax);
+        if (!object.isInFrustum || object.isEyeInside) {
+            object.isVisible = true;
+        }
+    }
+}
+
+bool OcclusionCuller::prepareDrawPacket(const int objectIndex, RenderQueue::DrawPacket& packet)
+{
+    if (!_isEnabled || objectIndex < 0 || objectIndex >= static_cast<int>(_objects.size())) {
+        return true;
+    }
+
+    const auto& object = _objects[objectIndex];
+    if (!object.isInFrustum)
+    {
+        _statistics.numOutsideFrustum++;
+        return false;
+    }
+
+    if (object.isEyeInside || object.query == nullptr || !object.query->wasIssued()) {
+        return true;
+    }
+
+    if (_mode == Mode::ConditionalRender)
+    {
+        packet.conditionalQuery = object.query.get();
+        _statistics.numConditional++;
+        return true;
+    }
+
+    if (!object.isVisible)
+    {
+        _statistics.numOccluded++;
+        return false;
+    }
+
+    return true;
+}
+
+void OcclusionCuller::issueQueries()
+{
+    INSTRUMENT_ZONE("OcclusionCuller::issueQueries");
+    _statistics.numQueriesIssued = 0;
+    if (!_isEnabled || _objects.empty()) {
+        return;
+    }
+
+    if (_boxVAO == 0) {
+        createBoxMesh();
+    }
+
+    auto& boundingBoxShaderProgram = getShaderProgram();
+    boundingBoxShaderProgram.useProgram();
+
+    // Boxes only test the depth buffer, they must not leave any trace in the frame (nor in the state)
+    auto& gsc = GLStateCache::getInstance();
+    const auto wasDepthTestEnabled = gsc.isEnabled(GL_DEPTH_TEST);
+    const auto wasCullFaceEnabled = gsc.isEnabled(GL_CULL_FACE);
+    const auto wasDepthMaskEnabled = gsc.isDepthMaskEnabled();
+    const auto previousColorMask = gsc.getColorMask();
+    gsc.bindVertexArray(_boxVAO);
+    gsc.enable(GL_DEPTH_TEST);
+    gsc.disable(GL_CULL_FACE);
+    gsc.colorMask(false, false, false, false);
+    gsc.depthMask(false);
+
+    for (auto& object : _objects)
+    {
+        // Objects outside of the frustum or around the camera are decided without queries
+        if (!object.isInFrustum || object.isEyeInside) {
+            continue;
+        }
+
+        if (object.query == nullptr) {
+            object.query = std::make_unique<OcclusionQuery>();
+        }
+        else if (_mode == Mode::DelayedReadback && object.query->isResultPending()) {
+            continue; // Previous result would be lost, GPU is still late
+        }
+
+        boundingBoxShaderProgram[ShaderConstants::boundsMin()] = object.boundsMin;
+        boundingBoxShaderProgram[ShaderConstants::boundsMax()] = object.boundsMax;
+
+        object.query->beginQuery();
+        glDrawArrays(GL_TRIANGLES, 0, 36);
+        object.query->endQuery();
+        _statistics.numQueriesIssued++;
+    }
+
+    gsc.colorMask(previousColorMask[0], previousColorMask[1], previousColorMask[2], previousColorMask[3]);
+    gsc.depthMask(wasDepthMaskEnabled);
+    gsc.setEnabled(GL_CULL_FACE, wasCullFaceEnabled);
+    gsc.setEnabled(GL_DEPTH_TEST, wasDepthTestEnabled);
+}
+
+void OcclusionCuller::setMode(const Mode mode)
+{
+    _mode = mode;
+}
+
+OcclusionCuller::Mode OcclusionCuller::getMode() const
+{
+    return _mode;
+}
+
+void OcclusionCuller::setEnabled(const bool enabled)
+{
+    // Visibility known from before could be long outdated
+    if (enabled && !_isEnabled)
+    {
+        for (auto& object : _objects) {
+            object.isVisible = true;
+        }
+    }
+
+    _isEnabled = enabled;
+}
+
+bool OcclusionCuller::isEnabled() const
+{
+    return _isEnabled;
+}
+
+const OcclusionCuller::Statistics& OcclusionCuller::getStatistics() const
+{
+    return _statistics;
+}
+
+void OcclusionCuller::renderImGui()
+{
+    if (!ImGui::CollapsingHeader("Occlusion culling")) {
+        return;
+    }
+
+    auto isEnabled = _isEnabled;
+    if (ImGui::Checkbox("Cull occluded objects", &isEnabled)) {
+        setEnabled(isEnabled);
+    }
+
+    auto isConditionalRender = _mode == Mode::ConditionalRender;
+    if (ImGui::Checkbox("Conditional rendering (no readback)", &isConditionalRender)) {
+        setMode(isConditionalRender ? Mode::ConditionalRender : Mode::DelayedReadback);
+    }
+
+    ImGui::Text("Objects: %zu, outside of frustum: %zu, occluded: %zu", _statistics.numObjects, _statistics.numOutsideFrustum, _statistics.numOccluded);
+    ImGui::Text("Left to the GPU: %zu, results pending: %zu, queries issued: %zu", _statistics.numConditional, _statistics.numPendingResults, _statistics.numQueriesIssued);
+}
+
+void OcclusionCuller::deleteAll()
+{
+    _objects.clear();
+    _boxVBO.deleteVBO();
+    if (_boxVAO != 0)
+    {
+        glDeleteVertexArrays(1, &_boxVAO);
+        GLStateCache::getInstance().onVertexArrayDeleted(_boxVAO);
+        _boxVAO = 0;
+    }
+}
+
+void OcclusionCuller::createBoxMesh()
+{
+    glGenVertexArrays(1, &_boxVAO);
+    GLStateCache::getInstance().bindVertexArray(_boxVAO);
+
+    // Unit cube is stretched to the bounds in the vertex shader, so one mesh serves all the boxes
+    _boxVBO.createVBO(sizeof(static_meshes_3D::Cube::vertices));
+    _boxVBO.bindVBO();
+    _boxVBO.addRawData(static_meshes_3D::Cube::vertices, sizeof(static_meshes_3D::Cube::vertices));
+    _boxVBO.uploadDataToGPU(GL_STATIC_DRAW);
+
+    glEnableVertexAttribArray(static_meshes_3D::StaticMesh3D::POSITION_ATTRIBUTE_INDEX);
+    glVertexAttribPointer(static_meshes_3D::StaticMesh3D::POSITION_ATTRIBUTE_INDEX, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), reinterpret_cast<void*>(0));
+}
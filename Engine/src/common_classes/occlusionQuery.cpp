@@ -1,23 +1,21 @@
-// STL
-#include <iostream>
-
 // Project
 #include "../includes/common_classes/occlusionQuery.h"
+#include "../includes/common_classes/logManager.h"
 
 OcclusionQuery::OcclusionQuery()
 {
     glGenQueries(1, &queryID_);
-    std::cout << "Created occlusion query with ID " << queryID_ << std::endl;
+    LOG_DEBUG(Render, "Created occlusion query with ID {}", queryID_);
 }
 
 OcclusionQuery::~OcclusionQuery()
 {
     glDeleteQueries(1, &queryID_);
-    std::cout << "Deleted occlusion query with ID " << queryID_ << std::endl;
+    LOG_DEBUG(Render, "Deleted occlusion query with ID {}", queryID_);
     queryID_ = 0;
 }
 
-void OcclusionQuery::beginQuery() const
+void OcclusionQuery::beginQuery()
 {
     glBeginQuery(GL_SAMPLES_PASSED, queryID_);
 }
@@ -25,7 +23,51 @@ void OcclusionQuery::beginQuery() const
 void OcclusionQuery::endQuery()
 {
     glEndQuery(GL_SAMPLES_PASSED);
+    isResultPending_ = true;
+}
+
+bool OcclusionQuery::updateResult()
+{
+    if (!isResultPending_) {
+        return false;
+    }
+
+    GLint isAvailable = GL_FALSE;
+    glGetQueryObjectiv(queryID_, GL_QUERY_RESULT_AVAILABLE, &isAvailable);
+    if (isAvailable == GL_FALSE) {
+        return false;
+    }
+
+    // Result is available, so reading it doesn't wait for anything
     glGetQueryObjectiv(queryID_, GL_QUERY_RESULT, &samplesPassed_);
+    isResultPending_ = false;
+    hasResult_ = true;
+    return true;
+}
+
+bool OcclusionQuery::isResultPending() const
+{
+    return isResultPending_;
+}
+
+bool OcclusionQuery::hasResult() const
+{
+    return hasResult_;
+}
+
+bool OcclusionQuery::wasIssued() const
+{
+    return isResultPending_ || hasResult_;
+}
+
+void OcclusionQuery::beginConditionalRender(const GLenum mode) const
+{
+    glBeginConditionalRender(queryID_, mode);
+}
+
+void OcclusionQuery::endConditionalRender()
+{
+    glEndConditionalRender();
 }
 
 GLint OcclusionQuery::getNumSamplesPassed() const
@@ -37,3 +79,8 @@ bool OcclusionQuery::anySamplesPassed() const
 {
     return samplesPassed_ > 0;
 }
+
+GLuint OcclusionQuery::getQueryID() const
+{
+    return queryID_;
+}
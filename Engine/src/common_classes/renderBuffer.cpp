@@ -1,8 +1,6 @@
-// STL
-#include <iostream>
-
 // Project
 #include "../includes/common_classes/renderBuffer.h"
+#include "../includes/common_classes/logManager.h"
 
 RenderBuffer::~RenderBuffer()
 {
@@ -14,12 +12,11 @@ bool RenderBuffer::create(GLenum internalFormat, GLsizei width, GLsizei height)
     glGenRenderbuffers(1, &renderBufferID_);
     if(renderBufferID_ == 0)
     {
-        std::cerr << "Unable to create renderbuffer with internal format " << internalFormat
-            << " and dimensions [" << width << ", " << height << "]!" << std::endl;
+        LOG_ERROR(Render, "Unable to create renderbuffer with internal format {} and dimensions [{}, {}]!", internalFormat, width, height);
         return false;
     }
 
-    std::cout << "Created renderbuffer with ID #" << renderBufferID_ << std::endl;
+    LOG_DEBUG(Render, "Created renderbuffer with ID #{}", renderBufferID_);
 
     // Bind newly created renderbuffer and set its storage attributes
     glBindRenderbuffer(GL_RENDERBUFFER, renderBufferID_);
@@ -52,7 +49,7 @@ void RenderBuffer::deleteRenderBuffer()
         return;
     }
 
-    std::cout << "Deleting renderbuffer with ID #" << renderBufferID_ << std::endl;
+    LOG_DEBUG(Render, "Deleting renderbuffer with ID #{}", renderBufferID_);
     glDeleteRenderbuffers(1, &renderBufferID_);
     renderBufferID_ = 0;
     width_ = 0;
@@ -0,0 +1,183 @@
+// STL
+#include <algorithm>
+
+// Project
+#include "../includes/common_classes/renderQueue.h"
+#include "../includes/common_classes/glStateCache.h"
+#include "../includes/common_classes/hashUtils.h"
+#include "../includes/common_classes/frameProfiler.h"
+#include "../includes/common_classes/instrumentation.h"
+#include "../includes/common_classes/logManager.h"
+
+const GLuint RenderQueue::KEEP_SAMPLER = 0xFFFFFFFF;
+
+void RenderQueue::DrawPacket::setTexture(const int textureUnit, const GLenum target, const GLuint textureID, const GLuint samplerID)
+{
+    if (textureUnit < 0 || textureUnit >= MAX_PACKET_TEXTURES)
+    {
+        LOG_ERROR(Render, "Texture unit {} can't be used by a draw packet (maximum is {})!", textureUnit, MAX_PACKET_TEXTURES - 1);
+        return;
+    }
+
+    textures[textureUnit] = TextureBinding{ target, textureID, samplerID };
+}
+
+void RenderQueue::begin(const glm::mat4& projectionMatrix, const glm::mat4& viewMatrix)
+{
+    _packets.clear();
+    _viewMatrix = viewMatrix;
+
+    // For perspective projection, far = P[3][2] / (P[2][2] + 1)
+    const auto denominator = projectionMatrix[2][2] + 1.0f;
+    _farPlane = denominator != 0.0f ? std::max(projectionMatrix[3][2] / denominator, 1.0f) : 1.0f;
+}
+
+void RenderQueue::submit(const DrawPacket& packet)
+{
+    if (packet.shaderProgram == nullptr || packet.draw == nullptr) {
+        return;
+    }
+
+    _packets.push_back(packet);
+}
+
+void RenderQueue::flush()
+{
+    INSTRUMENT_ZONE("RenderQueue::flush");
+    INSTRUMENT_COUNTER(DrawPackets, _packets.size());
+    _numFlushedPackets = _packets.size();
+    _numProgramChanges = 0;
+
+    _sortKeys.clear();
+    for (size_t i = 0; i < _packets.size(); i++) {
+        _sortKeys.emplace_back(computeSortKey(_packets[i]), static_cast<uint32_t>(i));
+    }
+
+    radixSortKeys();
+
+    // Program is switched only when it changes, textures and VAOs are skipped by the state cache when they don't
+    auto& gsc = GLStateCache::getInstance();
+    const ShaderProgram* currentProgram = nullptr;
+    auto isNormalMatrixComputed = false;
+    glm::mat4 normalMatrixModelMatrix(1.0f);
+    glm::mat3 normalMatrix(1.0f);
+    for (const auto& keyIndexPair : _sortKeys)
+    {
+        auto& packet = _packets[keyIndexPair.second];
+        if (packet.shaderProgram != currentProgram)
+        {
+            packet.shaderProgram->useProgram();
+            currentProgram = packet.shaderProgram;
+            _numProgramChanges++;
+        }
+
+        for (auto textureUnit = 0; textureUnit < MAX_PACKET_TEXTURES; textureUnit++)
+        {
+            const auto& textureBinding = packet.textures[textureUnit];
+            if (textureBinding.target == 0) {
+                continue;
+            }
+
+            gsc.bindTextureToUnit(textureUnit, textureBinding.target, textureBinding.textureID);
+            if (textureBinding.samplerID != KEEP_SAMPLER) {
+                gsc.bindSampler(textureUnit, textureBinding.samplerID);
+            }
+        }
+
+        gsc.bindVertexArray(packet.vao);
+
+        // Packets of the same object (meshes of a model, terrain chunks) share the model matrix and are mostly sorted together
+        if (!isNormalMatrixComputed || packet.modelMatrix != normalMatrixModelMatrix)
+        {
+            normalMatrixModelMatrix = packet.modelMatrix;
+            normalMatrix = glm::transpose(glm::inverse(glm::mat3(packet.modelMatrix)));
+            isNormalMatrixComputed = true;
+        }
+        packet.shaderProgram->setModelAndNormalMatrix(packet.modelMatrix, normalMatrix);
+
+        // GPU skips the draw calls on its own, if the query says nothing was visible (and renders, if it doesn't know yet)
+        if (packet.conditionalQuery != nullptr) {
+            packet.conditionalQuery->beginConditionalRender(GL_QUERY_NO_WAIT);
+        }
+
+        if (packet.profileScope == nullptr) {
+            packet.draw(packet.drawObject, packet.drawArgument);
+        }
+        else
+        {
+            FrameProfiler::Scope packetScope(packet.profileScope);
+            packet.draw(packet.drawObject, packet.drawArgument);
+        }
+
+        if (packet.conditionalQuery != nullptr) {
+            OcclusionQuery::endConditionalRender();
+        }
+    }
+
+    _packets.clear();
+}
+
+size_t RenderQueue::getNumFlushedPackets() const
+{
+    return _numFlushedPackets;
+}
+
+size_t RenderQueue::getNumProgramChanges() const
+{
+    return _numProgramChanges;
+}
+
+uint64_t RenderQueue::computeSortKey(const DrawPacket& packet) const
+{
+    // Material is identified by bound textures, hash is folded to 16 bits (collision only makes grouping worse)
+    auto materialHash = hash_utils::FNV_OFFSET_BASIS;
+    for (const auto& textureBinding : packet.textures) {
+        materialHash = hash_utils::fnv1a(&textureBinding, sizeof(TextureBinding), materialHash);
+    }
+    const auto material = static_cast<uint16_t>(materialHash ^ (materialHash >> 16) ^ (materialHash >> 32) ^ (materialHash >> 48));
+
+    // Depth is distance along view direction, closer packets have lower keys (front-to-back)
+    const auto viewPosition = _viewMatrix * packet.modelMatrix[3];
+    const auto normalizedDepth = glm::clamp(-viewPosition.z / _farPlane, 0.0f, 1.0f);
+    const auto depth = static_cast<uint16_t>(normalizedDepth * 65535.0f);
+
+    const auto program = static_cast<uint16_t>(packet.shaderProgram->getShaderProgramID());
+    const auto vao = static_cast<uint16_t>(packet.vao);
+    return (static_cast<uint64_t>(program) << 48) | (static_cast<uint64_t>(material) << 32) | (static_cast<uint64_t>(vao) << 16) | depth;
+}
+
+void RenderQueue::radixSortKeys()
+{
+    const auto numKeys = _sortKeys.size();
+    if (numKeys < 2) {
+        return;
+    }
+
+    _sortKeysTemp.resize(numKeys);
+    for (auto shift = 0; shift < 64; shift += 8)
+    {
+        size_t bucketOffsets[256] = {};
+        for (const auto& keyIndexPair : _sortKeys) {
+            bucketOffsets[(keyIndexPair.first >> shift) & 0xFF]++;
+        }
+
+        // All the keys share this byte, pass would not change the order
+        if (bucketOffsets[(_sortKeys[0].first >> shift) & 0xFF] == numKeys) {
+            continue;
+        }
+
+        size_t offset = 0;
+        for (auto& bucketOffset : bucketOffsets)
+        {
+            const auto bucketSize = bucketOffset;
+            bucketOffset = offset;
+            offset += bucketSize;
+        }
+
+        for (const auto& keyIndexPair : _sortKeys) {
+            _sortKeysTemp[bucketOffsets[(keyIndexPair.first >> shift) & 0xFF]++] = keyIndexPair;
+        }
+
+        _sortKeys.swap(_sortKeysTemp);
+    }
+}
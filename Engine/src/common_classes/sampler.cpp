@@ -1,8 +1,7 @@
-// STL
-#include <iostream>
-
 // Project
 #include "../includes/common_classes/sampler.h"
+#include "../includes/common_classes/glStateCache.h"
+#include "../includes/common_classes/logManager.h"
 
 Sampler::~Sampler()
 {
@@ -26,7 +25,7 @@ void Sampler::bind(const int textureUnit) const
         return;
     }
 
-    glBindSampler(textureUnit, _samplerID);
+    GLStateCache::getInstance().bindSampler(textureUnit, _samplerID);
 }
 
 void Sampler::deleteSampler()
@@ -36,6 +35,7 @@ void Sampler::deleteSampler()
     }
 
     glDeleteSamplers(1, &_samplerID);
+    GLStateCache::getInstance().onSamplerDeleted(_samplerID);
     _isCreated = false;
 }
 
@@ -88,13 +88,14 @@ void Sampler::setRepeat(bool repeat) const
 
     glSamplerParameteri(_samplerID, GL_TEXTURE_WRAP_S, param);
     glSamplerParameteri(_samplerID, GL_TEXTURE_WRAP_T, param);
+    glSamplerParameteri(_samplerID, GL_TEXTURE_WRAP_R, param); // Matters only for cube maps and 3D textures
 }
 
 bool Sampler::createdCheck() const
 {
     if (!_isCreated)
     {
-        std::cout << "Attempting to access non existing sampler!" << std::endl;
+        LOG_WARN(Assets, "Attempting to access non existing sampler!");
         return false;
     }
 
@@ -1,11 +1,32 @@
 // STL
 #include <sstream>
-#include <iostream>
 #include <fstream>
 
+#include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
+
+// GLFW
+#include <GLFW/glfw3.h>
+
 // Project
 #include "../includes/common_classes/shader.h"
 #include "../includes/common_classes/stringUtils.h"
+#include "../includes/common_classes/hashUtils.h"
+#include "../includes/common_classes/logManager.h"
+
+namespace {
+
+typedef void (APIENTRYP PFNGLMAXSHADERCOMPILERTHREADSPROC)(GLuint count);
+
+bool isParallelCompileEnabled = false; // Flag telling, whether completion status of shaders and programs can be polled
+
+// Raw lines of shader files read so far, shared by all shaders (common includes are read only once per process)
+std::mutex sourceFileCacheMutex;
+std::map<std::string, std::shared_ptr<const std::vector<std::string>>> sourceFileCache;
+
+} // namespace
 
 Shader::~Shader()
 {
@@ -15,64 +36,189 @@ Shader::~Shader()
 bool Shader::loadShaderFromFile(const std::string& fileName, GLenum shaderType)
 {
     std::vector<std::string> fileLines;
+    if (!readShaderSource(fileName, fileLines)) {
+        return false;
+    }
+
+    setShaderSource(std::move(fileLines), shaderType, fileName);
+    return true;
+}
+
+bool Shader::readShaderSource(const std::string& fileName, std::vector<std::string>& sourceLines)
+{
     std::set<std::string> filesIncludedAlready;
+    return getLinesFromFile(fileName, sourceLines, filesIncludedAlready);
+}
+
+void Shader::setShaderSource(std::vector<std::string> sourceLines, const GLenum shaderType, const std::string& fileName)
+{
+    deleteShader();
+
+    // Hash covers shader type as well, so that the same source used as different stage is distinguished
+    sourceHash_ = hash_utils::fnv1a(&shaderType, sizeof(GLenum));
+    for (const auto& line : sourceLines) {
+        sourceHash_ = hash_utils::fnv1a(line, sourceHash_);
+    }
+
+    sourceLines_ = std::move(sourceLines);
+    shaderType_ = shaderType;
+    fileName_ = fileName;
+    isLoaded_ = true;
+}
+
+bool Shader::compile() const
+{
+    return submitCompile() && finishCompile();
+}
 
-    if(!getLinesFromFile(fileName, fileLines, filesIncludedAlready))
+bool Shader::submitCompile() const
+{
+    if (isCompileSubmitted_ || isCompileFinished_) {
+        return true;
+    }
+
+    if (!isLoaded_) {
         return false;
+    }
 
     std::vector<const char*> programSource;
-    for(const auto& line : fileLines) {
+    for(const auto& line : sourceLines_) {
         programSource.push_back(line.c_str());
     }
 
-    // Create and compile shader
-    shaderID_ = glCreateShader(shaderType);
-    glShaderSource(shaderID_, static_cast<GLsizei>(fileLines.size()), programSource.data(), nullptr);
+    // Create shader and submit its compilation, status is not queried here so that the driver doesn't have to finish it
+    if (shaderID_ == 0) {
+        shaderID_ = glCreateShader(shaderType_);
+    }
+    glShaderSource(shaderID_, static_cast<GLsizei>(sourceLines_.size()), programSource.data(), nullptr);
     glCompileShader(shaderID_);
+    isCompileSubmitted_ = true;
+    return true;
+}
+
+bool Shader::isCompileReady() const
+{
+    if (!isCompileSubmitted_ || !isParallelCompileEnabled) {
+        return true;
+    }
+
+    GLint completionStatus = GL_FALSE;
+    glGetShaderiv(shaderID_, GL_COMPLETION_STATUS_KHR, &completionStatus);
+    return completionStatus == GL_TRUE;
+}
+
+bool Shader::finishCompile() const
+{
+    if (isCompileFinished_) {
+        return isCompiled_;
+    }
+
+    if (!isCompileSubmitted_) {
+        return false;
+    }
+
+    isCompileSubmitted_ = false;
+    isCompileFinished_ = true;
 
     // Get and check the compilation status
     GLint compilationStatus;
     glGetShaderiv(shaderID_, GL_COMPILE_STATUS, &compilationStatus);
     if(compilationStatus == GL_FALSE)
     {
-        std::cerr << "Error! Shader file " << fileName << " wasn't compiled!";
-
         // Get length of the error log first
         GLint logLength;
         glGetShaderiv(shaderID_, GL_INFO_LOG_LENGTH, &logLength);
 
-        // If there is some log, then retrieve it and output extra information
+        // If there is some log, then retrieve it and output it with the error as one message
+        std::string logMessage;
         if (logLength > 0)
         {
-            GLchar* logMessage = new GLchar[logLength];
-            glGetShaderInfoLog(shaderID_, logLength, nullptr, logMessage);
-            std::cerr << " The compiler returned: " << std::endl << std::endl << logMessage;
-            delete[] logMessage;
+            logMessage.resize(logLength);
+            glGetShaderInfoLog(shaderID_, logLength, nullptr, &logMessage[0]);
         }
 
-        std::cerr << std::endl;
+        LOG_ERROR(Shaders, "Error! Shader file {} wasn't compiled! The compiler returned:\n\n{}", fileName_, logMessage.c_str());
         return false;
     }
 
-    shaderType_ = shaderType;
     isCompiled_ = true;
     return true;
 }
 
+bool Shader::enableParallelCompile()
+{
+    // Both KHR and ARB versions of the extension share the same tokens
+    GLint numExtensions = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &numExtensions);
+    for (auto i = 0; i < numExtensions; i++)
+    {
+        const auto extensionName = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, static_cast<GLuint>(i)));
+        if (extensionName == nullptr) {
+            continue;
+        }
+
+        const auto isKHR = strcmp(extensionName, "GL_KHR_parallel_shader_compile") == 0;
+        const auto isARB = strcmp(extensionName, "GL_ARB_parallel_shader_compile") == 0;
+        if (!isKHR && !isARB) {
+            continue;
+        }
+
+        const auto maxShaderCompilerThreads = reinterpret_cast<PFNGLMAXSHADERCOMPILERTHREADSPROC>(
+            glfwGetProcAddress(isKHR ? "glMaxShaderCompilerThreadsKHR" : "glMaxShaderCompilerThreadsARB"));
+        if (maxShaderCompilerThreads != nullptr)
+        {
+            // 0xFFFFFFFF lets the driver use as many threads as it wants
+            GLint maxThreads = 0;
+            maxShaderCompilerThreads(0xFFFFFFFF);
+            glGetIntegerv(GL_MAX_SHADER_COMPILER_THREADS_KHR, &maxThreads);
+            LOG_INFO(Shaders, "Parallel shader compilation enabled ({}, max compiler threads: {})", extensionName, maxThreads);
+        }
+
+        isParallelCompileEnabled = true;
+        return true;
+    }
+
+    isParallelCompileEnabled = false;
+    return false;
+}
+
+bool Shader::isParallelCompileSupported()
+{
+    return isParallelCompileEnabled;
+}
+
+void Shader::clearSourceFileCache()
+{
+    std::lock_guard<std::mutex> lock(sourceFileCacheMutex);
+    sourceFileCache.clear();
+}
+
+bool Shader::isLoaded() const
+{
+    return isLoaded_;
+}
+
 bool Shader::isCompiled() const
 {
     return isCompiled_;
 }
 
+uint64_t Shader::getSourceHash() const
+{
+    return sourceHash_;
+}
+
 void Shader::deleteShader()
 {
     if (shaderID_ == 0) {
         return;
     }
 
-    std::cout << "Deleting shader with ID " << shaderID_ << std::endl;
+    LOG_DEBUG(Shaders, "Deleting shader with ID {}", shaderID_);
     glDeleteShader(shaderID_);
     isCompiled_ = false;
+    isCompileSubmitted_ = false;
+    isCompileFinished_ = false;
     shaderID_ = 0;
 }
 
@@ -86,12 +232,38 @@ GLenum Shader::getShaderType() const
     return shaderType_;
 }
 
-bool Shader::getLinesFromFile(const std::string& fileName, std::vector<std::string>& result, std::set<std::string>& filesIncludedAlready, bool isReadingIncludedFile) const
+std::shared_ptr<const std::vector<std::string>> Shader::getSourceFileLines(const std::string& fileName)
 {
+    {
+        std::lock_guard<std::mutex> lock(sourceFileCacheMutex);
+        const auto itCachedFile = sourceFileCache.find(fileName);
+        if (itCachedFile != sourceFileCache.end()) {
+            return itCachedFile->second;
+        }
+    }
+
     std::ifstream file(fileName);
-    if (!file.good())
+    if (!file.good()) {
+        return nullptr;
+    }
+
+    auto fileLines = std::make_shared<std::vector<std::string>>();
+    std::string line;
+    while (std::getline(file, line)) {
+        fileLines->push_back(line + "\n"); // getline does not keep newline character
+    }
+
+    // Another thread might have read the same file meanwhile, in that case its copy is kept
+    std::lock_guard<std::mutex> lock(sourceFileCacheMutex);
+    return sourceFileCache.emplace(fileName, std::move(fileLines)).first->second;
+}
+
+bool Shader::getLinesFromFile(const std::string& fileName, std::vector<std::string>& result, std::set<std::string>& filesIncludedAlready, bool isReadingIncludedFile)
+{
+    const auto fileLines = getSourceFileLines(fileName);
+    if (fileLines == nullptr)
     {
-        std::cout << "File " << fileName << " not found! (Have you set the working directory of the application to $(SolutionDir)bin/?)" << std::endl;
+        LOG_ERROR(Shaders, "File {} not found! (Have you set the working directory of the application to $(SolutionDir)bin/?)", fileName);
         return false;
     }
 
@@ -113,12 +285,9 @@ bool Shader::getLinesFromFile(const std::string& fileName, std::vector<std::stri
     startDirectory = fileName.substr(0, slashIndex + 1);
 
     // Get all lines from a file
-    std::string line;
     auto isInsideIncludePart = false;
-
-    while (std::getline(file, line))
+    for (const auto& line : *fileLines)
     {
-        line += "\n"; // getline does not keep newline character
         std::stringstream ss(line);
         std::string firstToken;
         ss >> firstToken;
@@ -160,6 +329,5 @@ bool Shader::getLinesFromFile(const std::string& fileName, std::vector<std::stri
             result.push_back(line);
     }
 
-    file.close();
     return true;
 }
@@ -3,6 +3,8 @@
 
 // Project
 #include "../includes/common_classes/shaderManager.h"
+#include "../includes/common_classes/asyncAssetLoader.h"
+#include "../includes/common_classes/instrumentation.h"
 
 ShaderManager& ShaderManager::getInstance()
 {
@@ -64,6 +66,91 @@ void ShaderManager::loadGeometryShader(const std::string& key, const std::string
     _geometryShaderCache[key] = std::move(geometryShader);
 }
 
+void ShaderManager::loadComputeShader(const std::string& key, const std::string& filePath)
+{
+    if (containsComputeShader(key))
+    {
+        auto msg = "Compute shader with key '" + key + "' already exists!";
+        throw std::runtime_error(msg.c_str());
+    }
+
+    auto computeShader = std::make_unique<Shader>();
+    if (!computeShader->loadShaderFromFile(filePath, GL_COMPUTE_SHADER))
+    {
+        auto msg = "Could not load compute shader '" + filePath + "'!";
+        throw std::runtime_error(msg);
+    }
+
+    _computeShaderCache[key] = std::move(computeShader);
+}
+
+std::shared_future<void> ShaderManager::loadVertexShaderAsync(const std::string& key, const std::string& filePath)
+{
+    return loadShaderAsync(_vertexShaderCache, key, filePath, GL_VERTEX_SHADER, "vertex");
+}
+
+std::shared_future<void> ShaderManager::loadFragmentShaderAsync(const std::string& key, const std::string& filePath)
+{
+    return loadShaderAsync(_fragmentShaderCache, key, filePath, GL_FRAGMENT_SHADER, "fragment");
+}
+
+std::shared_future<void> ShaderManager::loadGeometryShaderAsync(const std::string& key, const std::string& filePath)
+{
+    return loadShaderAsync(_geometryShaderCache, key, filePath, GL_GEOMETRY_SHADER, "geometry");
+}
+
+std::shared_future<void> ShaderManager::loadComputeShaderAsync(const std::string& key, const std::string& filePath)
+{
+    return loadShaderAsync(_computeShaderCache, key, filePath, GL_COMPUTE_SHADER, "compute");
+}
+
+std::shared_future<void> ShaderManager::loadShaderAsync(std::map<std::string, std::unique_ptr<Shader>>& shaderCache, const std::string& key,
+    const std::string& filePath, GLenum shaderType, const std::string& shaderTypeName)
+{
+    if (shaderCache.count(key) > 0)
+    {
+        auto msg = "Shader of type " + shaderTypeName + " with key '" + key + "' already exists!";
+        throw std::runtime_error(msg.c_str());
+    }
+
+    auto loadPromise = std::make_shared<std::promise<void>>();
+    auto loadFuture = loadPromise->get_future().share();
+    auto shaderCachePtr = &shaderCache;
+
+    const auto onFailure = [loadPromise](std::exception_ptr exception) { loadPromise->set_exception(exception); };
+    AsyncAssetLoader::getInstance().submitWorkerTask([shaderCachePtr, key, filePath, shaderType, shaderTypeName, loadPromise, onFailure]()
+    {
+        INSTRUMENT_ZONE("ShaderManager::readShaderSource");
+        auto sourceLines = std::make_shared<std::vector<std::string>>();
+        const auto isRead = Shader::readShaderSource(filePath, *sourceLines);
+
+        AsyncAssetLoader::getInstance().submitContextTask([shaderCachePtr, key, filePath, shaderType, shaderTypeName, loadPromise, sourceLines, isRead]()
+        {
+            if (shaderCachePtr->count(key) > 0)
+            {
+                auto msg = "Shader of type " + shaderTypeName + " with key '" + key + "' already exists!";
+                loadPromise->set_exception(std::make_exception_ptr(std::runtime_error(msg)));
+                return;
+            }
+
+            if (!isRead)
+            {
+                auto msg = "Could not load " + shaderTypeName + " shader '" + filePath + "'!";
+                loadPromise->set_exception(std::make_exception_ptr(std::runtime_error(msg)));
+                return;
+            }
+
+            // Shader is compiled later and only if its program is not found in the program binary cache
+            auto shader = std::make_unique<Shader>();
+            shader->setShaderSource(std::move(*sourceLines), shaderType, filePath);
+            (*shaderCachePtr)[key] = std::move(shader);
+            loadPromise->set_value();
+        }, onFailure);
+    }, onFailure);
+
+    return loadFuture;
+}
+
 bool ShaderManager::tryLoadGeometryShader(const std::string& key, const std::string& filePath)
 {
     try
@@ -111,11 +198,24 @@ const Shader& ShaderManager::getGeometryShader(const std::string & key) const
     return *_geometryShaderCache.at(key);
 }
 
+const Shader& ShaderManager::getComputeShader(const std::string& key) const
+{
+    if (!containsComputeShader(key))
+    {
+        auto msg = "Attempting to get non-existing compute shader with key '" + key + "'!";
+        throw std::runtime_error(msg.c_str());
+    }
+
+    return *_computeShaderCache.at(key);
+}
+
 void ShaderManager::clearShaderCache()
 {
     _vertexShaderCache.clear();
     _fragmentShaderCache.clear();
     _geometryShaderCache.clear();
+    _computeShaderCache.clear();
+    Shader::clearSourceFileCache();
 }
 
 bool ShaderManager::containsVertexShader(const std::string& key) const
@@ -132,3 +232,8 @@ bool ShaderManager::containsGeometryShader(const std::string & key) const
 {
     return _geometryShaderCache.count(key) > 0;
 }
+
+bool ShaderManager::containsComputeShader(const std::string& key) const
+{
+    return _computeShaderCache.count(key) > 0;
+}
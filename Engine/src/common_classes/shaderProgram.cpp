@@ -1,8 +1,71 @@
 // STL
-#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <filesystem>
 
 // Project
 #include "../includes/common_classes/shaderProgram.h"
+#include "../includes/common_classes/fileUtils.h"
+#include "../includes/common_classes/glStateCache.h"
+#include "../includes/common_classes/logManager.h"
+
+const std::string ShaderProgram::PROGRAM_CACHE_DIRECTORY = "../../Engine/data/shaders/program_cache/";
+const std::string ShaderProgram::PROGRAM_CACHE_EXTENSION = ".progcache";
+const uint32_t ShaderProgram::PROGRAM_CACHE_VERSION = 1;
+
+namespace {
+
+const uint32_t PROGRAM_CACHE_MAGIC = 0x47525045; // "EPRG" in little endian
+
+/**
+ * Header of the program binary cache file, it's followed by the program binary itself.
+ */
+struct ProgramCacheHeader
+{
+    uint32_t magic; // Magic number identifying the cache file
+    uint32_t version; // Version of the cache format
+    uint64_t cacheKey; // Key of the program (hash of sources and driver identification)
+    uint32_t binaryFormat; // Driver-specific format of the program binary
+    uint32_t binarySize; // Byte size of the program binary
+};
+
+/**
+ * Gets hash of OpenGL vendor, renderer and version strings. Binaries are valid only for the same driver,
+ * so this is part of every program cache key.
+ */
+uint64_t getDriverHash()
+{
+    static const auto driverHash = []()
+    {
+        auto hash = hash_utils::FNV_OFFSET_BASIS;
+        for (const auto name : { GL_VENDOR, GL_RENDERER, GL_VERSION })
+        {
+            const auto value = reinterpret_cast<const char*>(glGetString(name));
+            hash = hash_utils::fnv1aCString(value != nullptr ? value : "", hash);
+        }
+        return hash;
+    }();
+
+    return driverHash;
+}
+
+/**
+ * Checks, if the driver supports at least one program binary format.
+ */
+bool isProgramBinarySupported()
+{
+    static const auto isSupported = []()
+    {
+        GLint numFormats = 0;
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &numFormats);
+        return numFormats > 0;
+    }();
+
+    return isSupported;
+}
+
+} // namespace
 
 ShaderProgram::~ShaderProgram()
 {
@@ -14,55 +77,129 @@ void ShaderProgram::createProgram()
     shaderProgramID_ = glCreateProgram();
 }
 
-bool ShaderProgram::addShaderToProgram(const Shader& shader) const
+bool ShaderProgram::addShaderToProgram(const Shader& shader)
 {
-    if (!shader.isCompiled())
+    if (!shader.isLoaded())
         return false;
 
-    glAttachShader(shaderProgramID_, shader.getShaderID());
+    _shaders.push_back(&shader);
     return true;
 }
 
 bool ShaderProgram::linkProgram()
 {
-	if (_isLinked) {
+    return submitLink() && finishLink();
+}
+
+bool ShaderProgram::submitLink()
+{
+	if (_isLinked || _isLinkSubmitted) {
 		return true;
 	}
 
-    // Try to link program and get the link status
+    _programCacheKey = getProgramCacheKey();
+    if (isProgramBinarySupported() && loadProgramBinary(_programCacheKey))
+    {
+        _isLinked = true;
+        resolveUniformLocations();
+        return true;
+    }
+
+    // Compilation results are not queried here, they are collected together with the link status in finishLink
+    for (const auto shader : _shaders)
+    {
+        if (!shader->submitCompile()) {
+            return false;
+        }
+
+        glAttachShader(shaderProgramID_, shader->getShaderID());
+    }
+
+    if (!_transformFeedbackVariables.empty())
+    {
+        std::vector<const char*> recordedVariablesNamesPtrs;
+        for (const auto& recordedVariableName : _transformFeedbackVariables) {
+            recordedVariablesNamesPtrs.push_back(recordedVariableName.c_str());
+        }
+
+        glTransformFeedbackVaryings(shaderProgramID_, static_cast<GLsizei>(recordedVariablesNamesPtrs.size()), recordedVariablesNamesPtrs.data(), _transformFeedbackBufferMode);
+    }
+
+    // Binary has to be retrievable to be cached
+    glProgramParameteri(shaderProgramID_, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
     glLinkProgram(shaderProgramID_);
+    _isLinkSubmitted = true;
+    return true;
+}
+
+bool ShaderProgram::isLinkReady() const
+{
+    if (!_isLinkSubmitted || !Shader::isParallelCompileSupported()) {
+        return true;
+    }
+
+    GLint completionStatus = GL_FALSE;
+    glGetProgramiv(shaderProgramID_, GL_COMPLETION_STATUS_KHR, &completionStatus);
+    return completionStatus == GL_TRUE;
+}
+
+bool ShaderProgram::finishLink()
+{
+    if (_isLinked) {
+        return true;
+    }
+
+    if (!_isLinkSubmitted) {
+        return false;
+    }
+
+    _isLinkSubmitted = false;
+
+    // Collect compilation results of all shaders first, compiler errors are more helpful than the linker ones
+    auto areShadersCompiled = true;
+    for (const auto shader : _shaders) {
+        areShadersCompiled = shader->finishCompile() && areShadersCompiled;
+    }
+
     GLint linkStatus;
     glGetProgramiv(shaderProgramID_, GL_LINK_STATUS, &linkStatus);
-    _isLinked = linkStatus == GL_TRUE;
+    _isLinked = areShadersCompiled && linkStatus == GL_TRUE;
 
     if (!_isLinked)
     {
-        std::cerr << "Error! Shader program wasn't linked!";
-
         // Get length of the error log first
         GLint logLength;
         glGetProgramiv(shaderProgramID_, GL_INFO_LOG_LENGTH, &logLength);
 
-        // If there is some log, then retrieve it and output extra information
+        // If there is some log, then retrieve it and output it with the error as one message
+        std::string logMessage;
         if (logLength > 0)
         {
-            GLchar* logMessage = new GLchar[logLength];
-            glGetProgramInfoLog(shaderProgramID_, logLength, nullptr, logMessage);
-            std::cerr << " The linker returned: " << std::endl << std::endl << logMessage;
-            delete[] logMessage;
+            logMessage.resize(logLength);
+            glGetProgramInfoLog(shaderProgramID_, logLength, nullptr, &logMessage[0]);
         }
 
-        std::cerr << std::endl;
+        LOG_ERROR(Shaders, "Error! Shader program wasn't linked! The linker returned:\n\n{}", logMessage.c_str());
         return false;
     }
 
-    return _isLinked;
+    // Shaders are not needed anymore once the program is linked
+    for (const auto shader : _shaders) {
+        glDetachShader(shaderProgramID_, shader->getShaderID());
+    }
+
+    if (isProgramBinarySupported()) {
+        saveProgramBinary(_programCacheKey);
+    }
+
+    resolveUniformLocations();
+    return true;
 }
 
 void ShaderProgram::useProgram() const
 {
     if (_isLinked) {
-        glUseProgram(shaderProgramID_);
+        GLStateCache::getInstance().useProgram(shaderProgramID_);
     }
 }
 
@@ -72,9 +209,13 @@ void ShaderProgram::deleteProgram()
         return;
     }
 
-    std::cout << "Deleting shader program with ID " << shaderProgramID_ << std::endl;
+    LOG_DEBUG(Shaders, "Deleting shader program with ID {}", shaderProgramID_);
     glDeleteProgram(shaderProgramID_);
+    GLStateCache::getInstance().onProgramDeleted(shaderProgramID_);
     _isLinked = false;
+    _isLinkSubmitted = false;
+    _uniformSlots.clear();
+    _reportedMissingUniforms.clear();
 }
 
 GLuint ShaderProgram::getShaderProgramID() const
@@ -82,14 +223,25 @@ GLuint ShaderProgram::getShaderProgramID() const
     return shaderProgramID_;
 }
 
-Uniform& ShaderProgram::operator[](const std::string& varName)
+Uniform ShaderProgram::operator[](const std::string& varName)
 {
-    if (_uniforms.count(varName) == 0)
-    {
-        _uniforms[varName] = Uniform(varName, this);
+    const auto hash = hash_utils::fnv1a(varName);
+    const auto location = findUniformLocation(hash);
+    if (location == -1) {
+        reportMissingUniform(hash, varName.c_str());
     }
 
-    return _uniforms[varName];
+    return Uniform(location);
+}
+
+Uniform ShaderProgram::operator[](const UniformID& uniformID)
+{
+    const auto location = findUniformLocation(uniformID.hash);
+    if (location == -1) {
+        reportMissingUniform(uniformID.hash, uniformID.name);
+    }
+
+    return Uniform(location);
 }
 
 // Model and normal matrix setting is pretty common, that's why this convenience function
@@ -100,17 +252,23 @@ void ShaderProgram::setModelAndNormalMatrix(const glm::mat4& modelMatrix)
     (*this)[ShaderConstants::normalMatrix()] = glm::transpose(glm::inverse(glm::mat3(modelMatrix)));
 }
 
+void ShaderProgram::setModelAndNormalMatrix(const glm::mat4& modelMatrix, const glm::mat3& normalMatrix)
+{
+    (*this)[ShaderConstants::modelMatrix()] = modelMatrix;
+    (*this)[ShaderConstants::normalMatrix()] = normalMatrix;
+}
+
 GLuint ShaderProgram::getUniformBlockIndex(const std::string& uniformBlockName) const
 {
     if (!_isLinked)
     {
-        std::cerr << "Cannot get index of uniform block " << uniformBlockName << " when program has not been linked!" << std::endl;
+        LOG_ERROR(Shaders, "Cannot get index of uniform block {} when program has not been linked!", uniformBlockName);
         return GL_INVALID_INDEX;
     }
 
     const auto result = glGetUniformBlockIndex(shaderProgramID_, uniformBlockName.c_str());
     if (result == GL_INVALID_INDEX) {
-        std::cerr << "Could not get index of uniform block " << uniformBlockName << ", check if such uniform block really exists!" << std::endl;
+        LOG_ERROR(Shaders, "Could not get index of uniform block {}, check if such uniform block really exists!", uniformBlockName);
     }
 
     return result;
@@ -124,12 +282,221 @@ void ShaderProgram::bindUniformBlockToBindingPoint(const std::string& uniformBlo
     }
 }
 
-void ShaderProgram::setTransformFeedbackRecordedVariables(const std::vector<std::string>& recordedVariablesNames, const GLenum bufferMode) const
+void ShaderProgram::setTransformFeedbackRecordedVariables(const std::vector<std::string>& recordedVariablesNames, const GLenum bufferMode)
 {
-	std::vector<const char*> recordedVariablesNamesPtrs;
-	for (const auto& recordedVariableName : recordedVariablesNames) {
-		recordedVariablesNamesPtrs.push_back(recordedVariableName.c_str());
-	}
+	// Varyings are applied right before linking, they are part of the program cache key as well
+	_transformFeedbackVariables = recordedVariablesNames;
+	_transformFeedbackBufferMode = bufferMode;
+}
+
+uint64_t ShaderProgram::getProgramCacheKey() const
+{
+    auto cacheKey = getDriverHash();
+    for (const auto shader : _shaders)
+    {
+        const auto sourceHash = shader->getSourceHash();
+        cacheKey = hash_utils::fnv1a(&sourceHash, sizeof(uint64_t), cacheKey);
+    }
+
+    for (const auto& recordedVariableName : _transformFeedbackVariables) {
+        cacheKey = hash_utils::fnv1a(recordedVariableName + ";", cacheKey);
+    }
+
+    return hash_utils::fnv1a(&_transformFeedbackBufferMode, sizeof(GLenum), cacheKey);
+}
 
-	glTransformFeedbackVaryings(shaderProgramID_, static_cast<GLsizei>(recordedVariablesNamesPtrs.size()), recordedVariablesNamesPtrs.data(), bufferMode);
+std::string ShaderProgram::getProgramCacheFilePath(const uint64_t cacheKey)
+{
+    std::ostringstream ss;
+    ss << PROGRAM_CACHE_DIRECTORY << std::hex << std::setw(16) << std::setfill('0') << cacheKey << PROGRAM_CACHE_EXTENSION;
+    return ss.str();
+}
+
+bool ShaderProgram::loadProgramBinary(const uint64_t cacheKey)
+{
+    std::ifstream in(getProgramCacheFilePath(cacheKey), std::ios::binary);
+    if (!in) {
+        return false;
+    }
+
+    ProgramCacheHeader header;
+    if (!in.read(reinterpret_cast<char*>(&header), sizeof(ProgramCacheHeader))) {
+        return false;
+    }
+
+    if (header.magic != PROGRAM_CACHE_MAGIC || header.version != PROGRAM_CACHE_VERSION || header.cacheKey != cacheKey) {
+        return false;
+    }
+
+    std::vector<char> binary(header.binarySize);
+    if (!in.read(binary.data(), binary.size())) {
+        return false;
+    }
+
+    // Driver may still reject the binary (e.g. after an update that kept the version string), then just recompile
+    glProgramBinary(shaderProgramID_, header.binaryFormat, binary.data(), static_cast<GLsizei>(binary.size()));
+    GLint linkStatus = GL_FALSE;
+    glGetProgramiv(shaderProgramID_, GL_LINK_STATUS, &linkStatus);
+    if (linkStatus != GL_TRUE)
+    {
+        LOG_WARN(Shaders, "Cached binary of shader program with ID {} has been rejected, program will be recompiled", shaderProgramID_);
+        return false;
+    }
+
+    return true;
+}
+
+bool ShaderProgram::saveProgramBinary(const uint64_t cacheKey) const
+{
+    GLint binarySize = 0;
+    glGetProgramiv(shaderProgramID_, GL_PROGRAM_BINARY_LENGTH, &binarySize);
+    if (binarySize <= 0) {
+        return false;
+    }
+
+    std::vector<char> binary(binarySize);
+    GLenum binaryFormat = 0;
+    glGetProgramBinary(shaderProgramID_, binarySize, nullptr, &binaryFormat, binary.data());
+
+    ProgramCacheHeader header;
+    header.magic = PROGRAM_CACHE_MAGIC;
+    header.version = PROGRAM_CACHE_VERSION;
+    header.cacheKey = cacheKey;
+    header.binaryFormat = binaryFormat;
+    header.binarySize = static_cast<uint32_t>(binarySize);
+
+    std::error_code errorCode;
+    std::filesystem::create_directories(PROGRAM_CACHE_DIRECTORY, errorCode);
+
+    // Cache is written into a temporary file first, so that a crash or another process never leaves it half-written
+    const auto cacheFilePath = getProgramCacheFilePath(cacheKey);
+    const auto isWritten = file_utils::writeFileAtomically(cacheFilePath, [&](std::ostream& out)
+    {
+        out.write(reinterpret_cast<const char*>(&header), sizeof(ProgramCacheHeader));
+        out.write(binary.data(), binary.size());
+    });
+
+    if (!isWritten)
+    {
+        LOG_ERROR(Shaders, "Failed to write program binary cache {}!", cacheFilePath);
+        return false;
+    }
+
+    return true;
+}
+
+
+void ShaderProgram::resolveUniformLocations()
+{
+    _uniformSlots.clear();
+    _reportedMissingUniforms.clear();
+
+    GLint numUniforms = 0, maxNameLength = 0;
+    glGetProgramInterfaceiv(shaderProgramID_, GL_UNIFORM, GL_ACTIVE_RESOURCES, &numUniforms);
+    glGetProgramInterfaceiv(shaderProgramID_, GL_UNIFORM, GL_MAX_NAME_LENGTH, &maxNameLength);
+
+    // Query locations and array sizes first, so that the table can be sized properly
+    const GLenum properties[] = { GL_LOCATION, GL_ARRAY_SIZE };
+    std::vector<GLint> locations(numUniforms), arraySizes(numUniforms);
+    size_t numEntries = 0;
+    for (GLint i = 0; i < numUniforms; i++)
+    {
+        GLint values[2];
+        glGetProgramResourceiv(shaderProgramID_, GL_UNIFORM, i, 2, properties, 2, nullptr, values);
+        locations[i] = values[0];
+        arraySizes[i] = values[1];
+
+        // Members of uniform blocks have no location, arrays are registered by base name and every element
+        if (locations[i] != -1) {
+            numEntries += arraySizes[i] > 1 ? 1 + arraySizes[i] : 2;
+        }
+    }
+
+    // Keep load factor at most 0.5, so that probing is short and there is always an empty slot
+    size_t tableSize = 1;
+    while (tableSize < numEntries * 2) {
+        tableSize *= 2;
+    }
+    _uniformSlots.resize(tableSize);
+
+    std::vector<GLchar> nameBuffer(maxNameLength + 1);
+    for (GLint i = 0; i < numUniforms; i++)
+    {
+        if (locations[i] == -1) {
+            continue;
+        }
+
+        GLsizei nameLength = 0;
+        glGetProgramResourceName(shaderProgramID_, GL_UNIFORM, i, static_cast<GLsizei>(nameBuffer.size()), &nameLength, nameBuffer.data());
+        std::string name(nameBuffer.data(), nameLength);
+
+        // Array uniforms are reported as "name[0]", register the base name as well as all elements
+        const auto isArray = name.size() > 3 && name.compare(name.size() - 3, 3, "[0]") == 0;
+        if (!isArray)
+        {
+            insertUniformLocation(hash_utils::fnv1a(name), locations[i], name);
+            continue;
+        }
+
+        const auto baseName = name.substr(0, name.size() - 3);
+        insertUniformLocation(hash_utils::fnv1a(baseName), locations[i], baseName);
+        for (GLint element = 0; element < arraySizes[i]; element++)
+        {
+            const auto elementName = baseName + "[" + std::to_string(element) + "]";
+            insertUniformLocation(hash_utils::fnv1a(elementName), locations[i] + element, elementName);
+        }
+    }
+}
+
+void ShaderProgram::insertUniformLocation(const uint64_t hash, const GLint location, const std::string& name)
+{
+    const auto mask = _uniformSlots.size() - 1;
+    for (auto i = hash & mask;; i = (i + 1) & mask)
+    {
+        auto& slot = _uniformSlots[i];
+        if (slot.location == -1)
+        {
+            slot.hash = hash;
+            slot.location = location;
+            return;
+        }
+
+        if (slot.hash == hash)
+        {
+            if (slot.location != location) {
+                LOG_ERROR(Shaders, "Uniform name hash collision in shader program with ID {} (uniform {})!", shaderProgramID_, name);
+            }
+            return;
+        }
+    }
+}
+
+GLint ShaderProgram::findUniformLocation(const uint64_t hash) const
+{
+    if (_uniformSlots.empty()) {
+        return -1;
+    }
+
+    const auto mask = _uniformSlots.size() - 1;
+    for (auto i = hash & mask;; i = (i + 1) & mask)
+    {
+        const auto& slot = _uniformSlots[i];
+        if (slot.location == -1 || slot.hash == hash) {
+            return slot.location;
+        }
+    }
+}
+
+void ShaderProgram::reportMissingUniform(const uint64_t hash, const char* name)
+{
+    if (!_reportedMissingUniforms.insert(hash).second) {
+        return;
+    }
+
+    if (name != nullptr) {
+        LOG_WARN(Shaders, "Uniform with name {} does not exist in shader program with ID {}, setting it will fail!", name, shaderProgramID_);
+    }
+    else {
+        LOG_WARN(Shaders, "Uniform with hash {:#x} does not exist in shader program with ID {}, setting it will fail!", hash, shaderProgramID_);
+    }
 }
@@ -1,8 +1,11 @@
 // STL
 #include <stdexcept>
+#include <algorithm>
+#include <vector>
 
 // Project
 #include "../includes/common_classes/shaderProgramManager.h"
+#include "../includes/common_classes/instrumentation.h"
 
 ShaderProgramManager& ShaderProgramManager::getInstance()
 {
@@ -38,12 +41,37 @@ ShaderProgram& ShaderProgramManager::getShaderProgram(const std::string& key) co
 
 void ShaderProgramManager::linkAllPrograms()
 {
+    INSTRUMENT_ZONE("ShaderProgramManager::linkAllPrograms");
+    Shader::enableParallelCompile();
+
+    // Submit all the programs first, so that the driver can compile and link them in parallel
+    std::vector<std::pair<const std::string*, ShaderProgram*>> pendingPrograms;
     for (const auto& keyShaderProgramPair : _shaderProgramCache)
     {
-        if (!keyShaderProgramPair.second->linkProgram()) {
+        if (!keyShaderProgramPair.second->submitLink()) {
             auto msg = "Could not link shader program with key '" + keyShaderProgramPair.first + "'!";
             throw std::runtime_error(msg.c_str());
         }
+
+        pendingPrograms.emplace_back(&keyShaderProgramPair.first, keyShaderProgramPair.second.get());
+    }
+
+    // Collect results, programs that are ready go first. If none is ready, wait for the oldest one
+    while (!pendingPrograms.empty())
+    {
+        auto itProgram = std::find_if(pendingPrograms.begin(), pendingPrograms.end(), [](const std::pair<const std::string*, ShaderProgram*>& keyProgramPair) {
+            return keyProgramPair.second->isLinkReady();
+        });
+        if (itProgram == pendingPrograms.end()) {
+            itProgram = pendingPrograms.begin();
+        }
+
+        if (!itProgram->second->finishLink()) {
+            auto msg = "Could not link shader program with key '" + *itProgram->first + "'!";
+            throw std::runtime_error(msg.c_str());
+        }
+
+        pendingPrograms.erase(itProgram);
     }
 }
 
@@ -9,10 +9,10 @@ AmbientLight::AmbientLight(const glm::vec3& color, const bool isOn)
 {
 }
 
-void AmbientLight::setUniform(ShaderProgram& shaderProgram, const std::string& uniformName) const
+void AmbientLight::setUniform(ShaderProgram& shaderProgram, const UniformID& uniformID) const
 {
-    shaderProgram[constructAttributeName(uniformName, "color")] = color;
-    shaderProgram[constructAttributeName(uniformName, "isOn")] = isOn;
+    shaderProgram[uniformID.member("color")] = color;
+    shaderProgram[uniformID.member("isOn")] = isOn;
 }
 
 glm::vec3 AmbientLight::getColorContribution() const
@@ -20,4 +20,9 @@ glm::vec3 AmbientLight::getColorContribution() const
     return isOn ? color : glm::vec3(0.0f);
 }
 
+AmbientLight::Std140 AmbientLight::getStd140() const
+{
+    return { color, isOn ? 1 : 0 };
+}
+
 } // namespace shader_structs
\ No newline at end of file
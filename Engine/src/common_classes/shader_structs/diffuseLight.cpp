@@ -11,12 +11,22 @@ DiffuseLight::DiffuseLight(const glm::vec3& color, const glm::vec3& direction, c
 {
 }
 
-void DiffuseLight::setUniform(ShaderProgram& shaderProgram, const std::string& uniformName) const
+void DiffuseLight::setUniform(ShaderProgram& shaderProgram, const UniformID& uniformID) const
 {
-    shaderProgram[constructAttributeName(uniformName, "color")] = color;
-    shaderProgram[constructAttributeName(uniformName, "direction")] = direction;
-    shaderProgram[constructAttributeName(uniformName, "factor")] = factor;
-    shaderProgram[constructAttributeName(uniformName, "isOn")] = isOn;
+    shaderProgram[uniformID.member("color")] = color;
+    shaderProgram[uniformID.member("direction")] = direction;
+    shaderProgram[uniformID.member("factor")] = factor;
+    shaderProgram[uniformID.member("isOn")] = isOn;
+}
+
+DiffuseLight::Std140 DiffuseLight::getStd140() const
+{
+    Std140 result{};
+    result.color = color;
+    result.direction = direction;
+    result.factor = factor;
+    result.isOn = isOn ? 1 : 0;
+    return result;
 }
 
 const DiffuseLight& DiffuseLight::none()
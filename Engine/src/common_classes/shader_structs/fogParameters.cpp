@@ -28,18 +28,23 @@ const FogParameters& FogParameters::noFog()
     return noFogParameters;
 }
 
-void FogParameters::setUniform(ShaderProgram& shaderProgram, const std::string& uniformName) const
+void FogParameters::setUniform(ShaderProgram& shaderProgram, const UniformID& uniformID) const
 {
-    shaderProgram[constructAttributeName(uniformName, "isEnabled")] = isEnabled;
+    shaderProgram[uniformID.member("isEnabled")] = isEnabled;
     if (!isEnabled) {
         return; // Skip settings other parameters if fog is not enabled
     }
 
-    shaderProgram[constructAttributeName(uniformName, "color")] = color;
-    shaderProgram[constructAttributeName(uniformName, "linearStart")] = linearStart;
-    shaderProgram[constructAttributeName(uniformName, "linearEnd")] = linearEnd;
-    shaderProgram[constructAttributeName(uniformName, "density")] = density;
-    shaderProgram[constructAttributeName(uniformName, "equation")] = equation;
+    shaderProgram[uniformID.member("color")] = color;
+    shaderProgram[uniformID.member("linearStart")] = linearStart;
+    shaderProgram[uniformID.member("linearEnd")] = linearEnd;
+    shaderProgram[uniformID.member("density")] = density;
+    shaderProgram[uniformID.member("equation")] = equation;
+}
+
+FogParameters::Std140 FogParameters::getStd140() const
+{
+    return { color, linearStart, linearEnd, density, equation, isEnabled ? 1 : 0 };
 }
 
 std::string FogParameters::getFogEquationName() const
@@ -16,15 +16,15 @@ const Material& Material::none()
     return noMaterial;
 }
 
-void Material::setUniform(ShaderProgram& shaderProgram, const std::string& uniformName) const
+void Material::setUniform(ShaderProgram& shaderProgram, const UniformID& uniformID) const
 {
-    shaderProgram[constructAttributeName(uniformName, "isEnabled")] = isEnabled;
+    shaderProgram[uniformID.member("isEnabled")] = isEnabled;
     if (!isEnabled) {
         return; // Skip settings other parameters if material is not enabled
     }
 
-    shaderProgram[constructAttributeName(uniformName, "specularIntensity")] = specularIntensity;
-    shaderProgram[constructAttributeName(uniformName, "specularPower")] = specularPower;
+    shaderProgram[uniformID.member("specularIntensity")] = specularIntensity;
+    shaderProgram[uniformID.member("specularPower")] = specularPower;
 }
 
 } // namespace shader_structs
\ No newline at end of file
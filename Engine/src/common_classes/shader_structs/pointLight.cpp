@@ -16,15 +16,15 @@ PointLight::PointLight(const glm::vec3& position, const glm::vec3& color, const
 {
 }
 
-void PointLight::setUniform(ShaderProgram& shaderProgram, const std::string& uniformName) const
+void PointLight::setUniform(ShaderProgram& shaderProgram, const UniformID& uniformID) const
 {
-    shaderProgram[constructAttributeName(uniformName, "position")] = position;
-    shaderProgram[constructAttributeName(uniformName, "color")] = color;
-    shaderProgram[constructAttributeName(uniformName, "ambientFactor")] = ambientFactor;
-    shaderProgram[constructAttributeName(uniformName, "constantAttenuation")] = constantAttenuation;
-    shaderProgram[constructAttributeName(uniformName, "linearAttenuation")] = linearAttenuation;
-    shaderProgram[constructAttributeName(uniformName, "exponentialAttenuation")] = exponentialAttenuation;
-    shaderProgram[constructAttributeName(uniformName, "isOn")] = isOn;
+    shaderProgram[uniformID.member("position")] = position;
+    shaderProgram[uniformID.member("color")] = color;
+    shaderProgram[uniformID.member("ambientFactor")] = ambientFactor;
+    shaderProgram[uniformID.member("constantAttenuation")] = constantAttenuation;
+    shaderProgram[uniformID.member("linearAttenuation")] = linearAttenuation;
+    shaderProgram[uniformID.member("exponentialAttenuation")] = exponentialAttenuation;
+    shaderProgram[uniformID.member("isOn")] = isOn;
 }
 
 GLsizeiptr PointLight::getDataSizeStd140()
@@ -41,6 +41,19 @@ void* PointLight::getDataPointer() const
     return (void*)&position;
 }
 
+PointLight::Std140 PointLight::getStd140() const
+{
+    Std140 result{};
+    result.position = position;
+    result.color = color;
+    result.ambientFactor = ambientFactor;
+    result.constantAttenuation = constantAttenuation;
+    result.linearAttenuation = linearAttenuation;
+    result.exponentialAttenuation = exponentialAttenuation;
+    result.isOn = isOn;
+    return result;
+}
+
 const PointLight& PointLight::none()
 {
     static PointLight nonePointLight(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, 0.0f), 0.0f, 0.0f, 0.0f, 0.0f, false);
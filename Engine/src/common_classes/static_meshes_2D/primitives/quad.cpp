@@ -26,7 +26,7 @@ void Quad::render() const
         return;
     }
 
-    glBindVertexArray(_vao);
+    GLStateCache::getInstance().bindVertexArray(_vao);
     glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
 }
 
@@ -37,7 +37,7 @@ void Quad::initializeData()
     }
 
     glGenVertexArrays(1, &_vao);
-    glBindVertexArray(_vao);
+    GLStateCache::getInstance().bindVertexArray(_vao);
 
     const int numVertices = 4;
     int vertexByteSize = getVertexByteSize();	
@@ -25,6 +25,7 @@ void StaticMesh2D::deleteMesh()
     }
 
     glDeleteVertexArrays(1, &_vao);
+    GLStateCache::getInstance().onVertexArrayDeleted(_vao);
     _vbo.deleteVBO();
 
     _isInitialized = false;
@@ -1,3 +1,8 @@
+// STL
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
 // Assimp
 #include <assimp/Importer.hpp>
 #include <assimp/scene.h>
@@ -9,120 +14,338 @@
 // Project
 #include "../includes/common_classes/static_meshes_3D/assimpModel.h"
 #include "../includes/common_classes/stringUtils.h"
+#include "../includes/common_classes/hashUtils.h"
+#include "../includes/common_classes/fileUtils.h"
 #include "../includes/common_classes/textureManager.h"
+#include "../includes/common_classes/asyncAssetLoader.h"
+#include "../includes/common_classes/logManager.h"
 
 namespace static_meshes_3D {
 
+const std::string AssimpModel::MESH_CACHE_EXTENSION = ".meshcache";
+const uint32_t AssimpModel::MESH_CACHE_VERSION = 1;
+
+namespace {
+
+const uint32_t MESH_CACHE_MAGIC = 0x4853454D; // "MESH" in little endian
+
+// Joined vertices are kept and referenced through the index buffer, ImproveCacheLocality reorders
+// the triangles so that the post-transform vertex cache is hit as often as possible
+const unsigned int ASSIMP_IMPORT_FLAGS =
+    aiProcess_CalcTangentSpace |
+    aiProcess_GenSmoothNormals |
+    aiProcess_Triangulate |
+    aiProcess_JoinIdenticalVertices |
+    aiProcess_ImproveCacheLocality |
+    aiProcess_SortByPType;
+
+/**
+ * Checks, that all indices of the mesh point to existing vertices (indices are relative to the base vertex of the mesh).
+ *
+ * @param indexData      Pointer to the whole index data
+ * @param startIndex     Index of the first index of the mesh
+ * @param indicesCount   Number of indices of the mesh
+ * @param baseVertex     Base vertex of the mesh
+ * @param numVertices    Total number of vertices
+ *
+ * @return True, if all the indices are within the vertex data or false otherwise.
+ */
+template <typename IndexType>
+bool areMeshIndicesValid(const unsigned char* indexData, const int startIndex, const int indicesCount, const int baseVertex, const int numVertices)
+{
+    const auto numMeshVertices = static_cast<int64_t>(numVertices) - baseVertex;
+    const auto meshIndexData = indexData + static_cast<size_t>(startIndex) * sizeof(IndexType);
+    for (auto i = 0; i < indicesCount; i++)
+    {
+        IndexType index;
+        memcpy(&index, meshIndexData + static_cast<size_t>(i) * sizeof(IndexType), sizeof(IndexType));
+        if (static_cast<int64_t>(index) >= numMeshVertices) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+} // namespace
+
 AssimpModel::AssimpModel(const std::string& filePath, const std::string& defaultTextureName, bool withPositions, bool withTextureCoordinates, bool withNormals, const glm::mat4& modelTransformMatrix)
-    : StaticMesh3D(withPositions, withTextureCoordinates, withNormals)
+    : StaticMeshIndexed3D(withPositions, withTextureCoordinates, withNormals)
 {
     loadModelFromFile(filePath, defaultTextureName, modelTransformMatrix);
 }
 
 AssimpModel::AssimpModel(const std::string& filePath, bool withPositions, bool withTextureCoordinates, bool withNormals, const glm::mat4& modelTransformMatrix)
-    : StaticMesh3D(withPositions, withTextureCoordinates, withNormals)
+    : StaticMeshIndexed3D(withPositions, withTextureCoordinates, withNormals)
 {
     loadModelFromFile(filePath, "", modelTransformMatrix);
 }
 
+AssimpModel::~AssimpModel()
+{
+    cancelLoading();
+}
+
 bool AssimpModel::loadModelFromFile(const std::string& filePath, const std::string& defaultTextureName, const glm::mat4& modelTransformMatrix)
 {
+    cancelLoading();
     if (_isInitialized) {
         deleteMesh();
     }
 
-    Assimp::Importer importer;
-    const aiScene* scene = importer.ReadFile(filePath,
-        aiProcess_CalcTangentSpace |
-        aiProcess_GenSmoothNormals |
-        aiProcess_Triangulate |
-        aiProcess_JoinIdenticalVertices |
-        aiProcess_SortByPType);
-
-    if (!scene) {
+    ModelData modelData;
+    setVertexLayout(modelData);
+    if (!prepareModelData(filePath, defaultTextureName, modelTransformMatrix, modelData)) {
         return false;
     }
 
-    _modelRootDirectoryPath = string_utils::getDirectoryPath(filePath);
+    createFromModelData(modelData, defaultTextureName, false);
+    return _isInitialized;
+}
 
-    glGenVertexArrays(1, &_vao);
-    glBindVertexArray(_vao);
+std::shared_future<void> AssimpModel::loadModelFromFileAsync(const std::string& filePath, const std::string& defaultTextureName, const glm::mat4& modelTransformMatrix)
+{
+    cancelLoading();
+    if (_isInitialized) {
+        deleteMesh();
+    }
 
-    _vbo.createVBO();
-    _vbo.bindVBO();
+    auto loadingState = std::make_shared<ModelLoadingState>();
+    loadingState->model = this;
+    loadingState->filePath = filePath;
+    loadingState->defaultTextureName = defaultTextureName;
+    loadingState->modelTransformMatrix = modelTransformMatrix;
+    setVertexLayout(loadingState->modelData);
+    _loadingState = loadingState;
 
-    const auto vertexByteSize = sizeof(aiVector3D) * 2 + sizeof(aiVector2D);
-    auto vertexCount = 0;
+    auto loadPromise = std::make_shared<std::promise<void>>();
+    auto loadFuture = loadPromise->get_future().share();
 
-    if (hasPositions())
+    // Worker works only with the shared loading state, the model is touched on the context thread only if it still exists
+    const auto onFailure = [loadPromise](std::exception_ptr exception) { loadPromise->set_exception(exception); };
+    AsyncAssetLoader::getInstance().submitWorkerTask([loadingState, loadPromise, onFailure]()
     {
-        for (size_t i = 0; i < scene->mNumMeshes; i++)
+        const auto isPrepared = prepareModelData(loadingState->filePath, loadingState->defaultTextureName, loadingState->modelTransformMatrix, loadingState->modelData);
+
+        AsyncAssetLoader::getInstance().submitContextTask([loadingState, loadPromise, isPrepared]()
         {
-            const auto meshPtr = scene->mMeshes[i];
-            auto vertexCountMesh = 0;
-            _meshStartIndices.push_back(vertexCount);
-            _meshMaterialIndices.push_back(meshPtr->mMaterialIndex);
+            if (loadingState->isCancelled)
+            {
+                auto msg = "Loading of model from file '" + loadingState->filePath + "' has been cancelled!";
+                loadPromise->set_exception(std::make_exception_ptr(std::runtime_error(msg)));
+                return;
+            }
 
-            for (size_t j = 0; j < meshPtr->mNumFaces; j++)
+            // Loading is finished, prepared data (possibly mapped cache) are released with this task
+            auto& model = *loadingState->model;
+            model._loadingState.reset();
+            if (!isPrepared)
             {
-                const auto& face = meshPtr->mFaces[j];
-                if (face.mNumIndices != 3) {
-                    continue; // Skip non-triangle faces for now
-                }
+                auto msg = "Could not load model from file '" + loadingState->filePath + "'!";
+                loadPromise->set_exception(std::make_exception_ptr(std::runtime_error(msg)));
+                return;
+            }
 
-                for (size_t k = 0; k < face.mNumIndices; k++)
-                {
-                    const auto& position = meshPtr->mVertices[face.mIndices[k]];
-                    _vbo.addData(glm::vec3(modelTransformMatrix * glm::vec4(position.x, position.y, position.z, 1.0f)));
-                }
+            model.createFromModelData(loadingState->modelData, loadingState->defaultTextureName, true);
+            loadPromise->set_value();
+        }, onFailure);
+    }, onFailure);
 
-                vertexCountMesh += face.mNumIndices;
-            }
+    return loadFuture;
+}
 
-            vertexCount += vertexCountMesh;
-            _meshVerticesCount.push_back(vertexCountMesh);
-        }
+bool AssimpModel::prepareModelData(const std::string& filePath, const std::string& defaultTextureName, const glm::mat4& modelTransformMatrix, ModelData& modelData)
+{
+    modelData.modelRootDirectoryPath = string_utils::getDirectoryPath(filePath);
+
+    // Cache is valid only for exactly the same source file contents and import settings
+    MemoryMappedFile sourceFile;
+    if (!sourceFile.open(filePath))
+    {
+        LOG_ERROR(Assets, "Could not open model file {}!", filePath);
+        return false;
+    }
+
+    const auto sourceHash = hash_utils::fnv1a(sourceFile.getData(), sourceFile.getSize());
+    sourceFile.close();
+
+    const auto importKeyHash = getImportKeyHash(modelData, defaultTextureName, modelTransformMatrix);
+    const auto cacheFilePath = filePath + MESH_CACHE_EXTENSION;
+
+    if (loadModelFromCache(cacheFilePath, sourceHash, importKeyHash, modelData)) {
+        return true;
     }
 
-    if (hasTextureCoordinates())
+    // Cache might have been read partially before it turned out to be invalid
+    modelData.cacheFile.close();
+    modelData.meshBaseVertices.clear();
+    modelData.meshStartIndices.clear();
+    modelData.meshIndicesCount.clear();
+    modelData.meshMaterialIndices.clear();
+    modelData.materialTextureFileNames.clear();
+
+    if (!importModelWithAssimp(filePath, defaultTextureName, modelTransformMatrix, modelData)) {
+        return false;
+    }
+
+    saveModelToCache(cacheFilePath, sourceHash, importKeyHash, modelData);
+    modelData.vertexDataPtr = modelData.vertexData.data();
+    modelData.vertexDataSize = modelData.vertexData.size();
+    modelData.indexDataPtr = modelData.indexData.data();
+    modelData.indexDataSize = modelData.indexData.size();
+    return true;
+}
+
+void AssimpModel::setVertexLayout(ModelData& modelData) const
+{
+    modelData.hasPositions = hasPositions();
+    modelData.hasTextureCoordinates = hasTextureCoordinates();
+    modelData.hasNormals = hasNormals();
+}
+
+void AssimpModel::cancelLoading()
+{
+    if (_loadingState)
     {
-        for (size_t i = 0; i < scene->mNumMeshes; i++)
-        {
-            const auto meshPtr = scene->mMeshes[i];
-            for (size_t j = 0; j < meshPtr->mNumFaces; j++)
-            {
-                const auto& face = meshPtr->mFaces[j];
-                if (face.mNumIndices != 3) {
-                    continue; // Skip non-triangle faces for now
-                }
+        _loadingState->isCancelled = true;
+        _loadingState.reset();
+    }
+}
 
-                for (size_t k = 0; k < face.mNumIndices; k++)
-                {
-                    const auto& textureCoord = meshPtr->mTextureCoords[0][face.mIndices[k]];
-                    _vbo.addRawData(&textureCoord, sizeof(aiVector2D));
-                }
+void AssimpModel::createFromModelData(ModelData& modelData, const std::string& defaultTextureName, bool loadTexturesAsync)
+{
+    _modelRootDirectoryPath = std::move(modelData.modelRootDirectoryPath);
+    _meshBaseVertices = std::move(modelData.meshBaseVertices);
+    _meshStartIndices = std::move(modelData.meshStartIndices);
+    _meshIndicesCount = std::move(modelData.meshIndicesCount);
+    _meshMaterialIndices = std::move(modelData.meshMaterialIndices);
+    _indexType = modelData.indexType;
+    _numVertices = modelData.numVertices;
+    _numIndices = modelData.numIndices;
+
+    _materialTextureKeys.clear();
+    uploadModelData(modelData.vertexDataPtr, modelData.vertexDataSize, modelData.indexDataPtr, modelData.indexDataSize);
+
+    for (const auto& materialTextureFileName : modelData.materialTextureFileNames) {
+        loadMaterialTexture(materialTextureFileName.first, materialTextureFileName.second, loadTexturesAsync);
+    }
+
+    if (!defaultTextureName.empty()) {
+        loadMaterialTexture(0, defaultTextureName, loadTexturesAsync);
+    }
+
+    _isInitialized = true;
+}
+
+bool AssimpModel::importModelWithAssimp(const std::string& filePath, const std::string& defaultTextureName, const glm::mat4& modelTransformMatrix, ModelData& modelData)
+{
+    Assimp::Importer importer;
+    const aiScene* scene = importer.ReadFile(filePath, ASSIMP_IMPORT_FLAGS);
+
+    if (!scene) {
+        return false;
+    }
+
+    // First count the vertices and indices, so that all the data can be written in a single pass
+    size_t maxMeshVertices = 0;
+    auto& numVertices = modelData.numVertices;
+    auto& numIndices = modelData.numIndices;
+    numVertices = 0;
+    numIndices = 0;
+    for (size_t i = 0; i < scene->mNumMeshes; i++)
+    {
+        const auto meshPtr = scene->mMeshes[i];
+        if ((meshPtr->mPrimitiveTypes & aiPrimitiveType_TRIANGLE) == 0) {
+            continue; // Skip point and line meshes, only triangles are rendered
+        }
+
+        modelData.meshBaseVertices.push_back(numVertices);
+        modelData.meshStartIndices.push_back(numIndices);
+        modelData.meshMaterialIndices.push_back(meshPtr->mMaterialIndex);
+
+        auto indicesCountMesh = 0;
+        for (size_t j = 0; j < meshPtr->mNumFaces; j++)
+        {
+            if (meshPtr->mFaces[j].mNumIndices == 3) {
+                indicesCountMesh += 3;
             }
         }
+
+        modelData.meshIndicesCount.push_back(indicesCountMesh);
+        numVertices += static_cast<int>(meshPtr->mNumVertices);
+        numIndices += indicesCountMesh;
+        maxMeshVertices = std::max(maxMeshVertices, static_cast<size_t>(meshPtr->mNumVertices));
     }
-    
-    if (hasNormals())
+
+    // Indices are relative to the base vertex of every mesh, so 16 bits are enough if every mesh is small enough
+    const auto indexType = maxMeshVertices <= std::numeric_limits<GLushort>::max() + 1 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+    const auto indexByteSize = indexType == GL_UNSIGNED_SHORT ? sizeof(GLushort) : sizeof(GLuint);
+    modelData.indexType = indexType;
+
+    // Vertex data are stored in the same layout as setVertexAttributesPointers expects - all positions, then texture coordinates, then normals
+    auto& vertexData = modelData.vertexData;
+    auto& indexData = modelData.indexData;
+    vertexData.assign(numVertices * modelData.getVertexByteSize(), 0);
+    indexData.assign(numIndices * indexByteSize, 0);
+
+    auto positionsPtr = reinterpret_cast<glm::vec3*>(vertexData.data());
+    auto textureCoordinatesPtr = reinterpret_cast<glm::vec2*>(positionsPtr + (modelData.hasPositions ? numVertices : 0));
+    auto normalsPtr = reinterpret_cast<glm::vec3*>(textureCoordinatesPtr + (modelData.hasTextureCoordinates ? numVertices : 0));
+
+    const auto normalMatrix = glm::transpose(glm::inverse(glm::mat3(modelTransformMatrix)));
+    auto meshIndex = 0;
+    auto indexPtr = indexData.data();
+    for (size_t i = 0; i < scene->mNumMeshes; i++)
     {
-        const auto normalMatrix = glm::transpose(glm::inverse(glm::mat3(modelTransformMatrix)));
-        for (size_t i = 0; i < scene->mNumMeshes; i++)
+        const auto meshPtr = scene->mMeshes[i];
+        if ((meshPtr->mPrimitiveTypes & aiPrimitiveType_TRIANGLE) == 0) {
+            continue;
+        }
+
+        const auto baseVertex = modelData.meshBaseVertices[meshIndex++];
+        const auto hasMeshTextureCoordinates = meshPtr->HasTextureCoords(0);
+        const auto hasMeshNormals = meshPtr->HasNormals();
+        for (size_t j = 0; j < meshPtr->mNumVertices; j++)
         {
-            const auto meshPtr = scene->mMeshes[i];
-            for (size_t j = 0; j < meshPtr->mNumFaces; j++)
+            const auto vertexIndex = baseVertex + j;
+            if (modelData.hasPositions)
             {
-                const auto& face = meshPtr->mFaces[j];
-                if (face.mNumIndices != 3) {
-                    continue; // Skip non-triangle faces for now
-                }
+                const auto& position = meshPtr->mVertices[j];
+                positionsPtr[vertexIndex] = glm::vec3(modelTransformMatrix * glm::vec4(position.x, position.y, position.z, 1.0f));
+            }
+
+            if (modelData.hasTextureCoordinates && hasMeshTextureCoordinates)
+            {
+                const auto& textureCoord = meshPtr->mTextureCoords[0][j];
+                textureCoordinatesPtr[vertexIndex] = glm::vec2(textureCoord.x, textureCoord.y);
+            }
+
+            if (modelData.hasNormals)
+            {
+                const auto& normal = hasMeshNormals ? meshPtr->mNormals[j] : aiVector3D(0.0f, 1.0f, 0.0f);
+                normalsPtr[vertexIndex] = glm::normalize(normalMatrix * glm::vec3(normal.x, normal.y, normal.z));
+            }
+        }
+
+        for (size_t j = 0; j < meshPtr->mNumFaces; j++)
+        {
+            const auto& face = meshPtr->mFaces[j];
+            if (face.mNumIndices != 3) {
+                continue; // Skip non-triangle faces for now
+            }
 
-                for (size_t k = 0; k < face.mNumIndices; k++)
+            for (size_t k = 0; k < face.mNumIndices; k++)
+            {
+                if (indexType == GL_UNSIGNED_SHORT)
                 {
-                    const auto& normal = meshPtr->HasNormals() ? meshPtr->mNormals[face.mIndices[k]] : aiVector3D(0.0f, 1.0f, 0.0f);
-                    _vbo.addData(glm::normalize(normalMatrix * glm::vec3(normal.x, normal.y, normal.z)));
+                    const auto index = static_cast<GLushort>(face.mIndices[k]);
+                    memcpy(indexPtr, &index, sizeof(GLushort));
+                }
+                else {
+                    memcpy(indexPtr, &face.mIndices[k], sizeof(GLuint));
                 }
+
+                indexPtr += indexByteSize;
             }
         }
     }
@@ -135,23 +358,238 @@ bool AssimpModel::loadModelFromFile(const std::string& filePath, const std::stri
         // On 64-bit version, some models report texture count 1 and then it crashes when getting them
         if (defaultTextureName.empty() && materialPtr->GetTextureCount(aiTextureType_DIFFUSE) > 0)
         {
-            if (materialPtr->GetTexture(aiTextureType_DIFFUSE, 0, &aiTexturePath) == AI_SUCCESS)
-            {
-                const std::string textureFileName = aiStringToStdString(aiTexturePath);
-                loadMaterialTexture(static_cast<int>(i), textureFileName);
+            if (materialPtr->GetTexture(aiTextureType_DIFFUSE, 0, &aiTexturePath) == AI_SUCCESS) {
+                modelData.materialTextureFileNames[static_cast<int>(i)] = aiStringToStdString(aiTexturePath);
             }
         }
     }
 
-    if (!defaultTextureName.empty()) {
-        loadMaterialTexture(0, defaultTextureName);
+    return true;
+}
+
+bool AssimpModel::loadModelFromCache(const std::string& cacheFilePath, uint64_t sourceHash, uint64_t importKeyHash, ModelData& modelData)
+{
+    auto& cacheFile = modelData.cacheFile;
+    if (!cacheFile.open(cacheFilePath) || cacheFile.getSize() < sizeof(MeshCacheHeader)) {
+        return false;
     }
 
-    _vbo.uploadDataToGPU(GL_STATIC_DRAW);
-    setVertexAttributesPointers(vertexCount);
-    _isInitialized = true;
+    const auto data = cacheFile.getData();
+    const auto fileSize = static_cast<uint64_t>(cacheFile.getSize());
+    MeshCacheHeader header;
+    memcpy(&header, data, sizeof(MeshCacheHeader));
 
-    return _isInitialized;
+    if (header.magic != MESH_CACHE_MAGIC || header.version != MESH_CACHE_VERSION
+        || header.sourceHash != sourceHash || header.importKeyHash != importKeyHash) {
+        return false;
+    }
+
+    // Validate all the ranges against the file size, so that corrupted cache can't make us read outside of it
+    const auto indexByteSize = header.indexType == GL_UNSIGNED_SHORT ? sizeof(GLushort) : sizeof(GLuint);
+    const auto meshRangesSize = static_cast<uint64_t>(header.numMeshes) * 4 * sizeof(int32_t);
+    if ((header.indexType != GL_UNSIGNED_SHORT && header.indexType != GL_UNSIGNED_INT)
+        || header.numVertices < 0 || header.numIndices < 0
+        || sizeof(MeshCacheHeader) + meshRangesSize > fileSize
+        || header.vertexDataSize != static_cast<uint64_t>(header.numVertices) * modelData.getVertexByteSize()
+        || header.indexDataSize != static_cast<uint64_t>(header.numIndices) * indexByteSize
+        || header.vertexDataOffset > fileSize || header.vertexDataSize > fileSize - header.vertexDataOffset
+        || header.indexDataOffset > fileSize || header.indexDataSize > fileSize - header.indexDataOffset)
+    {
+        LOG_WARN(Assets, "Mesh cache {} is corrupted, model will be imported again.", cacheFilePath);
+        return false;
+    }
+
+    // Mesh ranges must lie within the vertex and index data, otherwise draws would read outside of the buffers
+    std::vector<int32_t> meshRanges(header.numMeshes * 4);
+    memcpy(meshRanges.data(), data + sizeof(MeshCacheHeader), static_cast<size_t>(meshRangesSize));
+    for (size_t i = 0; i < header.numMeshes; i++)
+    {
+        const auto baseVertex = meshRanges[i * 4];
+        const auto startIndex = meshRanges[i * 4 + 1];
+        const auto indicesCount = meshRanges[i * 4 + 2];
+        if (baseVertex < 0 || baseVertex > header.numVertices || startIndex < 0 || indicesCount < 0
+            || static_cast<int64_t>(startIndex) + indicesCount > header.numIndices)
+        {
+            LOG_WARN(Assets, "Mesh cache {} is corrupted, model will be imported again.", cacheFilePath);
+            return false;
+        }
+
+        modelData.meshBaseVertices.push_back(meshRanges[i * 4]);
+        modelData.meshStartIndices.push_back(meshRanges[i * 4 + 1]);
+        modelData.meshIndicesCount.push_back(meshRanges[i * 4 + 2]);
+        modelData.meshMaterialIndices.push_back(meshRanges[i * 4 + 3]);
+    }
+
+    // Indices must point to existing vertices too, out of range index would make the GPU read outside of the vertex buffer
+    const auto indexData = data + header.indexDataOffset;
+    for (size_t i = 0; i < header.numMeshes; i++)
+    {
+        const auto baseVertex = modelData.meshBaseVertices[i];
+        const auto startIndex = modelData.meshStartIndices[i];
+        const auto indicesCount = modelData.meshIndicesCount[i];
+        const auto areIndicesValid = header.indexType == GL_UNSIGNED_SHORT
+            ? areMeshIndicesValid<GLushort>(indexData, startIndex, indicesCount, baseVertex, header.numVertices)
+            : areMeshIndicesValid<GLuint>(indexData, startIndex, indicesCount, baseVertex, header.numVertices);
+        if (!areIndicesValid)
+        {
+            LOG_WARN(Assets, "Mesh cache {} has indices out of range, model will be imported again.", cacheFilePath);
+            return false;
+        }
+    }
+
+    auto offset = header.materialTexturesOffset;
+    for (size_t i = 0; i < header.materialTexturesCount; i++)
+    {
+        int32_t materialIndex = 0;
+        uint32_t fileNameLength = 0;
+        if (offset > fileSize || fileSize - offset < sizeof(int32_t) + sizeof(uint32_t))
+        {
+            LOG_WARN(Assets, "Mesh cache {} is corrupted, model will be imported again.", cacheFilePath);
+            return false;
+        }
+
+        memcpy(&materialIndex, data + offset, sizeof(int32_t));
+        memcpy(&fileNameLength, data + offset + sizeof(int32_t), sizeof(uint32_t));
+        offset += sizeof(int32_t) + sizeof(uint32_t);
+        if (fileSize - offset < fileNameLength)
+        {
+            LOG_WARN(Assets, "Mesh cache {} is corrupted, model will be imported again.", cacheFilePath);
+            return false;
+        }
+
+        modelData.materialTextureFileNames[materialIndex] = std::string(reinterpret_cast<const char*>(data + offset), fileNameLength);
+        offset += fileNameLength;
+    }
+
+    modelData.indexType = header.indexType;
+    modelData.numVertices = header.numVertices;
+    modelData.numIndices = header.numIndices;
+    modelData.vertexDataPtr = data + header.vertexDataOffset;
+    modelData.vertexDataSize = static_cast<size_t>(header.vertexDataSize);
+    modelData.indexDataPtr = data + header.indexDataOffset;
+    modelData.indexDataSize = static_cast<size_t>(header.indexDataSize);
+
+    LOG_DEBUG(Assets, "Loaded model from mesh cache {}", cacheFilePath);
+    return true;
+}
+
+bool AssimpModel::saveModelToCache(const std::string& cacheFilePath, uint64_t sourceHash, uint64_t importKeyHash, const ModelData& modelData)
+{
+    const auto& vertexData = modelData.vertexData;
+    const auto& indexData = modelData.indexData;
+    const auto& materialTextureFileNames = modelData.materialTextureFileNames;
+    std::vector<int32_t> meshRanges;
+    for (size_t i = 0; i < modelData.meshStartIndices.size(); i++)
+    {
+        meshRanges.push_back(modelData.meshBaseVertices[i]);
+        meshRanges.push_back(modelData.meshStartIndices[i]);
+        meshRanges.push_back(modelData.meshIndicesCount[i]);
+        meshRanges.push_back(modelData.meshMaterialIndices[i]);
+    }
+
+    std::vector<unsigned char> materialTexturesData;
+    for (const auto& materialTextureFileName : materialTextureFileNames)
+    {
+        const auto materialIndex = static_cast<int32_t>(materialTextureFileName.first);
+        const auto fileNameLength = static_cast<uint32_t>(materialTextureFileName.second.size());
+        const auto materialIndexPtr = reinterpret_cast<const unsigned char*>(&materialIndex);
+        const auto fileNameLengthPtr = reinterpret_cast<const unsigned char*>(&fileNameLength);
+        materialTexturesData.insert(materialTexturesData.end(), materialIndexPtr, materialIndexPtr + sizeof(int32_t));
+        materialTexturesData.insert(materialTexturesData.end(), fileNameLengthPtr, fileNameLengthPtr + sizeof(uint32_t));
+        materialTexturesData.insert(materialTexturesData.end(), materialTextureFileName.second.begin(), materialTextureFileName.second.end());
+    }
+
+    // Vertex data start at 16-byte aligned offset, so that the mapped data are nicely aligned for upload
+    MeshCacheHeader header;
+    header.magic = MESH_CACHE_MAGIC;
+    header.version = MESH_CACHE_VERSION;
+    header.sourceHash = sourceHash;
+    header.importKeyHash = importKeyHash;
+    header.indexType = modelData.indexType;
+    header.numMeshes = static_cast<uint32_t>(modelData.meshStartIndices.size());
+    header.numVertices = modelData.numVertices;
+    header.numIndices = modelData.numIndices;
+    header.materialTexturesOffset = sizeof(MeshCacheHeader) + meshRanges.size() * sizeof(int32_t);
+    header.materialTexturesCount = materialTextureFileNames.size();
+    header.vertexDataOffset = (header.materialTexturesOffset + materialTexturesData.size() + 15) & ~static_cast<uint64_t>(15);
+    header.vertexDataSize = vertexData.size();
+    header.indexDataOffset = header.vertexDataOffset + header.vertexDataSize;
+    header.indexDataSize = indexData.size();
+
+    // Cache is written into a temporary file first, so that the model loaded at the same time (or a crash) never sees it half-written
+    const auto isWritten = file_utils::writeFileAtomically(cacheFilePath, [&](std::ostream& out)
+    {
+        const char padding[16] = {};
+        out.write(reinterpret_cast<const char*>(&header), sizeof(MeshCacheHeader));
+        out.write(reinterpret_cast<const char*>(meshRanges.data()), meshRanges.size() * sizeof(int32_t));
+        out.write(reinterpret_cast<const char*>(materialTexturesData.data()), materialTexturesData.size());
+        out.write(padding, header.vertexDataOffset - header.materialTexturesOffset - materialTexturesData.size());
+        out.write(reinterpret_cast<const char*>(vertexData.data()), vertexData.size());
+        out.write(reinterpret_cast<const char*>(indexData.data()), indexData.size());
+    });
+
+    if (!isWritten)
+    {
+        LOG_ERROR(Assets, "Failed to write mesh cache {}!", cacheFilePath);
+        return false;
+    }
+
+    LOG_DEBUG(Assets, "Saved mesh cache {}", cacheFilePath);
+    return true;
+}
+
+void AssimpModel::uploadModelData(const void* vertexData, size_t vertexDataSize, const void* indexData, size_t indexDataSize)
+{
+    // Positions are the first block of the vertex data, bounds come from them whether the data are imported or cached
+    _boundsMin = _boundsMax = glm::vec3(0.0f);
+    if (hasPositions() && _numVertices > 0)
+    {
+        const auto positionsPtr = static_cast<const glm::vec3*>(vertexData);
+        _boundsMin = _boundsMax = positionsPtr[0];
+        for (auto i = 1; i < _numVertices; i++)
+        {
+            _boundsMin = glm::min(_boundsMin, positionsPtr[i]);
+            _boundsMax = glm::max(_boundsMax, positionsPtr[i]);
+        }
+    }
+
+    glGenVertexArrays(1, &_vao);
+    GLStateCache::getInstance().bindVertexArray(_vao);
+
+    _vbo.createVBO();
+    _vbo.bindVBO();
+    _vbo.uploadDataToGPU(vertexData, vertexDataSize, GL_STATIC_DRAW);
+    setVertexAttributesPointers(_numVertices);
+
+    _indicesVBO.createVBO();
+    _indicesVBO.bindVBO(GL_ELEMENT_ARRAY_BUFFER);
+    _indicesVBO.uploadDataToGPU(indexData, indexDataSize, GL_STATIC_DRAW);
+}
+
+int AssimpModel::ModelData::getVertexByteSize() const
+{
+    int result = 0;
+    if (hasPositions) {
+        result += sizeof(glm::vec3);
+    }
+    if (hasTextureCoordinates) {
+        result += sizeof(glm::vec2);
+    }
+    if (hasNormals) {
+        result += sizeof(glm::vec3);
+    }
+
+    return result;
+}
+
+uint64_t AssimpModel::getImportKeyHash(const ModelData& modelData, const std::string& defaultTextureName, const glm::mat4& modelTransformMatrix)
+{
+    const auto importFlags = static_cast<uint32_t>(ASSIMP_IMPORT_FLAGS);
+    const bool importSettings[] = { modelData.hasPositions, modelData.hasTextureCoordinates, modelData.hasNormals, defaultTextureName.empty() };
+
+    auto hash = hash_utils::fnv1a(&importFlags, sizeof(uint32_t));
+    hash = hash_utils::fnv1a(importSettings, sizeof(importSettings), hash);
+    return hash_utils::fnv1a(&modelTransformMatrix[0][0], sizeof(glm::mat4), hash);
 }
 
 void AssimpModel::render() const
@@ -160,39 +598,102 @@ void AssimpModel::render() const
         return;
     }
 
-    glBindVertexArray(_vao);
+    GLStateCache::getInstance().bindVertexArray(_vao);
 
+    const auto& tm = TextureManager::getInstance();
     std::string lastUsedTextureKey = "";
     for(size_t i = 0; i < _meshStartIndices.size(); i++)
     {
         const auto usedMaterialIndex = _meshMaterialIndices[i];
         if (_materialTextureKeys.count(usedMaterialIndex) > 0)
         {
+            // Texture might still be loading asynchronously
             const auto textureKey = _materialTextureKeys.at(usedMaterialIndex);
-            if (textureKey != lastUsedTextureKey) {
-                TextureManager::getInstance().getTexture(textureKey).bind();
+            if (textureKey != lastUsedTextureKey && tm.containsTexture(textureKey)) {
+                tm.getTexture(textureKey).bind();
             }
 
             lastUsedTextureKey = textureKey;
         }
 
-        glDrawArrays(GL_TRIANGLES, _meshStartIndices[i], _meshVerticesCount[i]);
+        renderMesh(i);
     }
 }
 
-void AssimpModel::renderPoints() const
+void AssimpModel::submit(RenderQueue& renderQueue, RenderQueue::DrawPacket packet) const
 {
     if (!_isInitialized) {
         return;
     }
 
-    glBindVertexArray(_vao);
-    for (size_t i = 0; i < _meshStartIndices.size(); i++) {
-        glDrawArrays(GL_POINTS, _meshStartIndices[i], _meshVerticesCount[i]);
+    const auto& tm = TextureManager::getInstance();
+    packet.vao = _vao;
+    packet.draw = [](const void* drawObject, const uint64_t drawArgument) { static_cast<const AssimpModel*>(drawObject)->renderMesh(static_cast<size_t>(drawArgument)); };
+    packet.drawObject = this;
+    for (size_t i = 0; i < _meshStartIndices.size(); i++)
+    {
+        // Texture might still be loading asynchronously
+        auto meshPacket = packet;
+        const auto usedMaterialIndex = _meshMaterialIndices[i];
+        if (_materialTextureKeys.count(usedMaterialIndex) > 0)
+        {
+            const auto& textureKey = _materialTextureKeys.at(usedMaterialIndex);
+            if (tm.containsTexture(textureKey)) {
+                meshPacket.setTexture(0, GL_TEXTURE_2D, tm.getTexture(textureKey).getID());
+            }
+        }
+
+        meshPacket.drawArgument = i;
+        renderQueue.submit(meshPacket);
+    }
+}
+
+glm::vec3 AssimpModel::getBoundsMin() const
+{
+    return _boundsMin;
+}
+
+glm::vec3 AssimpModel::getBoundsMax() const
+{
+    return _boundsMax;
+}
+
+void AssimpModel::renderInstancedGeometry(const GLsizei numInstances) const
+{
+    const auto& tm = TextureManager::getInstance();
+    const auto indexByteSize = _indexType == GL_UNSIGNED_SHORT ? sizeof(GLushort) : sizeof(GLuint);
+    for (size_t i = 0; i < _meshStartIndices.size(); i++)
+    {
+        // Texture might still be loading asynchronously, state cache skips rebinding the same one
+        const auto usedMaterialIndex = _meshMaterialIndices[i];
+        if (_materialTextureKeys.count(usedMaterialIndex) > 0 && tm.containsTexture(_materialTextureKeys.at(usedMaterialIndex))) {
+            tm.getTexture(_materialTextureKeys.at(usedMaterialIndex)).bind();
+        }
+
+        const auto indicesOffset = reinterpret_cast<void*>(_meshStartIndices[i] * indexByteSize);
+        glDrawElementsInstancedBaseVertex(GL_TRIANGLES, _meshIndicesCount[i], _indexType, indicesOffset, numInstances, _meshBaseVertices[i]);
+    }
+}
+
+void AssimpModel::renderMesh(const size_t meshIndex) const
+{
+    const auto indexByteSize = _indexType == GL_UNSIGNED_SHORT ? sizeof(GLushort) : sizeof(GLuint);
+    const auto indicesOffset = reinterpret_cast<void*>(_meshStartIndices[meshIndex] * indexByteSize);
+    glDrawElementsBaseVertex(GL_TRIANGLES, _meshIndicesCount[meshIndex], _indexType, indicesOffset, _meshBaseVertices[meshIndex]);
+}
+
+void AssimpModel::renderPoints() const
+{
+    if (!_isInitialized) {
+        return;
     }
+
+    // Vertices are deduplicated, so every vertex is rendered exactly once
+    GLStateCache::getInstance().bindVertexArray(_vao);
+    glDrawArrays(GL_POINTS, 0, _numVertices);
 }
 
-void AssimpModel::loadMaterialTexture(const int materialIndex, const std::string& textureFileName)
+void AssimpModel::loadMaterialTexture(const int materialIndex, const std::string& textureFileName, bool loadAsync)
 {
     // If the texture with such path is already loaded, just use it and go on
     const auto fullTexturePath = _modelRootDirectoryPath + textureFileName;
@@ -205,7 +706,13 @@ void AssimpModel::loadMaterialTexture(const int materialIndex, const std::string
 
     // Otherwise load this texture and store it in the manager
     const auto newTextureKey = "assimp_" + fullTexturePath;
-    TextureManager::getInstance().loadTexture2D(newTextureKey, fullTexturePath);
+    if (loadAsync) {
+        TextureManager::getInstance().loadTexture2DAsync(newTextureKey, fullTexturePath);
+    }
+    else {
+        TextureManager::getInstance().loadTexture2D(newTextureKey, fullTexturePath);
+    }
+
     _materialTextureKeys[materialIndex] = newTextureKey;
 }
 
@@ -1,6 +1,7 @@
 // STL
-#include <iostream>
 #include <random>
+#include <algorithm>
+#include <limits>
 
 // GLM
 #include <glm/glm.hpp>
@@ -14,10 +15,15 @@
 #include "../includes/common_classes/textureManager.h"
 #include "../includes/common_classes/shaderManager.h"
 #include "../includes/common_classes/shaderProgramManager.h"
+#include "../includes/common_classes/instrumentation.h"
+#include "../includes/common_classes/logManager.h"
 
 namespace static_meshes_3D {
 
 const std::string Heightmap::MULTILAYER_SHADER_PROGRAM_KEY = "multilayer_heightmap";
+const int Heightmap::ENVIRONMENT_TEXTURE_UNIT = 15;
+const int Heightmap::SPLAT_WEIGHTS_ATTRIBUTE_INDEX = 3;
+const int Heightmap::CHUNK_SIZE = 32;
 
 Heightmap::Heightmap(const HillAlgorithmParameters& params, bool withPositions, bool withTextureCoordinates, bool withNormals)
     : StaticMeshIndexed3D(withPositions, withTextureCoordinates, withNormals)
@@ -33,14 +39,23 @@ Heightmap::Heightmap(const std::string& fileName, bool withPositions, bool withT
         return;
     }
 
-    stbi_set_flip_vertically_on_load(1);
-    int width, height, bytesPerPixel;
-    const auto imageData = stbi_load(fileName.c_str(), &width, &height, &bytesPerPixel, 0);
-    dim = glm::vec2(height, width);
-    stbi_image_free(imageData);
+    createFromHeightData(heightData);
+}
+
+Heightmap::Heightmap(const std::vector<std::vector<float>>& heightData, bool withPositions, bool withTextureCoordinates, bool withNormals)
+    : StaticMeshIndexed3D(withPositions, withTextureCoordinates, withNormals)
+{
+    if (heightData.size() == 0) {
+        return;
+    }
 
     createFromHeightData(heightData);
+}
 
+Heightmap::~Heightmap()
+{
+    // Super destructors don't reach the overridden deleteMesh, so splat weights are deleted here
+    _splatWeightsVBO.deleteVBO();
 }
 
 void Heightmap::prepareMultiLayerShaderProgram()
@@ -70,6 +85,7 @@ ShaderProgram& Heightmap::getMultiLayerShaderProgram()
 
 void Heightmap::createFromHeightData(const std::vector<std::vector<float>>& heightData)
 {
+    INSTRUMENT_ZONE("Heightmap::createFromHeightData");
     if (_isInitialized) {
         deleteMesh();
     }
@@ -78,10 +94,18 @@ void Heightmap::createFromHeightData(const std::vector<std::vector<float>>& heig
     _rows = static_cast<int>(_heightData.size());
     _columns = static_cast<int>(_heightData[0].size());
     _numVertices = _rows * _columns;
+    dim = glm::vec2(_rows, _columns);
+
+    // Wetness is kept when the mesh is rebuilt after erosion, so that the water trails stay visible
+    if (_wetness.size() != _heightData.size() || _wetness[0].size() != _heightData[0].size())
+    {
+        _wetness = std::vector<std::vector<float>>(_rows, std::vector<float>(_columns, 0.0f));
+        _erosionRunWetness = _wetness;
+    }
 
     // First, prepare VAO and VBO for vertex data
     glGenVertexArrays(1, &_vao);
-    glBindVertexArray(_vao);
+    GLStateCache::getInstance().bindVertexArray(_vao);
     _vbo.createVBO(_numVertices*getVertexByteSize()); // Preallocate memory
     _vbo.bindVBO();
 
@@ -104,6 +128,7 @@ void Heightmap::createFromHeightData(const std::vector<std::vector<float>>& heig
     // Send data to GPU, they're ready now
     _vbo.uploadDataToGPU(GL_STATIC_DRAW);
     setVertexAttributesPointers(_numVertices);
+    setUpSplatWeights();
 
     // Vertex data are in, set up the index buffer
     setUpIndexBuffer();
@@ -123,45 +148,123 @@ void Heightmap::render() const
         return;
     }
 
-    glBindVertexArray(_vao);
-    glEnable(GL_PRIMITIVE_RESTART);
+    GLStateCache::getInstance().bindVertexArray(_vao);
+    GLStateCache::getInstance().enable(GL_PRIMITIVE_RESTART);
     glPrimitiveRestartIndex(_primitiveRestartIndex);
 
     glDrawElements(GL_TRIANGLE_STRIP, _numIndices, GL_UNSIGNED_INT, 0);
-    glDisable(GL_PRIMITIVE_RESTART);
+    GLStateCache::getInstance().disable(GL_PRIMITIVE_RESTART);
 }
 
-void Heightmap::renderMultilayered(const std::vector<std::string>& textureKeys, const std::vector<float> levels) const
+void Heightmap::deleteMesh()
 {
-    if (!_isInitialized) {
-        return;
+    _splatWeightsVBO.deleteVBO();
+    StaticMeshIndexed3D::deleteMesh();
+}
+
+bool Heightmap::loadSplatLayers(const std::vector<std::string>& filePaths)
+{
+    if (filePaths.size() > static_cast<size_t>(MAX_SPLAT_LAYERS))
+    {
+        LOG_ERROR(Erosion, "Heightmap can't have {} splat layers, maximum is {}!", filePaths.size(), MAX_SPLAT_LAYERS);
+        return false;
+    }
+
+    _splatLayers.deleteTextureArray();
+    return _splatLayers.loadTextureArray(filePaths);
+}
+
+void Heightmap::setSplatParameters(const SplatParameters& splatParameters)
+{
+    _splatParameters = splatParameters;
+    if (_isInitialized) {
+        uploadSplatWeights();
     }
+}
 
-    // If there are less than 2 textures, does not even make sense to render heightmap in multilayer way
-    if (textureKeys.size() < 2) {
+void Heightmap::renderMultilayered() const
+{
+    if (!_isInitialized || !_splatLayers.isLoaded()) {
         return;
     }
 
-    // Number of levels defined must be correct
-    if ((textureKeys.size() - 1) * 2 != levels.size()) {
+    _splatLayers.bind(0);
+    setMultilayerUniforms();
+
+    // Finally render heightmap
+    render();
+}
+
+void Heightmap::submitMultilayered(RenderQueue& renderQueue, const glm::mat4& modelMatrix) const
+{
+    if (!_isInitialized || !_splatLayers.isLoaded()) {
         return;
     }
 
-    // Bind chosen textures first
-    const auto& tm = TextureManager::getInstance();
-    auto& heightmapShaderProgram = getMultiLayerShaderProgram();
-    for (auto i = 0; i < static_cast<int>(textureKeys.size()); i++)
+    auto packet = createMultilayeredPacket(modelMatrix);
+    packet.draw = [](const void* drawObject, uint64_t)
     {
-        tm.getTexture(textureKeys[i]).bind(i);
-        heightmapShaderProgram[Heightmap::ShaderConstants::terrainSampler(i)] = i;
+        setMultilayerUniforms();
+        static_cast<const Heightmap*>(drawObject)->render();
+    };
+    renderQueue.submit(packet);
+}
+
+const std::vector<Heightmap::Chunk>& Heightmap::getChunks() const
+{
+    return _chunks;
+}
+
+void Heightmap::renderChunk(const size_t chunkIndex) const
+{
+    if (!_isInitialized || chunkIndex >= _chunks.size()) {
+        return;
     }
 
-    // Set uniform levels
-    heightmapShaderProgram[Heightmap::ShaderConstants::numLevels()] = static_cast<int>(levels.size());
-    heightmapShaderProgram[Heightmap::ShaderConstants::levels()] = levels;
+    const auto& chunk = _chunks[chunkIndex];
+    GLStateCache::getInstance().bindVertexArray(_vao);
+    GLStateCache::getInstance().enable(GL_PRIMITIVE_RESTART);
+    glPrimitiveRestartIndex(_primitiveRestartIndex);
 
-    // Finally render heightmap
-    render();
+    glDrawElements(GL_TRIANGLE_STRIP, chunk.numIndices, GL_UNSIGNED_INT, reinterpret_cast<void*>(chunk.firstIndex * sizeof(GLuint)));
+    GLStateCache::getInstance().disable(GL_PRIMITIVE_RESTART);
+}
+
+RenderQueue::DrawPacket Heightmap::createMultilayeredChunkPacket(const glm::mat4& modelMatrix, const size_t chunkIndex) const
+{
+    if (!_isInitialized || !_splatLayers.isLoaded() || chunkIndex >= _chunks.size()) {
+        return RenderQueue::DrawPacket();
+    }
+
+    auto packet = createMultilayeredPacket(modelMatrix);
+    packet.draw = [](const void* drawObject, const uint64_t drawArgument)
+    {
+        setMultilayerUniforms();
+        static_cast<const Heightmap*>(drawObject)->renderChunk(static_cast<size_t>(drawArgument));
+    };
+    packet.drawArgument = chunkIndex;
+    return packet;
+}
+
+RenderQueue::DrawPacket Heightmap::createMultilayeredPacket(const glm::mat4& modelMatrix) const
+{
+    RenderQueue::DrawPacket packet;
+    packet.shaderProgram = &getMultiLayerShaderProgram();
+    packet.modelMatrix = modelMatrix;
+    packet.vao = _vao;
+    packet.drawObject = this;
+    packet.setTexture(0, GL_TEXTURE_2D_ARRAY, _splatLayers.getID());
+    packet.profileScope = "terrain";
+    return packet;
+}
+
+void Heightmap::setMultilayerUniforms()
+{
+    auto& heightmapShaderProgram = getMultiLayerShaderProgram();
+    heightmapShaderProgram[Heightmap::ShaderConstants::terrainLayers()] = 0;
+
+    // Cube map sampler must always point to its own unit, sampler types can't be mixed on the same unit
+    heightmapShaderProgram[Heightmap::ShaderConstants::environmentSampler()] = ENVIRONMENT_TEXTURE_UNIT;
 }
 
 void Heightmap::renderPoints() const
@@ -170,7 +273,7 @@ void Heightmap::renderPoints() const
         return;
     }
 
-    glBindVertexArray(_vao);
+    GLStateCache::getInstance().bindVertexArray(_vao);
 
     // Render points only
     glDrawArrays(GL_POINTS, 0, _numVertices);
@@ -252,20 +355,20 @@ std::vector<std::vector<float>> Heightmap::generateRandomHeightData(const HillAl
 
 std::vector<std::vector<float>> Heightmap::getHeightDataFromImage(const std::string& fileName)
 {
-    stbi_set_flip_vertically_on_load(1);
+    // Image is flipped vertically while reading the rows, global stbi flag can't be used safely from loading threads
     int width, height, bytesPerPixel;
     const auto imageData = stbi_load(fileName.c_str(), &width, &height, &bytesPerPixel, 0);
     if (imageData == nullptr)
     {
         // Return empty vector in case of failure
-        std::cout << "Failed to load heightmap image " << fileName << "!" << std::endl;
+        LOG_ERROR(Erosion, "Failed to load heightmap image {}!", fileName);
         return std::vector<std::vector<float>>();
     }
 
     std::vector<std::vector<float>> result(height, std::vector<float>(width));
-    auto pixelPtr = &imageData[0];
     for (auto i = 0; i < height; i++)
     {
+        auto pixelPtr = &imageData[static_cast<size_t>(height - 1 - i) * width * bytesPerPixel];
         for (auto j = 0; j < width; j++)
         {
             result[i][j] = static_cast<float>(*pixelPtr) / 255.0f;
@@ -378,25 +481,139 @@ void Heightmap::setUpIndexBuffer()
     _indicesVBO.createVBO();
     _indicesVBO.bindVBO(GL_ELEMENT_ARRAY_BUFFER);
     _primitiveRestartIndex = _numVertices;
+    _chunks.clear();
+    _numIndices = 0;
 
-    for (auto i = 0; i < _rows - 1; i++)
+    // Indices are laid out chunk by chunk, so every chunk is a continuous range, rendering all of them renders the whole terrain
+    for (auto chunkRow = 0; chunkRow < _rows - 1; chunkRow += CHUNK_SIZE)
     {
-        for (auto j = 0; j < _columns; j++)
+        for (auto chunkColumn = 0; chunkColumn < _columns - 1; chunkColumn += CHUNK_SIZE)
         {
-            for (auto k = 0; k < 2; k++)
+            const auto lastRow = std::min(chunkRow + CHUNK_SIZE, _rows - 1);
+            const auto lastColumn = std::min(chunkColumn + CHUNK_SIZE, _columns - 1);
+
+            Chunk chunk;
+            chunk.firstIndex = _numIndices;
+            chunk.boundsMin = glm::vec3(std::numeric_limits<float>::max());
+            chunk.boundsMax = glm::vec3(std::numeric_limits<float>::lowest());
+            for (auto i = chunkRow; i < lastRow; i++)
             {
-                const auto row = i + k;
-                const auto index = row * _columns + j;
-                _indicesVBO.addRawData(&index, sizeof(int));
+                for (auto j = chunkColumn; j <= lastColumn; j++)
+                {
+                    for (auto k = 0; k < 2; k++)
+                    {
+                        const auto row = i + k;
+                        const auto index = row * _columns + j;
+                        _indicesVBO.addRawData(&index, sizeof(int));
+
+                        // Same positions as in setUpVertices, they're computed here too as vertices may not be present
+                        const auto position = glm::vec3(-0.5f + static_cast<float>(j) / static_cast<float>(_columns - 1), _heightData[row][j],
+                            -0.5f + static_cast<float>(row) / static_cast<float>(_rows - 1));
+                        chunk.boundsMin = glm::min(chunk.boundsMin, position);
+                        chunk.boundsMax = glm::max(chunk.boundsMax, position);
+                    }
+                }
+                // Restart triangle strips
+                _indicesVBO.addRawData(&_primitiveRestartIndex, sizeof(int));
             }
+
+            chunk.numIndices = (lastRow - chunkRow) * ((lastColumn - chunkColumn + 1) * 2 + 1);
+            _numIndices += chunk.numIndices;
+            _chunks.push_back(chunk);
         }
-        // Restart triangle strips
-        _indicesVBO.addRawData(&_primitiveRestartIndex, sizeof(int));
     }
 
     _indicesVBO.uploadDataToGPU(GL_STATIC_DRAW);
+}
+
+void Heightmap::setUpSplatWeights()
+{
+    _splatWeightsVBO.createVBO(_numVertices * sizeof(glm::vec4));
+    uploadSplatWeights();
+
+    glEnableVertexAttribArray(SPLAT_WEIGHTS_ATTRIBUTE_INDEX);
+    glVertexAttribPointer(SPLAT_WEIGHTS_ATTRIBUTE_INDEX, 4, GL_FLOAT, GL_FALSE, sizeof(glm::vec4), reinterpret_cast<void*>(0));
+}
+
+void Heightmap::uploadSplatWeights()
+{
+    INSTRUMENT_ZONE("Heightmap::uploadSplatWeights");
+    // Weights are computed once per mesh update, so the fragment shader does just a fixed number of samples
+    std::vector<glm::vec4> splatWeights;
+    splatWeights.reserve(_numVertices);
+    for (auto i = 0; i < _rows; i++)
+    {
+        for (auto j = 0; j < _columns; j++) {
+            splatWeights.push_back(computeSplatWeights(i, j));
+        }
+    }
+
+    _splatWeightsVBO.bindVBO();
+    _splatWeightsVBO.uploadDataToGPU(splatWeights.data(), splatWeights.size() * sizeof(glm::vec4), GL_STATIC_DRAW);
+}
+
+glm::vec4 Heightmap::computeSplatWeights(const int row, const int column) const
+{
+    const auto& params = _splatParameters;
+    const auto height = _heightData[row][column];
+    const auto numLevels = static_cast<int>(params.levels.size());
+    const auto layerWeight = [](const int layer)
+    {
+        auto weight = glm::vec4(0.0f);
+        if (layer >= 0 && layer < MAX_SPLAT_LAYERS) {
+            weight[layer] = 1.0f;
+        }
+        return weight;
+    };
+
+    // Height levels are evaluated exactly as the old per-fragment loop did
+    auto weights = glm::vec4(0.0f);
+    auto isWeightSet = false;
+    for (auto i = 0; i < numLevels && !isWeightSet; i++)
+    {
+        if (height > params.levels[i]) {
+            continue;
+        }
+
+        const auto currentLayer = i / 2;
+        if (i % 2 == 0) {
+            weights = layerWeight(currentLayer);
+        }
+        else
+        {
+            const auto levelDiff = params.levels[i] - params.levels[i - 1];
+            const auto factorNext = levelDiff > 0.0f ? (height - params.levels[i - 1]) / levelDiff : 1.0f;
+            weights = layerWeight(currentLayer) * (1.0f - factorNext) + layerWeight(currentLayer + 1) * factorNext;
+        }
+
+        isWeightSet = true;
+    }
 
-    _numIndices = (_rows - 1)*_columns * 2 + _rows - 1;
+    if (!isWeightSet) {
+        weights = layerWeight(numLevels / 2);
+    }
+
+    // Steepness is taken from central differences of the heights, scaled to the rendered proportions
+    if (params.slopeLayer >= 0)
+    {
+        const auto rowPrev = std::max(row - 1, 0), rowNext = std::min(row + 1, _rows - 1);
+        const auto colPrev = std::max(column - 1, 0), colNext = std::min(column + 1, _columns - 1);
+        const auto dHeightX = colNext > colPrev ? (_heightData[row][colNext] - _heightData[row][colPrev]) * (_columns - 1) / (colNext - colPrev) : 0.0f;
+        const auto dHeightZ = rowNext > rowPrev ? (_heightData[rowNext][column] - _heightData[rowPrev][column]) * (_rows - 1) / (rowNext - rowPrev) : 0.0f;
+        const auto normal = glm::normalize(glm::vec3(-dHeightX * params.heightScale, 1.0f, -dHeightZ * params.heightScale));
+        const auto slopeFactor = glm::smoothstep(params.slopeStart, params.slopeEnd, 1.0f - normal.y);
+        weights = glm::mix(weights, layerWeight(params.slopeLayer), slopeFactor);
+    }
+
+    if (params.wetLayer >= 0 && params.wetnessSaturation > 0.0f)
+    {
+        const auto wetFactor = glm::clamp(_wetness[row][column] / params.wetnessSaturation, 0.0f, 1.0f);
+        weights = glm::mix(weights, layerWeight(params.wetLayer), wetFactor);
+    }
+
+    // Layers out of range get no weight, so renormalize to keep the brightness
+    const auto weightSum = weights.x + weights.y + weights.z + weights.w;
+    return weightSum > 0.0f ? weights / weightSum : glm::vec4(1.0f, 0.0f, 0.0f, 0.0f);
 }
 
 glm::vec3 Heightmap::surfaceNormal(int i, int j)
@@ -433,6 +650,8 @@ glm::vec3 Heightmap::surfaceNormal(int i, int j)
 
 void Heightmap::erode(int cycles)
 {
+    INSTRUMENT_ZONE("Heightmap::erode");
+    [[maybe_unused]] int64_t numSteps = 0; // Only read by the instrumentation counter
     for (int i = 0; i < cycles; i++)
     {
         glm::vec2 newpos = glm::vec2(rand() % (int)_heightData[0].size(), rand() % (int)_heightData.size());
@@ -440,6 +659,7 @@ void Heightmap::erode(int cycles)
 
         while (drop.volume > minVol)
         {
+            numSteps++;
 
             glm::ivec2 ipos = drop.pos;
             glm::vec3 n = surfaceNormal(ipos.x, ipos.y);
@@ -457,10 +677,32 @@ void Heightmap::erode(int cycles)
 
             drop.sediment += dt * depositionRate * sdiff;
             _heightData[ipos.x][ipos.y] -= dt * drop.volume * depositionRate * sdiff;
+            _erosionRunWetness[ipos.x][ipos.y] += drop.volume;
 
             drop.volume *= (1.0 - dt * evapRate);
         }
     }
+
+    // Water volume of the run is normalized by its maximum, so that wetness doesn't grow with every run. Older runs
+    // fade out, wet layer then covers only the trails, where the water keeps flowing
+    auto maxRunWetness = 0.0f;
+    for (const auto& row : _erosionRunWetness) {
+        maxRunWetness = std::max(maxRunWetness, *std::max_element(row.begin(), row.end()));
+    }
+
+    const auto runWetnessScale = maxRunWetness > 0.0f ? (1.0f - wetnessRetention) / maxRunWetness : 0.0f;
+    for (auto row = 0; row < _rows; row++)
+    {
+        for (auto column = 0; column < _columns; column++)
+        {
+            auto& runWetness = _erosionRunWetness[row][column];
+            _wetness[row][column] = _wetness[row][column] * wetnessRetention + runWetness * runWetnessScale;
+            runWetness = 0.0f;
+        }
+    }
+
+    INSTRUMENT_COUNTER(DropletsSimulated, cycles);
+    INSTRUMENT_COUNTER(DropletSteps, numSteps);
 }
 
 }
\ No newline at end of file
@@ -8,6 +8,7 @@
 #include "../includes/common_classes/textureManager.h"
 #include "../includes/common_classes/shaderManager.h"
 #include "../includes/common_classes/shaderProgramManager.h"
+#include "../includes/common_classes/logManager.h"
 
 namespace static_meshes_3D {
 
@@ -69,6 +70,13 @@ void HeightmapWithFog::renderMultilayered(const std::vector<std::string>& textur
         return;
     }
 
+    // Terrain textures take units below the environment cube map unit, sampler types can't be mixed on the same unit
+    if (textureKeys.size() > static_cast<size_t>(ENVIRONMENT_TEXTURE_UNIT))
+    {
+        LOG_WARN(Render, "Multilayered heightmap can use at most {} textures, {} have been given!", ENVIRONMENT_TEXTURE_UNIT, textureKeys.size());
+        return;
+    }
+
     // Number of levels defined must be correct
     if ((textureKeys.size() - 1) * 2 != levels.size()) {
         return;
@@ -80,12 +88,12 @@ void HeightmapWithFog::renderMultilayered(const std::vector<std::string>& textur
     for (auto i = 0; i < static_cast<int>(textureKeys.size()); i++)
     {
         tm.getTexture(textureKeys[i]).bind(i);
-        heightmapShaderProgram[Heightmap::ShaderConstants::terrainSampler(i)] = i;
+        heightmapShaderProgram[ShaderConstants::terrainSampler(i)] = i;
     }
 
     // Set uniform levels
-    heightmapShaderProgram[Heightmap::ShaderConstants::numLevels()] = static_cast<int>(levels.size());
-    heightmapShaderProgram[Heightmap::ShaderConstants::levels()] = levels;
+    heightmapShaderProgram[ShaderConstants::numLevels()] = static_cast<int>(levels.size());
+    heightmapShaderProgram[ShaderConstants::levels()] = levels;
 
     // Finally render heightmap
     render();
@@ -36,7 +36,7 @@ void PlainGround::render() const
         return;
     }
 
-    glBindVertexArray(_vao);
+    GLStateCache::getInstance().bindVertexArray(_vao);
     glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
 }
 
@@ -47,7 +47,7 @@ void PlainGround::initializeData()
     }
 
     glGenVertexArrays(1, &_vao);
-    glBindVertexArray(_vao);
+    GLStateCache::getInstance().bindVertexArray(_vao);
 
     const auto numVertices = 4;
     const auto vertexByteSize = getVertexByteSize();
@@ -50,17 +50,22 @@ void Cube::render() const
         return;
     }
 
-    glBindVertexArray(_vao);
+    GLStateCache::getInstance().bindVertexArray(_vao);
     glDrawArrays(GL_TRIANGLES, 0, 36);
 }
 
+void Cube::renderInstancedGeometry(const GLsizei numInstances) const
+{
+    glDrawArraysInstanced(GL_TRIANGLES, 0, 36, numInstances);
+}
+
 void Cube::renderPoints() const
 {
     if (!_isInitialized) {
         return;
     }
 
-    glBindVertexArray(_vao);
+    GLStateCache::getInstance().bindVertexArray(_vao);
     glDrawArrays(GL_POINTS, 0, 36);
 }
 
@@ -70,7 +75,7 @@ void Cube::renderFaces(int facesBitmask) const
         return;
     }
 
-    glBindVertexArray(_vao);
+    GLStateCache::getInstance().bindVertexArray(_vao);
 
     if (facesBitmask & CUBE_FRONT_FACE) {
         glDrawArrays(GL_TRIANGLES, 0, 6);
@@ -99,7 +104,7 @@ void Cube::initializeData()
     }
 
     glGenVertexArrays(1, &_vao);
-    glBindVertexArray(_vao);
+    GLStateCache::getInstance().bindVertexArray(_vao);
 
     const auto numVertices = 36;
     const auto vertexByteSize = getVertexByteSize();
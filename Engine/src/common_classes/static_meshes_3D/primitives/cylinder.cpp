@@ -47,7 +47,7 @@ void Cylinder::initializeData()
 
     // Generate VAO and VBO for vertex attributes
     glGenVertexArrays(1, &_vao);
-    glBindVertexArray(_vao);
+    GLStateCache::getInstance().bindVertexArray(_vao);
     _vbo.createVBO(getVertexByteSize() * _numVerticesTotal);
 
     // Pre-calculate sines / cosines for given number of slices
@@ -159,7 +159,7 @@ void Cylinder::render() const
         return;
     }
 
-    glBindVertexArray(_vao);
+    GLStateCache::getInstance().bindVertexArray(_vao);
 
     // Render cylinder side first
     glDrawArrays(GL_TRIANGLE_STRIP, 0, _numVerticesSide);
@@ -171,6 +171,13 @@ void Cylinder::render() const
     glDrawArrays(GL_TRIANGLE_FAN, _numVerticesSide + _numVerticesTopBottom, _numVerticesTopBottom);
 }
 
+void Cylinder::renderInstancedGeometry(const GLsizei numInstances) const
+{
+    glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, _numVerticesSide, numInstances);
+    glDrawArraysInstanced(GL_TRIANGLE_FAN, _numVerticesSide, _numVerticesTopBottom, numInstances);
+    glDrawArraysInstanced(GL_TRIANGLE_FAN, _numVerticesSide + _numVerticesTopBottom, _numVerticesTopBottom, numInstances);
+}
+
 void Cylinder::renderPoints() const
 {
     if (!_isInitialized) {
@@ -178,7 +185,7 @@ void Cylinder::renderPoints() const
     }
 
     // Just render all points as they are stored in the VBO
-    glBindVertexArray(_vao);
+    GLStateCache::getInstance().bindVertexArray(_vao);
     glDrawArrays(GL_POINTS, 0, _numVerticesTotal);
 }
 
@@ -35,17 +35,22 @@ void Pyramid::render() const
 		return;
 	}
 
-	glBindVertexArray(_vao);
+	GLStateCache::getInstance().bindVertexArray(_vao);
 	glDrawArrays(GL_TRIANGLES, 0, 12);
 }
 
+void Pyramid::renderInstancedGeometry(const GLsizei numInstances) const
+{
+	glDrawArraysInstanced(GL_TRIANGLES, 0, 12, numInstances);
+}
+
 void Pyramid::renderPoints() const
 {
 	if (!_isInitialized) {
 		return;
 	}
 
-	glBindVertexArray(_vao);
+	GLStateCache::getInstance().bindVertexArray(_vao);
 	glDrawArrays(GL_POINTS, 0, 12);
 }
 
@@ -56,7 +61,7 @@ void Pyramid::initializeData()
 	}
 
 	glGenVertexArrays(1, &_vao);
-	glBindVertexArray(_vao);
+	GLStateCache::getInstance().bindVertexArray(_vao);
 
 	const auto numVertices = 12;
     const auto vertexByteSize = getVertexByteSize();	
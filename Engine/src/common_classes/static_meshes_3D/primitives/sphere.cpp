@@ -31,9 +31,9 @@ void Sphere::render() const
         return;
     }
 
-    glBindVertexArray(_vao);
+    GLStateCache::getInstance().bindVertexArray(_vao);
 
-    glEnable(GL_PRIMITIVE_RESTART);
+    GLStateCache::getInstance().enable(GL_PRIMITIVE_RESTART);
     glPrimitiveRestartIndex(_primitiveRestartIndex);
     
     // Render north pole
@@ -46,7 +46,18 @@ void Sphere::render() const
     glDrawElements(GL_TRIANGLES, _numPoleIndices, GL_UNSIGNED_INT, (void*)(sizeof(GLuint)*_southPoleIndexOffset));
 
     // Disable primitive restart, we won't need it now
-    glDisable(GL_PRIMITIVE_RESTART);
+    GLStateCache::getInstance().disable(GL_PRIMITIVE_RESTART);
+}
+
+void Sphere::renderInstancedGeometry(const GLsizei numInstances) const
+{
+    auto& gsc = GLStateCache::getInstance();
+    gsc.enable(GL_PRIMITIVE_RESTART);
+    glPrimitiveRestartIndex(_primitiveRestartIndex);
+    glDrawElementsInstanced(GL_TRIANGLES, _numPoleIndices, GL_UNSIGNED_INT, (void*)(sizeof(GLuint)*_northPoleIndexOffset), numInstances);
+    glDrawElementsInstanced(GL_TRIANGLE_STRIP, _numBodyIndices, GL_UNSIGNED_INT, (void*)(sizeof(GLuint)*_bodyIndexOffset), numInstances);
+    glDrawElementsInstanced(GL_TRIANGLES, _numPoleIndices, GL_UNSIGNED_INT, (void*)(sizeof(GLuint)*_southPoleIndexOffset), numInstances);
+    gsc.disable(GL_PRIMITIVE_RESTART);
 }
 
 void Sphere::renderPoints() const
@@ -55,7 +66,7 @@ void Sphere::renderPoints() const
         return;
     }
 
-    glBindVertexArray(_vao);
+    GLStateCache::getInstance().bindVertexArray(_vao);
     glDrawArrays(GL_POINTS, 0, _numVertices);
 }
 
@@ -102,7 +113,7 @@ void Sphere::initializeData()
 
     // Generate VAO and VBOs for vertex attributes and indices
     glGenVertexArrays(1, &_vao);
-    glBindVertexArray(_vao);
+    GLStateCache::getInstance().bindVertexArray(_vao);
     _vbo.createVBO(getVertexByteSize() * _numVertices);
     _indicesVBO.createVBO(sizeof(GLuint) * _numIndices);
 
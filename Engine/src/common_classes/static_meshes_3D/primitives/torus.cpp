@@ -29,7 +29,7 @@ void Torus::initializeData()
 
     // Generate VAO and VBOs for vertex attributes and indices
     glGenVertexArrays(1, &_vao);
-    glBindVertexArray(_vao);
+    GLStateCache::getInstance().bindVertexArray(_vao);
     _vbo.createVBO(getVertexByteSize() * _numVertices);
     _indicesVBO.createVBO(sizeof(GLuint)*_numIndices);
 
@@ -160,16 +160,25 @@ void Torus::render() const
         return;
     }
 
-    glBindVertexArray(_vao);
+    GLStateCache::getInstance().bindVertexArray(_vao);
     // Enable primitive restart, because we're rendering several triangle strips (for each main segment)
-    glEnable(GL_PRIMITIVE_RESTART);
+    GLStateCache::getInstance().enable(GL_PRIMITIVE_RESTART);
     glPrimitiveRestartIndex(_primitiveRestartIndex);
 
     // Render torus using precalculated indices
     glDrawElements(GL_TRIANGLE_STRIP, _numIndices, GL_UNSIGNED_INT, 0);
 
     // Disable primitive restart, we won't need it now
-    glDisable(GL_PRIMITIVE_RESTART);
+    GLStateCache::getInstance().disable(GL_PRIMITIVE_RESTART);
+}
+
+void Torus::renderInstancedGeometry(const GLsizei numInstances) const
+{
+    auto& gsc = GLStateCache::getInstance();
+    gsc.enable(GL_PRIMITIVE_RESTART);
+    glPrimitiveRestartIndex(_primitiveRestartIndex);
+    glDrawElementsInstanced(GL_TRIANGLE_STRIP, _numIndices, GL_UNSIGNED_INT, 0, numInstances);
+    gsc.disable(GL_PRIMITIVE_RESTART);
 }
 
 void Torus::renderPoints() const
@@ -178,7 +187,7 @@ void Torus::renderPoints() const
         return;
     }
 
-    glBindVertexArray(_vao);
+    GLStateCache::getInstance().bindVertexArray(_vao);
 
     // Render torus points only
     glDrawArrays(GL_POINTS, 0, _numVertices);
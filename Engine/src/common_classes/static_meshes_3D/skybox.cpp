@@ -1,5 +1,6 @@
 // STL
 #include <mutex>
+#include <cstring>
 
 // GLM
 #include <glm/gtc/matrix_transform.hpp>
@@ -7,149 +8,198 @@
 // Project
 #include "../includes/common_classes/static_meshes_3D/skybox.h"
 
-#include "../includes/common_classes/textureManager.h"
+#include "../includes/common_classes/asyncAssetLoader.h"
 #include "../includes/common_classes/samplerManager.h"
+#include "../includes/common_classes/shaderManager.h"
 #include "../includes/common_classes/shaderProgramManager.h"
+#include "../includes/common_classes/glStateCache.h"
+#include "../includes/common_classes/logManager.h"
 
 namespace static_meshes_3D {
 
 const std::string Skybox::SAMPLER_KEY = "skybox";
+const std::string Skybox::SHADER_PROGRAM_KEY = "skybox";
+
+namespace {
+
+/**
+ * Flips all mip levels of the image vertically. Decoded images have rows ordered bottom to top,
+ * but cube map faces are expected to have them top to bottom.
+ */
+void flipImageVertically(Texture::ImageData& imageData)
+{
+    for (const auto& mipLevel : imageData.mipLevels)
+    {
+        const auto rowByteSize = mipLevel.size / mipLevel.height;
+        std::vector<unsigned char> rowBuffer(rowByteSize);
+        auto levelPixels = imageData.pixels.data() + mipLevel.offset;
+        for (auto row = 0; row < mipLevel.height / 2; row++)
+        {
+            const auto topRow = levelPixels + rowByteSize * row;
+            const auto bottomRow = levelPixels + rowByteSize * (mipLevel.height - 1 - row);
+            memcpy(rowBuffer.data(), topRow, rowByteSize);
+            memcpy(topRow, bottomRow, rowByteSize);
+            memcpy(bottomRow, rowBuffer.data(), rowByteSize);
+        }
+    }
+}
+
+} // namespace
 
 Skybox::Skybox(const std::string& baseDirectory, const std::string& imageExtension, bool withPositions, bool withTextureCoordinates, bool withNormals)
     : Cube(withPositions, withTextureCoordinates, withNormals)
     , _baseDirectory(baseDirectory)
     , _imageExtension(imageExtension)
+    , _loadingState(std::make_shared<CubeMapLoadingState>())
 {
-    tryLoadTexture(CUBE_FRONT_FACE);
-    tryLoadTexture(CUBE_BACK_FACE);
-    tryLoadTexture(CUBE_LEFT_FACE);
-    tryLoadTexture(CUBE_RIGHT_FACE);
-    tryLoadTexture(CUBE_TOP_FACE);
-    tryLoadTexture(CUBE_BOTTOM_FACE);
-
     static std::once_flag prepareOnceFlag;
     std::call_once(prepareOnceFlag, []()
     {
         auto& sm = SamplerManager::getInstance();
         auto& sampler = sm.createSampler(SAMPLER_KEY, MAG_FILTER_BILINEAR, MIN_FILTER_TRILINEAR);
         sampler.setRepeat(false);
+
+        // Filter across the face edges, so that the seams of the cube aren't visible
+        GLStateCache::getInstance().enable(GL_TEXTURE_CUBE_MAP_SEAMLESS);
     });
+
+    // Every face is decoded on its own worker thread, the last one to finish creates the cube map on the context thread
+    auto& aal = AsyncAssetLoader::getInstance();
+    for (auto faceIndex = 0; faceIndex < 6; faceIndex++)
+    {
+        const auto fileName = getFaceFileName(faceIndex);
+        const auto loadingState = _loadingState;
+        aal.submitWorkerTask([this, faceIndex, fileName, loadingState]()
+        {
+            auto& face = loadingState->faces[faceIndex];
+            if (Texture::decodeImage(fileName, face))
+            {
+                flipImageVertically(face);
+                loadingState->isFaceDecoded[faceIndex] = true;
+            }
+
+            std::lock_guard<std::mutex> lock(loadingState->mutex);
+            if (--loadingState->numFacesRemaining > 0) {
+                return;
+            }
+
+            AsyncAssetLoader::getInstance().submitContextTask([this, loadingState]()
+            {
+                if (!loadingState->isCancelled) {
+                    createCubeMap(*loadingState);
+                }
+            });
+        });
+    }
 }
 
 Skybox::~Skybox()
 {
-    auto& tm = TextureManager::getInstance();
-    tm.deleteTexture(getTextureKey(CUBE_FRONT_FACE));
-    tm.deleteTexture(getTextureKey(CUBE_BACK_FACE));
-    tm.deleteTexture(getTextureKey(CUBE_LEFT_FACE));
-    tm.deleteTexture(getTextureKey(CUBE_RIGHT_FACE));
-    tm.deleteTexture(getTextureKey(CUBE_TOP_FACE));
-    tm.deleteTexture(getTextureKey(CUBE_BOTTOM_FACE));
+    _loadingState->isCancelled = true;
+    if (_cubeMapTextureID != 0) {
+        glDeleteTextures(1, &_cubeMapTextureID);
+        GLStateCache::getInstance().onTextureDeleted(_cubeMapTextureID);
+    }
 }
 
-void Skybox::render(const glm::vec3& renderPosition, ShaderProgram& shaderProgram) const
+void Skybox::prepareShaderProgram()
 {
-    // Get all texture keys
-    const auto frontKey = getTextureKey(CUBE_FRONT_FACE);
-    const auto backKey = getTextureKey(CUBE_BACK_FACE);
-    const auto leftKey = getTextureKey(CUBE_LEFT_FACE);
-    const auto rightKey = getTextureKey(CUBE_RIGHT_FACE);
-    const auto topKey = getTextureKey(CUBE_TOP_FACE);
-    const auto bottomKey = getTextureKey(CUBE_BOTTOM_FACE);
-    auto& tm = TextureManager::getInstance();
-    const auto& sampler = SamplerManager::getInstance().getSampler(SAMPLER_KEY);
-    sampler.bind();
-
-    // Turn off depth mask (don't write to depth buffer)
-    glDepthMask(GL_FALSE);
-
-    // Enlarge default cube by some factor, that's not further then far clipping plane (100 is fine)
-    auto skyboxModelMatrix = glm::translate(glm::mat4(1.0f), renderPosition);
-    skyboxModelMatrix = glm::scale(skyboxModelMatrix, glm::vec3(900.0f, 900.0f, 900.0f));
-    shaderProgram.setModelAndNormalMatrix(skyboxModelMatrix);
-
-    // Render front side if texture has been loaded
-    if (tm.containsTexture(frontKey))
-    {
-        tm.getTexture(frontKey).bind();
-        renderFaces(CUBE_FRONT_FACE);
-    }
+    auto& sm = ShaderManager::getInstance();
+    sm.loadVertexShader(SHADER_PROGRAM_KEY, "../../Engine/data/shaders/skybox/skybox.vert");
+    sm.loadFragmentShader(SHADER_PROGRAM_KEY, "../../Engine/data/shaders/skybox/skybox.frag");
 
-    // Render back side if texture has been loaded
-    if (tm.containsTexture(backKey))
-    {
-        tm.getTexture(backKey).bind();
-        renderFaces(CUBE_BACK_FACE);
-    }
+    auto& skyboxShaderProgram = ShaderProgramManager::getInstance().createShaderProgram(SHADER_PROGRAM_KEY);
+    skyboxShaderProgram.addShaderToProgram(sm.getVertexShader(SHADER_PROGRAM_KEY));
+    skyboxShaderProgram.addShaderToProgram(sm.getFragmentShader(SHADER_PROGRAM_KEY));
+}
 
-    // Render left side if texture has been loaded
-    if (tm.containsTexture(leftKey))
-    {
-        tm.getTexture(leftKey).bind();
-        renderFaces(CUBE_LEFT_FACE);
-    }
+ShaderProgram& Skybox::getShaderProgram()
+{
+    return ShaderProgramManager::getInstance().getShaderProgram(SHADER_PROGRAM_KEY);
+}
 
-    // Render right side if texture has been loaded
-    if (tm.containsTexture(rightKey))
-    {
-        tm.getTexture(rightKey).bind();
-        renderFaces(CUBE_RIGHT_FACE);
+void Skybox::render(const glm::vec4& color) const
+{
+    if (!isLoaded()) {
+        return;
     }
 
-    // Render top side if texture has been loaded
-    if (tm.containsTexture(topKey))
-    {
-        tm.getTexture(topKey).bind();
-        renderFaces(CUBE_TOP_FACE);
-    }
+    // Only rotation of the camera matters, shader removes translation from the view matrix
+    auto& skyboxShaderProgram = getShaderProgram();
+    skyboxShaderProgram.useProgram();
+    skyboxShaderProgram[::ShaderConstants::color()] = color;
+    skyboxShaderProgram[ShaderConstants::skyboxSampler()] = 0;
+    bindCubeMap(0);
+
+    // Skybox is at the far plane (depth 1.0), so it passes only where nothing has been rendered yet.
+    // It doesn't have to write to depth buffer at all
+    auto& gsc = GLStateCache::getInstance();
+    const auto previousDepthFunc = gsc.getDepthFunc();
+    const auto wasDepthMaskEnabled = gsc.isDepthMaskEnabled();
+    gsc.depthMask(false);
+    gsc.depthFunc(GL_LEQUAL);
+
+    Cube::render();
+
+    gsc.depthFunc(previousDepthFunc);
+    gsc.depthMask(wasDepthMaskEnabled);
+}
 
-    // Render bottom side if texture has been loaded
-    if (tm.containsTexture(bottomKey))
-    {
-        tm.getTexture(bottomKey).bind();
-        renderFaces(CUBE_BOTTOM_FACE);
+void Skybox::bindCubeMap(GLenum textureUnit) const
+{
+    if (!isLoaded()) {
+        return;
     }
 
-    // Turn the depth mask back on
-    glDepthMask(GL_TRUE);
+    GLStateCache::getInstance().bindTextureToUnit(textureUnit, GL_TEXTURE_CUBE_MAP, _cubeMapTextureID);
+    SamplerManager::getInstance().getSampler(SAMPLER_KEY).bind(textureUnit);
 }
 
-std::string Skybox::getSideFileName(const int sideBit)
+bool Skybox::isLoaded() const
 {
-    if (sideBit & CUBE_FRONT_FACE) {
-        return "front";
-    }
-    else if (sideBit & CUBE_BACK_FACE) {
-        return "back";
-    }
-    else if (sideBit & CUBE_LEFT_FACE) {
-        return "left";
-    }
-    else if (sideBit & CUBE_RIGHT_FACE) {
-        return "right";
-    }
-    else if (sideBit & CUBE_TOP_FACE) {
-        return "top";
-    }
-
-    return "bottom";
+    return _cubeMapTextureID != 0;
 }
 
-std::string Skybox::getTextureKey(const int sideBit) const
+std::string Skybox::getFaceFileName(int faceIndex) const
 {
-    return _baseDirectory + "/" + getSideFileName(sideBit);
+    // Order of GL_TEXTURE_CUBE_MAP_POSITIVE_X, NEGATIVE_X, POSITIVE_Y, NEGATIVE_Y, POSITIVE_Z, NEGATIVE_Z
+    static const std::string faceNames[6] = { "right", "left", "top", "bottom", "front", "back" };
+    return _baseDirectory + "/" + faceNames[faceIndex] + "." + _imageExtension;
 }
 
-void Skybox::tryLoadTexture(const int sideBit) const
+void Skybox::createCubeMap(const CubeMapLoadingState& loadingState)
 {
-    const auto key = getTextureKey(sideBit);
-    const auto fileName = key + "." + _imageExtension;
-    try
+    // All the faces must be present and have the same size and format
+    const auto& firstFace = loadingState.faces[0];
+    for (auto faceIndex = 0; faceIndex < 6; faceIndex++)
     {
-        auto& tm = TextureManager::getInstance();
-        tm.loadTexture2D(key, fileName);
+        const auto& face = loadingState.faces[faceIndex];
+        if (!loadingState.isFaceDecoded[faceIndex] || face.width != firstFace.width || face.height != firstFace.height || face.format != firstFace.format)
+        {
+            LOG_ERROR(Assets, "Could not create skybox cube map from {}, face {} is missing or doesn't match the others!", _baseDirectory, getFaceFileName(faceIndex));
+            return;
+        }
     }
-    catch (const std::runtime_error&) {}
+
+    glGenTextures(1, &_cubeMapTextureID);
+    GLStateCache::getInstance().bindTexture(GL_TEXTURE_CUBE_MAP, _cubeMapTextureID);
+    glTexStorage2D(GL_TEXTURE_CUBE_MAP, static_cast<GLsizei>(firstFace.mipLevels.size()), Texture::getSizedInternalFormat(firstFace.format), firstFace.width, firstFace.height);
+
+    GLint previousUnpackAlignment;
+    glGetIntegerv(GL_UNPACK_ALIGNMENT, &previousUnpackAlignment);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    for (auto faceIndex = 0; faceIndex < 6; faceIndex++)
+    {
+        const auto& face = loadingState.faces[faceIndex];
+        for (size_t level = 0; level < face.mipLevels.size(); level++)
+        {
+            const auto& mipLevel = face.mipLevels[level];
+            glTexSubImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + faceIndex, static_cast<GLint>(level), 0, 0, mipLevel.width, mipLevel.height,
+                face.format, GL_UNSIGNED_BYTE, face.pixels.data() + mipLevel.offset);
+        }
+    }
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, previousUnpackAlignment);
 }
 
-} // namespace static_meshes_3D
\ No newline at end of file
+} // namespace static_meshes_3D
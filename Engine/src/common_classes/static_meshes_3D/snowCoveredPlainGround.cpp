@@ -11,7 +11,6 @@
 #include "../includes/common_classes/shaderProgramManager.h"
 #include "../includes/common_classes/textureManager.h"
 #include "../includes/common_classes/samplerManager.h"
-#include "../includes/common_classes/matrixManager.h"
 
 namespace static_meshes_3D {
 
@@ -43,10 +42,7 @@ void SnowCoveredPlainGround::render() const
     const auto& groundSampler = SamplerManager::getInstance().getSampler("main");
     groundProgram.useProgram();
 
-    groundProgram[ShaderConstants::projectionMatrix()] = MatrixManager::getInstance().getProjectionMatrix();
-    groundProgram[ShaderConstants::viewMatrix()] = MatrixManager::getInstance().getViewMatrix();
-
-    // Render ground
+    // Render ground, camera matrices come from the frame constants uniform block
     groundProgram[ShaderConstants::modelMatrix()] = glm::mat4(1.0);
 
     // Setup snow texture
@@ -3,12 +3,14 @@
 
 // Project
 #include "../includes/common_classes/static_meshes_3D/staticMesh3D.h"
+#include "../includes/common_classes/logManager.h"
 
 namespace static_meshes_3D {
 
 const int StaticMesh3D::POSITION_ATTRIBUTE_INDEX           = 0;
 const int StaticMesh3D::TEXTURE_COORDINATE_ATTRIBUTE_INDEX = 1;
 const int StaticMesh3D::NORMAL_ATTRIBUTE_INDEX             = 2;
+const int StaticMesh3D::INSTANCE_MATRIX_ATTRIBUTE_INDEX    = 4;
 
 StaticMesh3D::StaticMesh3D(bool withPositions, bool withTextureCoordinates, bool withNormals)
     : _hasPositions(withPositions)
@@ -27,11 +29,81 @@ void StaticMesh3D::deleteMesh()
     }
 
     glDeleteVertexArrays(1, &_vao);
+    GLStateCache::getInstance().onVertexArrayDeleted(_vao);
     _vbo.deleteVBO();
+    _instanceVBO.deleteVBO();
 
     _isInitialized = false;
 }
 
+void StaticMesh3D::renderInstanced(const glm::mat4* modelMatrices, const size_t numInstances) const
+{
+    if (!_isInitialized || numInstances == 0) {
+        return;
+    }
+
+    auto& gsc = GLStateCache::getInstance();
+    gsc.bindVertexArray(_vao);
+
+    // Instance buffer is created lazily, matrix occupies four consecutive vec4 attributes advancing once per instance
+    if (_instanceVBO.getBufferID() == 0)
+    {
+        _instanceVBO.createVBO(sizeof(glm::mat4) * numInstances);
+        _instanceVBO.bindVBO();
+        for (auto column = 0; column < 4; column++)
+        {
+            const auto attributeIndex = INSTANCE_MATRIX_ATTRIBUTE_INDEX + column;
+            glEnableVertexAttribArray(attributeIndex);
+            glVertexAttribPointer(attributeIndex, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), reinterpret_cast<void*>(sizeof(glm::vec4) * column));
+            glVertexAttribDivisor(attributeIndex, 1);
+        }
+    }
+
+    // Whole buffer is respecified every time, so the driver can orphan the old storage instead of waiting for previous draws
+    _instanceVBO.bindVBO();
+    _instanceVBO.uploadDataToGPU(modelMatrices, sizeof(glm::mat4) * numInstances, GL_STREAM_DRAW);
+    renderInstancedGeometry(static_cast<GLsizei>(numInstances));
+}
+
+void StaticMesh3D::renderInstanced(const std::vector<glm::mat4>& modelMatrices) const
+{
+    renderInstanced(modelMatrices.data(), modelMatrices.size());
+}
+
+void StaticMesh3D::renderInstancedGeometry(GLsizei numInstances) const
+{
+    // Instanced rendering is usually attempted every frame, so it's reported just once
+    if (!_isUnsupportedInstancingReported)
+    {
+        LOG_WARN(Render, "Static mesh with VAO #{} doesn't support instanced rendering, its {} instances are not rendered!", _vao, numInstances);
+        _isUnsupportedInstancingReported = true;
+    }
+}
+
+void StaticMesh3D::submit(RenderQueue& renderQueue, RenderQueue::DrawPacket packet) const
+{
+    if (!_isInitialized) {
+        return;
+    }
+
+    packet.vao = _vao;
+    packet.draw = [](const void* drawObject, uint64_t) { static_cast<const StaticMesh3D*>(drawObject)->render(); };
+    packet.drawObject = this;
+    renderQueue.submit(packet);
+}
+
+void StaticMesh3D::submitPoints(RenderQueue& renderQueue, RenderQueue::DrawPacket packet) const
+{
+    if (!_isInitialized) {
+        return;
+    }
+
+    packet.vao = _vao;
+    packet.draw = [](const void* drawObject, uint64_t) { static_cast<const StaticMesh3D*>(drawObject)->renderPoints(); };
+    packet.drawObject = this;
+    renderQueue.submit(packet);
+}
+
 bool StaticMesh3D::hasPositions() const
 {
     return _hasPositions;
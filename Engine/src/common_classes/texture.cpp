@@ -1,6 +1,8 @@
 // STL
-#include <iostream>
+#include <fstream>
 #include <mutex>
+#include <cstring>
+#include <algorithm>
 
 // STB
 #define STB_IMAGE_IMPLEMENTATION
@@ -8,6 +10,70 @@
 
 // Project
 #include "../includes/common_classes/texture.h"
+#include "../includes/common_classes/memoryMappedFile.h"
+#include "../includes/common_classes/hashUtils.h"
+#include "../includes/common_classes/fileUtils.h"
+#include "../includes/common_classes/glStateCache.h"
+#include "../includes/common_classes/logManager.h"
+
+const std::string Texture::TEXTURE_CACHE_EXTENSION = ".texcache";
+const uint32_t Texture::TEXTURE_CACHE_VERSION = 1;
+
+namespace {
+
+const uint32_t TEXTURE_CACHE_MAGIC = 0x58455454; // "TTEX" in little endian
+
+/**
+ * Header of the texture cache file, it's followed by pixels of all mip levels.
+ */
+struct TextureCacheHeader
+{
+    uint32_t magic; // Magic number identifying the cache file
+    uint32_t version; // Version of the cache format
+    uint64_t sourceHash; // Hash of the source image file contents
+    uint32_t format; // Format of the pixels (e.g. GL_RGB)
+    int32_t width; // Width of the image in pixels
+    int32_t height; // Height of the image in pixels
+    uint32_t numMipLevels; // Number of stored mip levels
+    uint64_t dataSize; // Byte size of pixels of all mip levels
+};
+
+int getBytesPerPixel(GLenum format)
+{
+    switch (format)
+    {
+        case GL_RGBA: return 4;
+        case GL_RGB: return 3;
+        case GL_RG: return 2;
+        case GL_RED: return 1;
+        default: return 0;
+    }
+}
+
+/**
+ * Gets layout of the whole mip chain (or just level 0) of an image with given size, with all levels tightly packed after each other.
+ */
+std::vector<Texture::MipLevel> getMipLevels(GLsizei width, GLsizei height, int bytesPerPixel, bool withMipChain = true)
+{
+    std::vector<Texture::MipLevel> result;
+    size_t offset = 0;
+    while (true)
+    {
+        const auto size = static_cast<size_t>(width) * height * bytesPerPixel;
+        result.push_back({ width, height, offset, size });
+        offset += size;
+        if (!withMipChain || (width == 1 && height == 1)) {
+            break;
+        }
+
+        width = std::max(1, width / 2);
+        height = std::max(1, height / 2);
+    }
+
+    return result;
+}
+
+} // namespace
 
 Texture::~Texture()
 {
@@ -25,7 +91,7 @@ bool Texture::createFromData(const unsigned char* data, GLsizei width, GLsizei h
     format_ = format;
 
     glGenTextures(1, &textureID_);
-    glBindTexture(GL_TEXTURE_2D, textureID_);
+    GLStateCache::getInstance().bindTexture(GL_TEXTURE_2D, textureID_);
     glTexImage2D(GL_TEXTURE_2D, 0, format_, width_, height_, 0, format_, GL_UNSIGNED_BYTE, data);
 
     if (generateMipmaps) {
@@ -37,12 +103,38 @@ bool Texture::createFromData(const unsigned char* data, GLsizei width, GLsizei h
 
 bool Texture::loadTexture2D(const std::string& filePath, bool generateMipmaps)
 {
-    stbi_set_flip_vertically_on_load(1);
-    int bytesPerPixel;
-    const auto imageData = stbi_load(filePath.c_str(), &width_, &height_, &bytesPerPixel, 0);
-    if (imageData == nullptr)
+    ImageData imageData;
+    if (!decodeImage(filePath, imageData, generateMipmaps)) {
+        return false;
+    }
+
+    return createFromImageData(imageData, generateMipmaps);
+}
+
+bool Texture::decodeImage(const std::string& filePath, ImageData& imageData, const bool generateMipmaps)
+{
+    MemoryMappedFile sourceFile;
+    if (!sourceFile.open(filePath))
     {
-        std::cout << "Failed to load image " << filePath << "!" << std::endl;
+        LOG_ERROR(Assets, "Failed to load image {}!", filePath);
+        return false;
+    }
+
+    // Cached image is valid only if it has been decoded from exactly the same file contents
+    const auto sourceHash = hash_utils::fnv1a(sourceFile.getData(), sourceFile.getSize());
+    const auto cacheFilePath = filePath + TEXTURE_CACHE_EXTENSION;
+    imageData.filePath = filePath;
+    if (loadImageFromCache(cacheFilePath, sourceHash, generateMipmaps, imageData)) {
+        return true;
+    }
+
+    // Vertical flip is done manually, because stbi_set_flip_vertically_on_load is a global state
+    // that can't be safely changed from multiple loading threads
+    int width, height, bytesPerPixel;
+    const auto stbiData = stbi_load_from_memory(sourceFile.getData(), static_cast<int>(sourceFile.getSize()), &width, &height, &bytesPerPixel, 0);
+    if (stbiData == nullptr)
+    {
+        LOG_ERROR(Assets, "Failed to load image {}!", filePath);
         return false;
     }
 
@@ -53,14 +145,63 @@ bool Texture::loadTexture2D(const std::string& filePath, bool generateMipmaps)
     else if (bytesPerPixel == 3) {
         format = GL_RGB;
     }
+    else if (bytesPerPixel == 2) {
+        format = GL_RG;
+    }
     else if (bytesPerPixel == 1) {
-        format = GL_DEPTH_COMPONENT;
+        format = GL_RED;
     }
 
-    const auto result = createFromData(imageData, width_, height_, format, generateMipmaps);
-    stbi_image_free(imageData);
-    filePath_ = filePath;
-    return result;
+    imageData.width = width;
+    imageData.height = height;
+    imageData.format = format;
+    imageData.mipLevels = getMipLevels(width, height, bytesPerPixel, generateMipmaps);
+    imageData.pixels.resize(imageData.mipLevels.back().offset + imageData.mipLevels.back().size);
+
+    const auto rowByteSize = static_cast<size_t>(width) * bytesPerPixel;
+    for (auto row = 0; row < height; row++) {
+        memcpy(imageData.pixels.data() + rowByteSize * row, stbiData + rowByteSize * (height - 1 - row), rowByteSize);
+    }
+
+    stbi_image_free(stbiData);
+    generateMipChain(imageData, bytesPerPixel);
+    saveImageToCache(cacheFilePath, sourceHash, imageData);
+    return true;
+}
+
+bool Texture::createFromImageData(const ImageData& imageData, bool generateMipmaps)
+{
+    if (isLoaded() || imageData.mipLevels.empty()) {
+        return false;
+    }
+
+    width_ = imageData.width;
+    height_ = imageData.height;
+    format_ = imageData.format;
+    filePath_ = imageData.filePath;
+
+    // Storage is immutable and all the levels are precomputed, so nothing is generated on the GPU
+    const auto numLevels = generateMipmaps ? static_cast<GLsizei>(imageData.mipLevels.size()) : 1;
+    if (generateMipmaps && imageData.mipLevels.size() == 1 && (imageData.width > 1 || imageData.height > 1)) {
+        LOG_WARN(Assets, "Image {} has been decoded without mipmaps, texture will have level 0 only!", imageData.filePath);
+    }
+
+    glGenTextures(1, &textureID_);
+    GLStateCache::getInstance().bindTexture(GL_TEXTURE_2D, textureID_);
+    glTexStorage2D(GL_TEXTURE_2D, numLevels, getSizedInternalFormat(format_), width_, height_);
+
+    // Rows of small levels (or RGB images) don't have to be aligned to 4 bytes
+    GLint previousUnpackAlignment;
+    glGetIntegerv(GL_UNPACK_ALIGNMENT, &previousUnpackAlignment);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    for (auto level = 0; level < numLevels; level++)
+    {
+        const auto& mipLevel = imageData.mipLevels[level];
+        glTexSubImage2D(GL_TEXTURE_2D, level, 0, 0, mipLevel.width, mipLevel.height, format_, GL_UNSIGNED_BYTE, imageData.pixels.data() + mipLevel.offset);
+    }
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, previousUnpackAlignment);
+    return true;
 }
 
 void Texture::bind(const GLenum textureUnit) const
@@ -69,8 +210,7 @@ void Texture::bind(const GLenum textureUnit) const
         return;
     }
 
-    glActiveTexture(GL_TEXTURE0 + textureUnit);
-    glBindTexture(GL_TEXTURE_2D, textureID_);
+    GLStateCache::getInstance().bindTextureToUnit(textureUnit, GL_TEXTURE_2D, textureID_);
 }
 
 void Texture::deleteTexture()
@@ -80,6 +220,7 @@ void Texture::deleteTexture()
     }
 
     glDeleteTextures(1, &textureID_);
+    GLStateCache::getInstance().onTextureDeleted(textureID_);
     textureID_ = 0;
     width_ = height_ = 0;
     format_ = 0;
@@ -131,13 +272,136 @@ int Texture::getNumTextureImageUnits()
     return maxTextureUnits;
 }
 
+GLenum Texture::getSizedInternalFormat(GLenum format)
+{
+    switch (format)
+    {
+        case GL_RGBA: return GL_RGBA8;
+        case GL_RGB: return GL_RGB8;
+        case GL_RG: return GL_RG8;
+        default: return GL_R8;
+    }
+}
+
 bool Texture::isLoadedCheck() const
 {
     if (!isLoaded())
     {
-        std::cout << "Attempting to access non loaded texture!" << std::endl;
+        LOG_WARN(Assets, "Attempting to access non loaded texture!");
         return false;
     }
 
     return true;
 }
+
+bool Texture::loadImageFromCache(const std::string& cacheFilePath, uint64_t sourceHash, const bool generateMipmaps, ImageData& imageData)
+{
+    std::ifstream in(cacheFilePath, std::ios::binary);
+    if (!in) {
+        return false;
+    }
+
+    TextureCacheHeader header;
+    if (!in.read(reinterpret_cast<char*>(&header), sizeof(TextureCacheHeader))) {
+        return false;
+    }
+
+    if (header.magic != TEXTURE_CACHE_MAGIC || header.version != TEXTURE_CACHE_VERSION || header.sourceHash != sourceHash) {
+        return false;
+    }
+
+    const auto bytesPerPixel = getBytesPerPixel(header.format);
+    if (bytesPerPixel == 0 || header.width <= 0 || header.height <= 0)
+    {
+        LOG_WARN(Assets, "Texture cache {} is corrupted, image will be decoded again.", cacheFilePath);
+        return false;
+    }
+
+    // Cache holds either the whole mip chain or just level 0 (image decoded without mipmaps)
+    const auto cachedMipLevels = getMipLevels(header.width, header.height, bytesPerPixel, header.numMipLevels != 1);
+    if (header.numMipLevels != cachedMipLevels.size() || header.dataSize != cachedMipLevels.back().offset + cachedMipLevels.back().size)
+    {
+        LOG_WARN(Assets, "Texture cache {} is corrupted, image will be decoded again.", cacheFilePath);
+        return false;
+    }
+
+    const auto mipLevels = getMipLevels(header.width, header.height, bytesPerPixel, generateMipmaps);
+    if (mipLevels.size() > cachedMipLevels.size()) {
+        return false;
+    }
+
+    // Levels are stored from level 0, so reading just the needed ones is enough
+    const auto dataSize = mipLevels.back().offset + mipLevels.back().size;
+    imageData.pixels.resize(dataSize);
+    if (!in.read(reinterpret_cast<char*>(imageData.pixels.data()), dataSize))
+    {
+        LOG_WARN(Assets, "Texture cache {} is corrupted, image will be decoded again.", cacheFilePath);
+        return false;
+    }
+
+    imageData.width = header.width;
+    imageData.height = header.height;
+    imageData.format = header.format;
+    imageData.mipLevels = mipLevels;
+    return true;
+}
+
+bool Texture::saveImageToCache(const std::string& cacheFilePath, uint64_t sourceHash, const ImageData& imageData)
+{
+    TextureCacheHeader header;
+    header.magic = TEXTURE_CACHE_MAGIC;
+    header.version = TEXTURE_CACHE_VERSION;
+    header.sourceHash = sourceHash;
+    header.format = imageData.format;
+    header.width = imageData.width;
+    header.height = imageData.height;
+    header.numMipLevels = static_cast<uint32_t>(imageData.mipLevels.size());
+    header.dataSize = imageData.pixels.size();
+
+    // Several threads (or processes) may decode the same image, each writes its own temporary file and replaces the cache with it
+    const auto isWritten = file_utils::writeFileAtomically(cacheFilePath, [&](std::ostream& out)
+    {
+        out.write(reinterpret_cast<const char*>(&header), sizeof(TextureCacheHeader));
+        out.write(reinterpret_cast<const char*>(imageData.pixels.data()), imageData.pixels.size());
+    });
+
+    if (!isWritten)
+    {
+        LOG_ERROR(Assets, "Failed to write texture cache {}!", cacheFilePath);
+        return false;
+    }
+
+    return true;
+}
+
+void Texture::generateMipChain(ImageData& imageData, int bytesPerPixel)
+{
+    // Every texel of the next level is an average of 2x2 texels of the previous level,
+    // odd sizes are handled by clamping the coordinates to the previous level's edge
+    for (size_t level = 1; level < imageData.mipLevels.size(); level++)
+    {
+        const auto& source = imageData.mipLevels[level - 1];
+        const auto& destination = imageData.mipLevels[level];
+        const auto sourcePixels = imageData.pixels.data() + source.offset;
+        auto destinationPixels = imageData.pixels.data() + destination.offset;
+
+        for (auto y = 0; y < destination.height; y++)
+        {
+            const auto y0 = std::min(y * 2, source.height - 1);
+            const auto y1 = std::min(y * 2 + 1, source.height - 1);
+            for (auto x = 0; x < destination.width; x++)
+            {
+                const auto x0 = std::min(x * 2, source.width - 1);
+                const auto x1 = std::min(x * 2 + 1, source.width - 1);
+                for (auto channel = 0; channel < bytesPerPixel; channel++)
+                {
+                    const auto sum = sourcePixels[(static_cast<size_t>(y0) * source.width + x0) * bytesPerPixel + channel]
+                        + sourcePixels[(static_cast<size_t>(y0) * source.width + x1) * bytesPerPixel + channel]
+                        + sourcePixels[(static_cast<size_t>(y1) * source.width + x0) * bytesPerPixel + channel]
+                        + sourcePixels[(static_cast<size_t>(y1) * source.width + x1) * bytesPerPixel + channel];
+                    destinationPixels[(static_cast<size_t>(y) * destination.width + x) * bytesPerPixel + channel] = static_cast<unsigned char>((sum + 2) / 4);
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,187 @@
+// STL
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+// Project
+#include "../includes/common_classes/textureArray.h"
+#include "../includes/common_classes/glStateCache.h"
+#include "../includes/common_classes/logManager.h"
+
+namespace {
+
+/**
+ * Expands pixels of grey (GL_RED) or grey with alpha (GL_RG) image into RGBA, so that it looks the same as the other layers.
+ * OpenGL would fill missing components with zeros instead (red or red-green texture).
+ */
+std::vector<unsigned char> expandGreyToRGBA(const unsigned char* pixels, const size_t numPixels, const GLenum format)
+{
+    const auto hasAlpha = format == GL_RG;
+    const auto bytesPerPixel = hasAlpha ? 2 : 1;
+    std::vector<unsigned char> result(numPixels * 4);
+    for (size_t i = 0; i < numPixels; i++)
+    {
+        const auto grey = pixels[i * bytesPerPixel];
+        result[i * 4] = result[i * 4 + 1] = result[i * 4 + 2] = grey;
+        result[i * 4 + 3] = hasAlpha ? pixels[i * bytesPerPixel + 1] : 255;
+    }
+
+    return result;
+}
+
+} // namespace
+
+TextureArray::~TextureArray()
+{
+    deleteTextureArray();
+}
+
+bool TextureArray::loadTextureArray(const std::vector<std::string>& filePaths, bool generateMipmaps)
+{
+    std::vector<Texture::ImageData> layers(filePaths.size());
+    for (size_t i = 0; i < filePaths.size(); i++)
+    {
+        if (!Texture::decodeImage(filePaths[i], layers[i], generateMipmaps)) {
+            return false;
+        }
+    }
+
+    return createFromImageData(layers, generateMipmaps);
+}
+
+bool TextureArray::createFromImageData(const std::vector<Texture::ImageData>& layers, bool generateMipmaps)
+{
+    if (isLoaded() || layers.empty()) {
+        return false;
+    }
+
+    // All the layers must have the same size, smallest image defines it
+    auto width = layers[0].width;
+    auto height = layers[0].height;
+    for (const auto& layer : layers)
+    {
+        width = std::min(width, layer.width);
+        height = std::min(height, layer.height);
+    }
+
+    std::vector<int> baseLevels;
+    auto numLevels = generateMipmaps ? std::numeric_limits<GLsizei>::max() : 1;
+    for (const auto& layer : layers)
+    {
+        const auto baseLevel = findMipLevel(layer, width, height);
+        if (baseLevel < 0)
+        {
+            LOG_ERROR(Assets, "Image {} can't be used as a layer of {}x{} texture array!", layer.filePath, width, height);
+            return false;
+        }
+
+        if (layer.format != GL_RGBA && layer.format != GL_RGB && layer.format != GL_RG && layer.format != GL_RED)
+        {
+            LOG_ERROR(Assets, "Image {} has unsupported format and can't be used as a layer of texture array!", layer.filePath);
+            return false;
+        }
+
+        if (layer.format == GL_RG || layer.format == GL_RED) {
+            LOG_INFO(Assets, "Image {} is {} and will be expanded to RGBA as a layer of texture array", layer.filePath, layer.format == GL_RED ? "grey" : "grey with alpha");
+        }
+
+        baseLevels.push_back(baseLevel);
+        numLevels = std::min(numLevels, static_cast<GLsizei>(layer.mipLevels.size()) - baseLevel);
+    }
+
+    width_ = width;
+    height_ = height;
+    numLayers_ = static_cast<GLsizei>(layers.size());
+
+    // Layers may differ in format, so the storage is RGBA. RGB layers are converted during upload (alpha becomes one),
+    // grey layers are expanded on the CPU, because OpenGL would turn them into red ones
+    glGenTextures(1, &textureID_);
+    GLStateCache::getInstance().bindTexture(GL_TEXTURE_2D_ARRAY, textureID_);
+    glTexStorage3D(GL_TEXTURE_2D_ARRAY, numLevels, GL_RGBA8, width_, height_, numLayers_);
+
+    GLint previousUnpackAlignment;
+    glGetIntegerv(GL_UNPACK_ALIGNMENT, &previousUnpackAlignment);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    for (auto layerIndex = 0; layerIndex < numLayers_; layerIndex++)
+    {
+        const auto& layer = layers[layerIndex];
+        for (auto level = 0; level < numLevels; level++)
+        {
+            const auto& mipLevel = layer.mipLevels[baseLevels[layerIndex] + level];
+            const auto mipLevelPixels = layer.pixels.data() + mipLevel.offset;
+            if (layer.format == GL_RGBA || layer.format == GL_RGB)
+            {
+                glTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, layerIndex, mipLevel.width, mipLevel.height, 1, layer.format, GL_UNSIGNED_BYTE, mipLevelPixels);
+                continue;
+            }
+
+            const auto rgbaPixels = expandGreyToRGBA(mipLevelPixels, static_cast<size_t>(mipLevel.width) * mipLevel.height, layer.format);
+            glTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, layerIndex, mipLevel.width, mipLevel.height, 1, GL_RGBA, GL_UNSIGNED_BYTE, rgbaPixels.data());
+        }
+    }
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, previousUnpackAlignment);
+    return true;
+}
+
+void TextureArray::bind(const GLenum textureUnit) const
+{
+    if (!isLoaded())
+    {
+        LOG_WARN(Assets, "Attempting to access non loaded texture array!");
+        return;
+    }
+
+    GLStateCache::getInstance().bindTextureToUnit(textureUnit, GL_TEXTURE_2D_ARRAY, textureID_);
+}
+
+void TextureArray::deleteTextureArray()
+{
+    if (!isLoaded()) {
+        return;
+    }
+
+    glDeleteTextures(1, &textureID_);
+    GLStateCache::getInstance().onTextureDeleted(textureID_);
+    textureID_ = 0;
+    width_ = height_ = 0;
+    numLayers_ = 0;
+}
+
+GLuint TextureArray::getID() const
+{
+    return textureID_;
+}
+
+GLsizei TextureArray::getWidth() const
+{
+    return width_;
+}
+
+GLsizei TextureArray::getHeight() const
+{
+    return height_;
+}
+
+GLsizei TextureArray::getNumLayers() const
+{
+    return numLayers_;
+}
+
+bool TextureArray::isLoaded() const
+{
+    return textureID_ != 0;
+}
+
+int TextureArray::findMipLevel(const Texture::ImageData& imageData, const GLsizei width, const GLsizei height)
+{
+    for (size_t level = 0; level < imageData.mipLevels.size(); level++)
+    {
+        const auto& mipLevel = imageData.mipLevels[level];
+        if (mipLevel.width == width && mipLevel.height == height) {
+            return static_cast<int>(level);
+        }
+    }
+
+    return -1;
+}
@@ -3,6 +3,8 @@
 
 // Project
 #include "../includes/common_classes/textureManager.h"
+#include "../includes/common_classes/asyncAssetLoader.h"
+#include "../includes/common_classes/instrumentation.h"
 
 TextureManager& TextureManager::getInstance()
 {
@@ -12,6 +14,7 @@ TextureManager& TextureManager::getInstance()
 
 void TextureManager::loadTexture2D(const std::string& key, const std::string& fileName, bool generateMipmaps)
 {
+    INSTRUMENT_ZONE("TextureManager::loadTexture2D");
     if (containsTexture(key)) {
         return;
     }
@@ -25,6 +28,58 @@ void TextureManager::loadTexture2D(const std::string& key, const std::string& fi
     _textureCache[key] = std::move(texturePtr);
 }
 
+std::shared_future<void> TextureManager::loadTexture2DAsync(const std::string& key, const std::string& fileName, bool generateMipmaps)
+{
+    if (containsTexture(key))
+    {
+        std::promise<void> loadedPromise;
+        loadedPromise.set_value();
+        return loadedPromise.get_future().share();
+    }
+
+    const auto pendingTextureIt = _pendingTextures.find(key);
+    if (pendingTextureIt != _pendingTextures.end()) {
+        return pendingTextureIt->second;
+    }
+
+    auto loadPromise = std::make_shared<std::promise<void>>();
+    auto loadFuture = loadPromise->get_future().share();
+    _pendingTextures[key] = loadFuture;
+
+    // Failed task leaves the texture neither pending nor loaded (failure callback always runs on the context thread)
+    const auto onFailure = [this, key, loadPromise](std::exception_ptr exception)
+    {
+        _pendingTextures.erase(key);
+        loadPromise->set_exception(exception);
+    };
+
+    AsyncAssetLoader::getInstance().submitWorkerTask([this, key, fileName, generateMipmaps, loadPromise, onFailure]()
+    {
+        INSTRUMENT_ZONE("TextureManager::decodeTexture");
+        auto imageData = std::make_shared<Texture::ImageData>();
+        const auto isDecoded = Texture::decodeImage(fileName, *imageData, generateMipmaps);
+
+        AsyncAssetLoader::getInstance().submitContextTask([this, key, fileName, generateMipmaps, loadPromise, imageData, isDecoded]()
+        {
+            INSTRUMENT_ZONE("TextureManager::createTexture");
+            _pendingTextures.erase(key);
+
+            auto texturePtr = std::make_unique<Texture>();
+            if (!isDecoded || !texturePtr->createFromImageData(*imageData, generateMipmaps))
+            {
+                auto msg = "Could not load texture with key '" + key + "' from file '" + fileName + "'!";
+                loadPromise->set_exception(std::make_exception_ptr(std::runtime_error(msg.c_str())));
+                return;
+            }
+
+            _textureCache[key] = std::move(texturePtr);
+            loadPromise->set_value();
+        }, onFailure);
+    }, onFailure);
+
+    return loadFuture;
+}
+
 const Texture& TextureManager::getTexture(const std::string& key) const
 {
     if (!containsTexture(key))
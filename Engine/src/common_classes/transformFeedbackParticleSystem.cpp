@@ -1,5 +1,4 @@
 // STL
-#include <iostream>
 #include <random>
 
 // GLM
@@ -9,6 +8,8 @@
 #include "../includes/common_classes/transformFeedbackParticleSystem.h"
 #include "../includes/common_classes/shaderManager.h"
 #include "../includes/common_classes/shaderProgramManager.h"
+#include "../includes/common_classes/glStateCache.h"
+#include "../includes/common_classes/logManager.h"
 
 TransformFeedbackParticleSystem::TransformFeedbackParticleSystem(const int numMaxParticlesInBuffer)
     : numMaxParticlesInBuffer_(numMaxParticlesInBuffer)
@@ -27,8 +28,8 @@ bool TransformFeedbackParticleSystem::initialize()
         return true;
     }
 
-    // Add two default recorded attributes
-    addRecordedInt("outType", false);
+    // Add two default recorded attributes, type is needed for rendering to skip the generators
+    addRecordedInt("outType");
     addRecordedVec3("outPosition");
 
     // If the initialization of shaders and recorded variables fails, don't continue
@@ -50,11 +51,16 @@ void TransformFeedbackParticleSystem::renderParticles()
         return;
     }
 
-    // Prepare rendering and then render from index 1 (at index 0, there is always generator)
+    // Nothing has been recorded yet, read buffer holds just the generator
+    if (!isFeedbackRecorded_) {
+        return;
+    }
+
+    // Prepare rendering and then render all recorded particles (generator at index 0 is skipped by the shaders)
     prepareRenderParticles();
 
-    glBindVertexArray(renderVAOs_[readBufferIndex_]);
-    glDrawArrays(GL_POINTS, 1, numberOfParticles_ - 1);
+    GLStateCache::getInstance().bindVertexArray(renderVAOs_[readBufferIndex_]);
+    glDrawTransformFeedback(GL_POINTS, transformFeedbackIDs_[readBufferIndex_]);
 }
 
 void TransformFeedbackParticleSystem::updateParticles(const float deltaTime)
@@ -69,30 +75,47 @@ void TransformFeedbackParticleSystem::updateParticles(const float deltaTime)
 
     // Prepare update of particles
     prepareUpdateParticles(deltaTime);
+    collectParticleCount();
+
+    // Bind transform feedback object of the write buffer (it has the buffer attached) and VAO for updating particles
+    glBindTransformFeedback(GL_TRANSFORM_FEEDBACK, transformFeedbackIDs_[writeBufferIndex]);
+    GLStateCache::getInstance().bindVertexArray(updateVAOs_[readBufferIndex_]);
 
-    // Bind transform feedback object, VAO for updating particles and tell OpenGL where to store recorded data
-    glBindTransformFeedback(GL_TRANSFORM_FEEDBACK, transformFeedbackID_);
-    glBindVertexArray(updateVAOs_[readBufferIndex_]);
-    glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, particlesVBOs_[writeBufferIndex]);
+    // Number of written particles is observed only if the query slot is free, a pending one would have to be waited for
+    const auto countQueryIndex = nextCountQueryIndex_;
+    const auto issueCountQuery = !isCountQueryPending_[countQueryIndex];
 
-    // Update particles with special update shader program and also observe how many particles have been written
+    // Update particles with special update shader program
     // Discard rasterization - we don't want to render this, it's only about updating
-    glEnable(GL_RASTERIZER_DISCARD);
-    glBeginQuery(GL_TRANSFORM_FEEDBACK_PRIMITIVES_WRITTEN, numParticlesQueryID_);
-    
+    GLStateCache::getInstance().enable(GL_RASTERIZER_DISCARD);
+    if (issueCountQuery) {
+        glBeginQuery(GL_TRANSFORM_FEEDBACK_PRIMITIVES_WRITTEN, numParticlesQueryIDs_[countQueryIndex]);
+    }
+
+    // Number of particles to update is known only to the GPU, it's what the read buffer's transform feedback recorded
     glBeginTransformFeedback(GL_POINTS);
-    glDrawArrays(GL_POINTS, 0, numberOfParticles_);
+    if (isFeedbackRecorded_) {
+        glDrawTransformFeedback(GL_POINTS, transformFeedbackIDs_[readBufferIndex_]);
+    }
+    else {
+        glDrawArrays(GL_POINTS, 0, 1);
+    }
     glEndTransformFeedback();
 
-    glEndQuery(GL_TRANSFORM_FEEDBACK_PRIMITIVES_WRITTEN);
-    glGetQueryObjectiv(numParticlesQueryID_, GL_QUERY_RESULT, &numberOfParticles_);
+    if (issueCountQuery)
+    {
+        glEndQuery(GL_TRANSFORM_FEEDBACK_PRIMITIVES_WRITTEN);
+        isCountQueryPending_[countQueryIndex] = true;
+        nextCountQueryIndex_ = (countQueryIndex + 1) % NUM_COUNT_QUERIES;
+    }
+    isFeedbackRecorded_ = true;
 
     // Swap read / write buffers for the next frame
     readBufferIndex_ = writeBufferIndex;
 
     // Unbind transform feedback and restore normal rendering (don't discard anymore)
     glBindTransformFeedback(GL_TRANSFORM_FEEDBACK, 0);
-    glDisable(GL_RASTERIZER_DISCARD);
+    GLStateCache::getInstance().disable(GL_RASTERIZER_DISCARD);
 }
 
 void TransformFeedbackParticleSystem::calculateBillboardingVectors(const glm::vec3 &cameraViewVector, const glm::vec3& cameraUpVector)
@@ -119,14 +142,22 @@ void TransformFeedbackParticleSystem::releaseParticleSystem()
     }
 
     // Delete all allocated OpenGL objects    
-    glDeleteTransformFeedbacks(1, &transformFeedbackID_);
-    glDeleteQueries(1, &numParticlesQueryID_);
+    glDeleteTransformFeedbacks(2, transformFeedbackIDs_);
+    glDeleteQueries(NUM_COUNT_QUERIES, numParticlesQueryIDs_);
 
     glDeleteVertexArrays(2, renderVAOs_);
     glDeleteVertexArrays(2, updateVAOs_);
+    for (auto i = 0; i < 2; i++)
+    {
+        GLStateCache::getInstance().onVertexArrayDeleted(renderVAOs_[i]);
+        GLStateCache::getInstance().onVertexArrayDeleted(updateVAOs_[i]);
+    }
 
-    std::cout << "Deleting VBOs for particle system with IDs [" << particlesVBOs_[0] << ", " << particlesVBOs_[1] << "]" << std::endl;
+    LOG_DEBUG(Render, "Deleting VBOs for particle system with IDs [{}, {}]", particlesVBOs_[0], particlesVBOs_[1]);
     glDeleteBuffers(2, particlesVBOs_);
+    for (const auto particlesVBO : particlesVBOs_) {
+        GLStateCache::getInstance().onBufferDeleted(particlesVBO);
+    }
 
     recordedVariables_.clear();
     isInitialized_ = false;
@@ -206,9 +237,11 @@ void TransformFeedbackParticleSystem::RecordedVariable::enableAndSetupVertexAttr
 
 void TransformFeedbackParticleSystem::generateOpenGLObjects()
 {
-    glGenTransformFeedbacks(1, &transformFeedbackID_);
-    glGenQueries(1, &numParticlesQueryID_);
-    
+    glGenQueries(NUM_COUNT_QUERIES, numParticlesQueryIDs_);
+    for (auto& isCountQueryPending : isCountQueryPending_) {
+        isCountQueryPending = false;
+    }
+
     // Gather some constants
     const auto particleByteSize = calculateParticleByteSize();
     GLsizeiptr bufferByteSize = particleByteSize * numMaxParticlesInBuffer_;
@@ -218,7 +251,7 @@ void TransformFeedbackParticleSystem::generateOpenGLObjects()
     glGenBuffers(2, particlesVBOs_);
     for (auto i = 0; i < 2; i++)
     {
-        glBindBuffer(GL_ARRAY_BUFFER, particlesVBOs_[i]);
+        GLStateCache::getInstance().bindBuffer(GL_ARRAY_BUFFER, particlesVBOs_[i]);
         glBufferData(GL_ARRAY_BUFFER, bufferByteSize, NULL, GL_DYNAMIC_DRAW);
         if (i == 0)
         {
@@ -227,15 +260,23 @@ void TransformFeedbackParticleSystem::generateOpenGLObjects()
         }
     }
 
-    std::cout << "Created VBOs for particle system with IDs [" << particlesVBOs_[0] << ", " << particlesVBOs_[1]
-    << "] and size " << bufferByteSize << std::endl;
+    LOG_DEBUG(Render, "Created VBOs for particle system with IDs [{}, {}] and size {}", particlesVBOs_[0], particlesVBOs_[1], bufferByteSize);
+
+    // Every transform feedback records into its own VBO, so that drawing from it later uses the count recorded there
+    glGenTransformFeedbacks(2, transformFeedbackIDs_);
+    for (auto i = 0; i < 2; i++)
+    {
+        glBindTransformFeedback(GL_TRANSFORM_FEEDBACK, transformFeedbackIDs_[i]);
+        glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, particlesVBOs_[i]);
+    }
+    glBindTransformFeedback(GL_TRANSFORM_FEEDBACK, 0);
 
     // Set up VAOs for updating of particles
     glGenVertexArrays(2, updateVAOs_);
     for (auto i = 0; i < 2; i++)
     {
-        glBindVertexArray(updateVAOs_[i]);
-        glBindBuffer(GL_ARRAY_BUFFER, particlesVBOs_[i]);
+        GLStateCache::getInstance().bindVertexArray(updateVAOs_[i]);
+        GLStateCache::getInstance().bindBuffer(GL_ARRAY_BUFFER, particlesVBOs_[i]);
 
         GLsizeiptr byteOffset = 0;
         for (size_t j = 0; j < recordedVariables_.size(); j++)
@@ -249,8 +290,8 @@ void TransformFeedbackParticleSystem::generateOpenGLObjects()
     glGenVertexArrays(2, renderVAOs_);
     for (auto i = 0; i < 2; i++)
     {
-        glBindVertexArray(renderVAOs_[i]);
-        glBindBuffer(GL_ARRAY_BUFFER, particlesVBOs_[i]);
+        GLStateCache::getInstance().bindVertexArray(renderVAOs_[i]);
+        GLStateCache::getInstance().bindBuffer(GL_ARRAY_BUFFER, particlesVBOs_[i]);
 
         GLsizeiptr byteOffset = 0;
         for (size_t j = 0; j < recordedVariables_.size(); j++)
@@ -268,4 +309,27 @@ void TransformFeedbackParticleSystem::generateOpenGLObjects()
     // Initialize read buffer index and initial number of particles
     readBufferIndex_ = 0;
     numberOfParticles_ = 1;
+    nextCountQueryIndex_ = 0;
+    isFeedbackRecorded_ = false;
+}
+
+void TransformFeedbackParticleSystem::collectParticleCount()
+{
+    // Queries complete in the order they were issued, so the first unavailable one ends the search
+    for (auto i = 0; i < NUM_COUNT_QUERIES; i++)
+    {
+        const auto queryIndex = (nextCountQueryIndex_ + i) % NUM_COUNT_QUERIES;
+        if (!isCountQueryPending_[queryIndex]) {
+            continue;
+        }
+
+        GLint isAvailable = GL_FALSE;
+        glGetQueryObjectiv(numParticlesQueryIDs_[queryIndex], GL_QUERY_RESULT_AVAILABLE, &isAvailable);
+        if (isAvailable == GL_FALSE) {
+            break;
+        }
+
+        glGetQueryObjectiv(numParticlesQueryIDs_[queryIndex], GL_QUERY_RESULT, &numberOfParticles_);
+        isCountQueryPending_[queryIndex] = false;
+    }
 }
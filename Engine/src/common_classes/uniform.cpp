@@ -1,17 +1,13 @@
-#include <iostream>
-
 #include "../includes/common_classes/uniform.h"
-#include "../includes/common_classes/shaderProgram.h"
 
-Uniform::Uniform(const std::string& name, ShaderProgram* shaderProgram)
-    : name_(name)
-    , shaderProgram_(shaderProgram)
+Uniform::Uniform(const GLint location)
+    : location_(location)
+{
+}
+
+bool Uniform::isValid() const
 {
-    location_ = glGetUniformLocation(shaderProgram_->getShaderProgramID(), name_.c_str());
-    if (location_ == -1)
-    {
-        std::cout << "WARNING: uniform with name " << name << " does not exist, setting it will fail!" << std::endl;
-    }
+    return location_ != -1;
 }
 
 Uniform& Uniform::operator=(const glm::vec2& vector2D)
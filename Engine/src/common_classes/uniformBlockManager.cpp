@@ -0,0 +1,117 @@
+// STL
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+
+// Project
+#include "../includes/common_classes/uniformBlockManager.h"
+#include "../includes/common_classes/logManager.h"
+
+// Layout of the structures has to match std140 rules used by the shaders
+static_assert(sizeof(UniformBlockManager::FrameConstantsStd140) == 144, "Frame constants block does not follow std140 layout!");
+static_assert(sizeof(shader_structs::AmbientLight::Std140) == 16, "Ambient light does not follow std140 layout!");
+static_assert(sizeof(shader_structs::DiffuseLight::Std140) == 48, "Diffuse light does not follow std140 layout!");
+static_assert(sizeof(shader_structs::FogParameters::Std140) == 32, "Fog parameters do not follow std140 layout!");
+static_assert(sizeof(shader_structs::PointLight::Std140) == 48, "Point light does not follow std140 layout!");
+static_assert(offsetof(UniformBlockManager::LightsStd140, pointLights) == 112, "Lights block does not follow std140 layout!");
+
+UniformBlockManager& UniformBlockManager::getInstance()
+{
+    static UniformBlockManager ubm;
+    return ubm;
+}
+
+void UniformBlockManager::createBlocks()
+{
+    if (_areBlocksCreated) {
+        return;
+    }
+
+    // Lights block follows frame constants block, but its offset has to be properly aligned
+    GLint offsetAlignment = 0;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &offsetAlignment);
+    const auto alignment = static_cast<size_t>(std::max(offsetAlignment, 1));
+    _lightsOffset = (sizeof(FrameConstantsStd140) + alignment - 1) / alignment * alignment;
+
+    _stagingData.assign(_lightsOffset + sizeof(LightsStd140), 0);
+    _uniformBuffer.createUBO(_stagingData.size(), GL_DYNAMIC_DRAW);
+    _uniformBuffer.bindBufferRangeToBindingPoint(UniformBlockBindingPoints::FRAME_CONSTANTS, 0, sizeof(FrameConstantsStd140));
+    _uniformBuffer.bindBufferRangeToBindingPoint(UniformBlockBindingPoints::LIGHTS, _lightsOffset, sizeof(LightsStd140));
+    _areBlocksCreated = true;
+
+    // Upload zeroes first, so that the blocks are defined even if nothing is set
+    markDirty(0, _stagingData.size());
+    uploadBlocks();
+}
+
+void UniformBlockManager::setFrameConstants(const glm::mat4& projectionMatrix, const glm::mat4& viewMatrix, const glm::vec3& eyePosition)
+{
+    if (!_areBlocksCreated) {
+        return;
+    }
+
+    FrameConstantsStd140 frameConstants;
+    frameConstants.projectionMatrix = projectionMatrix;
+    frameConstants.viewMatrix = viewMatrix;
+    frameConstants.eyePosition = glm::vec4(eyePosition, 1.0f);
+
+    memcpy(_stagingData.data(), &frameConstants, sizeof(FrameConstantsStd140));
+    markDirty(0, sizeof(FrameConstantsStd140));
+}
+
+void UniformBlockManager::setLights(const shader_structs::AmbientLight& ambientLight, const shader_structs::DiffuseLight& diffuseLight,
+    const shader_structs::FogParameters& fogParams, const std::vector<shader_structs::PointLight>& pointLights)
+{
+    if (!_areBlocksCreated) {
+        return;
+    }
+
+    if (pointLights.size() > static_cast<size_t>(MAX_POINT_LIGHTS)) {
+        LOG_WARN(Buffers, "Too many point lights ({}), only first {} will be used!", pointLights.size(), MAX_POINT_LIGHTS);
+    }
+
+    // Point lights beyond the count are never read by the shaders, so only the used ones are uploaded
+    auto lights = reinterpret_cast<LightsStd140*>(_stagingData.data() + _lightsOffset);
+    const auto numPointLights = std::min(static_cast<int>(pointLights.size()), MAX_POINT_LIGHTS);
+    lights->ambientLight = ambientLight.getStd140();
+    lights->diffuseLight = diffuseLight.getStd140();
+    lights->fogParams = fogParams.getStd140();
+    lights->numPointLights = numPointLights;
+    for (auto i = 0; i < numPointLights; i++) {
+        lights->pointLights[i] = pointLights[i].getStd140();
+    }
+
+    markDirty(_lightsOffset, offsetof(LightsStd140, pointLights) + sizeof(shader_structs::PointLight::Std140) * numPointLights);
+}
+
+void UniformBlockManager::uploadBlocks()
+{
+    if (!_areBlocksCreated || _dirtyBegin >= _dirtyEnd) {
+        return;
+    }
+
+    _uniformBuffer.bindUBO();
+    _uniformBuffer.setBufferData(_dirtyBegin, _stagingData.data() + _dirtyBegin, _dirtyEnd - _dirtyBegin);
+    _dirtyBegin = _dirtyEnd = 0;
+}
+
+void UniformBlockManager::deleteBlocks()
+{
+    _uniformBuffer.deleteUBO();
+    _stagingData.clear();
+    _dirtyBegin = _dirtyEnd = 0;
+    _areBlocksCreated = false;
+}
+
+void UniformBlockManager::markDirty(const size_t offset, const size_t byteSize)
+{
+    if (_dirtyBegin >= _dirtyEnd)
+    {
+        _dirtyBegin = offset;
+        _dirtyEnd = offset + byteSize;
+        return;
+    }
+
+    _dirtyBegin = std::min(_dirtyBegin, offset);
+    _dirtyEnd = std::max(_dirtyEnd, offset + byteSize);
+}
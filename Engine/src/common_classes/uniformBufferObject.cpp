@@ -1,8 +1,7 @@
-// STL
-#include <iostream>
-
 // Project
 #include "../includes/common_classes/uniformBufferObject.h"
+#include "../includes/common_classes/glStateCache.h"
+#include "../includes/common_classes/logManager.h"
 
 UniformBufferObject::~UniformBufferObject()
 {
@@ -13,13 +12,13 @@ void UniformBufferObject::createUBO(const size_t byteSize, GLenum usageHint)
 {
     if (_isBufferCreated)
     {
-        std::cerr << "This buffer is already created! You need to delete it before re-creating it!" << std::endl;
+        LOG_ERROR(Buffers, "This buffer is already created! You need to delete it before re-creating it!");
         return;
     }
 
     // Generate buffer ID, bind it immediately and reserve space for it
     glGenBuffers(1, &_bufferID);
-    glBindBuffer(GL_UNIFORM_BUFFER, _bufferID);
+    GLStateCache::getInstance().bindBuffer(GL_UNIFORM_BUFFER, _bufferID);
     glBufferData(GL_UNIFORM_BUFFER, byteSize, NULL, usageHint);
 
     // Mark that the buffer has been created and store its size
@@ -31,30 +30,30 @@ void UniformBufferObject::bindUBO() const
 {
     if (!_isBufferCreated)
     {
-        std::cerr << "Uniform buffer object is not created yet! You cannot bind it before you create it!" << std::endl;
+        LOG_ERROR(Buffers, "Uniform buffer object is not created yet! You cannot bind it before you create it!");
         return;
     }
 
-    glBindBuffer(GL_UNIFORM_BUFFER, _bufferID);
+    GLStateCache::getInstance().bindBuffer(GL_UNIFORM_BUFFER, _bufferID);
 }
 
 void UniformBufferObject::setBufferData(const size_t offset, const void* ptrData, const size_t dataSize)
 {
     if (!_isBufferCreated)
     {
-        std::cerr << "Could not set data because uniform buffer object is not created yet!" << std::endl;
+        LOG_ERROR(Buffers, "Could not set data because uniform buffer object is not created yet!");
         return;
     }
 
     if (offset >= _byteSize)
     {
-        std::cerr << "Tried to set data of uniform buffer object at offset " << offset << ", but it's beyond buffer size " << _byteSize << ", will be ignored..." << std::endl;
+        LOG_WARN(Buffers, "Tried to set data of uniform buffer object at offset {}, but it's beyond buffer size {}, will be ignored...", offset, _byteSize);
         return;
     }
 
     if (offset + dataSize > _byteSize)
     {
-        std::cerr << "Could not set data because it would overflow the buffer! Offset: " << offset << ", data size: " << dataSize << std::endl;
+        LOG_ERROR(Buffers, "Could not set data because it would overflow the buffer! Offset: {}, data size: {}", offset, dataSize);
         return;
     }
 
@@ -65,11 +64,28 @@ void UniformBufferObject::bindBufferBaseToBindingPoint(const GLuint bindingPoint
 {
     if (!_isBufferCreated)
     {
-        std::cerr << "Could not bind buffer base to binding point " << bindingPoint << ", because uniform buffer object is not created yet!" << std::endl;
+        LOG_ERROR(Buffers, "Could not bind buffer base to binding point {}, because uniform buffer object is not created yet!", bindingPoint);
+        return;
+    }
+
+    GLStateCache::getInstance().bindBufferBase(GL_UNIFORM_BUFFER, bindingPoint, _bufferID);
+}
+
+void UniformBufferObject::bindBufferRangeToBindingPoint(const GLuint bindingPoint, const size_t offset, const size_t byteSize) const
+{
+    if (!_isBufferCreated)
+    {
+        LOG_ERROR(Buffers, "Could not bind buffer range to binding point {}, because uniform buffer object is not created yet!", bindingPoint);
+        return;
+    }
+
+    if (offset + byteSize > _byteSize)
+    {
+        LOG_ERROR(Buffers, "Could not bind buffer range to binding point {}, because it's beyond buffer size {}!", bindingPoint, _byteSize);
         return;
     }
 
-    glBindBufferBase(GL_UNIFORM_BUFFER, bindingPoint, _bufferID);
+    GLStateCache::getInstance().bindBufferRange(GL_UNIFORM_BUFFER, bindingPoint, _bufferID, offset, byteSize);
 }
 
 GLuint UniformBufferObject::getBufferID() const
@@ -83,7 +99,8 @@ void UniformBufferObject::deleteUBO()
         return;
     }
 
-    std::cout << "Deleting uniform buffer object with ID " << _bufferID << "..." << std::endl;
+    LOG_DEBUG(Buffers, "Deleting uniform buffer object with ID {}...", _bufferID);
     glDeleteBuffers(1, &_bufferID);
+    GLStateCache::getInstance().onBufferDeleted(_bufferID);
     _isBufferCreated = false;
 }
@@ -1,33 +1,35 @@
 // STL
-#include <iostream>
 #include <cstring>
 
 // Project
 #include "../includes/common_classes/vertexBufferObject.h"
+#include "../includes/common_classes/glStateCache.h"
+#include "../includes/common_classes/instrumentation.h"
+#include "../includes/common_classes/logManager.h"
 
 void VertexBufferObject::createVBO(size_t reserveSizeBytes)
 {
     if (isBufferCreated())
     {
-        std::cerr << "This buffer is already created! You need to delete it before re-creating it!" << std::endl;
+        LOG_ERROR(Buffers, "This buffer is already created! You need to delete it before re-creating it!");
         return;
     }
 
     glGenBuffers(1, &bufferID_);
     rawData_.reserve(reserveSizeBytes > 0 ? reserveSizeBytes : 1024);
-    std::cout << "Created vertex buffer object with ID " << bufferID_ << " and initial reserved size " << rawData_.capacity() << " bytes" << std::endl;
+    LOG_DEBUG(Buffers, "Created vertex buffer object with ID {} and initial reserved size {} bytes", bufferID_, rawData_.capacity());
 }
 
 void VertexBufferObject::bindVBO(GLenum bufferType)
 {
     if (!isBufferCreated())
     {
-        std::cerr << "This buffer is not created yet! You cannot bind it before you create it!" << std::endl;
+        LOG_ERROR(Buffers, "This buffer is not created yet! You cannot bind it before you create it!");
         return;
     }
 
     bufferType_ = bufferType;
-    glBindBuffer(bufferType_, bufferID_);
+    GLStateCache::getInstance().bindBuffer(bufferType_, bufferID_);
 }
 
 void VertexBufferObject::addRawData(const void* ptrData, size_t dataSizeBytes, size_t repeat)
@@ -66,17 +68,33 @@ void* VertexBufferObject::getRawDataPointer()
 
 void VertexBufferObject::uploadDataToGPU(GLenum usageHint)
 {
+    INSTRUMENT_ZONE("VertexBufferObject::uploadDataToGPU");
     if (!isBufferCreated())
     {
-        std::cerr << "This buffer is not created yet! Call createVBO before uploading data to GPU!" << std::endl;
+        LOG_ERROR(Buffers, "This buffer is not created yet! Call createVBO before uploading data to GPU!");
         return;
     }
 
     glBufferData(bufferType_, bytesAdded_, rawData_.data(), usageHint);
+    INSTRUMENT_COUNTER(VBOBytesUploaded, bytesAdded_);
     uploadedDataSize_ = bytesAdded_;
     bytesAdded_ = 0;
 }
 
+void VertexBufferObject::uploadDataToGPU(const void* ptrData, size_t dataSizeBytes, GLenum usageHint)
+{
+    INSTRUMENT_ZONE("VertexBufferObject::uploadDataToGPU");
+    if (!isBufferCreated())
+    {
+        LOG_ERROR(Buffers, "This buffer is not created yet! Call createVBO before uploading data to GPU!");
+        return;
+    }
+
+    glBufferData(bufferType_, dataSizeBytes, ptrData, usageHint);
+    INSTRUMENT_COUNTER(VBOBytesUploaded, dataSizeBytes);
+    uploadedDataSize_ = dataSizeBytes;
+}
+
 void* VertexBufferObject::mapBufferToMemory(GLenum usageHint) const
 {
     if (!isDataUploaded()) {
@@ -116,8 +134,9 @@ void VertexBufferObject::deleteVBO()
         return;
     }
 
-    std::cout << "Deleting vertex buffer object with ID " << bufferID_ << "..." << std::endl;
+    LOG_DEBUG(Buffers, "Deleting vertex buffer object with ID {}...", bufferID_);
     glDeleteBuffers(1, &bufferID_);
+    GLStateCache::getInstance().onBufferDeleted(bufferID_);
     bufferID_ = 0;
     bytesAdded_ = 0;
     uploadedDataSize_ = 0;
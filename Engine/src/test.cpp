@@ -1,15 +1,15 @@
-#include <iostream>
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 #include <imgui/imgui.h>
 #include <imgui/backends/imgui_impl_opengl3.h>
 
 #include "test.h"
+#include "../includes/common_classes/logManager.h"
 
 namespace Engine {
 	int Engine::CheckGLFW()
 	{
-		std::cout << "Engine start" << std::endl;
+		LOG_INFO(Core, "Engine start");
 
 
         GLFWwindow* window;
@@ -31,7 +31,7 @@ namespace Engine {
 
         if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
         {
-            std::cout << "LOG CRITICAL GLAD" << std::endl;
+            LOG_CRITICAL(Core, "Failed to load OpenGL functions with GLAD!");
             return -1;
         }
 
@@ -45,10 +45,10 @@ namespace Engine {
         glsl_version += (const char*)glGetString(GL_SHADING_LANGUAGE_VERSION);
 
 
-        std::cout << vendor << std::endl;
-        std::cout << renderer << std::endl;
-        std::cout << version << std::endl;
-        std::cout << glsl_version << std::endl;
+        LOG_INFO(Core, "{}", vendor);
+        LOG_INFO(Core, "{}", renderer);
+        LOG_INFO(Core, "{}", version);
+        LOG_INFO(Core, "{}", glsl_version);
 
         glClearColor(0, 0, 1, 0);
 